@@ -1,3 +1,15 @@
+REM Rebuilds every .spv in shaders\ from its source, the checked in binaries are only valid once this has run
 C:\VulkanSDK\1.2.198.1\Bin\glslc.exe shaders\simple_shader.vert -o shaders\simple_shader.vert.spv
 C:\VulkanSDK\1.2.198.1\Bin\glslc.exe shaders\simple_shader.frag -o shaders\simple_shader.frag.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe -DBINDLESS_MATERIALS shaders\simple_shader.frag -o shaders\simple_shader_bindless.frag.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe shaders\particle.comp -o shaders\particle.comp.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe shaders\particle.vert -o shaders\particle.vert.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe shaders\particle.frag -o shaders\particle.frag.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe shaders\hiz_downsample.comp -o shaders\hiz_downsample.comp.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe shaders\hiz_cull.comp -o shaders\hiz_cull.comp.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe shaders\light_cull.comp -o shaders\light_cull.comp.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe shaders\fullscreen.vert -o shaders\fullscreen.vert.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe shaders\tonemap.frag -o shaders\tonemap.frag.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe shaders\grade.frag -o shaders\grade.frag.spv
+C:\VulkanSDK\1.2.198.1\Bin\glslc.exe shaders\bloom.comp -o shaders\bloom.comp.spv
 pause
\ No newline at end of file
@@ -2,55 +2,464 @@
 
 //std
 #include <stdexcept>
+#include <algorithm>
 #include <array>
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <string>
+#include <thread>
 
 namespace lve
 {
-	FirstApp::FirstApp()
+	//Has to match the push_constant block of the shaders, vec3 members are 16 byte aligned in there
+	struct SimplePushConstantData
 	{
-		loadModels();
-		createPipelineLayout();
-		createPipeline();
-		createCommandBuffers();
+		glm::vec2 offset;
+		alignas(16) glm::vec3 color;
+		//Packed right after color, at offset 28
+		uint32_t materialIndex;
+		float depth;
+	};
+
+	FirstApp::FirstApp(const std::string& captureFilepath)
+	{
+		//Startup is a graph: a stage starts once the ones it needs are done, on a worker unless it has
+		//to be on the main thread. Shader files are read while the device is created, models decode on
+		//the job system while the swap chains and materials are set up. The stages uploading through the
+		//device's graphics queue and command pool (textures, the depth pyramid, particle buffers, command
+		//buffers) depend on each other, those two are not thread safe.
+		LveStartup startup{ jobSystem };
+		auto windowsStage = startup.addStage("windows", {}, [this]() { createWindows(); }, true);
+		auto shaderFilesStage = startup.addStage("shader files", {}, [this]() { readShaderFiles(); });
+		auto deviceStage = startup.addStage("device", { windowsStage }, [this]()
+		{
+			//Picked so one present queue reaches the surface of every window
+			std::vector<LveWindow*> windows = { lveWindow.get() };
+			if (secondWindow)
+			{
+				windows.push_back(secondWindow.get());
+			}//end if
+			lveDevice = std::make_unique<LveDevice>(windows);
+			createResourceManagers();
+		});
+		auto countersStage = startup.addStage("counters", { deviceStage }, [this]() { createCounters(); });
+		auto swapChainsStage = startup.addStage("swap chains", { deviceStage }, [this]() { createSwapChains(); });
+		//Counters are all registered before the loading jobs add to them
+		auto modelsStage = startup.addStage("models", { countersStage }, [this]() { loadModels(); });
+		auto materialsStage = startup.addStage("materials", { deviceStage }, [this]() { createMaterials(); });
+		startup.addStage("simulation", { modelsStage, materialsStage }, [this]() { createSimulation(); });
+		auto sceneTargetStage = startup.addStage("scene target", { swapChainsStage, materialsStage }, [this, captureFilepath]()
+		{
+			createSceneTarget();
+			if (!captureFilepath.empty())
+			{
+				//Before the pipelines, every one the queue draws with is added to the capture
+				captureWriter = std::make_unique<LveCaptureWriter>(captureFilepath, sceneTarget->getFullExtent());
+			}//end if
+		});
+		//After the materials, the two go through the same descriptor caches
+		auto lightingStage = startup.addStage("lighting", { materialsStage }, [this]() { createLighting(); });
+		auto pipelineLayoutStage = startup.addStage("pipeline layout", { lightingStage }, [this]() { createPipelineLayout(); });
+		auto pipelinesStage = startup.addStage(
+			"pipelines",
+			{ shaderFilesStage, pipelineLayoutStage, sceneTargetStage },
+			[this]() { createPipeline(); });
+		auto particlesStage = startup.addStage("particles", { pipelinesStage }, [this]() { createParticles(); });
+		startup.addStage("command buffers", { particlesStage }, [this]() { createCommandBuffers(); });
+		startup.addStage("readback", { swapChainsStage, sceneTargetStage }, [this]() { createReadback(); });
+		startup.run();
+
+		counters.set(counterIds.startupTime, startup.getTotalMs());
+		if (printStartupTimes)
+		{
+			startup.printReport();
+		}//end if
 	}//constructor
 
 	FirstApp::~FirstApp()
 	{
-		vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+		vkDestroyPipelineLayout(lveDevice->device(), pipelineLayout, nullptr);
 	}//destructor
 
 	void FirstApp::run() 
 	{
-		while (!lveWindow.shouldClose())
+		//The render thread needs a snapshot to draw from the very first frame
+		publishSnapshot();
+		renderThreadRunning = true;
+		std::thread renderThread{ &FirstApp::renderLoop, this };
+
+		//Main thread: window events and the fixed step simulation. Frame N+1 is simulated here while
+		//the render thread records and submits frame N, neither waits on the other.
+		using Clock = std::chrono::steady_clock;
+		const auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(SIMULATION_STEP));
+		auto nextStep = Clock::now() + step;
+		while (!lveWindow->shouldClose() && !(secondWindow && secondWindow->shouldClose()) && renderThreadRunning)
 		{
-			glfwPollEvents();
-			drawFrame();
+			//Sleep until the next step is due, but wake up right away for input
+			double untilNextStep = std::chrono::duration<double>(nextStep - Clock::now()).count();
+			if (untilNextStep > 0.0)
+			{
+				glfwWaitEventsTimeout(untilNextStep);
+			}
+			else
+			{
+				glfwPollEvents();
+			}//end if
+
+			int steps = 0;
+			while (Clock::now() >= nextStep && steps < MAX_STEPS_PER_UPDATE)
+			{
+				simulate(SIMULATION_STEP);
+				nextStep += step;
+				steps++;
+			}//end while
+			if (steps == MAX_STEPS_PER_UPDATE)
+			{
+				//Fell too far behind (e.g. the window was being dragged), drop the backlog instead of spiralling
+				nextStep = Clock::now() + step;
+			}//end if
+			if (steps > 0)
+			{
+				publishSnapshot();
+			}//end if
 		}//end while
 
+		renderThreadRunning = false;
+		renderThread.join();
+
 		//By calling this function the cpu will block until all gpu operations have completed
-		vkDeviceWaitIdle(lveDevice.device());
+		vkDeviceWaitIdle(lveDevice->device());
+
+		if (renderThreadError)
+		{
+			std::rethrow_exception(renderThreadError);
+		}//end if
 	}//end run 
 
 	void FirstApp::loadModels()
 	{
-		std::vector<LveModel::Vertex> vertices{
-			{{0.0f, -0.5f}},
-			{{0.5f, 0.5f}},
-			{{-0.5f, 0.5f}}
+		//The only model built before the first frame, everything else streams in on the job system
+		std::vector<LveModel::Vertex> placeholderVertices{
+			{{0.0f, -0.05f}},
+			{{0.05f, 0.05f}},
+			{{-0.05f, 0.05f}}
 		};
-		//Initialize the model
-		lveModel = std::make_unique<LveModel>(lveDevice, vertices);
+		placeholderModel = std::make_unique<LveModel>(*lveDevice, placeholderVertices);
+
+		triangleModel = assetManager->loadModel("triangle", []()
+		{
+			return std::vector<LveModel::Vertex>{
+				{{0.0f, -0.15f}},
+				{{0.15f, 0.15f}},
+				{{-0.15f, 0.15f}}
+			};
+		});
+		quadModel = assetManager->loadModel("quad", []()
+		{
+			return std::vector<LveModel::Vertex>{
+				{{-0.12f, -0.12f}}, {{0.12f, -0.12f}}, {{0.12f, 0.12f}},
+				{{-0.12f, -0.12f}}, {{0.12f, 0.12f}}, {{-0.12f, 0.12f}}
+			};
+		});
+		circleModel = assetManager->loadModel("circle", []()
+		{
+			const int segments = 64;
+			const float radius = 0.13f;
+			std::vector<LveModel::Vertex> vertices;
+			for (int i = 0; i < segments; i++)
+			{
+				float angle0 = 2.0f * 3.14159265f * i / segments;
+				float angle1 = 2.0f * 3.14159265f * (i + 1) / segments;
+				vertices.push_back({ { 0.0f, 0.0f } });
+				vertices.push_back({ { radius * std::cos(angle0), radius * std::sin(angle0) } });
+				vertices.push_back({ { radius * std::cos(angle1), radius * std::sin(angle1) } });
+			}//end for
+			return vertices;
+		});
 	}//end loadModels
 
+	void FirstApp::createSimulation()
+	{
+		//A few shapes bouncing around the screen, each with its own velocity and color
+		simObjects = {
+			{ triangleModel, { -0.5f, -0.5f }, { 0.35f, 0.25f }, { 1.0f, 0.0f, 1.0f }, 0.2f },
+			{ quadModel, { 0.5f, -0.3f }, { -0.2f, 0.4f }, { 0.0f, 1.0f, 0.5f }, 0.4f },
+			{ circleModel, { 0.0f, 0.4f }, { 0.45f, -0.15f }, { 1.0f, 0.6f, 0.0f }, 0.6f },
+			{ triangleModel, { -0.3f, 0.2f }, { -0.3f, -0.35f }, { 0.2f, 0.5f, 1.0f }, 0.8f }
+		};
+		for (uint32_t i = 0; i < simObjects.size(); i++)
+		{
+			SimObject& object = simObjects[i];
+			object.material = defaultMaterial;
+			object.proxy = spatialIndex.insert(getObjectBounds(object));
+			if (proxyObjects.size() <= object.proxy)
+			{
+				proxyObjects.resize(object.proxy + 1);
+			}//end if
+			proxyObjects[object.proxy] = i;
+		}//end for
+		spatialIndex.rebuild();
+
+		//Small colored lights scattered over the screen and the depth range, a fixed seed so every run
+		//starts from the same scene
+		std::mt19937 random{ 1234 };
+		std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+		simLights.resize(LIGHT_COUNT);
+		for (auto& simLight : simLights)
+		{
+			simLight.light.position = { unit(random) * 2.0f - 1.0f, unit(random) * 2.0f - 1.0f };
+			simLight.light.depth = unit(random);
+			simLight.light.radius = 0.05f + unit(random) * 0.1f;
+			simLight.light.color = { unit(random), unit(random), unit(random) };
+			simLight.light.intensity = 0.5f;
+			simLight.velocity = { unit(random) * 0.4f - 0.2f, unit(random) * 0.4f - 0.2f };
+		}//end for
+	}//end createSimulation
+
+	void FirstApp::createMaterials()
+	{
+		if (!lveDevice->isDescriptorIndexingEnabled())
+		{
+			//Nothing to index into, every object keeps material 0 and the scene uses the shader that never samples
+			return;
+		}//end if
+		bindlessTable = std::make_unique<LveBindlessTable>(*lveDevice, *descriptorLayouts, 4096, 1024);
+
+		//Checkerboard in slot 0, what a material shows before its own texture is in. Textures upload
+		//on the graphics queue, so this happens before the render thread starts.
+		const uint32_t size = 8;
+		std::vector<uint32_t> pixels(size * size);
+		for (uint32_t y = 0; y < size; y++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				pixels[y * size + x] = ((x + y) % 2 == 0) ? 0xffffffffu : 0xff808080u;
+			}//end for
+		}//end for
+		auto checkerboard = textureCache->createTexture("checkerboard", pixels.data(), size, size);
+		LveSamplerInfo samplerInfo{};
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		defaultMaterial = bindlessTable->addTexture(
+			textureCache->getImageView(*checkerboard),
+			textureCache->getSampler(samplerInfo));
+	}//end createMaterials
+
+	void FirstApp::createLighting()
+	{
+		clusteredLighting = std::make_unique<LveClusteredLighting>(
+			*lveDevice,
+			*descriptorLayouts,
+			*descriptorSets,
+			LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+	}//end createLighting
+
+	void FirstApp::createSceneTarget()
+	{
+		//The whole frame is one render graph: the scene is drawn offscreen at a resolution driven by the
+		//GPU time, post processed, upscaled into every swap chain and read back. The graph places the
+		//barriers between the passes and decides which images are kept after a pass.
+		//With dynamicRenderingEnabled the graph uses it for the passes that are not merged into subpasses
+		VkFormat depthFormat = lveSwapChain->findDepthFormat();
+		bool cullOcclusion = occlusionCullingEnabled && LveOcclusionCuller::isSupported(*lveDevice, depthFormat);
+		renderGraph = std::make_unique<LveRenderGraph>(*lveDevice, dynamicRenderingEnabled);
+		sceneTarget = std::make_unique<LveDynamicResolution>(
+			*lveDevice,
+			*renderGraph,
+			lveSwapChain->getSwapChainExtent(),
+			postProcessingEnabled ? LvePostProcess::SCENE_FORMAT : lveSwapChain->getSwapChainImageFormat(),
+			depthFormat,
+			LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+
+		RenderGraphPass& scenePass = sceneTarget->addScenePass("scene", { 0.1f, 0.1f, 0.1f, 1.0f });
+		if (cullOcclusion)
+		{
+			//The draws that passed the first phase lay down the depth the pyramid is rebuilt from, then
+			//the scene is resumed with the objects the second phase found disoccluded
+			scenePass.setRecord([this](VkCommandBuffer commandBuffer) { recordScene(commandBuffer, 0); });
+			renderGraph->addPass("depth pyramid")
+				.readTexture(sceneTarget->getDepth(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT)
+				.setRecord([this](VkCommandBuffer commandBuffer) { occlusionCuller->cullSecondPhase(commandBuffer); });
+			sceneTarget->addResumePass("scene resume").setRecord([this](VkCommandBuffer commandBuffer)
+			{
+				recordScene(commandBuffer, 1);
+				recordOverlays(commandBuffer);
+			});
+		}
+		else
+		{
+			scenePass.setRecord([this](VkCommandBuffer commandBuffer)
+			{
+				recordScene(commandBuffer, 0);
+				recordOverlays(commandBuffer);
+			});
+		}//end if
+		if (postProcessingEnabled)
+		{
+			postProcess = std::make_unique<LvePostProcess>(
+				*lveDevice,
+				*renderGraph,
+				*sceneTarget,
+				lveSwapChain->getSwapChainImageFormat());
+		}//end if
+
+		//Upscale the rendered area to the full image of every swap chain
+		RenderGraphResource upscaleSource = postProcess ? postProcess->getOutput() : sceneTarget->getColor();
+		RenderGraphPass& upscalePass = renderGraph->addPass("upscale").readTransfer(upscaleSource);
+		for (size_t i = 0; i < presentGroup->getSwapChainCount(); i++)
+		{
+			LveSwapChain& swapChain = presentGroup->getSwapChain(i);
+			swapChainImages.push_back(renderGraph->importImage(
+				"swap chain " + std::to_string(i),
+				swapChain.getSwapChainImageFormat(),
+				swapChain.getSwapChainExtent(),
+				VK_IMAGE_LAYOUT_UNDEFINED,
+				VK_IMAGE_LAYOUT_PRESENT_SRC_KHR));
+			upscalePass.writeTransfer(swapChainImages.back());
+		}//end for
+		upscalePass.setRecord([this, upscaleSource](VkCommandBuffer commandBuffer) { recordUpscale(commandBuffer, upscaleSource); });
+
+		//Copied out at the end of the frame and written once its fence comes around again
+		bool readFrames = dumpFrames && lveSwapChain->isReadable();
+		if (readFrames || dumpDepth)
+		{
+			RenderGraphPass& readbackPass = renderGraph->addPass("readback");
+			if (readFrames)
+			{
+				readbackPass.readTransfer(swapChainImages[0]);
+			}//end if
+			if (dumpDepth)
+			{
+				readbackPass.readTransfer(sceneTarget->getDepth());
+			}//end if
+			readbackPass.setRecord([this](VkCommandBuffer commandBuffer) { recordReadback(commandBuffer); });
+		}//end if
+
+		renderGraph->compile();
+		if (cullOcclusion)
+		{
+			occlusionCuller = std::make_unique<LveOcclusionCuller>(
+				*lveDevice,
+				*descriptorLayouts,
+				*descriptorSets,
+				*frameDescriptors,
+				*sceneTarget,
+				LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+		}//end if
+	}//end createSceneTarget
+
+	void FirstApp::createWindows()
+	{
+		//GLFW only creates windows on the main thread
+		lveWindow = std::make_unique<LveWindow>(WIDTH, HEIGHT, "Hello Vulkan!");
+		if (secondWindowEnabled)
+		{
+			secondWindow = std::make_unique<LveWindow>(WIDTH, HEIGHT, "Hello Vulkan! (viewport 2)");
+		}//end if
+	}//end createWindows
+
+	void FirstApp::createResourceManagers()
+	{
+		//All they need is the device, nothing is loaded or uploaded yet
+		assetManager = std::make_unique<LveAssetManager>(*lveDevice, jobSystem, &counters);
+		textureCache = std::make_unique<LveTextureCache>(*lveDevice);
+		descriptorLayouts = std::make_unique<LveDescriptorLayoutCache>(*lveDevice);
+		frameDescriptors = std::make_unique<LveFrameDescriptorAllocator>(*lveDevice, LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+		descriptorSets = std::make_unique<LveDescriptorSetCache>(*lveDevice);
+		streamingBuffer = std::make_unique<LveStreamingBuffer>(*lveDevice, STREAMING_BYTES_PER_FRAME, LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+		pipelineVariants = std::make_unique<LvePipelineVariantCache>(*lveDevice);
+	}//end createResourceManagers
+
+	void FirstApp::readShaderFiles()
+	{
+		//Every graphics shader createPipeline and createParticles may ask for
+		std::vector<std::string> filepaths = {
+			"shaders/simple_shader.vert.spv",
+			"shaders/simple_shader.frag.spv",
+			"shaders/simple_shader_bindless.frag.spv" };
+		if (particlesEnabled)
+		{
+			filepaths.push_back("shaders/particle.vert.spv");
+			filepaths.push_back("shaders/particle.frag.spv");
+		}//end if
+		if (postProcessingEnabled)
+		{
+			filepaths.push_back("shaders/fullscreen.vert.spv");
+			filepaths.push_back("shaders/tonemap.frag.spv");
+			filepaths.push_back("shaders/grade.frag.spv");
+		}//end if
+		shaderFiles.resize(filepaths.size());
+		jobSystem.parallelFor(static_cast<uint32_t>(filepaths.size()), 1, [this, &filepaths](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				shaderFiles[i] = { filepaths[i], LvePipeline::readFile(filepaths[i]) };
+			}//end for
+		});
+	}//end readShaderFiles
+
+	void FirstApp::createSwapChains()
+	{
+		lveSwapChain = std::make_unique<LveSwapChain>(*lveDevice, *lveWindow);
+		std::vector<LveSwapChain*> swapChains = { lveSwapChain.get() };
+		if (secondWindow)
+		{
+			//Same device, the swap chain of its own window's surface. The scene is drawn once and blitted into both.
+			secondSwapChain = std::make_unique<LveSwapChain>(*lveDevice, *secondWindow);
+			swapChains.push_back(secondSwapChain.get());
+		}//end if
+		presentGroup = std::make_unique<LvePresentGroup>(*lveDevice, swapChains);
+	}//end createSwapChains
+
+	void FirstApp::createReadback()
+	{
+		if (!dumpFrames && !dumpDepth)
+		{
+			return;
+		}//end if
+		if (dumpFrames && !lveSwapChain->isReadable())
+		{
+			std::cerr << "swap chain images cannot be read back, frames are not dumped\n";
+		}//end if
+		//A slot fits one full size image, the scene depth is never bigger than the swap chain
+		VkExtent2D extent = lveSwapChain->getSwapChainExtent();
+		readback = std::make_unique<LveReadback>(
+			*lveDevice,
+			jobSystem,
+			static_cast<VkDeviceSize>(extent.width) * extent.height * 4,
+			READBACK_SLOTS);
+	}//end createReadback
+
 	void FirstApp::createPipelineLayout()
 	{
+		//Per object data is pushed straight into the command buffer, read by both stages
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(SimplePushConstantData);
+
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 0;
-		pipelineLayoutInfo.pSetLayouts = nullptr;
-		pipelineLayoutInfo.pushConstantRangeCount = 0;
-		pipelineLayoutInfo.pPushConstantRanges = nullptr;
-		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		//Set 0 is the bindless table: one set for every material, bound once per frame. Set 1 is the
+		//lighting, also bound once per frame. Set layouts all come from the layout cache, so pipelines
+		//declaring the same sets get the same layouts.
+		std::vector<VkDescriptorSetLayout> setLayouts;
+		if (bindlessTable)
+		{
+			setLayouts.push_back(bindlessTable->getDescriptorSetLayout());
+		}
+		else
+		{
+			//Nothing is ever bound there, the lighting stays at set 1 either way
+			setLayouts.push_back(descriptorLayouts->getLayout(LveDescriptorLayoutInfo{}));
+		}//end if
+		setLayouts.push_back(clusteredLighting->getDescriptorSetLayout());
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = setLayouts.empty() ? nullptr : setLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(lveDevice->device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to create pipelinelayout");
 		}//end if
@@ -58,105 +467,664 @@ namespace lve
 
 	void FirstApp::createPipeline()
 	{
+		for (auto& shaderFile : shaderFiles)
+		{
+			pipelineVariants->addShaderCode(shaderFile.first, shaderFile.second);
+		}//end for
+		shaderFiles.clear();
+
 		PipelineConfigInfo pipelineConfig{};
 		LvePipeline::defaultPipelineConfigInfo(
 			pipelineConfig,
-			lveSwapChain.width(),
-			lveSwapChain.height());
-		pipelineConfig.renderPass = lveSwapChain.getRenderPass();
+			lveSwapChain->width(),
+			lveSwapChain->height());
+		sceneTarget->configurePipeline(pipelineConfig);
 		pipelineConfig.pipelineLayout = pipelineLayout;
-		lvePipeline = std::make_unique<LvePipeline>(
-			lveDevice,
+		if (depthPrePassEnabled)
+		{
+			LvePipeline::depthTestAfterPrePass(pipelineConfig);
+		}//end if
+		//SHOW_MATERIAL_INDEX (constant_id 0) is baked into the variant, the shader has no runtime branch for it
+		pipelineConfig.fragmentSpecialization.set<VkBool32>(0, showMaterialIndex ? VK_TRUE : VK_FALSE);
+		//The scene samples its material textures from the bindless table when there is one
+		const char* sceneFragFilepath = bindlessTable ? "shaders/simple_shader_bindless.frag.spv" : "shaders/simple_shader.frag.spv";
+		lvePipeline = pipelineVariants->getPipeline(
 			"shaders/simple_shader.vert.spv",
-			"shaders/simple_shader.frag.spv",
+			sceneFragFilepath,
 			pipelineConfig
 		);
+		if (captureWriter)
+		{
+			captureWriter->addPipeline(lvePipeline, LveCapturedPipeline::fromConfig(
+				"shaders/simple_shader.vert.spv",
+				sceneFragFilepath,
+				pipelineConfig));
+		}//end if
+
+		if (depthPrePassEnabled)
+		{
+			//Same vertex shader as the main pass (invariant gl_Position) and no fragment shader at all
+			PipelineConfigInfo depthConfig{};
+			LvePipeline::depthPrePassPipelineConfigInfo(
+				depthConfig,
+				lveSwapChain->width(),
+				lveSwapChain->height());
+			sceneTarget->configurePipeline(depthConfig);
+			depthConfig.pipelineLayout = pipelineLayout;
+			depthPrePassPipeline = pipelineVariants->getPipeline(
+				"shaders/simple_shader.vert.spv",
+				"",
+				depthConfig
+			);
+			if (captureWriter)
+			{
+				captureWriter->addPipeline(depthPrePassPipeline, LveCapturedPipeline::fromConfig(
+					"shaders/simple_shader.vert.spv",
+					"",
+					depthConfig));
+			}//end if
+		}//end if
+
+		if (showObjectBounds)
+		{
+			//Lines drawn over everything, from vertices streamed in every frame
+			PipelineConfigInfo boundsConfig{};
+			LvePipeline::defaultPipelineConfigInfo(
+				boundsConfig,
+				lveSwapChain->width(),
+				lveSwapChain->height());
+			boundsConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+			boundsConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+			boundsConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+			sceneTarget->configurePipeline(boundsConfig);
+			boundsConfig.pipelineLayout = pipelineLayout;
+			//Not part of the lit scene, LIGHTING (constant_id 1) off
+			boundsConfig.fragmentSpecialization.set<VkBool32>(1, VK_FALSE);
+			boundsPipeline = pipelineVariants->getPipeline(
+				"shaders/simple_shader.vert.spv",
+				"shaders/simple_shader.frag.spv",
+				boundsConfig
+			);
+		}//end if
+
+		if (postProcess)
+		{
+			postProcess->createPipelines(*descriptorLayouts, *descriptorSets, *pipelineVariants);
+		}//end if
 	}//end createPipeline
 
+	void FirstApp::createParticles()
+	{
+		if (!particlesEnabled)
+		{
+			return;
+		}//end if
+		particleSystem = std::make_unique<LveParticleSystem>(
+			*lveDevice,
+			*descriptorLayouts,
+			*descriptorSets,
+			PARTICLE_COUNT,
+			LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+
+		//Points read straight from the particle buffer, tested against the scene depth but not writing it
+		PipelineConfigInfo particleConfig{};
+		LvePipeline::defaultPipelineConfigInfo(
+			particleConfig,
+			lveSwapChain->width(),
+			lveSwapChain->height());
+		particleConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+		particleConfig.bindingDescriptions = LveParticleSystem::getBindingDescriptions();
+		particleConfig.attributeDescriptions = LveParticleSystem::getAttributeDescriptions();
+		particleConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+		particleConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+		sceneTarget->configurePipeline(particleConfig);
+		particleConfig.pipelineLayout = pipelineLayout;
+		particlePipeline = pipelineVariants->getPipeline(
+			"shaders/particle.vert.spv",
+			"shaders/particle.frag.spv",
+			particleConfig
+		);
+		lastParticleStep = std::chrono::steady_clock::now();
+	}//end createParticles
+
 	void FirstApp::createCommandBuffers() 
 	{
-		commandBuffers.resize(lveSwapChain.imageCount());
+		//One command buffer per frame in flight, re-recorded every frame because the render area changes
+		commandBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
 
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = lveDevice.getCommandPool();
+		allocInfo.commandPool = lveDevice->getCommandPool();
 		allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
 
-		if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+		if (vkAllocateCommandBuffers(lveDevice->device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to allocate command buffers!");
 		}//end if 
+	}//end createCommandBuffers
 
-		//Record draw commands to each buffer
-		for (int i = 0; i < commandBuffers.size(); i++)
+	void FirstApp::createCounters()
+	{
+		//Commands as recorded: with occlusion culling every object is recorded once per phase and only the
+		//GPU knows what those draw, its results say how many objects were culled
+		counterIds.drawCommands = counters.addCounter("draw_commands");
+		counterIds.directTriangles = counters.addCounter("direct_triangles");
+		counterIds.culledObjects = counters.addCounter("culled_objects");
+		counterIds.pipelineBinds = counters.addCounter("pipeline_binds");
+		counterIds.streamedBytes = counters.addCounter("streamed_bytes");
+		counterIds.frameTime = counters.addGauge("frame_ms");
+		counterIds.gpuTime = counters.addGauge("gpu_ms");
+		counterIds.deviceAllocations = counters.addGauge("device_allocations");
+		counterIds.pendingDeletions = counters.addGauge("pending_deletions");
+		counterIds.startupTime = counters.addGauge("startup_ms");
+		counterIds.firstFrameTime = counters.addGauge("first_frame_ms");
+		if (lveDevice->isMemoryBudgetEnabled())
 		{
-			VkCommandBufferBeginInfo beginInfo{};
-			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			
-			if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS)
+			lveDevice->getMemoryHeapUsage(heapUsage);
+			for (size_t i = 0; i < heapUsage.size(); i++)
 			{
-				throw std::runtime_error("failed to begin recording command buffer!");
+				std::string heap = "heap" + std::to_string(i);
+				counterIds.heapUsage.push_back(counters.addGauge(heap + "_usage_mb"));
+				counterIds.heapBudget.push_back(counters.addGauge(heap + "_budget_mb"));
+			}//end for
+		}//end if
+
+		if (exportCounters)
+		{
+			counterExporter = std::make_unique<LveCounterExporter>(COUNTERS_TARGET, COUNTERS_INTERVAL);
+		}//end if
+		lastFrameEnd = std::chrono::steady_clock::now();
+	}//end createCounters
+
+	void FirstApp::simulate(double dt)
+	{
+		const float bounds = 0.85f;
+		//Objects move independently, batches of them are spread over the job system workers
+		jobSystem.parallelFor(
+			static_cast<uint32_t>(simObjects.size()),
+			256,
+			[this, dt, bounds](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				SimObject& object = simObjects[i];
+				object.position += object.velocity * static_cast<float>(dt);
+				//Bounce off the edges of the screen
+				for (int axis = 0; axis < 2; axis++)
+				{
+					if ((object.position[axis] < -bounds && object.velocity[axis] < 0.0f) ||
+						(object.position[axis] > bounds && object.velocity[axis] > 0.0f))
+					{
+						object.velocity[axis] = -object.velocity[axis];
+					}//end if
+				}//end for
+			}//end for
+		});
+		//Lights bounce off the edges of NDC itself, they may light the screen border from just outside
+		for (auto& simLight : simLights)
+		{
+			simLight.light.position += simLight.velocity * static_cast<float>(dt);
+			for (int axis = 0; axis < 2; axis++)
+			{
+				if ((simLight.light.position[axis] < -1.0f && simLight.velocity[axis] < 0.0f) ||
+					(simLight.light.position[axis] > 1.0f && simLight.velocity[axis] > 0.0f))
+				{
+					simLight.velocity[axis] = -simLight.velocity[axis];
+				}//end if
+			}//end for
+		}//end for
+		for (auto& object : simObjects)
+		{
+			spatialIndex.update(object.proxy, getObjectBounds(object));
+		}//end for
+		spatialIndex.commit();
+
+		simulationStep++;
+		simulationTime += dt;
+	}//end simulate
+
+	LveBounds FirstApp::getObjectBounds(const SimObject& object)
+	{
+		//Models still streaming in are drawn as the placeholder, and take its room until they are loaded
+		LveModel* model = assetManager->getModel(object.model);
+		if (model == nullptr)
+		{
+			model = placeholderModel.get();
+		}//end if
+		return LveBounds::fromCircle(object.position, model->getBoundingRadius());
+	}//end getObjectBounds
+
+	void FirstApp::publishSnapshot()
+	{
+		//The slot still holds an old snapshot, reusing its vector keeps this allocation free
+		RenderSnapshot& snapshot = snapshots.getWriteBuffer();
+		snapshot.simulationStep = simulationStep;
+		snapshot.simulationTime = simulationTime;
+		snapshot.objects.clear();
+
+		//Only what overlaps the view, the four sides of NDC. Sorted back into object order so the
+		//snapshot does not depend on how the tree happens to be laid out.
+		const glm::vec3 viewPlanes[4] = {
+			{ 1.0f, 0.0f, 1.0f },
+			{ -1.0f, 0.0f, 1.0f },
+			{ 0.0f, 1.0f, 1.0f },
+			{ 0.0f, -1.0f, 1.0f } };
+		visibleProxies.clear();
+		spatialIndex.queryPlanes(viewPlanes, 4, visibleProxies);
+		for (auto& proxy : visibleProxies)
+		{
+			proxy = proxyObjects[proxy];
+		}//end for
+		std::sort(visibleProxies.begin(), visibleProxies.end());
+
+		for (uint32_t objectIndex : visibleProxies)
+		{
+			SimObject& object = simObjects[objectIndex];
+			LveModel* model = assetManager->getModel(object.model);
+			if (model == nullptr)
+			{
+				//Still streaming in (or failed to load)
+				if (!drawPlaceholders)
+				{
+					continue;
+				}//end if
+				model = placeholderModel.get();
 			}//end if
-			
-			 //First command 
-			VkRenderPassBeginInfo renderPassInfo{};
-			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassInfo.renderPass = lveSwapChain.getRenderPass();
-			renderPassInfo.framebuffer = lveSwapChain.getFrameBuffer(i);
-
-			//Defines the area where the shader loads and stores will take place
-			renderPassInfo.renderArea.offset = { 0, 0 };
-			renderPassInfo.renderArea.extent = lveSwapChain.getSwapChainExtent();
-
-			//Set clear values, corresponds to what we want the initial values of our framebuffer attachments to be cleared to.
-			std::array<VkClearValue, 2> clearValues{};
-			clearValues[0].color = { 0.1f, 0.1f, 0.1f, 1.0f };
-			clearValues[1].depthStencil = { 1.0f, 0 };
-			renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-			renderPassInfo.pClearValues = clearValues.data();
-
-			//let's record to our command buffer to begin this render pass
-			//VK_SUBPASS_CONTENTS_INLINE, signals that the subsequent render pass commands will be directly
-			//embedded in the primary command buffer itself, and that no secondary command buffer, will be used.
-			//SECONDARY_COMMAND_BUFFERS, alternative is to us VK_SUBPASS_CONTENT_SECONDARY_COMMAND_BUFFERS, signaling that 
-			//render pass commands will be executed from secondary command buffers.
-			vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-			lvePipeline->bind(commandBuffers[i]);
-			//Commands to draw three vertives and only one instance
-			lveModel->bind(commandBuffers[i]);
-			lveModel->draw(commandBuffers[i]);
-
-			vkCmdEndRenderPass(commandBuffers[i]);
-			if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS)
-			{
-				throw std::runtime_error("failed to record command buffer!");
-			}//end if 
+			//Projected diameter in pixels: models are in NDC, two units across the height of the target
+			float screenSize = model->getBoundingRadius() * static_cast<float>(lveSwapChain->height());
+			object.lod = lodSelector.selectLod(model->getLodCount(), screenSize, object.lod);
+			snapshot.objects.push_back({ model, object.position, object.color, object.material, object.lod, object.depth });
+		}//end for
+		snapshot.lights.clear();
+		for (auto& simLight : simLights)
+		{
+			snapshot.lights.push_back(simLight.light);
 		}//end for
+		snapshots.publish();
+		//Models unloaded before this snapshot was built stay alive until the render thread draws it (or a
+		//newer one), it may still be recording from an older snapshot that references them
+		assetManager->releaseUnloaded(snapshot.simulationStep, drawnStep.load(std::memory_order_acquire));
+	}//end publishSnapshot
 
-	}//end createCommandBuffers
-	void FirstApp::drawFrame()
+	void FirstApp::renderLoop()
+	{
+		if (pinRenderThread)
+		{
+			LveJobSystem::pinCurrentThread(RENDER_THREAD_CORE);
+		}//end if
+
+		try
+		{
+			while (renderThreadRunning)
+			{
+				//Picks up the newest snapshot if the simulation published one since the last frame,
+				//otherwise the previous one is drawn again
+				snapshots.consume();
+				const RenderSnapshot& snapshot = snapshots.getReadBuffer();
+				//Older snapshots are never drawn again, the models only they reference can go
+				drawnStep.store(snapshot.simulationStep, std::memory_order_release);
+				drawFrame(snapshot);
+			}//end while
+		}//end try
+		catch (...)
+		{
+			renderThreadError = std::current_exception();
+			renderThreadRunning = false;
+		}//end catch
+	}//end renderLoop
+
+	void FirstApp::recordCommandBuffer(int frameIndex, const std::vector<uint32_t>& imageIndices, const RenderSnapshot& snapshot)
+	{
+		VkCommandBuffer commandBuffer = commandBuffers[frameIndex];
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to begin recording command buffer!");
+		}//end if
+
+		//First culling phase before the scene pass: every object against the depth pyramid of last frame
+		if (occlusionCuller)
+		{
+			for (auto& object : snapshot.objects)
+			{
+				occlusionCuller->addObject(
+					object.offset,
+					object.model->getBoundingRadius(),
+					object.depth,
+					object.model->getLod(object.lod));
+			}//end for
+			occlusionCuller->cullFirstPhase(commandBuffer);
+		}//end if
+
+		//Compute, so outside the scene pass: which lights reach which cluster, read by the lit draws
+		clusteredLighting->assignLights(commandBuffer, frameIndex, snapshot.lights);
+
+		//Depth pre-pass: same subpass, so its depth writes are visible to the draws that follow. The
+		//pass is the top of the sort key, so every pre-pass draw is recorded before the main pass.
+		renderQueue.clear();
+		if (depthPrePassEnabled)
+		{
+			queueObjects(0, depthPrePassPipeline, snapshot);
+		}//end if
+		queueObjects(1, lvePipeline, snapshot);
+		if (captureWriter)
+		{
+			captureWriter->writeFrame(renderQueue);
+		}//end if
+		renderQueue.sort();
+
+		//Every pass of the frame, with the barriers between them, timed for the resolution scale
+		recordingSnapshot = &snapshot;
+		recordingFrameIndex = frameIndex;
+		for (size_t i = 0; i < swapChainImages.size(); i++)
+		{
+			renderGraph->setImportedImage(swapChainImages[i], presentGroup->getSwapChain(i).getImage(imageIndices[i]), VK_NULL_HANDLE);
+		}//end for
+		sceneTarget->beginTimer(commandBuffer, frameIndex);
+		renderGraph->execute(commandBuffer);
+		sceneTarget->endTimer(commandBuffer, frameIndex);
+		recordingSnapshot = nullptr;
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to record command buffer!");
+		}//end if 
+	}//end recordCommandBuffer
+
+	void FirstApp::recordScene(VkCommandBuffer commandBuffer, uint32_t phase)
+	{
+		//The only descriptor binds of the pass, every pipeline shares the layout so they stay bound
+		if (bindlessTable)
+		{
+			bindlessTable->bind(commandBuffer, pipelineLayout);
+		}//end if
+		clusteredLighting->bind(commandBuffer, pipelineLayout, 1);
+
+		//Per draw sets would go to set 2, right after the lighting
+		if (occlusionCuller)
+		{
+			//The queue is recorded once per culling phase, only the objects that phase let through draw
+			renderQueue.record(
+				commandBuffer,
+				pipelineLayout,
+				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+				2,
+				occlusionCuller->getIndirectBuffer(),
+				occlusionCuller->getPhaseOffset(phase));
+		}
+		else
+		{
+			renderQueue.record(
+				commandBuffer,
+				pipelineLayout,
+				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+				2);
+		}//end if
+	}//end recordScene
+
+	void FirstApp::recordOverlays(VkCommandBuffer commandBuffer)
+	{
+		//Drawn from the buffer the compute step of this frame writes, the submit waits for it
+		if (particleSystem)
+		{
+			particlePipeline->bind(commandBuffer);
+			particleSystem->draw(commandBuffer);
+		}//end if
+
+		if (boundsPipeline)
+		{
+			drawObjectBounds(commandBuffer, *recordingSnapshot);
+		}//end if
+	}//end recordOverlays
+
+	void FirstApp::recordUpscale(VkCommandBuffer commandBuffer, RenderGraphResource source)
 	{
-		uint32_t imageIndex;
-		//This function fetches the index of the frame we should render to next, also it automatically
-		//handles all the cpu and gpu synchronization, surronding double or triple buffering. 
+		for (size_t i = 0; i < swapChainImages.size(); i++)
+		{
+			sceneTarget->blit(
+				commandBuffer,
+				renderGraph->getImage(source),
+				renderGraph->getImage(swapChainImages[i]),
+				presentGroup->getSwapChain(i).getSwapChainExtent());
+		}//end for
+	}//end recordUpscale
+
+	void FirstApp::recordReadback(VkCommandBuffer commandBuffer)
+	{
+		//The graph has both images in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL with the writes made visible
+		std::string frameNumber = std::to_string(renderedFrames);
+		frameNumber.insert(0, frameNumber.size() < 6 ? 6 - frameNumber.size() : 0, '0');
+		if (dumpFrames && lveSwapChain->isReadable())
+		{
+			LveReadbackSource color{};
+			color.image = renderGraph->getImage(swapChainImages[0]);
+			color.format = lveSwapChain->getSwapChainImageFormat();
+			color.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+			color.extent = lveSwapChain->getSwapChainExtent();
+			color.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			color.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			color.access = 0;
+			readback->readImage(commandBuffer, recordingFrameIndex, color, FRAME_DUMP_PREFIX + frameNumber + ".ppm");
+		}//end if
+		if (dumpDepth)
+		{
+			//Only the scaled render area holds this frame's depth
+			LveReadbackSource depth{};
+			depth.image = sceneTarget->getDepthImage();
+			depth.format = sceneTarget->getDepthFormat();
+			depth.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+			depth.extent = sceneTarget->getRenderExtent();
+			depth.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			depth.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			depth.access = 0;
+			readback->readImage(commandBuffer, recordingFrameIndex, depth, FRAME_DUMP_PREFIX + frameNumber + "_depth.pgm");
+		}//end if
+	}//end recordReadback
+
+	void FirstApp::queueObjects(uint32_t pass, LvePipeline* pipeline, const RenderSnapshot& snapshot)
+	{
+		for (uint32_t i = 0; i < snapshot.objects.size(); i++)
+		{
+			const RenderObject& object = snapshot.objects[i];
+			SimplePushConstantData push{};
+			push.offset = object.offset;
+			push.color = object.color;
+			push.materialIndex = object.materialIndex;
+			push.depth = object.depth;
+			//Materials index the bindless table bound once per frame, so no draw needs a set of its own.
+			//Objects were added to the culler in snapshot order, so the index is their cull index.
+			uint32_t cullIndex = occlusionCuller ? i : LveRenderQueue::NO_CULL_INDEX;
+			renderQueue.submit(pass, pipeline, VK_NULL_HANDLE, object.model, object.lod, object.depth, &push, sizeof(push), cullIndex);
+		}//end for
+	}//end queueObjects
+
+	void FirstApp::drawObjectBounds(VkCommandBuffer commandBuffer, const RenderSnapshot& snapshot)
+	{
+		//Four lines per object, written into this frame's part of the ring: no buffer is created per frame
+		VkDeviceSize size = sizeof(LveModel::Vertex) * 8 * snapshot.objects.size();
+		LveStreamingAllocation allocation = streamingBuffer->allocate(size);
+		if (size == 0 || !allocation.isValid())
+		{
+			return;
+		}//end if
+		auto* vertices = static_cast<LveModel::Vertex*>(allocation.data);
+		for (auto& object : snapshot.objects)
+		{
+			float radius = object.model->getBoundingRadius();
+			glm::vec2 corners[4] = {
+				object.offset + glm::vec2{ -radius, -radius },
+				object.offset + glm::vec2{ radius, -radius },
+				object.offset + glm::vec2{ radius, radius },
+				object.offset + glm::vec2{ -radius, radius } };
+			for (int edge = 0; edge < 4; edge++)
+			{
+				(vertices++)->position = corners[edge];
+				(vertices++)->position = corners[(edge + 1) % 4];
+			}//end for
+		}//end for
+
+		boundsPipeline->bind(commandBuffer);
+		SimplePushConstantData push{};
+		push.color = { 1.0f, 1.0f, 1.0f };
+		vkCmdPushConstants(
+			commandBuffer,
+			pipelineLayout,
+			VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+			0,
+			sizeof(SimplePushConstantData),
+			&push);
+		VkBuffer buffers[] = { allocation.buffer };
+		VkDeviceSize offsets[] = { allocation.offset };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		vkCmdDraw(commandBuffer, static_cast<uint32_t>(8 * snapshot.objects.size()), 1, 0, 0);
+	}//end drawObjectBounds
+
+	void FirstApp::drawFrame(const RenderSnapshot& snapshot)
+	{
+		//This function fetches the index of the frame we should render to next in every swap chain, also
+		//it automatically handles all the cpu and gpu synchronization, surronding double or triple buffering. 
 		//The value results determines if the process was successful.
-		auto result = lveSwapChain.acquireNextImage(&imageIndex);
+		auto result = presentGroup->acquireNextImages(imageIndices);
 
 		if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
 		{
 			throw std::runtime_error("failed to acquire swap chain image!");
 		}//end if
 
+		//The fence of this frame slot was waited on by acquireNextImages, so its command buffer and
+		//timestamps from last time are free: read the GPU time and re-record at the new scale
+		int frameIndex = static_cast<int>(presentGroup->getCurrentFrame());
+		sceneTarget->update(frameIndex);
+		frameDescriptors->beginFrame(frameIndex);
+		streamingBuffer->beginFrame(frameIndex);
+		if (readback)
+		{
+			readback->beginFrame(frameIndex);
+		}//end if
+		if (occlusionCuller)
+		{
+			occlusionCuller->beginFrame(frameIndex);
+		}//end if
+		if (bindlessTable)
+		{
+			bindlessTable->nextFrame();
+		}//end if
+
+		//The particle step of this frame goes out first on the compute queue. It only writes the buffer
+		//drawn two frames ago, whose graphics finished with this slot's fence, so it runs alongside the
+		//graphics of the previous frame and only the vertex input of this frame waits for it.
+		std::vector<VkSemaphore> computeWaitSemaphores;
+		std::vector<VkPipelineStageFlags> computeWaitStages;
+		if (particleSystem)
+		{
+			auto now = std::chrono::steady_clock::now();
+			//Clamped so a stall does not throw every particle across the screen
+			float deltaTime = std::min(std::chrono::duration<float>(now - lastParticleStep).count(), 0.1f);
+			lastParticleStep = now;
+			computeWaitSemaphores.push_back(particleSystem->simulate(frameIndex, deltaTime));
+			computeWaitStages.push_back(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+		}//end if
+
+		recordCommandBuffer(frameIndex, imageIndices, snapshot);
+		//Only does anything when the streaming memory is not host coherent
+		streamingBuffer->flush();
+
 		//This function will submit the provided command buffer to our device graphics queue while 
-		//handling cpu and gpu synchronization, then the command buffer will be executed, and then the swapchain
+		//handling cpu and gpu synchronization, then the command buffer will be executed, and then every swapchain
 		// will present the associated color attachment image view to the display at the appropiate time
 		//based on the present mode selected. 
-		result = lveSwapChain.submitCommandBuffers(&commandBuffers[imageIndex], &imageIndex);
+		result = presentGroup->submitCommandBuffers(
+			&commandBuffers[frameIndex],
+			1,
+			imageIndices,
+			computeWaitSemaphores,
+			computeWaitStages);
 		if (result != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to present swap chain image!");
 		}
+
+		if (renderedFrames == 0)
+		{
+			//Launch to the first present, what startup is ultimately measured by
+			double firstFrameMs = LveStartup::millisecondsSinceLaunch();
+			counters.set(counterIds.firstFrameTime, firstFrameMs);
+			if (printStartupTimes)
+			{
+				std::cout << "first frame presented " << firstFrameMs << " ms after launch\n";
+			}//end if
+		}//end if
+		renderedFrames++;
+		updateCounters();
+		if (printRenderStats && renderedFrames % 300 == 0)
+		{
+			const LveRenderQueueStats& stats = renderQueue.getStats();
+			std::cout << "draw commands " << stats.drawCommands << " (" << stats.indirectDrawCommands << " indirect)"
+				<< ", pipeline binds " << stats.pipelineBinds << " (" << stats.pipelineBindsSkipped << " skipped)"
+				<< ", descriptor set binds " << stats.descriptorSetBinds << " (" << stats.descriptorSetBindsSkipped << " skipped)"
+				<< ", vertex buffer binds " << stats.vertexBufferBinds << " (" << stats.vertexBufferBindsSkipped << " skipped)\n";
+			if (occlusionCuller)
+			{
+				const LveOcclusionStats& occlusion = occlusionCuller->getStats();
+				std::cout << "occlusion: " << occlusion.objects << " objects, " << occlusion.drawnFirstPhase << " drawn in phase 1, "
+					<< occlusion.drawnSecondPhase << " disoccluded in phase 2, " << occlusion.culled << " culled\n";
+			}//end if
+			if (readback)
+			{
+				LveReadbackStats readbackStats = readback->getStats();
+				std::cout << "readback: " << readbackStats.written << " of " << readbackStats.requested << " images written, "
+					<< readbackStats.dropped << " dropped, " << readbackStats.failed << " failed\n";
+			}//end if
+			const LveStreamingStats& streaming = streamingBuffer->getStats();
+			std::cout << "streaming: " << streaming.bytesUsed << " bytes in " << streaming.allocations << " allocations, "
+				<< streaming.failedAllocations << " failed" << (streamingBuffer->isCoherent() ? "\n" : ", flushed\n");
+			if (particleSystem)
+			{
+				std::cout << "particle step " << particleSystem->getLastStepTime() << " ms for "
+					<< particleSystem->getParticleCount() << " particles\n";
+			}//end if
+		}//end if
 	}//end drawFrame
+
+	void FirstApp::updateCounters()
+	{
+		const LveRenderQueueStats& stats = renderQueue.getStats();
+		counters.add(counterIds.drawCommands, stats.drawCommands);
+		counters.add(counterIds.directTriangles, stats.directVertices / 3);
+		counters.add(counterIds.pipelineBinds, stats.pipelineBinds);
+		if (occlusionCuller)
+		{
+			//Read back by the culler from the last frame of this slot
+			counters.add(counterIds.culledObjects, occlusionCuller->getStats().culled);
+		}//end if
+		counters.add(counterIds.streamedBytes, streamingBuffer->getStats().bytesUsed);
+
+		auto now = std::chrono::steady_clock::now();
+		counters.set(counterIds.frameTime, std::chrono::duration<double, std::milli>(now - lastFrameEnd).count());
+		lastFrameEnd = now;
+		counters.set(counterIds.gpuTime, sceneTarget->getSmoothedGpuTimeMs());
+		counters.set(counterIds.deviceAllocations, static_cast<double>(lveDevice->getAllocationCount()));
+		counters.set(counterIds.pendingDeletions, static_cast<double>(lveDevice->deletionQueue().getPendingCount()));
+		//The budget query goes to the driver, twice a second is plenty for a gauge
+		if (!counterIds.heapUsage.empty() && renderedFrames % 30 == 0)
+		{
+			lveDevice->getMemoryHeapUsage(heapUsage);
+			for (size_t i = 0; i < counterIds.heapUsage.size(); i++)
+			{
+				counters.set(counterIds.heapUsage[i], heapUsage[i].usage / (1024.0 * 1024.0));
+				counters.set(counterIds.heapBudget[i], heapUsage[i].budget / (1024.0 * 1024.0));
+			}//end for
+		}//end if
+
+		counters.endFrame();
+		if (counterExporter)
+		{
+			counterExporter->update(counters);
+		}//end if
+	}//end updateCounters
 }//end namespace
\ No newline at end of file
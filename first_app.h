@@ -5,9 +5,36 @@
 #include "lve_swap_chain.h"
 #include "lve_window.h"
 #include "lve_model.h"
+#include "lve_asset_manager.h"
+#include "lve_bindless.h"
+#include "lve_capture.h"
+#include "lve_clustered_lighting.h"
+#include "lve_counters.h"
+#include "lve_descriptors.h"
+#include "lve_dynamic_resolution.h"
+#include "lve_job_system.h"
+#include "lve_lod_selector.h"
+#include "lve_occlusion_culler.h"
+#include "lve_particle_system.h"
+#include "lve_post_process.h"
+#include "lve_present_group.h"
+#include "lve_readback.h"
+#include "lve_render_graph.h"
+#include "lve_render_queue.h"
+#include "lve_render_snapshot.h"
+#include "lve_spatial_index.h"
+#include "lve_startup.h"
+#include "lve_streaming_buffer.h"
+#include "lve_texture.h"
+#include "lve_triple_buffer.h"
 
 //std
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 
@@ -17,8 +44,28 @@ namespace lve
 	public:
 		static constexpr int WIDTH = 800;
 		static constexpr int HEIGHT = 600;
+		//The simulation advances in fixed steps no matter how fast frames are rendered
+		static constexpr double SIMULATION_STEP = 1.0 / 60.0;
+		//Cap on the steps taken to catch up after a stall, past it the missed time is dropped
+		static constexpr int MAX_STEPS_PER_UPDATE = 8;
+		//Core the render thread is pinned to when pinRenderThread is set, the job system workers start past it
+		static constexpr uint32_t RENDER_THREAD_CORE = 1;
+		//Simulated by compute on the GPU, drawn as one point each
+		static constexpr uint32_t PARTICLE_COUNT = 1 << 20;
+		//Point lights moving through the scene, shaded through clustered lighting
+		static constexpr uint32_t LIGHT_COUNT = 2048;
+		//Room for the geometry written by the CPU each frame, per frame in flight
+		static constexpr VkDeviceSize STREAMING_BYTES_PER_FRAME = 1 << 20;
+		//Where exportCounters writes, a file or "unix:<path>" for a socket, and how often
+		static constexpr const char* COUNTERS_TARGET = "counters.jsonl";
+		static constexpr double COUNTERS_INTERVAL = 1.0;
+		//Frames dumped by dumpFrames/dumpDepth go to <prefix><frame number>.ppm (or .pgm for depth)
+		static constexpr const char* FRAME_DUMP_PREFIX = "frame_";
+		//Readback slots, enough for a few frames of color and depth waiting on their files
+		static constexpr uint32_t READBACK_SLOTS = 8;
 
-		FirstApp();
+		//With a captureFilepath every frame's draws are written there, see LveCaptureWriter
+		explicit FirstApp(const std::string& captureFilepath = "");
 		~FirstApp();
 
 		FirstApp(const FirstApp&) = delete;
@@ -27,18 +74,214 @@ namespace lve
 		void run();
 
 	private:
+		//What the engine reports each frame through counters
+		struct CounterIds
+		{
+			LveCounterId drawCommands;
+			LveCounterId directTriangles;
+			LveCounterId culledObjects;
+			LveCounterId pipelineBinds;
+			LveCounterId streamedBytes;
+			LveCounterId frameTime;
+			LveCounterId gpuTime;
+			LveCounterId deviceAllocations;
+			LveCounterId pendingDeletions;
+			LveCounterId startupTime;
+			LveCounterId firstFrameTime;
+			//Per memory heap, only with VK_EXT_memory_budget
+			std::vector<LveCounterId> heapUsage;
+			std::vector<LveCounterId> heapBudget;
+		};
+
+		//Simulation side state of one object, only ever touched by the main thread
+		struct SimObject
+		{
+			LveModelHandle model;
+			glm::vec2 position;
+			glm::vec2 velocity;
+			glm::vec3 color;
+			//Layer the object is drawn at, nearer layers hide the ones behind
+			float depth = 0.5f;
+			uint32_t material = 0;
+			//Level of detail drawn last, kept for the hysteresis of the next pick
+			uint32_t lod = 0;
+			uint32_t proxy = LveSpatialIndex::INVALID_PROXY;
+		};
+
+		//A light drifting through the scene, bouncing off the screen edges like the objects
+		struct SimLight
+		{
+			LveLight light;
+			glm::vec2 velocity;
+		};
+
+		//Startup stages, see the constructor for what runs alongside what
+		void createWindows();
+		void createResourceManagers();
+		void readShaderFiles();
+		void createSwapChains();
 		void loadModels();
+		void createSimulation();
+		void createMaterials();
+		void createLighting();
+		void createSceneTarget();
 		void createPipelineLayout();
 		void createPipeline();
+		void createParticles();
 		void createCommandBuffers();
-		void drawFrame();
+		void createCounters();
+		void createReadback();
+
+		//Main thread
+		void simulate(double dt);
+		LveBounds getObjectBounds(const SimObject& object);
+		void publishSnapshot();
+
+		//Render thread
+		void renderLoop();
+		void recordCommandBuffer(int frameIndex, const std::vector<uint32_t>& imageIndices, const RenderSnapshot& snapshot);
+		//Record callbacks of the graph passes, they draw the snapshot of the frame being recorded
+		void recordScene(VkCommandBuffer commandBuffer, uint32_t phase);
+		void recordOverlays(VkCommandBuffer commandBuffer);
+		void recordUpscale(VkCommandBuffer commandBuffer, RenderGraphResource source);
+		void recordReadback(VkCommandBuffer commandBuffer);
+		void queueObjects(uint32_t pass, LvePipeline* pipeline, const RenderSnapshot& snapshot);
+		void drawObjectBounds(VkCommandBuffer commandBuffer, const RenderSnapshot& snapshot);
+		void drawFrame(const RenderSnapshot& snapshot);
+		void updateCounters();
 
-		LveWindow lveWindow{ WIDTH, HEIGHT, "Hello Vulkan!" };
-		LveDevice lveDevice{ lveWindow };
-		LveSwapChain lveSwapChain{ lveDevice, lveWindow.getExtent() };
-		std::unique_ptr<LvePipeline> lvePipeline;
+		//Scene setting: lay down depth with a cheap position only pass first, so the main pass shades
+		//every pixel about once no matter how much overdraw the scene has
+		bool depthPrePassEnabled = false;
+		//Objects whose model is still streaming in are drawn with the placeholder instead of skipped
+		bool drawPlaceholders = true;
+		//Keeps the render thread on one core so the OS scheduler does not move it between frames
+		bool pinRenderThread = false;
+		//Debug view coloring every object by its material index, a specialization constant of the fragment shader
+		bool showMaterialIndex = false;
+		//Prints the draw and bind counts of the render queue every few seconds
+		bool printRenderStats = false;
+		//Skips the draws hidden behind nearer objects, tested on the GPU against a depth pyramid
+		bool occlusionCullingEnabled = true;
+		//GPU particles stepped on the compute queue, overlapping the graphics of the previous frame
+		bool particlesEnabled = true;
+		//Debug view outlining the bounds every object is culled and picked a level of detail with
+		bool showObjectBounds = false;
+		//Appends the engine counters as JSON lines to COUNTERS_TARGET, for monitoring long runs
+		bool exportCounters = false;
+		//Writes every presented frame, and the scene depth, to an image file without stalling, e.g. for
+		//video or to compare against golden images. Frames are dropped when the disk cannot keep up.
+		bool dumpFrames = false;
+		bool dumpDepth = false;
+		//Shows the scene in a second window as well (another monitor, an editor viewport), both
+		//presented with the same submit and present
+		bool secondWindowEnabled = false;
+		//Graph passes that are a render pass of their own are drawn without render pass and framebuffer
+		//objects when the device has dynamic rendering, their pipelines then only depend on the attachment
+		//formats. Passes merged into subpasses keep a render pass: with postProcessingEnabled that is the
+		//scene, so this only changes the scene passes with post processing off.
+		bool dynamicRenderingEnabled = true;
+		//Tonemapping and color grading as subpasses of the scene render pass, then bloom in compute
+		bool postProcessingEnabled = true;
+		//Prints how long every startup stage took, and when the first frame was presented
+		bool printStartupTimes = true;
+
+		//Workers shared by every system that wants to go wide (simulation, culling, decoding...)
+		LveJobSystem jobSystem;
+		//Draws, uploads, memory and frame times, added to from any thread and merged once per frame
+		LveCounters counters;
+
+		//Everything from here on is created by the startup stages in the constructor, the order of the
+		//members is still the order they are destroyed in
+		std::unique_ptr<LveWindow> lveWindow;
+		//Null unless secondWindowEnabled. Both windows outlive the device, it releases their surfaces.
+		std::unique_ptr<LveWindow> secondWindow;
+		std::unique_ptr<LveDevice> lveDevice;
+		std::unique_ptr<LveSwapChain> lveSwapChain;
+		//Null unless secondWindowEnabled
+		std::unique_ptr<LveSwapChain> secondSwapChain;
+		//Every swap chain, lveSwapChain first, acquired and presented together each frame
+		std::unique_ptr<LvePresentGroup> presentGroup;
+		//Image of each swap chain of the frame being drawn, render thread only
+		std::vector<uint32_t> imageIndices;
+		std::unique_ptr<LveAssetManager> assetManager;
+		std::unique_ptr<LveTextureCache> textureCache;
+		//Every set layout goes through here, pipeline layouts are built from the cached ones
+		std::unique_ptr<LveDescriptorLayoutCache> descriptorLayouts;
+		//Sets that only live for one frame, reset wholesale when the frame slot comes around again
+		std::unique_ptr<LveFrameDescriptorAllocator> frameDescriptors;
+		//Sets that live as long as the app, written once
+		std::unique_ptr<LveDescriptorSetCache> descriptorSets;
+		//Geometry rebuilt on the CPU every frame (debug lines), written straight into mapped memory
+		std::unique_ptr<LveStreamingBuffer> streamingBuffer;
+		//Every texture and storage buffer the shaders can see, null when the device has no descriptor indexing
+		std::unique_ptr<LveBindlessTable> bindlessTable;
+		uint32_t defaultMaterial = 0;
+		//Set 1 of the scene pipelines, the lights are assigned to clusters at the start of every frame
+		std::unique_ptr<LveClusteredLighting> clusteredLighting;
+		//Every pass of the frame, from the scene to the readback. Declared first so the targets adding
+		//passes to it are destroyed before it.
+		std::unique_ptr<LveRenderGraph> renderGraph;
+		//Each swap chain's image, imported into renderGraph and set to the acquired one every frame
+		std::vector<RenderGraphResource> swapChainImages;
+		std::unique_ptr<LveDynamicResolution> sceneTarget;
+		//Null unless postProcessingEnabled, its passes follow the scene passes in renderGraph
+		std::unique_ptr<LvePostProcess> postProcess;
+		//Null when disabled or the depth format cannot be sampled
+		std::unique_ptr<LveOcclusionCuller> occlusionCuller;
+		//Owns every pipeline, one per combination of shaders, specialization constants and state
+		std::unique_ptr<LvePipelineVariantCache> pipelineVariants;
+		//SPIR-V read while the device is being created, handed to pipelineVariants before the pipelines
+		std::vector<std::pair<std::string, std::vector<char>>> shaderFiles;
+		LvePipeline* lvePipeline = nullptr;
+		LvePipeline* depthPrePassPipeline = nullptr;
+		LvePipeline* particlePipeline = nullptr;
+		LvePipeline* boundsPipeline = nullptr;
+		std::unique_ptr<LveParticleSystem> particleSystem;
+		//Time of the last particle step, render thread only
+		std::chrono::steady_clock::time_point lastParticleStep;
 		VkPipelineLayout pipelineLayout;
 		std::vector<VkCommandBuffer> commandBuffers;
-		std::unique_ptr<LveModel> lveModel;
+		//Draws of the frame being recorded, render thread only
+		LveRenderQueue renderQueue;
+		//What the graph passes record from, only set while renderGraph executes
+		const RenderSnapshot* recordingSnapshot = nullptr;
+		int recordingFrameIndex = 0;
+		uint64_t renderedFrames = 0;
+		CounterIds counterIds;
+		//Null unless exportCounters is set
+		std::unique_ptr<LveCounterExporter> counterExporter;
+		//Render thread only, reused every frame
+		std::vector<MemoryHeapUsage> heapUsage;
+		std::chrono::steady_clock::time_point lastFrameEnd;
+		//Null unless dumpFrames or dumpDepth is set
+		std::unique_ptr<LveReadback> readback;
+		//Null unless the app was started with --capture
+		std::unique_ptr<LveCaptureWriter> captureWriter;
+		//Tiny model created up front, stands in for models that are not loaded yet
+		std::unique_ptr<LveModel> placeholderModel;
+		LveModelHandle triangleModel = INVALID_MODEL_HANDLE;
+		LveModelHandle quadModel = INVALID_MODEL_HANDLE;
+		LveModelHandle circleModel = INVALID_MODEL_HANDLE;
+
+		std::vector<SimObject> simObjects;
+		std::vector<SimLight> simLights;
+		//Bounds of every object, refitted each step, only the ones overlapping the view go into the snapshot
+		LveSpatialIndex spatialIndex{ jobSystem };
+		//Object of each proxy of spatialIndex
+		std::vector<uint32_t> proxyObjects;
+		//Reused every publishSnapshot
+		std::vector<uint32_t> visibleProxies;
+		LveLodSelector lodSelector;
+		uint64_t simulationStep = 0;
+		double simulationTime = 0.0;
+
+		//Hand-off between the simulation (producer) and the render thread (consumer)
+		LveTripleBuffer<RenderSnapshot> snapshots;
+		//Step of the snapshot the render thread started its latest frame with, see LveAssetManager::releaseUnloaded
+		std::atomic<uint64_t> drawnStep{ 0 };
+		std::atomic<bool> renderThreadRunning{ false };
+		//Set by the render thread before it stops, rethrown on the main thread
+		std::exception_ptr renderThreadError;
 	};//end class FirstApp
 }  // namespace lve 
@@ -0,0 +1,223 @@
+#include "lve_asset_manager.h"
+
+#include "lve_mesh_simplifier.h"
+
+//std
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace lve
+{
+	LveAssetManager::LveAssetManager(LveDevice& device, LveJobSystem& jobSystem, LveCounters* counters)
+		: lveDevice{ device }, jobSystem{ jobSystem }, counters{ counters }, slots{ std::make_unique<Slot[]>(MAX_MODELS) }
+	{
+		if (counters)
+		{
+			modelsLoadedCounter = counters->addCounter("models_loaded");
+			bytesUploadedCounter = counters->addCounter("model_bytes_uploaded");
+		}//end if
+	}//constructor
+
+	LveAssetManager::~LveAssetManager()
+	{
+		//Loads still in flight write into the slots, let them land before freeing anything
+		jobSystem.wait(loads);
+		uint32_t count = modelCount.load();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			slots[i].owner.reset();
+		}//end for
+	}//destructor
+
+	LveModelHandle LveAssetManager::loadModel(const std::string& filepath)
+	{
+		return loadModel(filepath, [filepath]() { return readObjFile(filepath); });
+	}//end loadModel
+
+	LveModelHandle LveAssetManager::loadModel(const std::string& name, VertexSource source)
+	{
+		std::lock_guard<std::mutex> lock{ handlesMutex };
+		auto found = handlesByName.find(name);
+		if (found != handlesByName.end())
+		{
+			return found->second;
+		}//end if
+		LveModelHandle handle = startLoad(name, std::move(source));
+		handlesByName.emplace(name, handle);
+		return handle;
+	}//end loadModel
+
+	LveModel* LveAssetManager::getModel(LveModelHandle handle) const
+	{
+		if (handle >= modelCount.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}//end if
+		//Pairs with the release store of the loading job, the buffers are fully written once seen
+		return slots[handle].model.load(std::memory_order_acquire);
+	}//end getModel
+
+	bool LveAssetManager::hasFailed(LveModelHandle handle) const
+	{
+		return handle < modelCount.load(std::memory_order_acquire) && slots[handle].failed.load();
+	}//end hasFailed
+
+	bool LveAssetManager::unloadModel(LveModelHandle handle)
+	{
+		if (handle >= modelCount.load(std::memory_order_acquire))
+		{
+			return false;
+		}//end if
+		Slot& slot = slots[handle];
+		if (slot.model.load(std::memory_order_acquire) == nullptr && !slot.failed.load())
+		{
+			//The loading job still owns the slot
+			return false;
+		}//end if
+		{
+			std::lock_guard<std::mutex> lock{ handlesMutex };
+			handlesByName.erase(slot.name);
+		}
+		slot.model.store(nullptr, std::memory_order_release);
+		//Cleared so a second unload of the handle is refused like a load in flight
+		slot.failed = false;
+		unloadedModels.push_back({ handle, std::move(slot.owner) });
+		return true;
+	}//end unloadModel
+
+	void LveAssetManager::releaseUnloaded(uint64_t publishedStep, uint64_t drawnStep)
+	{
+		for (auto& unloaded : unloadedModels)
+		{
+			unloaded.step = publishedStep;
+			retiringModels.push_back(std::move(unloaded));
+		}//end for
+		unloadedModels.clear();
+
+		//The render thread may still be recording from a snapshot older than drawnStep, but once it has
+		//started on drawnStep it is done with those. ~LveModel hands the buffers to the device's deletion
+		//queue tagged with the frame after the current one, which covers the last frame that drew them.
+		auto firstKept = std::stable_partition(retiringModels.begin(), retiringModels.end(), [drawnStep](const RetiringModel& retiring)
+		{
+			return retiring.step <= drawnStep;
+		});
+		if (firstKept == retiringModels.begin())
+		{
+			return;
+		}//end if
+		{
+			//Nothing can reach the slots anymore, the next loads take them
+			std::lock_guard<std::mutex> lock{ handlesMutex };
+			for (auto it = retiringModels.begin(); it != firstKept; ++it)
+			{
+				freeSlots.push_back(it->handle);
+			}//end for
+		}
+		retiringModels.erase(retiringModels.begin(), firstKept);
+	}//end releaseUnloaded
+
+	LveModelHandle LveAssetManager::startLoad(const std::string& name, VertexSource source)
+	{
+		//Called with handlesMutex held, which guards freeSlots
+		LveModelHandle handle;
+		if (!freeSlots.empty())
+		{
+			handle = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else
+		{
+			if (modelCount.load() >= MAX_MODELS)
+			{
+				throw std::runtime_error("too many models requested!");
+			}//end if
+			handle = modelCount.fetch_add(1, std::memory_order_acq_rel);
+		}//end if
+		pendingLoads.fetch_add(1);
+		slots[handle].name = name;
+
+		jobSystem.run([this, handle, name, source = std::move(source)]()
+		{
+			Slot& slot = slots[handle];
+			try
+			{
+				//Decode, build the LOD chain, then upload every level straight into the vertex buffer
+				std::vector<LveModel::Vertex> vertices = source();
+				slot.owner = std::make_unique<LveModel>(lveDevice, LveMeshSimplifier::buildLodChain(vertices));
+				if (counters)
+				{
+					//Added on the worker, merged with the other threads at the end of the frame
+					counters->add(modelsLoadedCounter);
+					counters->add(bytesUploadedCounter, sizeof(LveModel::Vertex) * slot.owner->getVertexCount());
+				}//end if
+				slot.model.store(slot.owner.get(), std::memory_order_release);
+			}//end try
+			catch (const std::exception& e)
+			{
+				//Nobody is there to catch it on a worker, the object just never gets its model
+				slot.failed = true;
+				std::cerr << "failed to load model " << name << ": " << e.what() << "\n";
+			}//end catch
+			pendingLoads.fetch_sub(1);
+		}, &loads);
+
+		return handle;
+	}//end startLoad
+
+	std::vector<LveModel::Vertex> LveAssetManager::readObjFile(const std::string& filepath)
+	{
+		std::ifstream file{ filepath };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open file: " + filepath);
+		}//end if
+
+		std::vector<glm::vec2> positions;
+		std::vector<LveModel::Vertex> vertices;
+		std::string line;
+		while (std::getline(file, line))
+		{
+			std::istringstream stream{ line };
+			std::string type;
+			stream >> type;
+			if (type == "v")
+			{
+				glm::vec2 position{};
+				stream >> position.x >> position.y;
+				positions.push_back(position);
+			}
+			else if (type == "f")
+			{
+				//Faces are triangulated as a fan, only the position index of v/vt/vn is used
+				std::vector<uint32_t> face;
+				std::string corner;
+				while (stream >> corner)
+				{
+					int index = std::stoi(corner.substr(0, corner.find('/')));
+					//Negative indices count back from the last position read
+					int resolved = index < 0 ? static_cast<int>(positions.size()) + index : index - 1;
+					if (resolved < 0 || resolved >= static_cast<int>(positions.size()))
+					{
+						throw std::runtime_error("face index out of range in " + filepath);
+					}//end if
+					face.push_back(static_cast<uint32_t>(resolved));
+				}//end while
+				for (size_t i = 2; i < face.size(); i++)
+				{
+					vertices.push_back({ positions[face[0]] });
+					vertices.push_back({ positions[face[i - 1]] });
+					vertices.push_back({ positions[face[i]] });
+				}//end for
+			}//end if
+		}//end while
+
+		if (vertices.size() < 3)
+		{
+			throw std::runtime_error("no faces in " + filepath);
+		}//end if
+		return vertices;
+	}//end readObjFile
+}//end namespace
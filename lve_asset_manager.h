@@ -0,0 +1,109 @@
+#pragma once
+
+#include "lve_counters.h"
+#include "lve_device.h"
+#include "lve_job_system.h"
+#include "lve_model.h"
+
+//std
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lve
+{
+	//Stable reference to a model that may still be loading
+	using LveModelHandle = uint32_t;
+	static constexpr LveModelHandle INVALID_MODEL_HANDLE = ~0u;
+
+	//Streams models in the background so nothing waits on them before the first frame. Reading,
+	//decoding and LOD generation run as jobs on the job system, and so does the upload: model buffers live in host
+	//visible memory, so filling them is a map and a memcpy with no queue submission to synchronize
+	//with the render thread. A finished model is published with a single atomic store, until then
+	//getModel returns nullptr and the caller draws a placeholder or skips the object.
+	class LveAssetManager
+	{
+	public:
+		static constexpr uint32_t MAX_MODELS = 4096;
+
+		//Produces the vertices of a model, runs on a worker thread
+		using VertexSource = std::function<std::vector<LveModel::Vertex>()>;
+
+		//counters, when given, gets the models loaded and the bytes uploaded by the loading jobs
+		LveAssetManager(LveDevice& device, LveJobSystem& jobSystem, LveCounters* counters = nullptr);
+		~LveAssetManager();
+
+		LveAssetManager(const LveAssetManager&) = delete;
+		LveAssetManager& operator=(const LveAssetManager&) = delete;
+
+		//Starts loading a Wavefront OBJ file (positions and faces only, x/y used). Asking for the same
+		//file again returns the same handle.
+		LveModelHandle loadModel(const std::string& filepath);
+		//Same for vertices produced by code, name identifies the model
+		LveModelHandle loadModel(const std::string& name, VertexSource source);
+
+		//Safe from any thread. nullptr while the model is loading or when it failed to load.
+		LveModel* getModel(LveModelHandle handle) const;
+		bool hasFailed(LveModelHandle handle) const;
+		//Main thread. getModel returns nullptr for the handle from now on and loading the same name
+		//again starts a new load. False while the model is still loading. The slot is handed out again
+		//by a later load once releaseUnloaded has destroyed the model, so the handle must not be kept.
+		bool unloadModel(LveModelHandle handle);
+		//Main thread, right after publishing the snapshot of publishedStep: the models unloaded since the
+		//last call are not referenced by it or anything newer. drawnStep is the step of the snapshot the
+		//render thread started its latest frame with, it never goes back to an older one. A model is
+		//destroyed once that snapshot no longer references it, its buffers only once the frames drawing
+		//them have finished on the GPU (see LveDeletionQueue).
+		void releaseUnloaded(uint64_t publishedStep, uint64_t drawnStep);
+		uint32_t getPendingCount() const { return pendingLoads.load(std::memory_order_relaxed); }
+
+	private:
+		struct Slot
+		{
+			std::atomic<LveModel*> model{ nullptr };
+			std::atomic<bool> failed{ false };
+			std::unique_ptr<LveModel> owner;
+			std::string name;
+		};
+
+		//An unloaded model and its slot, both given back once the render thread is done with them
+		struct RetiringModel
+		{
+			LveModelHandle handle;
+			//Null when the load had failed
+			std::unique_ptr<LveModel> model;
+			//Step of the first snapshot published without the model
+			uint64_t step = 0;
+		};
+
+		LveModelHandle startLoad(const std::string& name, VertexSource source);
+		static std::vector<LveModel::Vertex> readObjFile(const std::string& filepath);
+
+		LveDevice& lveDevice;
+		LveJobSystem& jobSystem;
+		LveCounters* counters;
+		LveCounterId modelsLoadedCounter = 0;
+		LveCounterId bytesUploadedCounter = 0;
+
+		//Fixed array so handles can be resolved by any thread while new loads are added. modelCount
+		//only grows, slots below it are recycled through freeSlots.
+		std::unique_ptr<Slot[]> slots;
+		std::atomic<uint32_t> modelCount{ 0 };
+
+		std::mutex handlesMutex;
+		std::unordered_map<std::string, LveModelHandle> handlesByName;
+		//Slots whose model has been destroyed, reused before modelCount grows. Guarded by handlesMutex.
+		std::vector<LveModelHandle> freeSlots;
+		//Unloaded models waiting for the next releaseUnloaded, main thread only
+		std::vector<RetiringModel> unloadedModels;
+		//Unloaded models tagged with their step, waiting for the render thread, main thread only
+		std::vector<RetiringModel> retiringModels;
+
+		LveJobCounter loads;
+		std::atomic<uint32_t> pendingLoads{ 0 };
+	};//end class LveAssetManager
+}//end namespace
@@ -0,0 +1,206 @@
+#include "lve_bindless.h"
+
+#include "lve_swap_chain.h"
+
+//std
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace lve
+{
+	LveIndexAllocator::LveIndexAllocator(uint32_t capacity, uint32_t framesToRetire)
+		: capacity{ capacity }, retiring(std::max(framesToRetire, 1u))
+	{
+	}//constructor
+
+	uint32_t LveIndexAllocator::allocate()
+	{
+		uint32_t index = INVALID_INDEX;
+		if (!freeList.empty())
+		{
+			index = freeList.back();
+			freeList.pop_back();
+		}
+		else if (nextUnused < capacity)
+		{
+			index = nextUnused++;
+		}//end if
+		if (index != INVALID_INDEX)
+		{
+			allocatedCount++;
+		}//end if
+		return index;
+	}//end allocate
+
+	void LveIndexAllocator::free(uint32_t index)
+	{
+		if (index >= nextUnused)
+		{
+			throw std::runtime_error("freeing a descriptor index that was never allocated!");
+		}//end if
+		retiring[retireFrame].push_back(index);
+		allocatedCount--;
+	}//end free
+
+	void LveIndexAllocator::nextFrame()
+	{
+		//The list about to be reused was filled a full round of frames ago, nothing reads those slots anymore
+		retireFrame = (retireFrame + 1) % static_cast<uint32_t>(retiring.size());
+		freeList.insert(freeList.end(), retiring[retireFrame].begin(), retiring[retireFrame].end());
+		retiring[retireFrame].clear();
+	}//end nextFrame
+
+	LveBindlessTable::LveBindlessTable(LveDevice& device, LveDescriptorLayoutCache& layoutCache, uint32_t maxTextures, uint32_t maxStorageBuffers)
+		: lveDevice{ device },
+		//The table is read by every frame in flight, the one being recorded included
+		textureIndices{ std::min(maxTextures, device.descriptorIndexingProperties.maxDescriptorSetUpdateAfterBindSampledImages), LveSwapChain::MAX_FRAMES_IN_FLIGHT + 1 },
+		storageBufferIndices{ std::min(maxStorageBuffers, device.descriptorIndexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers), LveSwapChain::MAX_FRAMES_IN_FLIGHT + 1 }
+	{
+		if (!lveDevice.isDescriptorIndexingEnabled())
+		{
+			throw std::runtime_error("bindless table needs descriptor indexing!");
+		}//end if
+		createDescriptorSetLayout(layoutCache);
+		createDescriptorPool();
+		allocateDescriptorSet();
+	}//constructor
+
+	LveBindlessTable::~LveBindlessTable()
+	{
+		//Destroying the pool frees the set as well
+		vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+	}//destructor
+
+	void LveBindlessTable::createDescriptorSetLayout(LveDescriptorLayoutCache& layoutCache)
+	{
+		LveDescriptorLayoutInfo layoutInfo{};
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutInfo.bindings.resize(2);
+		auto& bindings = layoutInfo.bindings;
+		bindings[0].binding = TEXTURE_BINDING;
+		bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		bindings[0].descriptorCount = getMaxTextures();
+		bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+		bindings[1].binding = STORAGE_BUFFER_BINDING;
+		bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[1].descriptorCount = getMaxStorageBuffers();
+		bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+		const VkDescriptorBindingFlags flags =
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+		layoutInfo.bindingFlags = { flags, flags };
+		descriptorSetLayout = layoutCache.getLayout(std::move(layoutInfo));
+	}//end createDescriptorSetLayout
+
+	void LveBindlessTable::createDescriptorPool()
+	{
+		std::array<VkDescriptorPoolSize, 2> poolSizes{};
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSizes[0].descriptorCount = getMaxTextures();
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSizes[1].descriptorCount = getMaxStorageBuffers();
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolInfo.maxSets = 1;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+		if (vkCreateDescriptorPool(lveDevice.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create bindless descriptor pool!");
+		}//end if
+	}//end createDescriptorPool
+
+	void LveBindlessTable::allocateDescriptorSet()
+	{
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = descriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &descriptorSetLayout;
+		if (vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, &descriptorSet) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate bindless descriptor set!");
+		}//end if
+	}//end allocateDescriptorSet
+
+	uint32_t LveBindlessTable::addTexture(VkImageView imageView, VkSampler sampler)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		uint32_t index = textureIndices.allocate();
+		if (index == LveIndexAllocator::INVALID_INDEX)
+		{
+			throw std::runtime_error("bindless texture table is full!");
+		}//end if
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.sampler = sampler;
+		imageInfo.imageView = imageView;
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = descriptorSet;
+		write.dstBinding = TEXTURE_BINDING;
+		write.dstArrayElement = index;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.pImageInfo = &imageInfo;
+		vkUpdateDescriptorSets(lveDevice.device(), 1, &write, 0, nullptr);
+		return index;
+	}//end addTexture
+
+	uint32_t LveBindlessTable::addStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		uint32_t index = storageBufferIndices.allocate();
+		if (index == LveIndexAllocator::INVALID_INDEX)
+		{
+			throw std::runtime_error("bindless storage buffer table is full!");
+		}//end if
+
+		VkDescriptorBufferInfo bufferInfo{};
+		bufferInfo.buffer = buffer;
+		bufferInfo.offset = offset;
+		bufferInfo.range = range;
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = descriptorSet;
+		write.dstBinding = STORAGE_BUFFER_BINDING;
+		write.dstArrayElement = index;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		write.pBufferInfo = &bufferInfo;
+		vkUpdateDescriptorSets(lveDevice.device(), 1, &write, 0, nullptr);
+		return index;
+	}//end addStorageBuffer
+
+	void LveBindlessTable::removeTexture(uint32_t index)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		textureIndices.free(index);
+	}//end removeTexture
+
+	void LveBindlessTable::removeStorageBuffer(uint32_t index)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		storageBufferIndices.free(index);
+	}//end removeStorageBuffer
+
+	void LveBindlessTable::nextFrame()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		textureIndices.nextFrame();
+		storageBufferIndices.nextFrame();
+	}//end nextFrame
+
+	void LveBindlessTable::bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t firstSet, VkPipelineBindPoint bindPoint)
+	{
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, firstSet, 1, &descriptorSet, 0, nullptr);
+	}//end bind
+}//end namespace
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "lve_descriptors.h"
+#include "lve_device.h"
+
+//std
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace lve
+{
+	//Hands out slots of a descriptor array. A freed slot may still be read by frames in flight, so
+	//it is only reused once FRAMES_TO_RETIRE calls to nextFrame have gone by.
+	class LveIndexAllocator
+	{
+	public:
+		static constexpr uint32_t INVALID_INDEX = ~0u;
+
+		LveIndexAllocator(uint32_t capacity, uint32_t framesToRetire);
+
+		//INVALID_INDEX when every slot is taken
+		uint32_t allocate();
+		void free(uint32_t index);
+		//Call once per frame, releases the slots freed FRAMES_TO_RETIRE frames ago
+		void nextFrame();
+
+		uint32_t getCapacity() const { return capacity; }
+		uint32_t getAllocatedCount() const { return allocatedCount; }
+
+	private:
+		uint32_t capacity;
+		uint32_t nextUnused = 0;
+		uint32_t allocatedCount = 0;
+		std::vector<uint32_t> freeList;
+		//One list per frame in flight, indexed by retireFrame
+		std::vector<std::vector<uint32_t>> retiring;
+		uint32_t retireFrame = 0;
+	};//end class LveIndexAllocator
+
+	//One descriptor set holding every texture and storage buffer the scene uses, bound once per frame
+	//instead of a set per material. Binding 0 is an array of combined image samplers and binding 1
+	//an array of storage buffers; shaders pick the entry with the index returned here (the material
+	//ID), nonuniformEXT when it varies inside a draw.
+	//The arrays are update-after-bind and partially bound: slots can be written while the set is bound
+	//by command buffers still in flight, as long as those command buffers do not read them, and
+	//unused slots never have to be filled in.
+	//Needs LveDevice::isDescriptorIndexingEnabled.
+	class LveBindlessTable
+	{
+	public:
+		static constexpr uint32_t TEXTURE_BINDING = 0;
+		static constexpr uint32_t STORAGE_BUFFER_BINDING = 1;
+
+		LveBindlessTable(LveDevice& device, LveDescriptorLayoutCache& layoutCache, uint32_t maxTextures, uint32_t maxStorageBuffers);
+		~LveBindlessTable();
+
+		LveBindlessTable(const LveBindlessTable&) = delete;
+		LveBindlessTable& operator=(const LveBindlessTable&) = delete;
+
+		//Safe from any thread, returns the array index shaders use to find the resource
+		uint32_t addTexture(VkImageView imageView, VkSampler sampler);
+		uint32_t addStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+		//The slot keeps pointing at the old resource until it is reused, frames in flight can still read it
+		void removeTexture(uint32_t index);
+		void removeStorageBuffer(uint32_t index);
+
+		//Render thread, once per frame after the fence of the frame slot was waited on
+		void nextFrame();
+		void bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t firstSet = 0, VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+		VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+		uint32_t getMaxTextures() const { return textureIndices.getCapacity(); }
+		uint32_t getMaxStorageBuffers() const { return storageBufferIndices.getCapacity(); }
+
+	private:
+		void createDescriptorSetLayout(LveDescriptorLayoutCache& layoutCache);
+		void createDescriptorPool();
+		void allocateDescriptorSet();
+
+		LveDevice& lveDevice;
+
+		//Owned by the layout cache
+		VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+		std::mutex mutex;
+		LveIndexAllocator textureIndices;
+		LveIndexAllocator storageBufferIndices;
+	};//end class LveBindlessTable
+}//end namespace
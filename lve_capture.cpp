@@ -0,0 +1,621 @@
+#include "lve_capture.h"
+
+#include "lve_clustered_lighting.h"
+#include "lve_descriptors.h"
+#include "lve_dynamic_resolution.h"
+#include "lve_job_system.h"
+#include "lve_readback.h"
+#include "lve_render_graph.h"
+
+//std
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+namespace lve
+{
+	static constexpr uint32_t CAPTURE_MAGIC = 0x4345564C; //"LVEC"
+	static constexpr uint32_t CAPTURE_VERSION = 1;
+	static constexpr uint32_t CAPTURE_FRAMES_IN_FLIGHT = 2;
+
+	enum CaptureChunk : uint32_t
+	{
+		CAPTURE_CHUNK_PIPELINE = 1,
+		CAPTURE_CHUNK_MODEL = 2,
+		CAPTURE_CHUNK_FRAME = 3
+	};
+
+	template<typename T>
+	static void put(std::vector<uint8_t>& out, const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values go into a capture");
+		size_t offset = out.size();
+		out.resize(offset + sizeof(T));
+		std::memcpy(out.data() + offset, &value, sizeof(T));
+	}//end put
+
+	static void putBytes(std::vector<uint8_t>& out, const void* data, size_t size)
+	{
+		put(out, static_cast<uint32_t>(size));
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		out.insert(out.end(), bytes, bytes + size);
+	}//end putBytes
+
+	template<typename T>
+	static void putVector(std::vector<uint8_t>& out, const std::vector<T>& values)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values go into a capture");
+		put(out, static_cast<uint32_t>(values.size()));
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values.data());
+		out.insert(out.end(), bytes, bytes + sizeof(T) * values.size());
+	}//end putVector
+
+	//Reads values back in the order they were put, throws instead of reading past the end
+	class CaptureCursor
+	{
+	public:
+		CaptureCursor(const uint8_t* data, size_t size) : data{ data }, size{ size } {}
+
+		template<typename T>
+		T get()
+		{
+			T value;
+			std::memcpy(&value, take(sizeof(T)), sizeof(T));
+			return value;
+		}//end get
+
+		std::string getString()
+		{
+			uint32_t length = get<uint32_t>();
+			const uint8_t* bytes = take(length);
+			return std::string{ reinterpret_cast<const char*>(bytes), length };
+		}//end getString
+
+		template<typename T>
+		std::vector<T> getVector()
+		{
+			uint32_t count = get<uint32_t>();
+			if (count > (size - offset) / sizeof(T))
+			{
+				throw std::runtime_error("capture file is truncated!");
+			}//end if
+			std::vector<T> values(count);
+			std::memcpy(values.data(), take(sizeof(T) * count), sizeof(T) * count);
+			return values;
+		}//end getVector
+
+		bool atEnd() const { return offset == size; }
+
+	private:
+		const uint8_t* take(size_t count)
+		{
+			if (count > size - offset)
+			{
+				throw std::runtime_error("capture file is truncated!");
+			}//end if
+			const uint8_t* bytes = data + offset;
+			offset += count;
+			return bytes;
+		}//end take
+
+		const uint8_t* data;
+		size_t size;
+		size_t offset = 0;
+	};//end class CaptureCursor
+
+	static void putSpecialization(std::vector<uint8_t>& out, const LveSpecialization& specialization)
+	{
+		putVector(out, specialization.mapEntries);
+		putVector(out, specialization.data);
+	}//end putSpecialization
+
+	static LveSpecialization getSpecialization(CaptureCursor& cursor)
+	{
+		LveSpecialization specialization;
+		specialization.mapEntries = cursor.getVector<VkSpecializationMapEntry>();
+		specialization.data = cursor.getVector<uint8_t>();
+		return specialization;
+	}//end getSpecialization
+
+	//Set 0 stays empty in the replay, so a fragment shader sampling the bindless table
+	//("name_bindless.frag.spv") is swapped for its build without the table ("name.frag.spv")
+	static std::string replayFragFilepath(const std::string& filepath)
+	{
+		const std::string bindlessSuffix = "_bindless.frag.spv";
+		if (filepath.size() > bindlessSuffix.size() &&
+			filepath.compare(filepath.size() - bindlessSuffix.size(), bindlessSuffix.size(), bindlessSuffix) == 0)
+		{
+			return filepath.substr(0, filepath.size() - bindlessSuffix.size()) + ".frag.spv";
+		}//end if
+		return filepath;
+	}//end replayFragFilepath
+
+	LveCapturedPipeline LveCapturedPipeline::fromConfig(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo)
+	{
+		LveCapturedPipeline description{};
+		description.vertFilepath = vertFilepath;
+		description.fragFilepath = fragFilepath;
+		description.topology = configInfo.inputAssemblyInfo.topology;
+		description.cullMode = configInfo.rasterizationInfo.cullMode;
+		description.depthTestEnable = configInfo.depthStencilInfo.depthTestEnable;
+		description.depthWriteEnable = configInfo.depthStencilInfo.depthWriteEnable;
+		description.depthCompareOp = configInfo.depthStencilInfo.depthCompareOp;
+		description.blendEnable = configInfo.colorBlendAttachment.blendEnable;
+		description.colorWriteMask = configInfo.colorBlendAttachment.colorWriteMask;
+		description.bindingDescriptions = configInfo.bindingDescriptions;
+		description.attributeDescriptions = configInfo.attributeDescriptions;
+		description.vertexSpecialization = configInfo.vertexSpecialization;
+		description.fragmentSpecialization = configInfo.fragmentSpecialization;
+		return description;
+	}//end fromConfig
+
+	void LveCapturedPipeline::applyTo(PipelineConfigInfo& configInfo) const
+	{
+		configInfo.inputAssemblyInfo.topology = topology;
+		configInfo.rasterizationInfo.cullMode = cullMode;
+		configInfo.depthStencilInfo.depthTestEnable = depthTestEnable;
+		configInfo.depthStencilInfo.depthWriteEnable = depthWriteEnable;
+		configInfo.depthStencilInfo.depthCompareOp = depthCompareOp;
+		configInfo.colorBlendAttachment.blendEnable = blendEnable;
+		configInfo.colorBlendAttachment.colorWriteMask = colorWriteMask;
+		configInfo.bindingDescriptions = bindingDescriptions;
+		configInfo.attributeDescriptions = attributeDescriptions;
+		configInfo.vertexSpecialization = vertexSpecialization;
+		configInfo.fragmentSpecialization = fragmentSpecialization;
+	}//end applyTo
+
+	LveCaptureWriter::LveCaptureWriter(const std::string& filepath, VkExtent2D extent)
+	{
+		file.open(filepath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open capture file: " + filepath);
+		}//end if
+		std::array<uint32_t, 4> header = { CAPTURE_MAGIC, CAPTURE_VERSION, extent.width, extent.height };
+		file.write(reinterpret_cast<const char*>(header.data()), sizeof(header));
+	}//constructor
+
+	LveCaptureWriter::~LveCaptureWriter()
+	{
+		std::cout << "captured " << frameCount << " frames" << std::endl;
+	}//destructor
+
+	void LveCaptureWriter::addPipeline(const LvePipeline* pipeline, const LveCapturedPipeline& description)
+	{
+		if (pipelineIds.count(pipeline) != 0)
+		{
+			return;
+		}//end if
+		uint32_t id = static_cast<uint32_t>(pipelineIds.size());
+		pipelineIds.emplace(pipeline, id);
+
+		chunk.clear();
+		put(chunk, id);
+		putBytes(chunk, description.vertFilepath.data(), description.vertFilepath.size());
+		putBytes(chunk, description.fragFilepath.data(), description.fragFilepath.size());
+		put(chunk, description.topology);
+		put(chunk, description.cullMode);
+		put(chunk, description.depthTestEnable);
+		put(chunk, description.depthWriteEnable);
+		put(chunk, description.depthCompareOp);
+		put(chunk, description.blendEnable);
+		put(chunk, description.colorWriteMask);
+		putVector(chunk, description.bindingDescriptions);
+		putVector(chunk, description.attributeDescriptions);
+		putSpecialization(chunk, description.vertexSpecialization);
+		putSpecialization(chunk, description.fragmentSpecialization);
+		writeChunk(CAPTURE_CHUNK_PIPELINE);
+	}//end addPipeline
+
+	uint32_t LveCaptureWriter::getModelId(LveModel* model)
+	{
+		auto found = modelIds.find(model);
+		if (found != modelIds.end())
+		{
+			return found->second;
+		}//end if
+		uint32_t id = static_cast<uint32_t>(modelIds.size());
+		modelIds.emplace(model, id);
+
+		//Written the first time a frame draws the model, before that frame
+		chunk.clear();
+		put(chunk, id);
+		auto lods = model->readLods();
+		put(chunk, static_cast<uint32_t>(lods.size()));
+		for (auto& vertices : lods)
+		{
+			putVector(chunk, vertices);
+		}//end for
+		writeChunk(CAPTURE_CHUNK_MODEL);
+		return id;
+	}//end getModelId
+
+	void LveCaptureWriter::writeFrame(const LveRenderQueue& queue)
+	{
+		frameChunk.clear();
+		put(frameChunk, static_cast<uint32_t>(queue.getPackets().size()));
+		uint32_t pushConstantOffset = 0;
+		for (auto& packet : queue.getPackets())
+		{
+			auto pipeline = pipelineIds.find(packet.pipeline);
+			if (pipeline == pipelineIds.end())
+			{
+				throw std::runtime_error("draw with a pipeline that was not added to the capture!");
+			}//end if
+			LveCapturedDraw draw{};
+			draw.pass = packet.pass;
+			draw.pipeline = pipeline->second;
+			draw.model = getModelId(packet.model);
+			draw.lod = packet.lod;
+			draw.depth = packet.depth;
+			draw.pushConstantOffset = pushConstantOffset;
+			draw.pushConstantSize = packet.pushConstantSize;
+			put(frameChunk, draw);
+			pushConstantOffset += packet.pushConstantSize;
+		}//end for
+		put(frameChunk, pushConstantOffset);
+		for (auto& packet : queue.getPackets())
+		{
+			const uint8_t* pushConstants = queue.getPushConstants(packet);
+			frameChunk.insert(frameChunk.end(), pushConstants, pushConstants + packet.pushConstantSize);
+		}//end for
+
+		chunk.swap(frameChunk);
+		writeChunk(CAPTURE_CHUNK_FRAME);
+		chunk.swap(frameChunk);
+		frameCount++;
+	}//end writeFrame
+
+	void LveCaptureWriter::writeChunk(uint32_t type)
+	{
+		std::array<uint32_t, 2> header = { type, static_cast<uint32_t>(chunk.size()) };
+		file.write(reinterpret_cast<const char*>(header.data()), sizeof(header));
+		file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+		if (!file)
+		{
+			throw std::runtime_error("failed to write capture file!");
+		}//end if
+	}//end writeChunk
+
+	LveCaptureReader::LveCaptureReader(const std::string& filepath)
+	{
+		std::ifstream file{ filepath, std::ios::ate | std::ios::binary };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open capture file: " + filepath);
+		}//end if
+		std::vector<uint8_t> contents(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+
+		CaptureCursor cursor{ contents.data(), contents.size() };
+		if (cursor.get<uint32_t>() != CAPTURE_MAGIC || cursor.get<uint32_t>() != CAPTURE_VERSION)
+		{
+			throw std::runtime_error("not a capture file, or one of another version: " + filepath);
+		}//end if
+		extent.width = cursor.get<uint32_t>();
+		extent.height = cursor.get<uint32_t>();
+
+		while (!cursor.atEnd())
+		{
+			uint32_t type = cursor.get<uint32_t>();
+			uint32_t size = cursor.get<uint32_t>();
+			if (type == CAPTURE_CHUNK_PIPELINE)
+			{
+				LveCapturedPipeline pipeline{};
+				if (cursor.get<uint32_t>() != pipelines.size())
+				{
+					throw std::runtime_error("capture pipelines are out of order!");
+				}//end if
+				pipeline.vertFilepath = cursor.getString();
+				pipeline.fragFilepath = cursor.getString();
+				pipeline.topology = cursor.get<VkPrimitiveTopology>();
+				pipeline.cullMode = cursor.get<VkCullModeFlags>();
+				pipeline.depthTestEnable = cursor.get<VkBool32>();
+				pipeline.depthWriteEnable = cursor.get<VkBool32>();
+				pipeline.depthCompareOp = cursor.get<VkCompareOp>();
+				pipeline.blendEnable = cursor.get<VkBool32>();
+				pipeline.colorWriteMask = cursor.get<VkColorComponentFlags>();
+				pipeline.bindingDescriptions = cursor.getVector<VkVertexInputBindingDescription>();
+				pipeline.attributeDescriptions = cursor.getVector<VkVertexInputAttributeDescription>();
+				pipeline.vertexSpecialization = getSpecialization(cursor);
+				pipeline.fragmentSpecialization = getSpecialization(cursor);
+				pipelines.push_back(std::move(pipeline));
+			}
+			else if (type == CAPTURE_CHUNK_MODEL)
+			{
+				if (cursor.get<uint32_t>() != models.size())
+				{
+					throw std::runtime_error("capture models are out of order!");
+				}//end if
+				uint32_t lodCount = cursor.get<uint32_t>();
+				if (lodCount == 0)
+				{
+					throw std::runtime_error("capture model has no levels!");
+				}//end if
+				std::vector<std::vector<LveModel::Vertex>> lods;
+				for (uint32_t i = 0; i < lodCount; i++)
+				{
+					lods.push_back(cursor.getVector<LveModel::Vertex>());
+					if (lods.back().size() < 3)
+					{
+						throw std::runtime_error("capture model level has fewer than 3 vertices!");
+					}//end if
+				}//end for
+				models.push_back(std::move(lods));
+			}
+			else if (type == CAPTURE_CHUNK_FRAME)
+			{
+				LveCapturedFrame frame;
+				frame.draws = cursor.getVector<LveCapturedDraw>();
+				frame.pushConstants = cursor.getVector<uint8_t>();
+				for (auto& draw : frame.draws)
+				{
+					//64 bit sum, an offset and size near 4 GB must not wrap around into range
+					if (draw.pipeline >= pipelines.size() || draw.model >= models.size() ||
+						draw.lod >= models[draw.model].size() ||
+						static_cast<uint64_t>(draw.pushConstantOffset) + draw.pushConstantSize > frame.pushConstants.size())
+					{
+						throw std::runtime_error("capture frame references data it does not have!");
+					}//end if
+				}//end for
+				frames.push_back(std::move(frame));
+			}
+			else
+			{
+				//Written by a newer version, skip what we do not know
+				for (uint32_t i = 0; i < size; i++)
+				{
+					cursor.get<uint8_t>();
+				}//end for
+			}//end if
+		}//end while
+	}//constructor
+
+	void runCaptureReplay(const std::string& filepath, uint32_t repeats, const std::string& dumpPrefix)
+	{
+		LveCaptureReader capture{ filepath };
+		if (capture.getFrames().empty())
+		{
+			throw std::runtime_error("capture has no frames: " + filepath);
+		}//end if
+
+		//No window and no presentation, the frames only go as fast as the GPU takes them
+		LveDevice device{};
+		VkFormat depthFormat = device.findSupportedFormat(
+			{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+		//One scene pass, with dynamic rendering when the device has it
+		LveRenderGraph graph{ device, true };
+		LveDynamicResolution target{
+			device,
+			graph,
+			capture.getExtent(),
+			VK_FORMAT_B8G8R8A8_UNORM,
+			depthFormat,
+			CAPTURE_FRAMES_IN_FLIGHT };
+		//Same workload every frame: the resolution never follows the GPU time
+		target.getSettings().minScale = 1.0f;
+		target.getSettings().maxScale = 1.0f;
+
+		//The lights are not part of the capture: the lit shaders get a lighting set without any lights,
+		//so they shade with the ambient term only. Set 0 (the bindless table in the app) stays empty, the
+		//material textures are not captured either.
+		auto descriptorLayouts = std::make_unique<LveDescriptorLayoutCache>(device);
+		auto descriptorSets = std::make_unique<LveDescriptorSetCache>(device);
+		auto lighting = std::make_unique<LveClusteredLighting>(device, *descriptorLayouts, *descriptorSets, CAPTURE_FRAMES_IN_FLIGHT);
+		std::array<VkDescriptorSetLayout, 2> setLayouts = {
+			descriptorLayouts->getLayout(LveDescriptorLayoutInfo{}),
+			lighting->getDescriptorSetLayout() };
+		const std::vector<LveLight> noLights;
+
+		//Push constants as big as any draw may push, plus the sets above
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = LveRenderQueue::MAX_PUSH_CONSTANT_SIZE;
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		VkPipelineLayout pipelineLayout;
+		if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create replay pipeline layout!");
+		}//end if
+
+		//Recorded by the passes of the graph, filled in before every execute
+		LveRenderQueue renderQueue;
+		uint32_t frameIndex = 0;
+		uint32_t frameNumber = 0;
+		bool dumpFrame = false;
+		target.addScenePass("scene", { 0.1f, 0.1f, 0.1f, 1.0f }).setRecord([&](VkCommandBuffer commandBuffer)
+		{
+			lighting->bind(commandBuffer, pipelineLayout, 1);
+			renderQueue.record(commandBuffer, pipelineLayout, pushConstantRange.stageFlags, 2);
+		});
+
+		//The frames of the first repeat are written out as they were replayed, e.g. as golden images
+		std::unique_ptr<LveJobSystem> jobSystem;
+		std::unique_ptr<LveReadback> readback;
+		if (!dumpPrefix.empty())
+		{
+			jobSystem = std::make_unique<LveJobSystem>();
+			readback = std::make_unique<LveReadback>(
+				device,
+				*jobSystem,
+				static_cast<VkDeviceSize>(capture.getExtent().width) * capture.getExtent().height * 4,
+				CAPTURE_FRAMES_IN_FLIGHT * 4);
+			graph.addPass("readback").readTransfer(target.getColor()).setRecord([&](VkCommandBuffer commandBuffer)
+			{
+				if (!dumpFrame)
+				{
+					return;
+				}//end if
+				LveReadbackSource color{};
+				color.image = target.getColorImage();
+				color.format = target.getColorFormat();
+				color.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+				color.extent = target.getRenderExtent();
+				color.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+				color.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+				color.access = 0;
+				readback->readImage(commandBuffer, frameIndex, color, dumpPrefix + std::to_string(frameNumber) + ".png");
+			});
+		}//end if
+		graph.compile();
+
+		std::vector<LvePipeline*> pipelines;
+		auto variants = std::make_unique<LvePipelineVariantCache>(device);
+		for (auto& description : capture.getPipelines())
+		{
+			PipelineConfigInfo configInfo{};
+			LvePipeline::defaultPipelineConfigInfo(configInfo, capture.getExtent().width, capture.getExtent().height);
+			description.applyTo(configInfo);
+			target.configurePipeline(configInfo);
+			configInfo.pipelineLayout = pipelineLayout;
+			pipelines.push_back(variants->getPipeline(description.vertFilepath, replayFragFilepath(description.fragFilepath), configInfo));
+		}//end for
+		std::vector<std::unique_ptr<LveModel>> models;
+		for (auto& lods : capture.getModels())
+		{
+			models.push_back(std::make_unique<LveModel>(device, lods));
+		}//end for
+
+		std::vector<VkCommandBuffer> commandBuffers(CAPTURE_FRAMES_IN_FLIGHT);
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = device.getCommandPool();
+		allocInfo.commandBufferCount = CAPTURE_FRAMES_IN_FLIGHT;
+		if (vkAllocateCommandBuffers(device.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate replay command buffers!");
+		}//end if
+		std::vector<VkFence> fences(CAPTURE_FRAMES_IN_FLIGHT);
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+		for (auto& fence : fences)
+		{
+			if (vkCreateFence(device.device(), &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create replay fence!");
+			}//end if
+		}//end for
+
+		uint64_t draws = 0;
+		double recordMs = 0.0;
+		double gpuMs = 0.0;
+		uint32_t gpuSamples = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t repeat = 0; repeat < repeats; repeat++)
+		{
+			for (auto& frame : capture.getFrames())
+			{
+				frameIndex = frameNumber % CAPTURE_FRAMES_IN_FLIGHT;
+				vkWaitForFences(device.device(), 1, &fences[frameIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+				vkResetFences(device.device(), 1, &fences[frameIndex]);
+				target.update(frameIndex);
+				if (frameNumber >= CAPTURE_FRAMES_IN_FLIGHT)
+				{
+					gpuMs += target.getSmoothedGpuTimeMs();
+					gpuSamples++;
+				}//end if
+				device.deletionQueue().beginFrame(CAPTURE_FRAMES_IN_FLIGHT);
+				if (readback)
+				{
+					readback->beginFrame(frameIndex);
+				}//end if
+
+				//The same path the app records with: submit, sort, record with redundant binds skipped
+				auto recordStart = std::chrono::steady_clock::now();
+				VkCommandBuffer commandBuffer = commandBuffers[frameIndex];
+				VkCommandBufferBeginInfo beginInfo{};
+				beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+				if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to begin recording command buffer!");
+				}//end if
+				lighting->assignLights(commandBuffer, frameIndex, noLights);
+				renderQueue.clear();
+				for (auto& draw : frame.draws)
+				{
+					renderQueue.submit(
+						draw.pass,
+						pipelines[draw.pipeline],
+						VK_NULL_HANDLE,
+						models[draw.model].get(),
+						draw.lod,
+						draw.depth,
+						frame.pushConstants.data() + draw.pushConstantOffset,
+						draw.pushConstantSize);
+				}//end for
+				renderQueue.sort();
+				dumpFrame = repeat == 0;
+				target.beginTimer(commandBuffer, frameIndex);
+				graph.execute(commandBuffer);
+				target.endTimer(commandBuffer, frameIndex);
+				if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to record command buffer!");
+				}//end if
+
+				VkSubmitInfo submitInfo{};
+				submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+				submitInfo.commandBufferCount = 1;
+				submitInfo.pCommandBuffers = &commandBuffer;
+				if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, fences[frameIndex]) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to submit replay frame!");
+				}//end if
+				recordMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordStart).count();
+				draws += renderQueue.getStats().drawCommands;
+				frameNumber++;
+			}//end for
+		}//end for
+		vkDeviceWaitIdle(device.device());
+		double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "replayed " << frameNumber << " frames (" << capture.getFrames().size() << " x " << repeats << ") in "
+			<< totalMs << " ms: " << totalMs / frameNumber << " ms per frame, "
+			<< recordMs / frameNumber << " ms recording, "
+			<< (gpuSamples > 0 ? gpuMs / gpuSamples : 0.0) << " ms GPU (smoothed), "
+			<< draws / frameNumber << " draws per frame\n";
+
+		if (readback)
+		{
+			//The copies of the last frames are written once their slots come around, the device is idle
+			//so hand them over now
+			for (uint32_t i = 0; i < CAPTURE_FRAMES_IN_FLIGHT; i++)
+			{
+				readback->beginFrame(i);
+			}//end for
+			readback->waitForWrites();
+			LveReadbackStats stats = readback->getStats();
+			readback.reset();
+			std::cout << "dumped " << stats.written << " frames, " << stats.dropped << " dropped, " << stats.failed << " failed\n";
+		}//end if
+
+		for (auto fence : fences)
+		{
+			vkDestroyFence(device.device(), fence, nullptr);
+		}//end for
+		vkFreeCommandBuffers(device.device(), device.getCommandPool(), CAPTURE_FRAMES_IN_FLIGHT, commandBuffers.data());
+		models.clear();
+		variants.reset();
+		lighting.reset();
+		descriptorSets.reset();
+		descriptorLayouts.reset();
+		vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+	}//end runCaptureReplay
+}//end namespace
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "lve_device.h"
+#include "lve_model.h"
+#include "lve_pipeline.h"
+#include "lve_render_queue.h"
+
+//std
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lve
+{
+	//Pipeline state a capture keeps: everything the engine changes on top of
+	//LvePipeline::defaultPipelineConfigInfo, so a replay can build the same variant again
+	struct LveCapturedPipeline
+	{
+		std::string vertFilepath;
+		std::string fragFilepath;
+		VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		VkCullModeFlags cullMode = VK_CULL_MODE_NONE;
+		VkBool32 depthTestEnable = VK_TRUE;
+		VkBool32 depthWriteEnable = VK_TRUE;
+		VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+		VkBool32 blendEnable = VK_FALSE;
+		VkColorComponentFlags colorWriteMask = 0;
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+		LveSpecialization vertexSpecialization;
+		LveSpecialization fragmentSpecialization;
+
+		static LveCapturedPipeline fromConfig(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
+		//Render pass and layout are left to the caller
+		void applyTo(PipelineConfigInfo& configInfo) const;
+	};
+
+	//One draw of the render queue, pipeline and model are indices into the capture
+	struct LveCapturedDraw
+	{
+		uint32_t pass;
+		uint32_t pipeline;
+		uint32_t model;
+		uint32_t lod;
+		float depth;
+		uint32_t pushConstantOffset;
+		uint32_t pushConstantSize;
+	};
+
+	struct LveCapturedFrame
+	{
+		std::vector<LveCapturedDraw> draws;
+		//Push constants of every draw, back to back
+		std::vector<uint8_t> pushConstants;
+	};
+
+	//Writes the high level draw stream of every frame to a compact binary file: the pipelines and
+	//models as they are first used, then per frame the draws submitted to the render queue. Enough to
+	//replay the exact same workload without the app (see runCaptureReplay).
+	//File: "LVEC", version, extent, then chunks of { type, size in bytes, payload }.
+	class LveCaptureWriter
+	{
+	public:
+		LveCaptureWriter(const std::string& filepath, VkExtent2D extent);
+		~LveCaptureWriter();
+
+		LveCaptureWriter(const LveCaptureWriter&) = delete;
+		LveCaptureWriter& operator=(const LveCaptureWriter&) = delete;
+
+		//Every pipeline draws can use has to be added before the first frame using it
+		void addPipeline(const LvePipeline* pipeline, const LveCapturedPipeline& description);
+		//Render thread, once every draw of the frame was submitted. Models are identified by address,
+		//so one must not be unloaded and another loaded in its place while capturing.
+		void writeFrame(const LveRenderQueue& queue);
+
+		uint32_t getFrameCount() const { return frameCount; }
+
+	private:
+		uint32_t getModelId(LveModel* model);
+		void writeChunk(uint32_t type);
+
+		std::ofstream file;
+		std::unordered_map<const LvePipeline*, uint32_t> pipelineIds;
+		std::unordered_map<const LveModel*, uint32_t> modelIds;
+		uint32_t frameCount = 0;
+		//Payload of the chunk being written, reused so capturing a frame does not allocate
+		std::vector<uint8_t> chunk;
+		std::vector<uint8_t> frameChunk;
+	};//end class LveCaptureWriter
+
+	//Loads a whole capture into memory, so replaying it never waits on the disk
+	class LveCaptureReader
+	{
+	public:
+		explicit LveCaptureReader(const std::string& filepath);
+
+		VkExtent2D getExtent() const { return extent; }
+		const std::vector<LveCapturedPipeline>& getPipelines() const { return pipelines; }
+		//Every level of detail of each model
+		const std::vector<std::vector<std::vector<LveModel::Vertex>>>& getModels() const { return models; }
+		const std::vector<LveCapturedFrame>& getFrames() const { return frames; }
+
+	private:
+		VkExtent2D extent{};
+		std::vector<LveCapturedPipeline> pipelines;
+		std::vector<std::vector<std::vector<LveModel::Vertex>>> models;
+		std::vector<LveCapturedFrame> frames;
+	};//end class LveCaptureReader
+
+	//Replays a capture on a headless device as fast as the GPU takes it, repeats times over, and
+	//prints the CPU and GPU time per frame. With a dumpPrefix the frames of the first repeat are read
+	//back to <dumpPrefix><frame>.png. Started with "--replay <file> [repeats] [--dump <prefix>]".
+	void runCaptureReplay(const std::string& filepath, uint32_t repeats, const std::string& dumpPrefix = "");
+}//end namespace
@@ -0,0 +1,202 @@
+#include "lve_clustered_lighting.h"
+
+//std
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve
+{
+	//Push constants of light_cull.comp
+	struct LightCullPushConstantData
+	{
+		uint32_t lightCount;
+		uint32_t lightIndexCapacity;
+	};
+
+	static_assert(sizeof(LveLight) == 32, "LveLight has to match the std430 layout of Light in the shaders");
+
+	LveClusteredLighting::LveClusteredLighting(
+		LveDevice& device,
+		LveDescriptorLayoutCache& layoutCache,
+		LveDescriptorSetCache& setCache,
+		uint32_t framesInFlight)
+		: lveDevice{ device }, frames(framesInFlight)
+	{
+		createPipeline(layoutCache);
+		createBuffers(setCache);
+	}//constructor
+
+	LveClusteredLighting::~LveClusteredLighting()
+	{
+		for (auto& frame : frames)
+		{
+			vkUnmapMemory(lveDevice.device(), frame.lightMemory);
+			vkDestroyBuffer(lveDevice.device(), frame.lightBuffer, nullptr);
+			vkFreeMemory(lveDevice.device(), frame.lightMemory, nullptr);
+		}//end for
+		vkDestroyBuffer(lveDevice.device(), clusterBuffer, nullptr);
+		vkFreeMemory(lveDevice.device(), clusterMemory, nullptr);
+		vkDestroyBuffer(lveDevice.device(), lightIndexBuffer, nullptr);
+		vkFreeMemory(lveDevice.device(), lightIndexMemory, nullptr);
+		cullPipeline.reset();
+		vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+	}//destructor
+
+	void LveClusteredLighting::createPipeline(LveDescriptorLayoutCache& layoutCache)
+	{
+		//Lights, one offset/count pair per cluster, the packed light indices. The compute pass writes
+		//the last two, the fragment shader reads all three through the same layout.
+		LveDescriptorLayoutInfo layoutInfo{};
+		for (uint32_t binding = 0; binding < 3; binding++)
+		{
+			VkDescriptorSetLayoutBinding layoutBinding{};
+			layoutBinding.binding = binding;
+			layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			layoutBinding.descriptorCount = 1;
+			layoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+			layoutInfo.bindings.push_back(layoutBinding);
+		}//end for
+		setLayout = layoutCache.getLayout(layoutInfo);
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(LightCullPushConstantData);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &setLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create light culling pipeline layout!");
+		}//end if
+
+		cullPipeline = std::make_unique<LveComputePipeline>(
+			lveDevice,
+			"shaders/light_cull.comp.spv",
+			pipelineLayout);
+	}//end createPipeline
+
+	void LveClusteredLighting::createBuffers(LveDescriptorSetCache& setCache)
+	{
+		//Only ever touched by the GPU. The index list starts with the count of indices handed out so far,
+		//zeroed before each pass.
+		lveDevice.createBuffer(
+			sizeof(uint32_t) * 2 * CLUSTER_COUNT,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			clusterBuffer,
+			clusterMemory);
+		lveDevice.createBuffer(
+			sizeof(uint32_t) * (1 + LIGHT_INDEX_CAPACITY),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			lightIndexBuffer,
+			lightIndexMemory);
+
+		//Sized for MAX_LIGHTS up front, so the buffers (and the sets pointing at them) never change
+		VkDeviceSize lightsSize = sizeof(LveLight) * MAX_LIGHTS;
+		for (auto& frame : frames)
+		{
+			lveDevice.createBuffer(
+				lightsSize,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				frame.lightBuffer,
+				frame.lightMemory);
+			vkMapMemory(lveDevice.device(), frame.lightMemory, 0, lightsSize, 0, &frame.mappedLights);
+
+			std::array<VkBuffer, 3> buffers = { frame.lightBuffer, clusterBuffer, lightIndexBuffer };
+			std::vector<LveDescriptorWrite> writes(buffers.size());
+			for (uint32_t binding = 0; binding < writes.size(); binding++)
+			{
+				writes[binding].binding = binding;
+				writes[binding].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				writes[binding].bufferInfo.buffer = buffers[binding];
+				writes[binding].bufferInfo.offset = 0;
+				writes[binding].bufferInfo.range = VK_WHOLE_SIZE;
+			}//end for
+			frame.descriptorSet = setCache.getSet(setLayout, writes);
+		}//end for
+	}//end createBuffers
+
+	void LveClusteredLighting::assignLights(VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::vector<LveLight>& lights)
+	{
+		currentFrame = frameIndex;
+		FrameResources& frame = frames[frameIndex];
+		lightCount = static_cast<uint32_t>(std::min<size_t>(lights.size(), MAX_LIGHTS));
+		//Host writes before the submit are visible to it, no barrier needed for the upload
+		if (lightCount > 0)
+		{
+			std::memcpy(frame.mappedLights, lights.data(), sizeof(LveLight) * lightCount);
+		}//end if
+
+		//The lists are shared by every frame in flight: the previous frame's fragments have to be done
+		//reading them before they are cleared and rebuilt
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, 0, nullptr);
+		vkCmdFillBuffer(commandBuffer, lightIndexBuffer, 0, sizeof(uint32_t), 0);
+
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		//One workgroup per cluster, its invocations split the lights between them
+		cullPipeline->bind(commandBuffer);
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			pipelineLayout,
+			0,
+			1,
+			&frame.descriptorSet,
+			0,
+			nullptr);
+		LightCullPushConstantData push{};
+		push.lightCount = lightCount;
+		push.lightIndexCapacity = LIGHT_INDEX_CAPACITY;
+		vkCmdPushConstants(
+			commandBuffer,
+			pipelineLayout,
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			sizeof(LightCullPushConstantData),
+			&push);
+		vkCmdDispatch(commandBuffer, CLUSTER_COUNT, 1, 1);
+
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}//end assignLights
+
+	void LveClusteredLighting::bind(VkCommandBuffer commandBuffer, VkPipelineLayout layout, uint32_t set)
+	{
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			layout,
+			set,
+			1,
+			&frames[currentFrame].descriptorSet,
+			0,
+			nullptr);
+	}//end bind
+}//end namespace
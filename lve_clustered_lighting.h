@@ -0,0 +1,102 @@
+#pragma once
+
+#include "lve_compute_pipeline.h"
+#include "lve_descriptors.h"
+#include "lve_device.h"
+
+//libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+//std
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lve
+{
+	//Point light in the space the scene is drawn in: NDC x/y plus the depth of the layers it lights.
+	//Same layout as Light in light_cull.comp and simple_shader.frag (std430, 32 byte stride).
+	struct LveLight
+	{
+		glm::vec2 position{};
+		float depth = 0.5f;
+		//Distance at which it has faded out completely
+		float radius = 0.1f;
+		glm::vec3 color{ 1.0f };
+		float intensity = 1.0f;
+	};
+
+	//Clustered forward lighting. The view is cut into a grid of clusters (screen tiles times depth
+	//slices), a compute pass tests every light against every cluster once per frame and packs the
+	//indices of the lights reaching each cluster into one list. A fragment then only walks the lights
+	//of its own cluster, so the cost of shading follows how many lights overlap a pixel, not how many
+	//lights there are.
+	//The scene has no perspective, so the clusters are boxes in NDC and the slices are spaced evenly
+	//over the depth range instead of exponentially.
+	class LveClusteredLighting
+	{
+	public:
+		//Must match the constants of light_cull.comp and simple_shader.frag
+		static constexpr uint32_t CLUSTERS_X = 16;
+		static constexpr uint32_t CLUSTERS_Y = 9;
+		static constexpr uint32_t CLUSTERS_Z = 16;
+		static constexpr uint32_t CLUSTER_COUNT = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+		//Lights a cluster keeps at most (which ones is up to the GPU past that), also the workgroup
+		//size of light_cull.comp. Bounds the work of the most crowded pixel.
+		static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 64;
+		static constexpr uint32_t MAX_LIGHTS = 16384;
+		//Length of the packed index list, room for half the maximum in every cluster
+		static constexpr uint32_t LIGHT_INDEX_CAPACITY = CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER / 2;
+
+		LveClusteredLighting(
+			LveDevice& device,
+			LveDescriptorLayoutCache& layoutCache,
+			LveDescriptorSetCache& setCache,
+			uint32_t framesInFlight);
+		~LveClusteredLighting();
+
+		LveClusteredLighting(const LveClusteredLighting&) = delete;
+		LveClusteredLighting& operator=(const LveClusteredLighting&) = delete;
+
+		//Set the fragment shader reads the lights through: lights, cluster ranges, light indices
+		VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout; }
+
+		//Outside a render pass, after the fence of frameIndex was waited on and before the lit draws.
+		//Uploads the lights (past MAX_LIGHTS they are dropped) and builds the cluster lists from them.
+		void assignLights(VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::vector<LveLight>& lights);
+		//The set of the frame assignLights was last called for
+		void bind(VkCommandBuffer commandBuffer, VkPipelineLayout layout, uint32_t set);
+
+		uint32_t getLightCount() const { return lightCount; }
+
+	private:
+		//Host visible and persistently mapped, only written while the slot's fence is signaled
+		struct FrameResources
+		{
+			VkBuffer lightBuffer = VK_NULL_HANDLE;
+			VkDeviceMemory lightMemory = VK_NULL_HANDLE;
+			void* mappedLights = nullptr;
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		};
+
+		void createBuffers(LveDescriptorSetCache& setCache);
+		void createPipeline(LveDescriptorLayoutCache& layoutCache);
+
+		LveDevice& lveDevice;
+
+		std::vector<FrameResources> frames;
+		uint32_t currentFrame = 0;
+		uint32_t lightCount = 0;
+		//Rebuilt every frame and only used within it, the barriers keep frames from overlapping on them
+		VkBuffer clusterBuffer;
+		VkDeviceMemory clusterMemory;
+		VkBuffer lightIndexBuffer;
+		VkDeviceMemory lightIndexMemory;
+
+		VkDescriptorSetLayout setLayout;
+		VkPipelineLayout pipelineLayout;
+		std::unique_ptr<LveComputePipeline> cullPipeline;
+	};//end class LveClusteredLighting
+}//end namespace
@@ -0,0 +1,69 @@
+#include "lve_compute_pipeline.h"
+
+//std
+#include <stdexcept>
+
+namespace lve
+{
+	LveComputePipeline::LveComputePipeline(
+		LveDevice& device,
+		const std::string& compFilepath,
+		VkPipelineLayout pipelineLayout,
+		const LveSpecialization& specialization)
+		: lveDevice{ device }, pipelineLayout{ pipelineLayout }
+	{
+		auto compCode = LvePipeline::readFile(compFilepath);
+		LvePipeline::createShaderModule(lveDevice, compCode, &computeShaderModule);
+
+		VkSpecializationInfo specializationInfo{};
+		specializationInfo.mapEntryCount = static_cast<uint32_t>(specialization.mapEntries.size());
+		specializationInfo.pMapEntries = specialization.mapEntries.data();
+		specializationInfo.dataSize = specialization.data.size();
+		specializationInfo.pData = specialization.data.data();
+
+		VkPipelineShaderStageCreateInfo stageInfo{};
+		stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		stageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		stageInfo.module = computeShaderModule;
+		stageInfo.pName = "main";
+		stageInfo.pSpecializationInfo = specialization.empty() ? nullptr : &specializationInfo;
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = stageInfo;
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineInfo.basePipelineIndex = -1;
+
+		if (vkCreateComputePipelines(lveDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS)
+		{
+			vkDestroyShaderModule(lveDevice.device(), computeShaderModule, nullptr);
+			throw std::runtime_error("failed to create compute pipeline");
+		}//end if
+	}//constructor
+
+	LveComputePipeline::~LveComputePipeline()
+	{
+		vkDestroyShaderModule(lveDevice.device(), computeShaderModule, nullptr);
+		vkDestroyPipeline(lveDevice.device(), computePipeline, nullptr);
+	}//destructor
+
+	void LveComputePipeline::bind(VkCommandBuffer commandBuffer)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+	}//end bind
+
+	void LveComputePipeline::dispatch(VkCommandBuffer commandBuffer, uint32_t count, uint32_t groupSize)
+	{
+		vkCmdDispatch(commandBuffer, (count + groupSize - 1) / groupSize, 1, 1);
+	}//end dispatch
+
+	void LveComputePipeline::dispatch(VkCommandBuffer commandBuffer, VkExtent2D count, VkExtent2D groupSize)
+	{
+		vkCmdDispatch(
+			commandBuffer,
+			(count.width + groupSize.width - 1) / groupSize.width,
+			(count.height + groupSize.height - 1) / groupSize.height,
+			1);
+	}//end dispatch
+}//end namespace
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "lve_device.h"
+#include "lve_pipeline.h"
+
+//std
+#include <string>
+
+namespace lve
+{
+	//Compute counterpart of LvePipeline: one compute shader, its specialization constants and the
+	//layout its descriptor sets and push constants are declared in
+	class LveComputePipeline
+	{
+	public:
+		LveComputePipeline(
+			LveDevice& device,
+			const std::string& compFilepath,
+			VkPipelineLayout pipelineLayout,
+			const LveSpecialization& specialization = LveSpecialization{});
+		~LveComputePipeline();
+
+		LveComputePipeline(const LveComputePipeline&) = delete;
+		LveComputePipeline& operator=(const LveComputePipeline&) = delete;
+
+		void bind(VkCommandBuffer commandBuffer);
+		//Enough workgroups of groupSize invocations to cover count items, the shader skips the rest
+		void dispatch(VkCommandBuffer commandBuffer, uint32_t count, uint32_t groupSize);
+		//Same over a 2D grid, e.g. one invocation per texel
+		void dispatch(VkCommandBuffer commandBuffer, VkExtent2D count, VkExtent2D groupSize);
+
+		VkPipelineLayout getPipelineLayout() const { return pipelineLayout; }
+
+	private:
+		LveDevice& lveDevice;
+		VkPipelineLayout pipelineLayout;
+		VkShaderModule computeShaderModule;
+		VkPipeline computePipeline;
+	};//end class LveComputePipeline
+}//end namespace
@@ -0,0 +1,260 @@
+#include "lve_counters.h"
+
+//std
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace lve
+{
+	namespace
+	{
+		std::atomic<uint64_t> nextRegistrySerial{ 1 };
+
+		//Totals of the registry the thread used last, so add is a compare and a store after the first call
+		struct ThreadTotalsCache
+		{
+			uint64_t serial = 0;
+			void* totals = nullptr;
+		};
+		thread_local ThreadTotalsCache threadTotalsCache;
+	}
+
+	LveCounters::LveCounters() : serial{ nextRegistrySerial.fetch_add(1) }
+	{
+		entries.reserve(MAX_COUNTERS);
+	}//constructor
+
+	LveCounters::~LveCounters()
+	{
+	}//destructor
+
+	LveCounterId LveCounters::addCounter(const std::string& name)
+	{
+		return addEntry(name, false);
+	}//end addCounter
+
+	LveCounterId LveCounters::addGauge(const std::string& name)
+	{
+		return addEntry(name, true);
+	}//end addGauge
+
+	LveCounterId LveCounters::addEntry(const std::string& name, bool gauge)
+	{
+		if (entries.size() >= MAX_COUNTERS)
+		{
+			throw std::runtime_error("too many counters registered!");
+		}//end if
+		entries.push_back({ name, gauge });
+		return static_cast<LveCounterId>(entries.size() - 1);
+	}//end addEntry
+
+	LveCounters::ThreadTotals& LveCounters::getThreadTotals()
+	{
+		if (threadTotalsCache.serial == serial)
+		{
+			return *static_cast<ThreadTotals*>(threadTotalsCache.totals);
+		}//end if
+		std::lock_guard<std::mutex> lock{ threadsMutex };
+		ThreadTotals*& totals = totalsByThread[std::this_thread::get_id()];
+		if (totals == nullptr)
+		{
+			//Kept after the thread exits, what it added still counts
+			threadTotals.push_back(std::make_unique<ThreadTotals>());
+			totals = threadTotals.back().get();
+		}//end if
+		threadTotalsCache.serial = serial;
+		threadTotalsCache.totals = totals;
+		return *totals;
+	}//end getThreadTotals
+
+	void LveCounters::add(LveCounterId counter, uint64_t amount)
+	{
+		//Only this thread writes its totals, endFrame reads them: no read-modify-write needed
+		std::atomic<uint64_t>& total = getThreadTotals().totals[counter];
+		total.store(total.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}//end add
+
+	void LveCounters::set(LveCounterId gauge, double value)
+	{
+		gauges[gauge].store(value, std::memory_order_relaxed);
+	}//end set
+
+	void LveCounters::endFrame()
+	{
+		std::array<uint64_t, MAX_COUNTERS> totals{};
+		{
+			std::lock_guard<std::mutex> lock{ threadsMutex };
+			for (auto& thread : threadTotals)
+			{
+				for (uint32_t i = 0; i < entries.size(); i++)
+				{
+					totals[i] += thread->totals[i].load(std::memory_order_relaxed);
+				}//end for
+			}//end for
+		}
+		for (uint32_t i = 0; i < entries.size(); i++)
+		{
+			if (entries[i].gauge)
+			{
+				values[i] = gauges[i].load(std::memory_order_relaxed);
+			}
+			else
+			{
+				values[i] = static_cast<double>(totals[i] - mergedTotals[i]);
+				mergedTotals[i] = totals[i];
+			}//end if
+		}//end for
+		frame++;
+	}//end endFrame
+
+	LveCounterExporter::LveCounterExporter(const std::string& target, double intervalSeconds)
+		: interval{ intervalSeconds }
+	{
+		start = std::chrono::steady_clock::now();
+		intervalStart = start;
+		const std::string socketPrefix = "unix:";
+		if (target.compare(0, socketPrefix.size(), socketPrefix) == 0)
+		{
+			socketPath = target.substr(socketPrefix.size());
+#ifdef _WIN32
+			throw std::runtime_error("counter export to a unix socket is not supported on this platform!");
+#else
+			//Not fatal, the monitor may come up later
+			connectSocket();
+#endif
+			return;
+		}//end if
+		file.open(target, std::ios::app);
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open counters file: " + target);
+		}//end if
+	}//constructor
+
+	LveCounterExporter::~LveCounterExporter()
+	{
+		closeSocket();
+	}//destructor
+
+	void LveCounterExporter::update(const LveCounters& counters)
+	{
+		for (uint32_t i = 0; i < counters.getCount(); i++)
+		{
+			sums[i] += counters.getValue(i);
+		}//end for
+		intervalFrames++;
+
+		auto now = std::chrono::steady_clock::now();
+		if (std::chrono::duration<double>(now - intervalStart).count() < interval)
+		{
+			return;
+		}//end if
+		write(formatLine(counters, std::chrono::duration<double>(now - start).count()));
+		sums.fill(0.0);
+		intervalFrames = 0;
+		intervalStart = now;
+	}//end update
+
+	std::string LveCounterExporter::formatLine(const LveCounters& counters, double time)
+	{
+		std::ostringstream line;
+		line << "{\"time\":" << time << ",\"frame\":" << counters.getFrame() << ",\"frames\":" << intervalFrames;
+		for (bool gauges : { false, true })
+		{
+			line << (gauges ? ",\"gauges\":{" : ",\"counters\":{");
+			bool first = true;
+			for (uint32_t i = 0; i < counters.getCount(); i++)
+			{
+				if (counters.isGauge(i) != gauges)
+				{
+					continue;
+				}//end if
+				line << (first ? "" : ",") << '"' << counters.getName(i) << "\":" << (gauges ? counters.getValue(i) : sums[i]);
+				first = false;
+			}//end for
+			line << '}';
+		}//end for
+		line << "}\n";
+		return line.str();
+	}//end formatLine
+
+	void LveCounterExporter::write(const std::string& line)
+	{
+		if (socketPath.empty())
+		{
+			//Flushed every line, a soak run that crashes still leaves everything up to its last interval
+			file << line;
+			file.flush();
+			return;
+		}//end if
+#ifndef _WIN32
+		if (socketHandle < 0 && !connectSocket())
+		{
+			return;
+		}//end if
+		int flags = 0;
+#ifdef MSG_NOSIGNAL
+		flags = MSG_NOSIGNAL;
+#endif
+		//Non blocking: a monitor that stops reading drops lines instead of stalling the frame. A line
+		//only partly sent would corrupt the stream, so the connection is dropped and made again.
+		ssize_t sent = send(socketHandle, line.data(), line.size(), flags);
+		if (sent != static_cast<ssize_t>(line.size()))
+		{
+			closeSocket();
+		}//end if
+#endif
+	}//end write
+
+	bool LveCounterExporter::connectSocket()
+	{
+#ifdef _WIN32
+		return false;
+#else
+		sockaddr_un address{};
+		address.sun_family = AF_UNIX;
+		if (socketPath.size() >= sizeof(address.sun_path))
+		{
+			throw std::runtime_error("counters socket path too long: " + socketPath);
+		}//end if
+		socketPath.copy(address.sun_path, socketPath.size());
+
+		socketHandle = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (socketHandle < 0)
+		{
+			return false;
+		}//end if
+#ifdef SO_NOSIGPIPE
+		int noSigPipe = 1;
+		setsockopt(socketHandle, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+		if (connect(socketHandle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+		{
+			closeSocket();
+			return false;
+		}//end if
+		fcntl(socketHandle, F_SETFL, fcntl(socketHandle, F_GETFL, 0) | O_NONBLOCK);
+		std::cout << "exporting counters to " << socketPath << std::endl;
+		return true;
+#endif
+	}//end connectSocket
+
+	void LveCounterExporter::closeSocket()
+	{
+#ifndef _WIN32
+		if (socketHandle >= 0)
+		{
+			close(socketHandle);
+			socketHandle = -1;
+		}//end if
+#endif
+	}//end closeSocket
+}//end namespace
@@ -0,0 +1,120 @@
+#pragma once
+
+//std
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace lve
+{
+	using LveCounterId = uint32_t;
+
+	//Named counters and gauges the engine reports about itself. Counters are summed: every thread
+	//adds to totals of its own with a plain load and store, no lock and no contended cache line, and
+	//endFrame merges the threads once per frame. Gauges just hold the last value set.
+	class LveCounters
+	{
+	public:
+		static constexpr uint32_t MAX_COUNTERS = 64;
+
+		LveCounters();
+		~LveCounters();
+
+		LveCounters(const LveCounters&) = delete;
+		LveCounters& operator=(const LveCounters&) = delete;
+
+		//Register everything before the threads using it start. Names go out as is, so they should
+		//be plain identifiers.
+		LveCounterId addCounter(const std::string& name);
+		LveCounterId addGauge(const std::string& name);
+
+		//Any thread. The first add on a thread registers its totals, later ones never lock.
+		void add(LveCounterId counter, uint64_t amount = 1);
+		//Any thread
+		void set(LveCounterId gauge, double value);
+
+		//One thread, once per frame: what every thread added since the last call becomes the value
+		//of the frame
+		void endFrame();
+
+		uint32_t getCount() const { return static_cast<uint32_t>(entries.size()); }
+		const std::string& getName(LveCounterId id) const { return entries[id].name; }
+		bool isGauge(LveCounterId id) const { return entries[id].gauge; }
+		//Sum of the last merged frame for counters, last value for gauges
+		double getValue(LveCounterId id) const { return values[id]; }
+		uint64_t getFrame() const { return frame; }
+
+	private:
+		//Only written by its thread, read by endFrame
+		struct ThreadTotals
+		{
+			std::array<std::atomic<uint64_t>, MAX_COUNTERS> totals{};
+		};
+
+		struct Entry
+		{
+			std::string name;
+			bool gauge;
+		};
+
+		LveCounterId addEntry(const std::string& name, bool gauge);
+		ThreadTotals& getThreadTotals();
+
+		//Tells registries apart in the per thread cache, even one created where another was freed
+		uint64_t serial;
+		std::vector<Entry> entries;
+		std::array<std::atomic<double>, MAX_COUNTERS> gauges{};
+
+		std::mutex threadsMutex;
+		std::vector<std::unique_ptr<ThreadTotals>> threadTotals;
+		std::unordered_map<std::thread::id, ThreadTotals*> totalsByThread;
+
+		//endFrame only
+		std::array<uint64_t, MAX_COUNTERS> mergedTotals{};
+		std::array<double, MAX_COUNTERS> values{};
+		uint64_t frame = 0;
+	};//end class LveCounters
+
+	//Writes the counters as one JSON object per line, for monitoring long runs:
+	//{"time":12.5,"frame":750,"frames":60,"counters":{"draw_commands":7200,...},"gauges":{"frame_ms":16.6,...}}
+	//counters are summed over the frames of the interval, gauges are the last value.
+	class LveCounterExporter
+	{
+	public:
+		//target is a file the lines are appended to, or "unix:<path>" for a stream socket a monitor
+		//listens on. The socket is reconnected at the next interval whenever it drops.
+		LveCounterExporter(const std::string& target, double intervalSeconds = 1.0);
+		~LveCounterExporter();
+
+		LveCounterExporter(const LveCounterExporter&) = delete;
+		LveCounterExporter& operator=(const LveCounterExporter&) = delete;
+
+		//After LveCounters::endFrame, on the same thread: adds the frame to the interval and writes
+		//the line once the interval is over
+		void update(const LveCounters& counters);
+
+	private:
+		std::string formatLine(const LveCounters& counters, double time);
+		void write(const std::string& line);
+		bool connectSocket();
+		void closeSocket();
+
+		std::string socketPath;
+		std::ofstream file;
+		int socketHandle = -1;
+
+		double interval;
+		std::chrono::steady_clock::time_point start;
+		std::chrono::steady_clock::time_point intervalStart;
+		std::array<double, LveCounters::MAX_COUNTERS> sums{};
+		uint32_t intervalFrames = 0;
+	};//end class LveCounterExporter
+}//end namespace
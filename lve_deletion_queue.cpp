@@ -0,0 +1,108 @@
+#include "lve_deletion_queue.h"
+
+//std
+#include <algorithm>
+#include <vector>
+
+namespace lve
+{
+	LveDeletionQueue::LveDeletionQueue(VkDevice device) : device{ device }
+	{
+	}//constructor
+
+	LveDeletionQueue::~LveDeletionQueue()
+	{
+		flush();
+	}//destructor
+
+	void LveDeletionQueue::release(const LveReleasedResources& resources)
+	{
+		release(resources, currentFrame.load() + 1);
+	}//end release
+
+	void LveDeletionQueue::release(const LveReleasedResources& resources, uint64_t lastUseFrame)
+	{
+		std::lock_guard<std::mutex> lock{ entriesMutex };
+		entries.push_back({ lastUseFrame, resources });
+	}//end release
+
+	void LveDeletionQueue::beginFrame(uint32_t framesInFlight)
+	{
+		uint64_t frame = currentFrame.load() + 1;
+		currentFrame.store(frame);
+		if (frame < framesInFlight)
+		{
+			return;
+		}//end if
+		//The fence waited on belongs to frame - framesInFlight, and a fence signals only after every
+		//earlier submission to the queue has completed too
+		uint64_t completedFrame = frame - framesInFlight;
+
+		//Destroyed outside the lock so releases from other threads never wait on the driver
+		std::vector<LveReleasedResources> retired;
+		{
+			std::lock_guard<std::mutex> lock{ entriesMutex };
+			auto firstPending = std::stable_partition(entries.begin(), entries.end(), [completedFrame](const Entry& entry)
+			{
+				return entry.lastUseFrame <= completedFrame;
+			});
+			for (auto it = entries.begin(); it != firstPending; ++it)
+			{
+				retired.push_back(it->resources);
+			}//end for
+			entries.erase(entries.begin(), firstPending);
+		}
+		for (auto& resources : retired)
+		{
+			destroy(resources);
+		}//end for
+	}//end beginFrame
+
+	void LveDeletionQueue::flush()
+	{
+		std::deque<Entry> all;
+		{
+			std::lock_guard<std::mutex> lock{ entriesMutex };
+			all.swap(entries);
+		}
+		for (auto& entry : all)
+		{
+			destroy(entry.resources);
+		}//end for
+	}//end flush
+
+	size_t LveDeletionQueue::getPendingCount()
+	{
+		std::lock_guard<std::mutex> lock{ entriesMutex };
+		return entries.size();
+	}//end getPendingCount
+
+	void LveDeletionQueue::destroy(const LveReleasedResources& resources)
+	{
+		//Views and pipelines before what they were made from, memory last once nothing is bound to it
+		if (resources.pipeline != VK_NULL_HANDLE)
+		{
+			vkDestroyPipeline(device, resources.pipeline, nullptr);
+		}//end if
+		if (resources.sampler != VK_NULL_HANDLE)
+		{
+			vkDestroySampler(device, resources.sampler, nullptr);
+		}//end if
+		if (resources.imageView != VK_NULL_HANDLE)
+		{
+			vkDestroyImageView(device, resources.imageView, nullptr);
+		}//end if
+		if (resources.image != VK_NULL_HANDLE)
+		{
+			vkDestroyImage(device, resources.image, nullptr);
+		}//end if
+		if (resources.buffer != VK_NULL_HANDLE)
+		{
+			vkDestroyBuffer(device, resources.buffer, nullptr);
+		}//end if
+		if (resources.memory != VK_NULL_HANDLE)
+		{
+			vkFreeMemory(device, resources.memory, nullptr);
+		}//end if
+	}//end destroy
+}//end namespace
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+//std
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace lve
+{
+	//Handles given up together by one object, any of them can be left null
+	struct LveReleasedResources
+	{
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkImage image = VK_NULL_HANDLE;
+		VkImageView imageView = VK_NULL_HANDLE;
+		VkSampler sampler = VK_NULL_HANDLE;
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+	};
+
+	//Destroys Vulkan objects once no frame that may use them is still on the GPU, so releasing
+	//something while frames are in flight never needs vkDeviceWaitIdle. Frames are numbered as they
+	//start, every release is tagged with the last frame that may still use the objects and destroyed
+	//once that frame's fence has been waited on.
+	class LveDeletionQueue
+	{
+	public:
+		explicit LveDeletionQueue(VkDevice device);
+		//Destroys whatever is left, the device has to be idle by then
+		~LveDeletionQueue();
+
+		LveDeletionQueue(const LveDeletionQueue&) = delete;
+		LveDeletionQueue& operator=(const LveDeletionQueue&) = delete;
+
+		//Safe from any thread. By default the objects are kept alive through the frame after the
+		//current one: a frame that already picked up state referencing them may be just starting.
+		void release(const LveReleasedResources& resources);
+		void release(const LveReleasedResources& resources, uint64_t lastUseFrame);
+
+		//Render thread, once the fence of the frame framesInFlight frames back has been waited on:
+		//numbers the new frame and destroys everything whose last use has finished
+		void beginFrame(uint32_t framesInFlight);
+		//Destroys everything released so far, for when the device is known to be idle
+		void flush();
+
+		//Number of the frame being recorded
+		uint64_t getCurrentFrame() const { return currentFrame.load(); }
+		size_t getPendingCount();
+
+	private:
+		struct Entry
+		{
+			uint64_t lastUseFrame;
+			LveReleasedResources resources;
+		};
+
+		void destroy(const LveReleasedResources& resources);
+
+		VkDevice device;
+		std::atomic<uint64_t> currentFrame{ 0 };
+		std::mutex entriesMutex;
+		//Mostly in release order, so retired entries are usually at the front
+		std::deque<Entry> entries;
+	};//end class LveDeletionQueue
+}//end namespace
@@ -0,0 +1,346 @@
+#include "lve_descriptors.h"
+
+//std
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace lve
+{
+	namespace
+	{
+		void hashCombine(size_t& seed, size_t value)
+		{
+			seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		}//end hashCombine
+
+		bool sameBinding(const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b)
+		{
+			return a.binding == b.binding &&
+				a.descriptorType == b.descriptorType &&
+				a.descriptorCount == b.descriptorCount &&
+				a.stageFlags == b.stageFlags;
+		}//end sameBinding
+
+		bool sameWrite(const LveDescriptorWrite& a, const LveDescriptorWrite& b)
+		{
+			return a.binding == b.binding &&
+				a.type == b.type &&
+				a.bufferInfo.buffer == b.bufferInfo.buffer &&
+				a.bufferInfo.offset == b.bufferInfo.offset &&
+				a.bufferInfo.range == b.bufferInfo.range &&
+				a.imageInfo.sampler == b.imageInfo.sampler &&
+				a.imageInfo.imageView == b.imageInfo.imageView &&
+				a.imageInfo.imageLayout == b.imageInfo.imageLayout;
+		}//end sameWrite
+
+		bool isImageDescriptor(VkDescriptorType type)
+		{
+			return type == VK_DESCRIPTOR_TYPE_SAMPLER ||
+				type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
+				type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
+				type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
+				type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+		}//end isImageDescriptor
+	}//end namespace
+
+	bool LveDescriptorLayoutInfo::operator==(const LveDescriptorLayoutInfo& other) const
+	{
+		return flags == other.flags &&
+			bindingFlags == other.bindingFlags &&
+			std::equal(bindings.begin(), bindings.end(), other.bindings.begin(), other.bindings.end(), sameBinding);
+	}//end operator==
+
+	size_t LveDescriptorLayoutInfo::hash() const
+	{
+		size_t seed = std::hash<uint32_t>{}(flags);
+		for (auto& binding : bindings)
+		{
+			//binding, type, count and stages packed into one 64 bit value
+			uint64_t packed = static_cast<uint64_t>(binding.binding) |
+				static_cast<uint64_t>(binding.descriptorType) << 8 |
+				static_cast<uint64_t>(binding.stageFlags) << 16 |
+				static_cast<uint64_t>(binding.descriptorCount) << 32;
+			hashCombine(seed, std::hash<uint64_t>{}(packed));
+		}//end for
+		for (auto bindingFlag : bindingFlags)
+		{
+			hashCombine(seed, std::hash<uint32_t>{}(bindingFlag));
+		}//end for
+		return seed;
+	}//end hash
+
+	LveDescriptorLayoutCache::LveDescriptorLayoutCache(LveDevice& device) : lveDevice{ device }
+	{
+	}//constructor
+
+	LveDescriptorLayoutCache::~LveDescriptorLayoutCache()
+	{
+		for (auto& entry : layouts)
+		{
+			vkDestroyDescriptorSetLayout(lveDevice.device(), entry.second, nullptr);
+		}//end for
+	}//destructor
+
+	VkDescriptorSetLayout LveDescriptorLayoutCache::getLayout(LveDescriptorLayoutInfo info)
+	{
+		if (!info.bindingFlags.empty() && info.bindingFlags.size() != info.bindings.size())
+		{
+			throw std::runtime_error("descriptor binding flags must match the bindings one to one!");
+		}//end if
+		for (auto& binding : info.bindings)
+		{
+			if (binding.pImmutableSamplers != nullptr)
+			{
+				throw std::runtime_error("immutable samplers are not supported by the layout cache!");
+			}//end if
+		}//end for
+
+		//Same bindings listed in another order are the same layout, sort them (and their flags) first
+		if (!std::is_sorted(info.bindings.begin(), info.bindings.end(),
+			[](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; }))
+		{
+			std::vector<size_t> order(info.bindings.size());
+			for (size_t i = 0; i < order.size(); i++)
+			{
+				order[i] = i;
+			}//end for
+			std::sort(order.begin(), order.end(),
+				[&info](size_t a, size_t b) { return info.bindings[a].binding < info.bindings[b].binding; });
+			LveDescriptorLayoutInfo sorted{};
+			sorted.flags = info.flags;
+			for (size_t index : order)
+			{
+				sorted.bindings.push_back(info.bindings[index]);
+				if (!info.bindingFlags.empty())
+				{
+					sorted.bindingFlags.push_back(info.bindingFlags[index]);
+				}//end if
+			}//end for
+			info = std::move(sorted);
+		}//end if
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		auto found = layouts.find(info);
+		if (found != layouts.end())
+		{
+			return found->second;
+		}//end if
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = static_cast<uint32_t>(info.bindingFlags.size());
+		bindingFlagsInfo.pBindingFlags = info.bindingFlags.data();
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = info.bindingFlags.empty() ? nullptr : &bindingFlagsInfo;
+		layoutInfo.flags = info.flags;
+		layoutInfo.bindingCount = static_cast<uint32_t>(info.bindings.size());
+		layoutInfo.pBindings = info.bindings.data();
+
+		VkDescriptorSetLayout layout;
+		if (vkCreateDescriptorSetLayout(lveDevice.device(), &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create descriptor set layout!");
+		}//end if
+		layouts.emplace(std::move(info), layout);
+		return layout;
+	}//end getLayout
+
+	LveDescriptorAllocator::LveDescriptorAllocator(LveDevice& device, uint32_t initialSetsPerPool)
+		: lveDevice{ device },
+		ratios{
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+			{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1.0f } },
+		setsPerPool{ std::max(initialSetsPerPool, 1u) }
+	{
+	}//constructor
+
+	LveDescriptorAllocator::~LveDescriptorAllocator()
+	{
+		//Destroying a pool frees every set allocated from it
+		if (currentPool != VK_NULL_HANDLE)
+		{
+			vkDestroyDescriptorPool(lveDevice.device(), currentPool, nullptr);
+		}//end if
+		for (auto pool : usedPools)
+		{
+			vkDestroyDescriptorPool(lveDevice.device(), pool, nullptr);
+		}//end for
+		for (auto pool : freePools)
+		{
+			vkDestroyDescriptorPool(lveDevice.device(), pool, nullptr);
+		}//end for
+	}//destructor
+
+	VkDescriptorSet LveDescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+	{
+		if (currentPool == VK_NULL_HANDLE)
+		{
+			currentPool = grabPool();
+		}//end if
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = currentPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &layout;
+
+		VkDescriptorSet set;
+		VkResult result = vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, &set);
+		if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+		{
+			//This pool is full, retire it until the next reset and try once more in a fresh one
+			usedPools.push_back(currentPool);
+			currentPool = grabPool();
+			allocInfo.descriptorPool = currentPool;
+			result = vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, &set);
+		}//end if
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate descriptor set!");
+		}//end if
+		return set;
+	}//end allocate
+
+	void LveDescriptorAllocator::reset()
+	{
+		if (currentPool != VK_NULL_HANDLE)
+		{
+			usedPools.push_back(currentPool);
+			currentPool = VK_NULL_HANDLE;
+		}//end if
+		for (auto pool : usedPools)
+		{
+			vkResetDescriptorPool(lveDevice.device(), pool, 0);
+			freePools.push_back(pool);
+		}//end for
+		usedPools.clear();
+	}//end reset
+
+	VkDescriptorPool LveDescriptorAllocator::grabPool()
+	{
+		if (!freePools.empty())
+		{
+			VkDescriptorPool pool = freePools.back();
+			freePools.pop_back();
+			return pool;
+		}//end if
+		//Every new pool is bigger than the last, a busy allocator settles on few large pools
+		VkDescriptorPool pool = createPool(setsPerPool);
+		setsPerPool = std::min(setsPerPool + setsPerPool / 2, MAX_SETS_PER_POOL);
+		return pool;
+	}//end grabPool
+
+	VkDescriptorPool LveDescriptorAllocator::createPool(uint32_t setCount)
+	{
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		for (auto& ratio : ratios)
+		{
+			poolSizes.push_back({ ratio.type, static_cast<uint32_t>(ratio.ratio * setCount) });
+		}//end for
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = 0;
+		poolInfo.maxSets = setCount;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+
+		VkDescriptorPool pool;
+		if (vkCreateDescriptorPool(lveDevice.device(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create descriptor pool!");
+		}//end if
+		return pool;
+	}//end createPool
+
+	LveFrameDescriptorAllocator::LveFrameDescriptorAllocator(LveDevice& device, uint32_t framesInFlight)
+	{
+		for (uint32_t i = 0; i < framesInFlight; i++)
+		{
+			allocators.push_back(std::make_unique<LveDescriptorAllocator>(device));
+		}//end for
+	}//constructor
+
+	void LveFrameDescriptorAllocator::beginFrame(uint32_t frameIndex)
+	{
+		currentFrame = frameIndex;
+		allocators[currentFrame]->reset();
+	}//end beginFrame
+
+	VkDescriptorSet LveFrameDescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+	{
+		return allocators[currentFrame]->allocate(layout);
+	}//end allocate
+
+	bool LveDescriptorSetCache::SetKey::operator==(const SetKey& other) const
+	{
+		return layout == other.layout &&
+			std::equal(writes.begin(), writes.end(), other.writes.begin(), other.writes.end(), sameWrite);
+	}//end operator==
+
+	size_t LveDescriptorSetCache::SetKeyHash::operator()(const SetKey& key) const
+	{
+		size_t seed = std::hash<VkDescriptorSetLayout>{}(key.layout);
+		for (auto& write : key.writes)
+		{
+			hashCombine(seed, std::hash<uint32_t>{}(write.binding));
+			hashCombine(seed, std::hash<VkBuffer>{}(write.bufferInfo.buffer));
+			hashCombine(seed, std::hash<VkDeviceSize>{}(write.bufferInfo.offset));
+			hashCombine(seed, std::hash<VkImageView>{}(write.imageInfo.imageView));
+			hashCombine(seed, std::hash<VkSampler>{}(write.imageInfo.sampler));
+		}//end for
+		return seed;
+	}//end operator()
+
+	LveDescriptorSetCache::LveDescriptorSetCache(LveDevice& device)
+		: lveDevice{ device }, allocator{ device }
+	{
+	}//constructor
+
+	VkDescriptorSet LveDescriptorSetCache::getSet(VkDescriptorSetLayout layout, const std::vector<LveDescriptorWrite>& writes)
+	{
+		SetKey key{ layout, writes };
+		std::lock_guard<std::mutex> lock{ mutex };
+		auto found = sets.find(key);
+		if (found != sets.end())
+		{
+			return found->second;
+		}//end if
+
+		VkDescriptorSet set = allocator.allocate(layout);
+		std::vector<VkWriteDescriptorSet> descriptorWrites(writes.size());
+		for (size_t i = 0; i < writes.size(); i++)
+		{
+			VkWriteDescriptorSet& descriptorWrite = descriptorWrites[i];
+			descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrite.dstSet = set;
+			descriptorWrite.dstBinding = writes[i].binding;
+			descriptorWrite.descriptorCount = 1;
+			descriptorWrite.descriptorType = writes[i].type;
+			if (isImageDescriptor(writes[i].type))
+			{
+				descriptorWrite.pImageInfo = &writes[i].imageInfo;
+			}
+			else
+			{
+				descriptorWrite.pBufferInfo = &writes[i].bufferInfo;
+			}//end if
+		}//end for
+		vkUpdateDescriptorSets(
+			lveDevice.device(),
+			static_cast<uint32_t>(descriptorWrites.size()),
+			descriptorWrites.data(),
+			0,
+			nullptr);
+
+		sets.emplace(std::move(key), set);
+		return set;
+	}//end getSet
+}//end namespace
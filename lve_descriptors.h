@@ -0,0 +1,152 @@
+#pragma once
+
+#include "lve_device.h"
+
+//std
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace lve
+{
+	//Everything that makes two descriptor set layouts interchangeable
+	struct LveDescriptorLayoutInfo
+	{
+		VkDescriptorSetLayoutCreateFlags flags = 0;
+		//Sorted by binding number when the layout is created through the cache
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		//Empty, or one entry per binding (update-after-bind, partially bound...)
+		std::vector<VkDescriptorBindingFlags> bindingFlags;
+
+		bool operator==(const LveDescriptorLayoutInfo& other) const;
+		size_t hash() const;
+	};
+
+	//Hands out one VkDescriptorSetLayout per distinct layout description, so pipelines asking for the
+	//same bindings share a layout (and therefore stay compatible for set binding). Owns the layouts.
+	class LveDescriptorLayoutCache
+	{
+	public:
+		LveDescriptorLayoutCache(LveDevice& device);
+		~LveDescriptorLayoutCache();
+
+		LveDescriptorLayoutCache(const LveDescriptorLayoutCache&) = delete;
+		LveDescriptorLayoutCache& operator=(const LveDescriptorLayoutCache&) = delete;
+
+		//Safe from any thread. Immutable samplers are not supported.
+		VkDescriptorSetLayout getLayout(LveDescriptorLayoutInfo info);
+
+	private:
+		struct LayoutHash
+		{
+			size_t operator()(const LveDescriptorLayoutInfo& info) const { return info.hash(); }
+		};
+
+		LveDevice& lveDevice;
+
+		std::mutex mutex;
+		std::unordered_map<LveDescriptorLayoutInfo, VkDescriptorSetLayout, LayoutHash> layouts;
+	};//end class LveDescriptorLayoutCache
+
+	//Allocates descriptor sets from pools it creates as they fill up, instead of one big pool sized
+	//up front. reset() hands every set back at once by resetting the pools, which is far cheaper
+	//than freeing sets one by one and leaves nothing fragmented.
+	//Not thread safe, give each thread (or frame) its own allocator.
+	class LveDescriptorAllocator
+	{
+	public:
+		//Descriptors of each type per set in a pool, a guess at the typical set
+		struct PoolSizeRatio
+		{
+			VkDescriptorType type;
+			float ratio;
+		};
+
+		LveDescriptorAllocator(LveDevice& device, uint32_t initialSetsPerPool = 64);
+		~LveDescriptorAllocator();
+
+		LveDescriptorAllocator(const LveDescriptorAllocator&) = delete;
+		LveDescriptorAllocator& operator=(const LveDescriptorAllocator&) = delete;
+
+		VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+		//Every set allocated since the last reset becomes invalid, the pools are kept for reuse
+		void reset();
+
+	private:
+		static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+		VkDescriptorPool grabPool();
+		VkDescriptorPool createPool(uint32_t setCount);
+
+		LveDevice& lveDevice;
+		std::vector<PoolSizeRatio> ratios;
+		uint32_t setsPerPool;
+
+		VkDescriptorPool currentPool = VK_NULL_HANDLE;
+		//Pools that ran out since the last reset
+		std::vector<VkDescriptorPool> usedPools;
+		//Reset pools waiting to be used again
+		std::vector<VkDescriptorPool> freePools;
+	};//end class LveDescriptorAllocator
+
+	//One allocator per frame in flight for sets that only live for a frame. A frame's pools are
+	//reset wholesale once its fence has signaled and the GPU is done with every set in them.
+	class LveFrameDescriptorAllocator
+	{
+	public:
+		LveFrameDescriptorAllocator(LveDevice& device, uint32_t framesInFlight);
+
+		//Call after the fence of frameIndex was waited on, before allocating for that frame
+		void beginFrame(uint32_t frameIndex);
+		VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+
+	private:
+		std::vector<std::unique_ptr<LveDescriptorAllocator>> allocators;
+		uint32_t currentFrame = 0;
+	};//end class LveFrameDescriptorAllocator
+
+	//Resources written into one binding of a set
+	struct LveDescriptorWrite
+	{
+		uint32_t binding = 0;
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		VkDescriptorBufferInfo bufferInfo{};
+		VkDescriptorImageInfo imageInfo{};
+	};
+
+	//Long lived sets: asking twice for the same layout with the same resources returns the same set,
+	//written once. The sets live until the cache is destroyed.
+	class LveDescriptorSetCache
+	{
+	public:
+		LveDescriptorSetCache(LveDevice& device);
+
+		LveDescriptorSetCache(const LveDescriptorSetCache&) = delete;
+		LveDescriptorSetCache& operator=(const LveDescriptorSetCache&) = delete;
+
+		//Safe from any thread
+		VkDescriptorSet getSet(VkDescriptorSetLayout layout, const std::vector<LveDescriptorWrite>& writes);
+
+	private:
+		struct SetKey
+		{
+			VkDescriptorSetLayout layout;
+			std::vector<LveDescriptorWrite> writes;
+
+			bool operator==(const SetKey& other) const;
+		};
+
+		struct SetKeyHash
+		{
+			size_t operator()(const SetKey& key) const;
+		};
+
+		LveDevice& lveDevice;
+
+		std::mutex mutex;
+		LveDescriptorAllocator allocator;
+		std::unordered_map<SetKey, VkDescriptorSet, SetKeyHash> sets;
+	};//end class LveDescriptorSetCache
+}//end namespace
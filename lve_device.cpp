@@ -1,6 +1,7 @@
 #include "lve_device.h"
 
 // std headers
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -47,16 +48,33 @@ void DestroyDebugUtilsMessengerEXT(
 }
 
 // class member functions
-LveDevice::LveDevice(LveWindow &window) : window{window} {
+LveDevice::LveDevice(LveWindow &window) : LveDevice{std::vector<LveWindow *>{&window}} {}
+
+LveDevice::LveDevice(const std::vector<LveWindow *> &windows) : windows{windows} {
+  createInstance();
+  setupDebugMessenger();
+  createSurfaces();
+  pickPhysicalDevice();
+  createLogicalDevice();
+  createCommandPool();
+  deletionQueue_ = std::make_unique<LveDeletionQueue>(device_);
+}
+
+LveDevice::LveDevice() {
   createInstance();
   setupDebugMessenger();
-  createSurface();
   pickPhysicalDevice();
   createLogicalDevice();
   createCommandPool();
+  deletionQueue_ = std::make_unique<LveDeletionQueue>(device_);
 }
 
 LveDevice::~LveDevice() {
+  // Everything still waiting for its frames goes first, the device is idle by now
+  deletionQueue_.reset();
+  if (computeCommandPool != commandPool) {
+    vkDestroyCommandPool(device_, computeCommandPool, nullptr);
+  }
   vkDestroyCommandPool(device_, commandPool, nullptr);
   vkDestroyDevice(device_, nullptr);
 
@@ -64,7 +82,10 @@ LveDevice::~LveDevice() {
     DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
   }
 
-  vkDestroySurfaceKHR(instance, surface_, nullptr);
+  // The windows outlive the device, but their surfaces cannot outlive the instance
+  for (auto *window : windows) {
+    window->destroySurface();
+  }
   vkDestroyInstance(instance, nullptr);
 }
 
@@ -79,7 +100,20 @@ void LveDevice::createInstance() {
   appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   appInfo.pEngineName = "No Engine";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_0;
+  // Ask for 1.3 when the loader has it (dynamic rendering is core there), else 1.2 (descriptor
+  // indexing is core there), 1.0 loaders only take 1.0
+  auto enumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+      vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+  uint32_t loaderVersion = VK_API_VERSION_1_0;
+  if (enumerateInstanceVersion != nullptr) {
+    enumerateInstanceVersion(&loaderVersion);
+  }
+  if (loaderVersion >= VK_API_VERSION_1_3) {
+    instanceApiVersion = VK_API_VERSION_1_3;
+  } else {
+    instanceApiVersion = loaderVersion >= VK_API_VERSION_1_2 ? VK_API_VERSION_1_2 : VK_API_VERSION_1_0;
+  }
+  appInfo.apiVersion = instanceApiVersion;
 
   VkInstanceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -137,7 +171,10 @@ void LveDevice::createLogicalDevice() {
   QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+  std::set<uint32_t> uniqueQueueFamilies = {
+      indices.graphicsFamily,
+      indices.presentFamily,
+      indices.computeFamily};
 
   float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -149,18 +186,71 @@ void LveDevice::createLogicalDevice() {
     queueCreateInfos.push_back(queueCreateInfo);
   }
 
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy = VK_TRUE;
+  // Compressed texture families are enabled whenever the device has them
+  deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+  deviceFeatures.textureCompressionASTC_LDR = supportedFeatures.textureCompressionASTC_LDR;
+  deviceFeatures.textureCompressionETC2 = supportedFeatures.textureCompressionETC2;
+  enabledFeatures = deviceFeatures;
+
+  std::vector<const char *> enabledExtensions = getRequiredDeviceExtensions();
+
+  VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+  indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+  descriptorIndexingEnabled = queryDescriptorIndexingSupport();
+  if (descriptorIndexingEnabled) {
+    indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+    if (properties.apiVersion < VK_API_VERSION_1_2) {
+      enabledExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    }
+  }
+
+  // Only a query extension, nothing to turn on besides the extension itself
+  memoryBudgetEnabled = instanceApiVersion >= VK_API_VERSION_1_2 &&
+                        properties.apiVersion >= VK_API_VERSION_1_1 &&
+                        isDeviceExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  if (memoryBudgetEnabled) {
+    enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  }
+
+  VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+  dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+  dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+  dynamicRenderingEnabled = queryDynamicRenderingSupport();
+  if (dynamicRenderingEnabled && std::min(instanceApiVersion, properties.apiVersion) < VK_API_VERSION_1_3) {
+    enabledExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+  }
+
+  // Feature structs of everything turned on, chained
+  void *featureChain = nullptr;
+  if (dynamicRenderingEnabled) {
+    dynamicRenderingFeatures.pNext = featureChain;
+    featureChain = &dynamicRenderingFeatures;
+  }
+  if (descriptorIndexingEnabled) {
+    indexingFeatures.pNext = featureChain;
+    featureChain = &indexingFeatures;
+  }
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  createInfo.pNext = featureChain;
 
   createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
   createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+  createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
   // might not really be necessary anymore because device specific validation layers
   // have been deprecated
@@ -177,6 +267,19 @@ void LveDevice::createLogicalDevice() {
 
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+  vkGetDeviceQueue(device_, indices.computeFamily, 0, &computeQueue_);
+
+  if (dynamicRenderingEnabled) {
+    // Same functions under their core or their extension names, depending on where they came from
+    bool core = std::min(instanceApiVersion, properties.apiVersion) >= VK_API_VERSION_1_3;
+    beginRendering_ = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+        vkGetDeviceProcAddr(device_, core ? "vkCmdBeginRendering" : "vkCmdBeginRenderingKHR"));
+    endRendering_ = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+        vkGetDeviceProcAddr(device_, core ? "vkCmdEndRendering" : "vkCmdEndRenderingKHR"));
+    if (beginRendering_ == nullptr || endRendering_ == nullptr) {
+      throw std::runtime_error("failed to load the dynamic rendering functions!");
+    }
+  }
 }
 
 void LveDevice::createCommandPool() {
@@ -191,18 +294,92 @@ void LveDevice::createCommandPool() {
   if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
     throw std::runtime_error("failed to create command pool!");
   }
+
+  if (!queueFamilyIndices.hasDedicatedCompute()) {
+    computeCommandPool = commandPool;
+    return;
+  }
+  poolInfo.queueFamilyIndex = queueFamilyIndices.computeFamily;
+  if (vkCreateCommandPool(device_, &poolInfo, nullptr, &computeCommandPool) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create compute command pool!");
+  }
 }
 
-void LveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+bool LveDevice::queryDescriptorIndexingSupport() {
+  // Core in 1.2, an extension on 1.1 devices. The feature query itself needs 1.1.
+  if (instanceApiVersion < VK_API_VERSION_1_2 || properties.apiVersion < VK_API_VERSION_1_1) {
+    return false;
+  }
+  if (properties.apiVersion < VK_API_VERSION_1_2 &&
+      !isDeviceExtensionSupported(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+    return false;
+  }
+
+  VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+  indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+  VkPhysicalDeviceFeatures2 features2{};
+  features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features2.pNext = &indexingFeatures;
+  vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+  bool supported = indexingFeatures.shaderSampledImageArrayNonUniformIndexing &&
+                   indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+                   indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind &&
+                   indexingFeatures.descriptorBindingUpdateUnusedWhilePending &&
+                   indexingFeatures.descriptorBindingPartiallyBound &&
+                   indexingFeatures.runtimeDescriptorArray;
+  if (supported) {
+    descriptorIndexingProperties.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties2{};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &descriptorIndexingProperties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+  }
+  return supported;
+}
+
+bool LveDevice::queryDynamicRenderingSupport() {
+  // Core in 1.3, the extension needs 1.2 (it builds on depth stencil resolve)
+  uint32_t version = std::min(instanceApiVersion, properties.apiVersion);
+  if (version < VK_API_VERSION_1_2) {
+    return false;
+  }
+  if (version < VK_API_VERSION_1_3 && !isDeviceExtensionSupported(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) {
+    return false;
+  }
+
+  VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+  dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+  VkPhysicalDeviceFeatures2 features2{};
+  features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features2.pNext = &dynamicRenderingFeatures;
+  vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+  return dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+}
+
+void LveDevice::cmdBeginRendering(VkCommandBuffer commandBuffer, const VkRenderingInfoKHR &renderingInfo) {
+  beginRendering_(commandBuffer, &renderingInfo);
+}
+
+void LveDevice::cmdEndRendering(VkCommandBuffer commandBuffer) { endRendering_(commandBuffer); }
+
+void LveDevice::createSurfaces() {
+  for (auto *window : windows) {
+    window->createSurface(instance);
+  }
+}
 
 bool LveDevice::isDeviceSuitable(VkPhysicalDevice device) {
   QueueFamilyIndices indices = findQueueFamilies(device);
 
   bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-  bool swapChainAdequate = false;
-  if (extensionsSupported) {
-    SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
+  // Nothing to present to when headless
+  // Every window has to get a swap chain, not just the first
+  bool swapChainAdequate = extensionsSupported;
+  for (size_t i = 0; swapChainAdequate && i < windows.size(); i++) {
+    SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device, windows[i]->getSurface());
     swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
   }
 
@@ -261,11 +438,14 @@ bool LveDevice::checkValidationLayerSupport() {
 }
 
 std::vector<const char *> LveDevice::getRequiredExtensions() {
-  uint32_t glfwExtensionCount = 0;
-  const char **glfwExtensions;
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-  std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  std::vector<const char *> extensions;
+  // Surface extensions, glfw is not even initialized without a window
+  if (!isHeadless()) {
+    uint32_t glfwExtensionCount = 0;
+    const char **glfwExtensions;
+    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  }
 
   if (enableValidationLayers) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -297,6 +477,31 @@ void LveDevice::hasGflwRequiredInstanceExtensions() {
   }
 }
 
+std::vector<const char *> LveDevice::getRequiredDeviceExtensions() {
+  if (isHeadless()) {
+    return {};
+  }
+  return deviceExtensions;
+}
+
+bool LveDevice::isDeviceExtensionSupported(const char *extensionName) {
+  uint32_t extensionCount;
+  vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+  std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(
+      physicalDevice,
+      nullptr,
+      &extensionCount,
+      availableExtensions.data());
+
+  for (const auto &extension : availableExtensions) {
+    if (strcmp(extension.extensionName, extensionName) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool LveDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
   uint32_t extensionCount;
   vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
@@ -308,7 +513,10 @@ bool LveDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
       &extensionCount,
       availableExtensions.data());
 
-  std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+  auto requiredDeviceExtensions = getRequiredDeviceExtensions();
+  std::set<std::string> requiredExtensions(
+      requiredDeviceExtensions.begin(),
+      requiredDeviceExtensions.end());
 
   for (const auto &extension : availableExtensions) {
     requiredExtensions.erase(extension.extensionName);
@@ -328,46 +536,65 @@ QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device) {
 
   int i = 0;
   for (const auto &queueFamily : queueFamilies) {
-    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-      indices.graphicsFamily = i;
-      indices.graphicsFamilyHasValue = true;
-    }
-    VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-    if (queueFamily.queueCount > 0 && presentSupport) {
-      indices.presentFamily = i;
-      indices.presentFamilyHasValue = true;
+    if (!indices.isComplete()) {
+      if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        indices.graphicsFamily = i;
+        indices.graphicsFamilyHasValue = true;
+      }
+      // One present queue presents every swap chain, so it has to support the surface of each window
+      VkBool32 presentSupport = true;
+      if (isHeadless()) {
+        presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+      }
+      for (size_t w = 0; presentSupport && w < windows.size(); w++) {
+        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, windows[w]->getSurface(), &presentSupport);
+      }
+      if (queueFamily.queueCount > 0 && presentSupport) {
+        indices.presentFamily = i;
+        indices.presentFamilyHasValue = true;
+      }
     }
-    if (indices.isComplete()) {
-      break;
+    // Compute without graphics is the async compute family, its work overlaps the graphics queue
+    if (!indices.computeFamilyHasValue && queueFamily.queueCount > 0 &&
+        (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) &&
+        !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+      indices.computeFamily = i;
+      indices.computeFamilyHasValue = true;
     }
 
     i++;
   }
 
+  // Graphics families always support compute too
+  if (!indices.computeFamilyHasValue && indices.graphicsFamilyHasValue) {
+    indices.computeFamily = indices.graphicsFamily;
+    indices.computeFamilyHasValue = true;
+  }
+
   return indices;
 }
 
-SwapChainSupportDetails LveDevice::querySwapChainSupport(VkPhysicalDevice device) {
+SwapChainSupportDetails LveDevice::querySwapChainSupport(
+    VkPhysicalDevice device, VkSurfaceKHR surface) {
   SwapChainSupportDetails details;
-  vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface_, &details.capabilities);
+  vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
 
   uint32_t formatCount;
-  vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface_, &formatCount, nullptr);
+  vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
 
   if (formatCount != 0) {
     details.formats.resize(formatCount);
-    vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface_, &formatCount, details.formats.data());
+    vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, details.formats.data());
   }
 
   uint32_t presentModeCount;
-  vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface_, &presentModeCount, nullptr);
+  vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, nullptr);
 
   if (presentModeCount != 0) {
     details.presentModes.resize(presentModeCount);
     vkGetPhysicalDeviceSurfacePresentModesKHR(
         device,
-        surface_,
+        surface,
         &presentModeCount,
         details.presentModes.data());
   }
@@ -403,17 +630,39 @@ uint32_t LveDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags pr
   throw std::runtime_error("failed to find suitable memory type!");
 }
 
+bool LveDevice::hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+  VkPhysicalDeviceMemoryProperties memProperties;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+    if ((typeFilter & (1 << i)) &&
+        (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void LveDevice::createBuffer(
     VkDeviceSize size,
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory) {
+    VkDeviceMemory &bufferMemory,
+    const std::vector<uint32_t> &sharedQueueFamilies) {
+  std::set<uint32_t> uniqueFamilies(sharedQueueFamilies.begin(), sharedQueueFamilies.end());
+  std::vector<uint32_t> families(uniqueFamilies.begin(), uniqueFamilies.end());
+
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
   bufferInfo.usage = usage;
-  bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  if (families.size() > 1) {
+    bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(families.size());
+    bufferInfo.pQueueFamilyIndices = families.data();
+  } else {
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  }
 
   if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
     throw std::runtime_error("failed to create vertex buffer!");
@@ -430,10 +679,45 @@ void LveDevice::createBuffer(
   if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
     throw std::runtime_error("failed to allocate vertex buffer memory!");
   }
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
 
   vkBindBufferMemory(device_, buffer, bufferMemory, 0);
 }
 
+VkMemoryPropertyFlags LveDevice::getMemoryTypeProperties(uint32_t memoryTypeIndex) {
+  VkPhysicalDeviceMemoryProperties memProperties;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+  return memProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+}
+
+void LveDevice::getMemoryHeapUsage(std::vector<MemoryHeapUsage> &heaps) {
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+  budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+  VkPhysicalDeviceMemoryProperties2 memProperties2{};
+  memProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+  if (memoryBudgetEnabled) {
+    memProperties2.pNext = &budgetProperties;
+    vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memProperties2);
+  } else {
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties2.memoryProperties);
+  }
+
+  const VkPhysicalDeviceMemoryProperties &memProperties = memProperties2.memoryProperties;
+  heaps.resize(memProperties.memoryHeapCount);
+  for (uint32_t i = 0; i < memProperties.memoryHeapCount; i++) {
+    heaps[i].size = memProperties.memoryHeaps[i].size;
+    heaps[i].usage = budgetProperties.heapUsage[i];
+    heaps[i].budget = budgetProperties.heapBudget[i];
+    heaps[i].deviceLocal = (memProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+  }
+}
+
+VkFormatProperties LveDevice::getFormatProperties(VkFormat format) {
+  VkFormatProperties props;
+  vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+  return props;
+}
+
 VkCommandBuffer LveDevice::beginSingleTimeCommands() {
   VkCommandBufferAllocateInfo allocInfo{};
   allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -525,6 +809,7 @@ void LveDevice::createImageWithInfo(
   if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
     throw std::runtime_error("failed to allocate image memory!");
   }
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
 
   if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
     throw std::runtime_error("failed to bind image memory!");
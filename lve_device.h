@@ -1,8 +1,11 @@
 #pragma once
 
+#include "lve_deletion_queue.h"
 #include "lve_window.h"
 
 // std lib headers
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -17,9 +20,21 @@ struct SwapChainSupportDetails {
 struct QueueFamilyIndices {
   uint32_t graphicsFamily;
   uint32_t presentFamily;
+  // A compute only family when the device has one (async compute), the graphics family otherwise
+  uint32_t computeFamily;
   bool graphicsFamilyHasValue = false;
   bool presentFamilyHasValue = false;
+  bool computeFamilyHasValue = false;
   bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
+  bool hasDedicatedCompute() { return computeFamilyHasValue && computeFamily != graphicsFamily; }
+};
+
+// Bytes of one memory heap, usage and budget cover every process using the device
+struct MemoryHeapUsage {
+  VkDeviceSize size;
+  VkDeviceSize usage;
+  VkDeviceSize budget;
+  bool deviceLocal;
 };
 
 class LveDevice {
@@ -31,6 +46,13 @@ class LveDevice {
 #endif
 
   LveDevice(LveWindow &window);
+  // Presents to every window in windows, e.g. a second monitor or an editor viewport. Each window
+  // gets its surface from the device, and the physical device and present queue are picked so
+  // they can present to all of those surfaces.
+  LveDevice(const std::vector<LveWindow *> &windows);
+  // Headless: no surface and no swap chain, for offscreen work such as replaying captures. The
+  // present queue is the graphics queue.
+  LveDevice();
   ~LveDevice();
 
   // Not copyable or movable
@@ -40,24 +62,54 @@ class LveDevice {
   LveDevice &operator=(LveDevice &&) = delete;
 
   VkCommandPool getCommandPool() { return commandPool; }
+  // Command buffers for computeQueue, which may belong to another family than the graphics queue
+  VkCommandPool getComputeCommandPool() { return computeCommandPool; }
   VkDevice device() { return device_; }
-  VkSurfaceKHR surface() { return surface_; }
+  bool isHeadless() { return windows.empty(); }
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
-
-  SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
+  // Runs alongside the graphics queue when the device has a dedicated compute family, otherwise it
+  // is the graphics queue itself
+  VkQueue computeQueue() { return computeQueue_; }
+  // Objects released while frames may still use them are destroyed through here, see LveDeletionQueue
+  LveDeletionQueue &deletionQueue() { return *deletionQueue_; }
+
+  SwapChainSupportDetails getSwapChainSupport(VkSurfaceKHR surface) {
+    return querySwapChainSupport(physicalDevice, surface);
+  }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+  bool hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+  // All the flags of a memory type, e.g. whether the type findMemoryType picked is also coherent
+  VkMemoryPropertyFlags getMemoryTypeProperties(uint32_t memoryTypeIndex);
+  VkFormatProperties getFormatProperties(VkFormat format);
+  bool isDeviceExtensionSupported(const char *extensionName);
+  // Update-after-bind, partially bound, runtime sized descriptor arrays (bindless resource tables)
+  bool isDescriptorIndexingEnabled() { return descriptorIndexingEnabled; }
+  // VK_EXT_memory_budget, without it getMemoryHeapUsage only knows the heap sizes
+  bool isMemoryBudgetEnabled() { return memoryBudgetEnabled; }
+  // VK_KHR_dynamic_rendering (core in 1.3): passes draw straight into image views between
+  // cmdBeginRendering and cmdEndRendering, without render pass or framebuffer objects
+  bool isDynamicRenderingEnabled() { return dynamicRenderingEnabled; }
+  void cmdBeginRendering(VkCommandBuffer commandBuffer, const VkRenderingInfoKHR &renderingInfo);
+  void cmdEndRendering(VkCommandBuffer commandBuffer);
+  // Fills heaps (reused between calls) with one entry per memory heap
+  void getMemoryHeapUsage(std::vector<MemoryHeapUsage> &heaps);
+  // Device memory allocations made through createBuffer and createImageWithInfo so far
+  uint64_t getAllocationCount() { return allocationCount.load(std::memory_order_relaxed); }
   QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
   VkFormat findSupportedFormat(
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
   // Buffer Helper Functions
+  // Buffers used by queues of more than one family (graphics and async compute) list them in
+  // sharedQueueFamilies, they are then shared concurrently instead of needing ownership transfers
   void createBuffer(
       VkDeviceSize size,
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      VkDeviceMemory &bufferMemory,
+      const std::vector<uint32_t> &sharedQueueFamilies = {});
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -71,14 +123,20 @@ class LveDevice {
       VkDeviceMemory &imageMemory);
 
   VkPhysicalDeviceProperties properties;
+  // Optional features actually turned on, e.g. block compressed texture formats
+  VkPhysicalDeviceFeatures enabledFeatures{};
+  // Only filled in when descriptor indexing is enabled
+  VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties{};
 
  private:
   void createInstance();
   void setupDebugMessenger();
-  void createSurface();
+  void createSurfaces();
   void pickPhysicalDevice();
   void createLogicalDevice();
   void createCommandPool();
+  bool queryDescriptorIndexingSupport();
+  bool queryDynamicRenderingSupport();
 
   // helper functions
   bool isDeviceSuitable(VkPhysicalDevice device);
@@ -88,18 +146,32 @@ class LveDevice {
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
   void hasGflwRequiredInstanceExtensions();
   bool checkDeviceExtensionSupport(VkPhysicalDevice device);
-  SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
+  SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
+  // deviceExtensions, minus the swap chain when headless
+  std::vector<const char *> getRequiredDeviceExtensions();
 
   VkInstance instance;
   VkDebugUtilsMessengerEXT debugMessenger;
   VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-  LveWindow &window;
+  // Windows presented to, each owns the surface the device created for it
+  std::vector<LveWindow *> windows;
   VkCommandPool commandPool;
+  VkCommandPool computeCommandPool;
 
   VkDevice device_;
-  VkSurfaceKHR surface_;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  VkQueue computeQueue_;
+  std::unique_ptr<LveDeletionQueue> deletionQueue_;
+
+  // Version the instance was created with, device level features above 1.0 also depend on it
+  uint32_t instanceApiVersion = VK_API_VERSION_1_0;
+  bool descriptorIndexingEnabled = false;
+  bool memoryBudgetEnabled = false;
+  bool dynamicRenderingEnabled = false;
+  PFN_vkCmdBeginRenderingKHR beginRendering_ = nullptr;
+  PFN_vkCmdEndRenderingKHR endRendering_ = nullptr;
+  std::atomic<uint64_t> allocationCount{0};
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
   const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
@@ -0,0 +1,216 @@
+#include "lve_dynamic_resolution.h"
+
+//std
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+namespace lve
+{
+	LveDynamicResolution::LveDynamicResolution(
+		LveDevice& device,
+		LveRenderGraph& graph,
+		VkExtent2D fullExtent,
+		VkFormat colorFormat,
+		VkFormat depthFormat,
+		uint32_t framesInFlight)
+		: lveDevice{ device }, graph{ graph }, fullExtent{ fullExtent }, renderExtent{ fullExtent }, colorFormat{ colorFormat }, depthFormat{ depthFormat }
+	{
+		queriesWritten.resize(framesInFlight, false);
+		RenderGraphImageInfo imageInfo{};
+		imageInfo.extent = fullExtent;
+		imageInfo.format = colorFormat;
+		color = graph.createImage("scene color", imageInfo);
+		imageInfo.format = depthFormat;
+		depth = graph.createImage("scene depth", imageInfo);
+		createQueryPool();
+	}//end constructor
+
+	LveDynamicResolution::~LveDynamicResolution()
+	{
+		if (queryPool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(lveDevice.device(), queryPool, nullptr);
+		}//end if
+	}//end destructor
+
+	RenderGraphPass& LveDynamicResolution::addScenePass(const std::string& name, VkClearColorValue clearColor)
+	{
+		RenderGraphPass& pass = graph.addPass(name)
+			.writeColor(color, clearColor)
+			.writeDepth(depth, { 1.0f, 0 })
+			.setRenderArea(renderExtent);
+		scenePasses.push_back(&pass);
+		return pass;
+	}//end addScenePass
+
+	RenderGraphPass& LveDynamicResolution::addResumePass(const std::string& name)
+	{
+		//Same attachments in the same order as the first pass, only loaded instead of cleared
+		RenderGraphPass& pass = graph.addPass(name)
+			.writeColor(color)
+			.writeDepth(depth)
+			.setRenderArea(renderExtent);
+		scenePasses.push_back(&pass);
+		return pass;
+	}//end addResumePass
+
+	void LveDynamicResolution::configurePipeline(PipelineConfigInfo& configInfo)
+	{
+		if (scenePasses.empty())
+		{
+			throw std::runtime_error("scene target has no scene pass!");
+		}//end if
+		scenePasses.front()->configurePipeline(configInfo);
+	}//end configurePipeline
+
+	void LveDynamicResolution::createQueryPool()
+	{
+		//Without timestamps there is nothing to drive the controller, so the scale simply stays at max
+		timestampsSupported = lveDevice.properties.limits.timestampComputeAndGraphics == VK_TRUE;
+		if (!timestampsSupported)
+		{
+			return;
+		}//end if
+
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = static_cast<uint32_t>(queriesWritten.size() * 2);
+
+		if (vkCreateQueryPool(lveDevice.device(), &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create timestamp query pool!");
+		}//end if
+	}//end createQueryPool
+
+	void LveDynamicResolution::update(uint32_t frameIndex)
+	{
+		if (timestampsSupported && queriesWritten[frameIndex])
+		{
+			readGpuTime(frameIndex);
+		}//end if
+		for (auto pass : scenePasses)
+		{
+			pass->setRenderArea(renderExtent);
+		}//end for
+	}//end update
+
+	void LveDynamicResolution::readGpuTime(uint32_t frameIndex)
+	{
+		//The fence of this frame slot has signaled, so the results are available and we never wait here
+		std::array<uint64_t, 2> timestamps{};
+		VkResult result = vkGetQueryPoolResults(
+			lveDevice.device(),
+			queryPool,
+			frameIndex * 2,
+			2,
+			sizeof(timestamps),
+			timestamps.data(),
+			sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS)
+		{
+			return;
+		}//end if
+
+		//timestampPeriod is the number of nanoseconds per timestamp tick
+		double ticks = static_cast<double>(timestamps[1] - timestamps[0]);
+		float gpuTimeMs = static_cast<float>(ticks * lveDevice.properties.limits.timestampPeriod / 1000000.0);
+		applyGpuTime(gpuTimeMs);
+	}//end readGpuTime
+
+	void LveDynamicResolution::applyGpuTime(float gpuTimeMs)
+	{
+		if (smoothedGpuTimeMs <= 0.0f)
+		{
+			smoothedGpuTimeMs = gpuTimeMs;
+		}
+		else
+		{
+			smoothedGpuTimeMs += (gpuTimeMs - smoothedGpuTimeMs) * settings.smoothing;
+		}//end else
+
+		//Hysteresis: a sample inside the band resets both counters, so small oscillations around the budget never move the scale
+		if (smoothedGpuTimeMs > settings.frameBudgetMs * settings.overBudget)
+		{
+			framesOverBudget++;
+			framesUnderBudget = 0;
+		}
+		else if (smoothedGpuTimeMs < settings.frameBudgetMs * settings.underBudget)
+		{
+			framesUnderBudget++;
+			framesOverBudget = 0;
+		}
+		else
+		{
+			framesOverBudget = 0;
+			framesUnderBudget = 0;
+		}//end else
+
+		float newScale = scale;
+		if (framesOverBudget >= settings.framesBeforeScaleDown)
+		{
+			//Scene cost grows with the pixel count (scale squared), so jump straight to the scale that fits the budget
+			newScale = scale * std::sqrt(settings.frameBudgetMs * settings.underBudget / smoothedGpuTimeMs);
+		}
+		else if (framesUnderBudget >= settings.framesBeforeScaleUp)
+		{
+			newScale = scale + settings.scaleUpStep;
+		}//end else if
+		newScale = std::clamp(newScale, settings.minScale, settings.maxScale);
+
+		if (newScale != scale)
+		{
+			//Predict the time at the new scale so the average doesn't push the controller a second time
+			smoothedGpuTimeMs *= (newScale * newScale) / (scale * scale);
+			scale = newScale;
+			framesOverBudget = 0;
+			framesUnderBudget = 0;
+			renderExtent.width = std::max(1u, static_cast<uint32_t>(fullExtent.width * scale));
+			renderExtent.height = std::max(1u, static_cast<uint32_t>(fullExtent.height * scale));
+		}//end if
+	}//end applyGpuTime
+
+	void LveDynamicResolution::beginTimer(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		if (!timestampsSupported)
+		{
+			return;
+		}//end if
+		vkCmdResetQueryPool(commandBuffer, queryPool, frameIndex * 2, 2);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, frameIndex * 2);
+		queriesWritten[frameIndex] = true;
+	}//end beginTimer
+
+	void LveDynamicResolution::endTimer(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		if (timestampsSupported)
+		{
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, frameIndex * 2 + 1);
+		}//end if
+	}//end endTimer
+
+	void LveDynamicResolution::blit(VkCommandBuffer commandBuffer, VkImage source, VkImage destination, VkExtent2D destinationExtent)
+	{
+		//The graph put both images in their transfer layouts, the previous contents of the destination
+		//are irrelevant, all of it is overwritten
+		VkImageBlit blit{};
+		blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		blit.srcOffsets[0] = { 0, 0, 0 };
+		blit.srcOffsets[1] = { static_cast<int32_t>(renderExtent.width), static_cast<int32_t>(renderExtent.height), 1 };
+		blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		blit.dstOffsets[0] = { 0, 0, 0 };
+		blit.dstOffsets[1] = { static_cast<int32_t>(destinationExtent.width), static_cast<int32_t>(destinationExtent.height), 1 };
+		vkCmdBlitImage(
+			commandBuffer,
+			source,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			destination,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1,
+			&blit,
+			VK_FILTER_LINEAR);
+	}//end blit
+}//end namespace
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "lve_device.h"
+#include "lve_pipeline.h"
+#include "lve_render_graph.h"
+
+//std
+#include <string>
+#include <vector>
+
+namespace lve
+{
+	//Knobs for the resolution controller. The budget is GPU time for the whole render graph (scene,
+	//post processing and the upscale), measured around LveRenderGraph::execute.
+	struct DynamicResolutionSettings
+	{
+		float frameBudgetMs = 14.0f;
+		float minScale = 0.5f;
+		float maxScale = 1.0f;
+		//Hysteresis band: scale down above budget*overBudget, scale up only below budget*underBudget
+		float overBudget = 1.0f;
+		float underBudget = 0.8f;
+		//How many consecutive frames have to agree before the scale changes, slow to grow, fast to shrink
+		int framesBeforeScaleDown = 3;
+		int framesBeforeScaleUp = 60;
+		float scaleUpStep = 0.05f;
+		//Weight of the newest sample in the exponential moving average of the GPU time
+		float smoothing = 0.2f;
+	};
+
+	//Offscreen scene target whose rendered area follows the GPU frame time. Color and depth are images
+	//of the render graph, allocated once at the full size: only the render area of the scene passes
+	//shrinks, so changing the scale never re-creates anything. The scene is then upscaled into the swap
+	//chain image with a blit. Whether the scene passes use a render pass or dynamic rendering, and
+	//whether the depth is kept after them, is up to the graph.
+	class LveDynamicResolution
+	{
+	public:
+		LveDynamicResolution(
+			LveDevice& device,
+			LveRenderGraph& graph,
+			VkExtent2D fullExtent,
+			VkFormat colorFormat,
+			VkFormat depthFormat,
+			uint32_t framesInFlight);
+		~LveDynamicResolution();
+
+		LveDynamicResolution(const LveDynamicResolution&) = delete;
+		LveDynamicResolution& operator=(const LveDynamicResolution&) = delete;
+
+		//A pass drawing the scene at the current scale, clearing color and depth
+		RenderGraphPass& addScenePass(const std::string& name, VkClearColorValue clearColor);
+		//A pass drawing more of the scene into what the passes before left, e.g. after compute that reads
+		//the depth drawn so far. Pipelines made for one scene pass work in all of them.
+		RenderGraphPass& addResumePass(const std::string& name);
+		//Makes a pipeline draw in the scene passes, only after the graph is compiled
+		void configurePipeline(PipelineConfigInfo& configInfo);
+
+		RenderGraphResource getColor() { return color; }
+		RenderGraphResource getDepth() { return depth; }
+		//The images only exist once the graph is compiled
+		VkImage getColorImage() { return graph.getImage(color); }
+		VkImageView getColorImageView() { return graph.getImageView(color); }
+		VkFormat getColorFormat() { return colorFormat; }
+		VkImage getDepthImage() { return graph.getImage(depth); }
+		VkImageView getDepthImageView() { return graph.getImageView(depth); }
+		VkFormat getDepthFormat() { return depthFormat; }
+		VkExtent2D getFullExtent() { return fullExtent; }
+		VkExtent2D getRenderExtent() { return renderExtent; }
+		float getScale() { return scale; }
+		float getSmoothedGpuTimeMs() { return smoothedGpuTimeMs; }
+		DynamicResolutionSettings& getSettings() { return settings; }
+
+		//Reads back the GPU time the frame slot measured last time it was used and sets the render area
+		//of the scene passes. Must be called after the slot's fence has been waited on (i.e. after
+		//LveSwapChain::acquireNextImage).
+		void update(uint32_t frameIndex);
+
+		//Around LveRenderGraph::execute, the time in between drives the scale
+		void beginTimer(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+		void endTimer(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+		//Upscales the rendered area of source (in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, rendered area in
+		//its top left corner) into the whole destination (in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL). Inside
+		//a graph pass that reads source and writes destination as transfers.
+		void blit(VkCommandBuffer commandBuffer, VkImage source, VkImage destination, VkExtent2D destinationExtent);
+
+	private:
+		void createQueryPool();
+		void readGpuTime(uint32_t frameIndex);
+		void applyGpuTime(float gpuTimeMs);
+
+		LveDevice& lveDevice;
+		LveRenderGraph& graph;
+		DynamicResolutionSettings settings;
+
+		VkExtent2D fullExtent;
+		VkExtent2D renderExtent;
+		VkFormat colorFormat;
+		VkFormat depthFormat;
+		RenderGraphResource color;
+		RenderGraphResource depth;
+		std::vector<RenderGraphPass*> scenePasses;
+
+		//Two timestamps (start/end of the graph) per frame in flight
+		VkQueryPool queryPool = VK_NULL_HANDLE;
+		std::vector<bool> queriesWritten;
+		bool timestampsSupported = false;
+
+		float scale = 1.0f;
+		float smoothedGpuTimeMs = 0.0f;
+		int framesOverBudget = 0;
+		int framesUnderBudget = 0;
+	};//end class LveDynamicResolution
+}//end namespace
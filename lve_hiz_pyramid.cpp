@@ -0,0 +1,270 @@
+#include "lve_hiz_pyramid.h"
+
+//std
+#include <algorithm>
+#include <stdexcept>
+
+namespace lve
+{
+	//Push constants of hiz_downsample.comp
+	struct DownsamplePushConstantData
+	{
+		int32_t sourceSize[2];
+		int32_t destinationSize[2];
+	};
+
+	static uint32_t previousPowerOfTwo(uint32_t value)
+	{
+		uint32_t result = 1;
+		while (result * 2 <= value)
+		{
+			result *= 2;
+		}//end while
+		return result;
+	}//end previousPowerOfTwo
+
+	LveHiZPyramid::LveHiZPyramid(
+		LveDevice& device,
+		LveDescriptorLayoutCache& layoutCache,
+		LveDescriptorSetCache& setCache,
+		VkImageView depthView,
+		VkExtent2D depthExtent)
+		: lveDevice{ device }
+	{
+		extent.width = previousPowerOfTwo(depthExtent.width);
+		extent.height = previousPowerOfTwo(depthExtent.height);
+		levelCount = 1;
+		while ((std::max(extent.width, extent.height) >> levelCount) > 0)
+		{
+			levelCount++;
+		}//end while
+
+		createImage();
+		createSampler();
+		createPipeline(layoutCache);
+		createDescriptorSets(setCache, depthView);
+	}//constructor
+
+	LveHiZPyramid::~LveHiZPyramid()
+	{
+		downsamplePipeline.reset();
+		vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+		vkDestroySampler(lveDevice.device(), sampler, nullptr);
+		for (auto view : levelViews)
+		{
+			vkDestroyImageView(lveDevice.device(), view, nullptr);
+		}//end for
+		vkDestroyImageView(lveDevice.device(), pyramidView, nullptr);
+		vkDestroyImage(lveDevice.device(), image, nullptr);
+		vkFreeMemory(lveDevice.device(), imageMemory, nullptr);
+	}//destructor
+
+	bool LveHiZPyramid::isSupported(LveDevice& device, VkFormat depthFormat)
+	{
+		//R32_SFLOAT storage images are always there, sampling depth is not
+		VkFormatProperties properties = device.getFormatProperties(depthFormat);
+		return (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+	}//end isSupported
+
+	void LveHiZPyramid::createImage()
+	{
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = VK_FORMAT_R32_SFLOAT;
+		imageInfo.extent.width = extent.width;
+		imageInfo.extent.height = extent.height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = levelCount;
+		imageInfo.arrayLayers = 1;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		lveDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = levelCount;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+		if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &pyramidView) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create depth pyramid view!");
+		}//end if
+
+		levelViews.resize(levelCount);
+		viewInfo.subresourceRange.levelCount = 1;
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			viewInfo.subresourceRange.baseMipLevel = level;
+			if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &levelViews[level]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create depth pyramid level view!");
+			}//end if
+		}//end for
+
+		//GENERAL for good: every level is written as a storage image and read back by the next one
+		VkCommandBuffer commandBuffer = lveDevice.beginSingleTimeCommands();
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = levelCount;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+		lveDevice.endSingleTimeCommands(commandBuffer);
+	}//end createImage
+
+	void LveHiZPyramid::createSampler()
+	{
+		//Only ever read with texelFetch, the sampler just has to exist
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.mipLodBias = 0.0f;
+		samplerInfo.anisotropyEnable = VK_FALSE;
+		samplerInfo.maxAnisotropy = 1.0f;
+		samplerInfo.compareEnable = VK_FALSE;
+		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+		samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+		samplerInfo.unnormalizedCoordinates = VK_FALSE;
+		if (vkCreateSampler(lveDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create depth pyramid sampler!");
+		}//end if
+	}//end createSampler
+
+	void LveHiZPyramid::createPipeline(LveDescriptorLayoutCache& layoutCache)
+	{
+		LveDescriptorLayoutInfo layoutInfo{};
+		VkDescriptorSetLayoutBinding sourceBinding{};
+		sourceBinding.binding = 0;
+		sourceBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		sourceBinding.descriptorCount = 1;
+		sourceBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		layoutInfo.bindings.push_back(sourceBinding);
+		VkDescriptorSetLayoutBinding destinationBinding{};
+		destinationBinding.binding = 1;
+		destinationBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		destinationBinding.descriptorCount = 1;
+		destinationBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		layoutInfo.bindings.push_back(destinationBinding);
+		setLayout = layoutCache.getLayout(layoutInfo);
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(DownsamplePushConstantData);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &setLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create depth pyramid pipeline layout!");
+		}//end if
+
+		downsamplePipeline = std::make_unique<LveComputePipeline>(
+			lveDevice,
+			"shaders/hiz_downsample.comp.spv",
+			pipelineLayout);
+	}//end createPipeline
+
+	void LveHiZPyramid::createDescriptorSets(LveDescriptorSetCache& setCache, VkImageView depthView)
+	{
+		descriptorSets.resize(levelCount);
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			std::vector<LveDescriptorWrite> writes(2);
+			writes[0].binding = 0;
+			writes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			writes[0].imageInfo.sampler = sampler;
+			writes[0].imageInfo.imageView = level == 0 ? depthView : levelViews[level - 1];
+			writes[0].imageInfo.imageLayout = level == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+			writes[1].binding = 1;
+			writes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			writes[1].imageInfo.imageView = levelViews[level];
+			writes[1].imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			descriptorSets[level] = setCache.getSet(setLayout, writes);
+		}//end for
+	}//end createDescriptorSets
+
+	void LveHiZPyramid::build(VkCommandBuffer commandBuffer, VkExtent2D renderExtent)
+	{
+		//The render graph has the depth sampleable, and the culling that read the old pyramid ended
+		//with a compute to compute barrier, so it is done before the pyramid gets overwritten
+		downsamplePipeline->bind(commandBuffer);
+		VkExtent2D sourceSize = renderExtent;
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			VkExtent2D levelSize{ std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u) };
+
+			vkCmdBindDescriptorSets(
+				commandBuffer,
+				VK_PIPELINE_BIND_POINT_COMPUTE,
+				pipelineLayout,
+				0,
+				1,
+				&descriptorSets[level],
+				0,
+				nullptr);
+
+			DownsamplePushConstantData push{};
+			push.sourceSize[0] = static_cast<int32_t>(sourceSize.width);
+			push.sourceSize[1] = static_cast<int32_t>(sourceSize.height);
+			push.destinationSize[0] = static_cast<int32_t>(levelSize.width);
+			push.destinationSize[1] = static_cast<int32_t>(levelSize.height);
+			vkCmdPushConstants(
+				commandBuffer,
+				pipelineLayout,
+				VK_SHADER_STAGE_COMPUTE_BIT,
+				0,
+				sizeof(DownsamplePushConstantData),
+				&push);
+			downsamplePipeline->dispatch(commandBuffer, levelSize, { WORKGROUP_SIZE, WORKGROUP_SIZE });
+
+			//The next level reads this one, the last barrier makes the whole pyramid visible to later compute
+			VkMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				0, 1, &barrier, 0, nullptr, 0, nullptr);
+			sourceSize = levelSize;
+		}//end for
+
+		built = true;
+	}//end build
+}//end namespace
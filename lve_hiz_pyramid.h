@@ -0,0 +1,75 @@
+#pragma once
+
+#include "lve_compute_pipeline.h"
+#include "lve_descriptors.h"
+#include "lve_device.h"
+
+//std
+#include <memory>
+#include <vector>
+
+namespace lve
+{
+	//Hierarchical depth: a mip chain where every texel holds the farthest depth of the texels below
+	//it. An object whose nearest depth is behind the farthest depth of the few texels covering its
+	//bounds is hidden, whatever its size, so occlusion tests cost four fetches.
+	//Level 0 is the largest power of two size not above the depth target, the render area of the
+	//scene is reduced into it whatever its scale.
+	class LveHiZPyramid
+	{
+	public:
+		//Must match local_size of hiz_downsample.comp
+		static constexpr uint32_t WORKGROUP_SIZE = 8;
+
+		//depthView must outlive the pyramid, the first level is reduced from it
+		LveHiZPyramid(
+			LveDevice& device,
+			LveDescriptorLayoutCache& layoutCache,
+			LveDescriptorSetCache& setCache,
+			VkImageView depthView,
+			VkExtent2D depthExtent);
+		~LveHiZPyramid();
+
+		LveHiZPyramid(const LveHiZPyramid&) = delete;
+		LveHiZPyramid& operator=(const LveHiZPyramid&) = delete;
+
+		//Not every depth format that can be rendered to can also be sampled
+		static bool isSupported(LveDevice& device, VkFormat depthFormat);
+
+		//In a render graph pass that reads the depth as a compute texture. Reduces its renderExtent part
+		//into every level, compute shaders recorded afterwards see the new pyramid.
+		void build(VkCommandBuffer commandBuffer, VkExtent2D renderExtent);
+
+		//Every level, in VK_IMAGE_LAYOUT_GENERAL
+		VkImageView getView() const { return pyramidView; }
+		VkSampler getSampler() const { return sampler; }
+		VkExtent2D getExtent() const { return extent; }
+		uint32_t getLevelCount() const { return levelCount; }
+		//False until the first build, the contents are undefined before that
+		bool isBuilt() const { return built; }
+
+	private:
+		void createImage();
+		void createSampler();
+		void createPipeline(LveDescriptorLayoutCache& layoutCache);
+		void createDescriptorSets(LveDescriptorSetCache& setCache, VkImageView depthView);
+
+		LveDevice& lveDevice;
+		VkExtent2D extent;
+		uint32_t levelCount;
+		bool built = false;
+
+		VkImage image;
+		VkDeviceMemory imageMemory;
+		VkImageView pyramidView;
+		//One view per level, written as storage images and read by the level above
+		std::vector<VkImageView> levelViews;
+		VkSampler sampler;
+
+		VkDescriptorSetLayout setLayout;
+		VkPipelineLayout pipelineLayout;
+		std::unique_ptr<LveComputePipeline> downsamplePipeline;
+		//Set i reads the depth (i == 0) or level i - 1 and writes level i
+		std::vector<VkDescriptorSet> descriptorSets;
+	};//end class LveHiZPyramid
+}//end namespace
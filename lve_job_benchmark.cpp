@@ -0,0 +1,128 @@
+#include "lve_job_benchmark.h"
+#include "lve_job_system.h"
+
+//std
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace lve
+{
+	static constexpr uint32_t JOB_COUNT = 100000;
+	static constexpr uint32_t ELEMENT_COUNT = 1 << 20;
+	static constexpr uint32_t BATCH_SIZE = 256;
+	static constexpr int REPEATS = 5;
+
+	//Stand-in for a tiny unit of work such as testing one object against the frustum
+	static uint32_t tinyWork(uint32_t seed)
+	{
+		uint32_t x = seed | 1u;
+		for (int i = 0; i < 32; i++)
+		{
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+		}//end for
+		return x;
+	}//end tinyWork
+
+	//Best of a few runs, in milliseconds
+	static double measure(const std::function<void()>& function)
+	{
+		double best = 1e30;
+		for (int i = 0; i < REPEATS; i++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			auto end = std::chrono::steady_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+		}//end for
+		return best;
+	}//end measure
+
+	//Halves the range until it is one batch, the way nested parallelism ends up on the worker deques
+	static void splitRange(LveJobSystem& jobSystem, LveJobCounter& counter, std::vector<uint32_t>& results, uint32_t begin, uint32_t end)
+	{
+		while (end - begin > BATCH_SIZE)
+		{
+			uint32_t middle = begin + (end - begin) / 2;
+			jobSystem.run([&jobSystem, &counter, &results, middle, end]() { splitRange(jobSystem, counter, results, middle, end); }, &counter);
+			end = middle;
+		}//end while
+		for (uint32_t i = begin; i < end; i++)
+		{
+			results[i] = tinyWork(i);
+		}//end for
+	}//end splitRange
+
+	void runJobSystemBenchmark()
+	{
+		std::vector<uint32_t> results(ELEMENT_COUNT);
+
+		double serialMs = measure([&]()
+		{
+			for (uint32_t i = 0; i < ELEMENT_COUNT; i++)
+			{
+				results[i] = tinyWork(i);
+			}//end for
+		});
+
+		std::cout << "serial: " << ELEMENT_COUNT << " elements in " << std::fixed << std::setprecision(3) << serialMs << " ms\n";
+		std::cout << "workers | " << JOB_COUNT << " jobs (ms, ns/job) | split " << ELEMENT_COUNT << " (ms) | parallelFor " << ELEMENT_COUNT << " (ms, speedup)\n";
+
+		std::vector<uint32_t> workerCounts;
+		uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+		for (uint32_t count = 1; count < hardwareThreads; count *= 2)
+		{
+			workerCounts.push_back(count);
+		}//end for
+		workerCounts.push_back(hardwareThreads);
+
+		for (uint32_t workerCount : workerCounts)
+		{
+			JobSystemConfig config{};
+			config.workerCount = workerCount;
+			LveJobSystem jobSystem{ config };
+
+			//Every job started from outside the pool, the worst case for the injection queue
+			double jobsMs = measure([&]()
+			{
+				LveJobCounter counter;
+				for (uint32_t i = 0; i < JOB_COUNT; i++)
+				{
+					jobSystem.run([&results, i]() { results[i] = tinyWork(i); }, &counter);
+				}//end for
+				jobSystem.wait(counter);
+			});
+
+			//Jobs spawning jobs, they stay on the worker deques and get stolen
+			double splitMs = measure([&]()
+			{
+				LveJobCounter counter;
+				jobSystem.run([&]() { splitRange(jobSystem, counter, results, 0, ELEMENT_COUNT); }, &counter);
+				jobSystem.wait(counter);
+			});
+
+			double parallelForMs = measure([&]()
+			{
+				jobSystem.parallelFor(ELEMENT_COUNT, BATCH_SIZE, [&results](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t i = begin; i < end; i++)
+					{
+						results[i] = tinyWork(i);
+					}//end for
+				});
+			});
+
+			std::cout << std::setw(7) << workerCount << " | "
+				<< std::setw(10) << jobsMs << " " << std::setw(8) << jobsMs * 1e6 / JOB_COUNT << " | "
+				<< std::setw(10) << splitMs << " | "
+				<< std::setw(10) << parallelForMs << " " << std::setw(6) << serialMs / parallelForMs << "x\n";
+		}//end for
+	}//end runJobSystemBenchmark
+}//end namespace
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace lve
+{
+	//Measures how LveJobSystem scales with the number of workers on thousands of tiny jobs and
+	//prints a table to stdout. Started with "--job-benchmark" on the command line.
+	void runJobSystemBenchmark();
+}//end namespace
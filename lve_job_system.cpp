@@ -0,0 +1,427 @@
+#include "lve_job_system.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+//std
+#include <algorithm>
+#include <iostream>
+
+namespace lve
+{
+	//Which system and which of its workers the calling thread is, -1 for any other thread
+	static thread_local LveJobSystem* currentSystem = nullptr;
+	static thread_local int currentWorker = -1;
+	//Per thread xorshift state to pick steal victims
+	static thread_local uint32_t stealSeed = 0;
+
+	//Idle rounds spent yielding before a worker goes to sleep
+	static constexpr int SPIN_COUNT = 64;
+
+	bool LveWorkStealingDeque::push(LveJob* job)
+	{
+		int64_t b = bottom.load(std::memory_order_relaxed);
+		int64_t t = top.load(std::memory_order_acquire);
+		if (b - t >= CAPACITY)
+		{
+			return false;
+		}//end if
+		buffer[b & MASK].store(job, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return true;
+	}//end push
+
+	LveJob* LveWorkStealingDeque::pop()
+	{
+		int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = top.load(std::memory_order_relaxed);
+
+		if (t > b)
+		{
+			//Empty
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}//end if
+
+		LveJob* job = buffer[b & MASK].load(std::memory_order_relaxed);
+		if (t == b)
+		{
+			//Last job left, race the thieves for it
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				job = nullptr;
+			}//end if
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}//end if
+		return job;
+	}//end pop
+
+	LveJob* LveWorkStealingDeque::steal()
+	{
+		int64_t t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t b = bottom.load(std::memory_order_acquire);
+		if (t >= b)
+		{
+			return nullptr;
+		}//end if
+
+		LveJob* job = buffer[t & MASK].load(std::memory_order_relaxed);
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			//Lost to the owner or another thief
+			return nullptr;
+		}//end if
+		return job;
+	}//end steal
+
+	LveJobSystem::LveJobSystem(const JobSystemConfig& config) : config{ config }
+	{
+		uint32_t workerCount = config.workerCount;
+		if (workerCount == 0)
+		{
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = hardwareThreads > 3 ? hardwareThreads - 2 : 1;
+		}//end if
+
+		//Every deque has to exist before any worker may try to steal from it
+		for (uint32_t i = 0; i < workerCount; i++)
+		{
+			workers.push_back(std::make_unique<Worker>());
+		}//end for
+		for (uint32_t i = 0; i < workerCount; i++)
+		{
+			workers[i]->thread = std::thread{ &LveJobSystem::workerLoop, this, i };
+		}//end for
+	}//constructor
+
+	LveJobSystem::~LveJobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ sleepMutex };
+			stopping = true;
+		}
+		wakeCondition.notify_all();
+		for (auto& worker : workers)
+		{
+			worker->thread.join();
+		}//end for
+
+		//Jobs nobody waited on are dropped
+		for (auto& worker : workers)
+		{
+			while (LveJob* job = worker->deque.pop())
+			{
+				delete job;
+			}//end while
+		}//end for
+		for (LveJob* job : injectionQueue)
+		{
+			delete job;
+		}//end for
+	}//destructor
+
+	void LveJobSystem::run(std::function<void()> function, LveJobCounter* counter)
+	{
+		if (counter != nullptr)
+		{
+			counter->pending.fetch_add(1, std::memory_order_relaxed);
+		}//end if
+		schedule(new LveJob{ std::move(function), counter });
+	}//end run
+
+	void LveJobSystem::runAfter(LveJobCounter& dependency, std::function<void()> function, LveJobCounter* counter)
+	{
+		if (counter != nullptr)
+		{
+			counter->pending.fetch_add(1, std::memory_order_relaxed);
+		}//end if
+		LveJob* job = new LveJob{ std::move(function), counter };
+
+		{
+			//The last finish of the dependency takes this lock, so it either sees the job or we see zero
+			std::lock_guard<std::mutex> lock{ dependency.mutex };
+			if (dependency.pending.load(std::memory_order_acquire) != 0)
+			{
+				dependency.continuations.push_back(job);
+				return;
+			}//end if
+		}
+		schedule(job);
+	}//end runAfter
+
+	void LveJobSystem::wait(LveJobCounter& counter)
+	{
+		while (!counter.isDone())
+		{
+			if (LveJob* job = tryGetJob())
+			{
+				execute(job);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}//end if
+		}//end while
+
+		//The thread that brought the counter to zero may still be releasing its continuations,
+		//the counter must not go away (it usually lives on the waiter's stack) before it is done
+		std::exception_ptr exception;
+		{
+			std::lock_guard<std::mutex> lock{ counter.mutex };
+			//Taken out so the counter can be reused
+			exception.swap(counter.exception);
+		}
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}//end if
+	}//end wait
+
+	void LveJobSystem::parallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t, uint32_t)>& function)
+	{
+		if (count == 0)
+		{
+			return;
+		}//end if
+		batchSize = std::max(batchSize, 1u);
+
+		LveJobCounter counter;
+		for (uint32_t begin = batchSize; begin < count; begin += batchSize)
+		{
+			uint32_t end = std::min(begin + batchSize, count);
+			run([&function, begin, end]() { function(begin, end); }, &counter);
+		}//end for
+
+		//Small ranges never leave the calling thread. The other batches still reference the counter and
+		//the function, so they are waited on even if this one throws.
+		std::exception_ptr exception;
+		try
+		{
+			function(0, std::min(batchSize, count));
+		}//end try
+		catch (...)
+		{
+			exception = std::current_exception();
+		}//end catch
+		wait(counter);
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}//end if
+	}//end parallelFor
+
+	bool LveJobSystem::pinCurrentThread(uint32_t core)
+	{
+		if (core >= std::thread::hardware_concurrency())
+		{
+			return false;
+		}//end if
+#if defined(_WIN32)
+		return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << core) != 0;
+#elif defined(__linux__)
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		CPU_SET(core, &cpuSet);
+		return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+		return false;
+#endif
+	}//end pinCurrentThread
+
+	void LveJobSystem::workerLoop(uint32_t index)
+	{
+		currentSystem = this;
+		currentWorker = static_cast<int>(index);
+		stealSeed = index * 2654435761u + 1;
+		if (config.pinWorkers)
+		{
+			pinCurrentThread(config.firstWorkerCore + index);
+		}//end if
+
+		int idleRounds = 0;
+		while (!stopping.load(std::memory_order_relaxed))
+		{
+			if (LveJob* job = tryGetJob())
+			{
+				execute(job);
+				idleRounds = 0;
+				continue;
+			}//end if
+
+			if (++idleRounds < SPIN_COUNT)
+			{
+				std::this_thread::yield();
+				continue;
+			}//end if
+
+			//Announce the sleep before checking for work, schedule() checks in the opposite order
+			std::unique_lock<std::mutex> lock{ sleepMutex };
+			sleepingWorkers.fetch_add(1);
+			wakeCondition.wait(lock, [this]() { return pendingJobs.load() > 0 || stopping.load(); });
+			sleepingWorkers.fetch_sub(1);
+			idleRounds = 0;
+		}//end while
+	}//end workerLoop
+
+	void LveJobSystem::schedule(LveJob* job)
+	{
+		pendingJobs.fetch_add(1);
+
+		bool queued = false;
+		if (currentSystem == this && currentWorker >= 0)
+		{
+			queued = workers[currentWorker]->deque.push(job);
+		}//end if
+		if (!queued)
+		{
+			//Not a worker of ours, or its deque is full
+			std::lock_guard<std::mutex> lock{ injectionMutex };
+			injectionQueue.push_back(job);
+			injectedJobs.fetch_add(1, std::memory_order_release);
+		}//end if
+
+		if (sleepingWorkers.load() > 0)
+		{
+			std::lock_guard<std::mutex> lock{ sleepMutex };
+			wakeCondition.notify_one();
+		}//end if
+	}//end schedule
+
+	LveJob* LveJobSystem::tryGetJob()
+	{
+		LveJob* job = nullptr;
+		bool isWorker = currentSystem == this && currentWorker >= 0;
+
+		if (isWorker)
+		{
+			job = workers[currentWorker]->deque.pop();
+		}//end if
+
+		if (job == nullptr && injectedJobs.load(std::memory_order_acquire) > 0)
+		{
+			std::lock_guard<std::mutex> lock{ injectionMutex };
+			if (!injectionQueue.empty())
+			{
+				job = injectionQueue.front();
+				injectionQueue.pop_front();
+				injectedJobs.fetch_sub(1, std::memory_order_relaxed);
+			}//end if
+		}//end if
+
+		if (job == nullptr && !workers.empty())
+		{
+			//Start at a random victim so thieves spread out instead of all hitting worker 0
+			if (stealSeed == 0)
+			{
+				stealSeed = static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1u;
+			}//end if
+			stealSeed ^= stealSeed << 13;
+			stealSeed ^= stealSeed >> 17;
+			stealSeed ^= stealSeed << 5;
+
+			uint32_t workerCount = static_cast<uint32_t>(workers.size());
+			uint32_t start = stealSeed % workerCount;
+			for (uint32_t i = 0; i < workerCount && job == nullptr; i++)
+			{
+				uint32_t victim = (start + i) % workerCount;
+				if (isWorker && victim == static_cast<uint32_t>(currentWorker))
+				{
+					continue;
+				}//end if
+				job = workers[victim]->deque.steal();
+			}//end for
+		}//end if
+
+		if (job != nullptr)
+		{
+			pendingJobs.fetch_sub(1);
+		}//end if
+		return job;
+	}//end tryGetJob
+
+	void LveJobSystem::execute(LveJob* job)
+	{
+		//Nothing may escape: on a worker it would terminate the program, on a waiting thread it would
+		//leave the counter above zero forever
+		std::exception_ptr exception;
+		try
+		{
+			job->function();
+		}//end try
+		catch (...)
+		{
+			exception = std::current_exception();
+		}//end catch
+		LveJobCounter* counter = job->counter;
+		delete job;
+
+		if (exception)
+		{
+			if (counter != nullptr)
+			{
+				std::lock_guard<std::mutex> lock{ counter->mutex };
+				if (!counter->exception)
+				{
+					counter->exception = exception;
+				}//end if
+			}
+			else
+			{
+				try
+				{
+					std::rethrow_exception(exception);
+				}//end try
+				catch (const std::exception& e)
+				{
+					std::cerr << "job without counter threw: " << e.what() << "\n";
+				}
+				catch (...)
+				{
+					std::cerr << "job without counter threw\n";
+				}//end catch
+			}//end if
+		}//end if
+		if (counter != nullptr)
+		{
+			finish(*counter);
+		}//end if
+	}//end execute
+
+	void LveJobSystem::finish(LveJobCounter& counter)
+	{
+		//Decrements that cannot reach zero stay lock-free
+		uint32_t pending = counter.pending.load(std::memory_order_relaxed);
+		while (pending > 1)
+		{
+			if (counter.pending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+			{
+				return;
+			}//end if
+		}//end while
+
+		//Possibly the last one: drop to zero under the lock so runAfter and wait see a consistent state,
+		//and never touch the counter again after unlocking
+		std::vector<LveJob*> ready;
+		{
+			std::lock_guard<std::mutex> lock{ counter.mutex };
+			if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				ready.swap(counter.continuations);
+			}//end if
+		}
+		for (LveJob* job : ready)
+		{
+			schedule(job);
+		}//end for
+	}//end finish
+}//end namespace
@@ -0,0 +1,138 @@
+#pragma once
+
+//std
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lve
+{
+	struct LveJob;
+
+	//Tracks a group of jobs. It goes back to zero once every job started with it has finished, other
+	//jobs can be made to start only then (LveJobSystem::runAfter). It can be reused once waited on.
+	//A job that throws still counts as finished, the first exception is kept for wait() to rethrow.
+	class LveJobCounter
+	{
+	public:
+		LveJobCounter() = default;
+
+		LveJobCounter(const LveJobCounter&) = delete;
+		LveJobCounter& operator=(const LveJobCounter&) = delete;
+
+		bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class LveJobSystem;
+
+		std::atomic<uint32_t> pending{ 0 };
+		//Guards the transition to zero, the jobs waiting for it and the exception
+		std::mutex mutex;
+		std::vector<LveJob*> continuations;
+		std::exception_ptr exception;
+	};//end class LveJobCounter
+
+	struct LveJob
+	{
+		std::function<void()> function;
+		LveJobCounter* counter = nullptr;
+	};
+
+	//Fixed size Chase-Lev work-stealing deque (Le et al. 2013 memory orderings). Only the owning
+	//worker pushes and pops at the bottom, any thread may steal from the top.
+	class LveWorkStealingDeque
+	{
+	public:
+		static constexpr int64_t CAPACITY = 4096;
+
+		//Owner only, returns false when full
+		bool push(LveJob* job);
+		//Owner only, newest job first so the working set stays in cache
+		LveJob* pop();
+		//Any thread, oldest job first
+		LveJob* steal();
+
+	private:
+		static constexpr int64_t MASK = CAPACITY - 1;
+
+		alignas(64) std::atomic<int64_t> top{ 0 };
+		alignas(64) std::atomic<int64_t> bottom{ 0 };
+		std::atomic<LveJob*> buffer[CAPACITY]{};
+	};//end class LveWorkStealingDeque
+
+	struct JobSystemConfig
+	{
+		//0 picks one worker per hardware thread minus the main and the render threads
+		uint32_t workerCount = 0;
+		//Pin worker i to core firstWorkerCore + i
+		bool pinWorkers = false;
+		uint32_t firstWorkerCore = 2;
+	};
+
+	//Thread pool shared by the whole engine. Every worker owns a deque: jobs started from a worker
+	//go to its own deque, jobs started from any other thread go to a shared injection queue, and idle
+	//workers steal from each other before going to sleep. Waiting on a counter never blocks a thread
+	//that could be running jobs, the waiting thread executes pending jobs until the counter is done.
+	class LveJobSystem
+	{
+	public:
+		LveJobSystem(const JobSystemConfig& config = JobSystemConfig{});
+		~LveJobSystem();
+
+		LveJobSystem(const LveJobSystem&) = delete;
+		LveJobSystem& operator=(const LveJobSystem&) = delete;
+
+		//Starts a job, counter (optional) is incremented now and decremented once the job has finished.
+		//Exceptions of a job started without a counter have nobody to go to, they are reported and dropped.
+		void run(std::function<void()> function, LveJobCounter* counter = nullptr);
+		//Starts a job once dependency reaches zero (even if one of its jobs threw), counter is incremented right away
+		void runAfter(LveJobCounter& dependency, std::function<void()> function, LveJobCounter* counter = nullptr);
+		//Runs other jobs on the calling thread until counter reaches zero, then rethrows the first
+		//exception thrown by one of its jobs
+		void wait(LveJobCounter& counter);
+
+		//Splits [0, count) into batches of batchSize and calls function(begin, end) for each of them
+		//in parallel. The first batch runs on the calling thread, returns (or throws) once all of them are done.
+		void parallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t, uint32_t)>& function);
+
+		uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+
+		//Restricts the calling thread to one core (e.g. the render thread), false if not supported
+		static bool pinCurrentThread(uint32_t core);
+
+	private:
+		struct Worker
+		{
+			LveWorkStealingDeque deque;
+			std::thread thread;
+		};
+
+		void workerLoop(uint32_t index);
+		void schedule(LveJob* job);
+		LveJob* tryGetJob();
+		void execute(LveJob* job);
+		void finish(LveJobCounter& counter);
+
+		JobSystemConfig config;
+		std::vector<std::unique_ptr<Worker>> workers;
+
+		//Jobs started from threads that are not workers of this system
+		std::mutex injectionMutex;
+		std::deque<LveJob*> injectionQueue;
+		std::atomic<uint32_t> injectedJobs{ 0 };
+
+		//Jobs scheduled and not yet taken, lets idle workers sleep without missing new work
+		std::atomic<uint32_t> pendingJobs{ 0 };
+		std::atomic<uint32_t> sleepingWorkers{ 0 };
+		std::mutex sleepMutex;
+		std::condition_variable wakeCondition;
+		std::atomic<bool> stopping{ false };
+	};//end class LveJobSystem
+}//end namespace
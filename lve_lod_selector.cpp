@@ -0,0 +1,46 @@
+#include "lve_lod_selector.h"
+
+//std
+#include <algorithm>
+#include <cmath>
+
+namespace lve
+{
+	uint32_t LveLodSelector::selectLod(uint32_t lodCount, float screenSize, uint32_t currentLod) const
+	{
+		if (lodCount <= 1)
+		{
+			return 0;
+		}//end if
+		const uint32_t coarsest = lodCount - 1;
+		//The model may have changed under the object (placeholder replaced by the real one)
+		currentLod = std::min(currentLod, coarsest);
+
+		uint32_t ideal = 0;
+		if (screenSize <= 0.0f)
+		{
+			ideal = coarsest;
+		}
+		else if (screenSize < settings.fullDetailSize)
+		{
+			float level = std::floor(std::log2(settings.fullDetailSize / screenSize));
+			ideal = static_cast<uint32_t>(std::min(level, static_cast<float>(coarsest)));
+		}//end if
+
+		if (ideal > currentLod && screenSize < lowerBound(currentLod) * (1.0f - settings.hysteresis))
+		{
+			return ideal;
+		}//end if
+		//The upper bound of a level is the lower bound of the one before it
+		if (ideal < currentLod && screenSize > lowerBound(currentLod - 1) * (1.0f + settings.hysteresis))
+		{
+			return ideal;
+		}//end if
+		return currentLod;
+	}//end selectLod
+
+	float LveLodSelector::lowerBound(uint32_t lod) const
+	{
+		return settings.fullDetailSize / static_cast<float>(2u << lod);
+	}//end lowerBound
+}//end namespace
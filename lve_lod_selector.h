@@ -0,0 +1,35 @@
+#pragma once
+
+//std
+#include <cstdint>
+
+namespace lve
+{
+	//Picks the level of detail of an object from its projected size. Every level halves the size it
+	//is meant for: level 0 down to fullDetailSize / 2, level 1 down to a quarter and so on.
+	//An object near a boundary would flip between two levels every few frames (and pop visibly), so
+	//it only leaves its current level once it is hysteresis past the boundary.
+	class LveLodSelector
+	{
+	public:
+		struct Settings
+		{
+			//Projected diameter in pixels from which on the full resolution mesh is drawn
+			float fullDetailSize = 256.0f;
+			//Fraction of a boundary the size has to cross before the level changes
+			float hysteresis = 0.15f;
+		};
+
+		LveLodSelector() = default;
+		LveLodSelector(const Settings& settings) : settings{ settings } {}
+
+		//screenSize is the projected diameter in pixels, currentLod the level drawn last frame
+		uint32_t selectLod(uint32_t lodCount, float screenSize, uint32_t currentLod) const;
+
+	private:
+		//Smallest projected size the level is meant for
+		float lowerBound(uint32_t lod) const;
+
+		Settings settings{};
+	};//end class LveLodSelector
+}//end namespace
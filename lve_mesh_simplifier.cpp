@@ -0,0 +1,355 @@
+#include "lve_mesh_simplifier.h"
+
+//std
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <queue>
+#include <utility>
+
+namespace lve
+{
+	namespace
+	{
+		//Error of a point against a sum of lines a*x + b*y + c = 0: the 3x3 symmetric matrix of
+		//[a b c]^T [a b c], kept as its six distinct coefficients
+		struct Quadric
+		{
+			double aa = 0.0, ab = 0.0, ac = 0.0, bb = 0.0, bc = 0.0, cc = 0.0;
+
+			void addLine(double a, double b, double c, double weight)
+			{
+				aa += weight * a * a;
+				ab += weight * a * b;
+				ac += weight * a * c;
+				bb += weight * b * b;
+				bc += weight * b * c;
+				cc += weight * c * c;
+			}//end addLine
+
+			void add(const Quadric& other)
+			{
+				aa += other.aa;
+				ab += other.ab;
+				ac += other.ac;
+				bb += other.bb;
+				bc += other.bc;
+				cc += other.cc;
+			}//end add
+
+			double error(double x, double y) const
+			{
+				return aa * x * x + 2.0 * ab * x * y + 2.0 * ac * x + bb * y * y + 2.0 * bc * y + cc;
+			}//end error
+		};
+
+		struct Point
+		{
+			double x, y;
+		};
+
+		double signedArea(const Point& a, const Point& b, const Point& c)
+		{
+			return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		}//end signedArea
+
+		struct Collapse
+		{
+			double cost;
+			uint32_t remove;
+			uint32_t keep;
+			//Versions of both vertices when the collapse was evaluated, stale entries are skipped
+			uint32_t removeVersion;
+			uint32_t keepVersion;
+
+			bool operator>(const Collapse& other) const { return cost > other.cost; }
+		};
+
+		//Indexed copy of the mesh that edge collapses are applied to
+		class CollapseMesh
+		{
+		public:
+			CollapseMesh(const std::vector<LveModel::Vertex>& vertices)
+			{
+				//Weld the triangle list on exact positions
+				std::map<std::pair<float, float>, uint32_t> welded;
+				for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+				{
+					std::array<uint32_t, 3> triangle;
+					for (int corner = 0; corner < 3; corner++)
+					{
+						const glm::vec2& position = vertices[i + corner].position;
+						auto inserted = welded.emplace(std::make_pair(position.x, position.y), static_cast<uint32_t>(points.size()));
+						if (inserted.second)
+						{
+							points.push_back({ position.x, position.y });
+						}//end if
+						triangle[corner] = inserted.first->second;
+					}//end for
+					if (triangle[0] != triangle[1] && triangle[1] != triangle[2] && triangle[0] != triangle[2])
+					{
+						triangles.push_back(triangle);
+					}//end if
+				}//end for
+
+				triangleAlive.assign(triangles.size(), true);
+				aliveTriangles = static_cast<uint32_t>(triangles.size());
+				vertexTriangles.resize(points.size());
+				versions.assign(points.size(), 0);
+				quadrics.resize(points.size());
+				for (uint32_t t = 0; t < triangles.size(); t++)
+				{
+					for (uint32_t vertex : triangles[t])
+					{
+						vertexTriangles[vertex].push_back(t);
+					}//end for
+				}//end for
+
+				//Boundary edges are the ones used by a single triangle
+				std::map<std::pair<uint32_t, uint32_t>, int> edgeUses;
+				for (auto& triangle : triangles)
+				{
+					for (int corner = 0; corner < 3; corner++)
+					{
+						uint32_t a = triangle[corner];
+						uint32_t b = triangle[(corner + 1) % 3];
+						edgeUses[std::minmax(a, b)]++;
+					}//end for
+				}//end for
+				for (auto& edge : edgeUses)
+				{
+					if (edge.second != 1)
+					{
+						continue;
+					}//end if
+					const Point& a = points[edge.first.first];
+					const Point& b = points[edge.first.second];
+					double dx = b.x - a.x;
+					double dy = b.y - a.y;
+					double length = std::sqrt(dx * dx + dy * dy);
+					if (length == 0.0)
+					{
+						continue;
+					}//end if
+					//Unit normal of the edge, weighted by its length so long edges hold their place harder
+					double nx = -dy / length;
+					double ny = dx / length;
+					double c = -(nx * a.x + ny * a.y);
+					quadrics[edge.first.first].addLine(nx, ny, c, length);
+					quadrics[edge.first.second].addLine(nx, ny, c, length);
+				}//end for
+
+				for (uint32_t t = 0; t < triangles.size(); t++)
+				{
+					for (int corner = 0; corner < 3; corner++)
+					{
+						pushCollapses(triangles[t][corner], triangles[t][(corner + 1) % 3]);
+					}//end for
+				}//end for
+			}//constructor
+
+			uint32_t getTriangleCount() const { return aliveTriangles; }
+
+			//Collapses the cheapest edges until the mesh is down to targetTriangles or nothing under
+			//maxError is left
+			void simplify(uint32_t targetTriangles, double maxError)
+			{
+				while (aliveTriangles > targetTriangles && !queue.empty())
+				{
+					Collapse collapse = queue.top();
+					if (collapse.cost > maxError)
+					{
+						break;
+					}//end if
+					queue.pop();
+					if (versions[collapse.remove] != collapse.removeVersion ||
+						versions[collapse.keep] != collapse.keepVersion ||
+						vertexTriangles[collapse.remove].empty() ||
+						!canCollapse(collapse.remove, collapse.keep))
+					{
+						continue;
+					}//end if
+					applyCollapse(collapse.remove, collapse.keep);
+				}//end while
+			}//end simplify
+
+			std::vector<LveModel::Vertex> toTriangleList() const
+			{
+				std::vector<LveModel::Vertex> vertices;
+				vertices.reserve(aliveTriangles * 3);
+				for (uint32_t t = 0; t < triangles.size(); t++)
+				{
+					if (!triangleAlive[t])
+					{
+						continue;
+					}//end if
+					for (uint32_t vertex : triangles[t])
+					{
+						vertices.push_back({ { static_cast<float>(points[vertex].x), static_cast<float>(points[vertex].y) } });
+					}//end for
+				}//end for
+				return vertices;
+			}//end toTriangleList
+
+		private:
+			void pushCollapses(uint32_t a, uint32_t b)
+			{
+				//Either end can be kept, the error is checked at the position of the one kept
+				Quadric combined = quadrics[a];
+				combined.add(quadrics[b]);
+				queue.push({ combined.error(points[a].x, points[a].y), b, a, versions[b], versions[a] });
+				queue.push({ combined.error(points[b].x, points[b].y), a, b, versions[a], versions[b] });
+			}//end pushCollapses
+
+			std::vector<uint32_t> neighbors(uint32_t vertex) const
+			{
+				std::vector<uint32_t> result;
+				for (uint32_t t : vertexTriangles[vertex])
+				{
+					for (uint32_t other : triangles[t])
+					{
+						if (other != vertex)
+						{
+							result.push_back(other);
+						}//end if
+					}//end for
+				}//end for
+				std::sort(result.begin(), result.end());
+				result.erase(std::unique(result.begin(), result.end()), result.end());
+				return result;
+			}//end neighbors
+
+			bool canCollapse(uint32_t remove, uint32_t keep) const
+			{
+				//Link condition: the only vertices next to both ends are the tips of the triangles on
+				//the edge, otherwise the collapse would pinch the mesh
+				std::vector<uint32_t> removeNeighbors = neighbors(remove);
+				std::vector<uint32_t> keepNeighbors = neighbors(keep);
+				if (!std::binary_search(removeNeighbors.begin(), removeNeighbors.end(), keep))
+				{
+					return false;
+				}//end if
+				std::vector<uint32_t> shared;
+				std::set_intersection(
+					removeNeighbors.begin(), removeNeighbors.end(),
+					keepNeighbors.begin(), keepNeighbors.end(),
+					std::back_inserter(shared));
+				uint32_t edgeTriangles = 0;
+				for (uint32_t t : vertexTriangles[remove])
+				{
+					const auto& triangle = triangles[t];
+					if (triangle[0] == keep || triangle[1] == keep || triangle[2] == keep)
+					{
+						edgeTriangles++;
+					}//end if
+				}//end for
+				if (shared.size() != edgeTriangles)
+				{
+					return false;
+				}//end if
+
+				//No triangle that survives may flip over or become degenerate
+				for (uint32_t t : vertexTriangles[remove])
+				{
+					const auto& triangle = triangles[t];
+					if (triangle[0] == keep || triangle[1] == keep || triangle[2] == keep)
+					{
+						continue;
+					}//end if
+					Point before[3];
+					Point after[3];
+					for (int corner = 0; corner < 3; corner++)
+					{
+						before[corner] = points[triangle[corner]];
+						after[corner] = triangle[corner] == remove ? points[keep] : points[triangle[corner]];
+					}//end for
+					double areaBefore = signedArea(before[0], before[1], before[2]);
+					double areaAfter = signedArea(after[0], after[1], after[2]);
+					if (areaBefore * areaAfter <= 0.0 || std::abs(areaAfter) < std::abs(areaBefore) * 1e-3)
+					{
+						return false;
+					}//end if
+				}//end for
+				return true;
+			}//end canCollapse
+
+			void applyCollapse(uint32_t remove, uint32_t keep)
+			{
+				for (uint32_t t : vertexTriangles[remove])
+				{
+					auto& triangle = triangles[t];
+					if (triangle[0] == keep || triangle[1] == keep || triangle[2] == keep)
+					{
+						triangleAlive[t] = false;
+						aliveTriangles--;
+						auto& keepTriangles = vertexTriangles[keep];
+						keepTriangles.erase(std::remove(keepTriangles.begin(), keepTriangles.end(), t), keepTriangles.end());
+						for (uint32_t other : triangle)
+						{
+							if (other != remove && other != keep)
+							{
+								auto& otherTriangles = vertexTriangles[other];
+								otherTriangles.erase(std::remove(otherTriangles.begin(), otherTriangles.end(), t), otherTriangles.end());
+							}//end if
+						}//end for
+					}
+					else
+					{
+						for (auto& corner : triangle)
+						{
+							if (corner == remove)
+							{
+								corner = keep;
+							}//end if
+						}//end for
+						vertexTriangles[keep].push_back(t);
+					}//end if
+				}//end for
+				vertexTriangles[remove].clear();
+				quadrics[keep].add(quadrics[remove]);
+				versions[remove]++;
+				versions[keep]++;
+
+				//Every edge of the kept vertex has a new cost now
+				for (uint32_t vertex : neighbors(keep))
+				{
+					pushCollapses(keep, vertex);
+				}//end for
+			}//end applyCollapse
+
+			std::vector<Point> points;
+			std::vector<Quadric> quadrics;
+			std::vector<uint32_t> versions;
+			std::vector<std::array<uint32_t, 3>> triangles;
+			std::vector<bool> triangleAlive;
+			uint32_t aliveTriangles = 0;
+			std::vector<std::vector<uint32_t>> vertexTriangles;
+			std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+		};//end class CollapseMesh
+	}//end namespace
+
+	std::vector<std::vector<LveModel::Vertex>> LveMeshSimplifier::buildLodChain(
+		const std::vector<LveModel::Vertex>& vertices,
+		const Settings& settings)
+	{
+		std::vector<std::vector<LveModel::Vertex>> lods{ vertices };
+		CollapseMesh mesh{ vertices };
+		uint32_t previousTriangles = static_cast<uint32_t>(vertices.size() / 3);
+
+		//Each level carries on from the previous one, so the chain is one progressive simplification
+		for (uint32_t level = 0; level < settings.maxLods; level++)
+		{
+			uint32_t target = static_cast<uint32_t>(previousTriangles * settings.reduction);
+			mesh.simplify(target, settings.maxError);
+			uint32_t triangles = mesh.getTriangleCount();
+			if (triangles == 0 || triangles > previousTriangles * settings.minimumReduction)
+			{
+				break;
+			}//end if
+			lods.push_back(mesh.toTriangleList());
+			previousTriangles = triangles;
+		}//end for
+		return lods;
+	}//end buildLodChain
+}//end namespace
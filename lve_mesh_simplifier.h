@@ -0,0 +1,42 @@
+#pragma once
+
+#include "lve_model.h"
+
+//std
+#include <cstdint>
+#include <vector>
+
+namespace lve
+{
+	//Builds the LOD chain of a mesh by quadric error edge collapse (Garland-Heckbert).
+	//Our meshes are flat 2D triangle lists, so every triangle lies in the same plane and the face
+	//quadrics of the original method would be zero everywhere. The error that matters is how far
+	//the outline moves: each boundary edge adds the quadric of its line to both of its vertices, so
+	//interior vertices collapse for free and outline vertices only where the outline stays straight
+	//or the error is the smallest left.
+	class LveMeshSimplifier
+	{
+	public:
+		struct Settings
+		{
+			//Levels after the full resolution one
+			uint32_t maxLods = 4;
+			//Triangles of each level relative to the one before
+			float reduction = 0.5f;
+			//A level is only kept when it has at most this fraction of the triangles of the level before
+			float minimumReduction = 0.85f;
+			//Largest quadric error a collapse may add: squared distance the outline moves, times the
+			//length of the edges it moves away from (model units, NDC for our models)
+			float maxError = 1e-4f;
+		};
+
+		//Triangle list in, one triangle list per level out, level 0 being the input itself
+		static std::vector<std::vector<LveModel::Vertex>> buildLodChain(
+			const std::vector<LveModel::Vertex>& vertices,
+			const Settings& settings);
+		static std::vector<std::vector<LveModel::Vertex>> buildLodChain(const std::vector<LveModel::Vertex>& vertices)
+		{
+			return buildLodChain(vertices, Settings{});
+		}
+	};//end class LveMeshSimplifier
+}//end namespace
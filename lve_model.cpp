@@ -1,26 +1,49 @@
 #include "lve_model.h"
 
 //std 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 
 namespace lve
 {
 	LveModel::LveModel(LveDevice& device, const std::vector<Vertex>& vertices) : lveDevice{device}
 	{
-		createVertexBuffers(vertices);
+		createVertexBuffers({ vertices });
+	}//end constructor
+
+	LveModel::LveModel(LveDevice& device, const std::vector<std::vector<Vertex>>& lods) : lveDevice{device}
+	{
+		createVertexBuffers(lods);
 	}//end constructor
 
 	LveModel::~LveModel()
 	{
-		vkDestroyBuffer(lveDevice.device(), vertexBuffer, nullptr);
-		vkFreeMemory(lveDevice.device(), vertexBufferMemory, nullptr);
+		//Frames still in flight may draw from the buffer, it goes once they have finished
+		LveReleasedResources resources{};
+		resources.buffer = vertexBuffer;
+		resources.memory = vertexBufferMemory;
+		lveDevice.deletionQueue().release(resources);
 	}//end destructor
 
-	void LveModel::createVertexBuffers(const std::vector<Vertex>& vertices)
+	void LveModel::createVertexBuffers(const std::vector<std::vector<Vertex>>& lodVertices)
 	{
-		vertexCount = static_cast<uint32_t>(vertices.size());
-		assert(vertexCount >= 3 && "Vertex count must be at least 3");
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
+		assert(!lodVertices.empty() && "A model needs at least its full resolution level");
+		//Levels are laid out one after the other, a draw only picks its first vertex and count
+		vertexCount = 0;
+		for (auto& vertices : lodVertices)
+		{
+			assert(vertices.size() >= 3 && "Vertex count must be at least 3");
+			lods.push_back({ vertexCount, static_cast<uint32_t>(vertices.size()) });
+			vertexCount += static_cast<uint32_t>(vertices.size());
+		}//end for
+		for (auto& vertex : lodVertices[0])
+		{
+			boundingRadius = std::max(boundingRadius, std::sqrt(vertex.position.x * vertex.position.x + vertex.position.y * vertex.position.y));
+		}//end for
+		VkDeviceSize bufferSize = sizeof(Vertex) * vertexCount;
 		lveDevice.createBuffer(
 			bufferSize,
 			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
@@ -34,14 +57,32 @@ namespace lve
 		//in order for the changes to propagate. 
 		void* data;
 		vkMapMemory(lveDevice.device(), vertexBufferMemory, 0, bufferSize, 0, &data);
-		memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
+		for (size_t i = 0; i < lodVertices.size(); i++)
+		{
+			memcpy(static_cast<Vertex*>(data) + lods[i].firstVertex, lodVertices[i].data(), sizeof(Vertex) * lods[i].vertexCount);
+		}//end for
 		vkUnmapMemory(lveDevice.device(), vertexBufferMemory);
 
 	}//end createVertexBuffers
 
-	void LveModel::draw(VkCommandBuffer commandBUffer)
+	std::vector<std::vector<LveModel::Vertex>> LveModel::readLods()
+	{
+		std::vector<std::vector<Vertex>> lodVertices(lods.size());
+		void* data;
+		vkMapMemory(lveDevice.device(), vertexBufferMemory, 0, sizeof(Vertex) * vertexCount, 0, &data);
+		for (size_t i = 0; i < lods.size(); i++)
+		{
+			const Vertex* first = static_cast<const Vertex*>(data) + lods[i].firstVertex;
+			lodVertices[i].assign(first, first + lods[i].vertexCount);
+		}//end for
+		vkUnmapMemory(lveDevice.device(), vertexBufferMemory);
+		return lodVertices;
+	}//end readLods
+
+	void LveModel::draw(VkCommandBuffer commandBUffer, uint32_t lod)
 	{
-		vkCmdDraw(commandBUffer, vertexCount, 1, 0, 0);
+		const Lod& range = lods[std::min(lod, static_cast<uint32_t>(lods.size()) - 1)];
+		vkCmdDraw(commandBUffer, range.vertexCount, 1, range.firstVertex, 0);
 	}//end draw
 
 	void LveModel::bind(VkCommandBuffer commandBuffer)
@@ -71,4 +112,15 @@ namespace lve
 		return attributeDescription;
 		
 	}//end getAttributeDescriptions
+
+	std::vector<VkVertexInputAttributeDescription> LveModel::Vertex::getPositionAttributeDescriptions()
+	{
+		std::vector<VkVertexInputAttributeDescription> attributeDescription(1);
+
+		attributeDescription[0].binding = 0;
+		attributeDescription[0].location = 0;
+		attributeDescription[0].format = VK_FORMAT_R32G32_SFLOAT;
+		attributeDescription[0].offset = offsetof(Vertex, position);
+		return attributeDescription;
+	}//end getPositionAttributeDescriptions
 }//end namespace
\ No newline at end of file
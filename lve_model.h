@@ -21,24 +21,47 @@ namespace lve
 
 			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
 			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+			//Only the position attribute, for depth only pipelines
+			static std::vector<VkVertexInputAttributeDescription> getPositionAttributeDescriptions();
+		};
+
+		//Range of the vertex buffer holding one level of detail
+		struct Lod
+		{
+			uint32_t firstVertex;
+			uint32_t vertexCount;
 		};
 
 		LveModel(LveDevice &device, const std::vector<Vertex>& vertices);
+		//Level 0 is the full resolution mesh, every level is stored back to back in the one vertex buffer
+		LveModel(LveDevice &device, const std::vector<std::vector<Vertex>>& lods);
 		~LveModel();
 
 		LveModel(const LveModel&) = delete;
 		LveModel &operator=(const LveModel&) = delete;
 
 		void bind(VkCommandBuffer commandBuffer);
-		void draw(VkCommandBuffer commandBUffer);
+		void draw(VkCommandBuffer commandBUffer, uint32_t lod = 0);
+
+		uint32_t getLodCount() const { return static_cast<uint32_t>(lods.size()); }
+		const Lod& getLod(uint32_t lod) const { return lods[lod]; }
+		//Every level together, as stored in the vertex buffer
+		uint32_t getVertexCount() const { return vertexCount; }
+		//Copies every level back out of the vertex buffer, e.g. to write the model to a capture. Reads
+		//mapped device memory, so it is slow and not meant for every frame.
+		std::vector<std::vector<Vertex>> readLods();
+		//Distance from the model origin to its farthest vertex
+		float getBoundingRadius() const { return boundingRadius; }
 
 	private:
-		void createVertexBuffers(const std::vector<Vertex>& vertices);
+		void createVertexBuffers(const std::vector<std::vector<Vertex>>& lodVertices);
 
 		LveDevice& lveDevice; 
 		//In vulkan the buffer and its assigned memory are two separate objects.
 		VkBuffer vertexBuffer;
 		VkDeviceMemory vertexBufferMemory;
 		uint32_t vertexCount;
+		std::vector<Lod> lods;
+		float boundingRadius = 0.0f;
 	};//end class LveDevice
 }//end namespace
\ No newline at end of file
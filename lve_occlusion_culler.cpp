@@ -0,0 +1,281 @@
+#include "lve_occlusion_culler.h"
+
+//std
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve
+{
+	//Push constants of hiz_cull.comp
+	struct CullPushConstantData
+	{
+		uint32_t objectCount;
+		uint32_t phase;
+		uint32_t pyramidValid;
+		uint32_t levelCount;
+		glm::vec2 pyramidSize;
+	};
+
+	LveOcclusionCuller::LveOcclusionCuller(
+		LveDevice& device,
+		LveDescriptorLayoutCache& layoutCache,
+		LveDescriptorSetCache& setCache,
+		LveFrameDescriptorAllocator& frameDescriptors,
+		LveDynamicResolution& sceneTarget,
+		uint32_t framesInFlight)
+		: lveDevice{ device }, frameDescriptors{ frameDescriptors }, sceneTarget{ sceneTarget }, frames(framesInFlight)
+	{
+		pyramid = std::make_unique<LveHiZPyramid>(
+			lveDevice,
+			layoutCache,
+			setCache,
+			sceneTarget.getDepthImageView(),
+			sceneTarget.getFullExtent());
+		createPipeline(layoutCache);
+		for (auto& frame : frames)
+		{
+			reserve(frame, 256);
+		}//end for
+	}//constructor
+
+	LveOcclusionCuller::~LveOcclusionCuller()
+	{
+		for (auto& frame : frames)
+		{
+			destroyFrameResources(frame);
+		}//end for
+		cullPipeline.reset();
+		vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+	}//destructor
+
+	void LveOcclusionCuller::createPipeline(LveDescriptorLayoutCache& layoutCache)
+	{
+		//Pyramid, bounds in, draw commands out
+		LveDescriptorLayoutInfo layoutInfo{};
+		std::array<VkDescriptorType, 3> types = {
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER };
+		for (uint32_t binding = 0; binding < types.size(); binding++)
+		{
+			VkDescriptorSetLayoutBinding layoutBinding{};
+			layoutBinding.binding = binding;
+			layoutBinding.descriptorType = types[binding];
+			layoutBinding.descriptorCount = 1;
+			layoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			layoutInfo.bindings.push_back(layoutBinding);
+		}//end for
+		setLayout = layoutCache.getLayout(layoutInfo);
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(CullPushConstantData);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &setLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create occlusion culling pipeline layout!");
+		}//end if
+
+		cullPipeline = std::make_unique<LveComputePipeline>(
+			lveDevice,
+			"shaders/hiz_cull.comp.spv",
+			pipelineLayout);
+	}//end createPipeline
+
+	void LveOcclusionCuller::reserve(FrameResources& frame, uint32_t capacity)
+	{
+		if (capacity <= frame.capacity)
+		{
+			return;
+		}//end if
+		//The slot's fence has signaled, nothing in flight uses the old buffers
+		destroyFrameResources(frame);
+		frame.capacity = std::max(capacity, frame.capacity * 2);
+
+		VkDeviceSize boundsSize = sizeof(ObjectBounds) * frame.capacity;
+		lveDevice.createBuffer(
+			boundsSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			frame.boundsBuffer,
+			frame.boundsMemory);
+		vkMapMemory(lveDevice.device(), frame.boundsMemory, 0, boundsSize, 0, &frame.mappedBounds);
+
+		//Read back on the CPU for the stats, two phases per object
+		VkDeviceSize commandsSize = sizeof(VkDrawIndirectCommand) * 2 * frame.capacity;
+		lveDevice.createBuffer(
+			commandsSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			frame.commandBuffer,
+			frame.commandMemory);
+		vkMapMemory(lveDevice.device(), frame.commandMemory, 0, commandsSize, 0, &frame.mappedCommands);
+		frame.objectCount = 0;
+	}//end reserve
+
+	void LveOcclusionCuller::destroyFrameResources(FrameResources& frame)
+	{
+		if (frame.boundsBuffer != VK_NULL_HANDLE)
+		{
+			vkUnmapMemory(lveDevice.device(), frame.boundsMemory);
+			vkDestroyBuffer(lveDevice.device(), frame.boundsBuffer, nullptr);
+			vkFreeMemory(lveDevice.device(), frame.boundsMemory, nullptr);
+			frame.boundsBuffer = VK_NULL_HANDLE;
+		}//end if
+		if (frame.commandBuffer != VK_NULL_HANDLE)
+		{
+			vkUnmapMemory(lveDevice.device(), frame.commandMemory);
+			vkDestroyBuffer(lveDevice.device(), frame.commandBuffer, nullptr);
+			vkFreeMemory(lveDevice.device(), frame.commandMemory, nullptr);
+			frame.commandBuffer = VK_NULL_HANDLE;
+		}//end if
+	}//end destroyFrameResources
+
+	void LveOcclusionCuller::beginFrame(uint32_t frameIndex)
+	{
+		currentFrame = frameIndex;
+		FrameResources& frame = frames[frameIndex];
+
+		//The instance counts the culling shader wrote the last time this slot was submitted
+		if (frame.objectCount > 0)
+		{
+			const auto* results = static_cast<const VkDrawIndirectCommand*>(frame.mappedCommands);
+			stats = LveOcclusionStats{};
+			stats.objects = frame.objectCount;
+			for (uint32_t i = 0; i < frame.objectCount; i++)
+			{
+				stats.drawnFirstPhase += results[i].instanceCount;
+				stats.drawnSecondPhase += results[frame.objectCount + i].instanceCount;
+			}//end for
+			stats.culled = stats.objects - stats.drawnFirstPhase - stats.drawnSecondPhase;
+		}//end if
+
+		bounds.clear();
+		commands.clear();
+		frame.descriptorSet = VK_NULL_HANDLE;
+	}//end beginFrame
+
+	uint32_t LveOcclusionCuller::addObject(glm::vec2 center, float radius, float nearestDepth, const LveModel::Lod& lod)
+	{
+		ObjectBounds object{};
+		object.rect = { center.x - radius, center.y - radius, center.x + radius, center.y + radius };
+		object.nearestDepth = nearestDepth;
+		bounds.push_back(object);
+
+		//The culling shader only ever writes instanceCount
+		VkDrawIndirectCommand command{};
+		command.vertexCount = lod.vertexCount;
+		command.instanceCount = 0;
+		command.firstVertex = lod.firstVertex;
+		command.firstInstance = 0;
+		commands.push_back(command);
+		return static_cast<uint32_t>(bounds.size() - 1);
+	}//end addObject
+
+	VkDeviceSize LveOcclusionCuller::getPhaseOffset(uint32_t phase) const
+	{
+		return sizeof(VkDrawIndirectCommand) * phase * frames[currentFrame].objectCount;
+	}//end getPhaseOffset
+
+	void LveOcclusionCuller::cullFirstPhase(VkCommandBuffer commandBuffer)
+	{
+		FrameResources& frame = frames[currentFrame];
+		uint32_t objectCount = static_cast<uint32_t>(bounds.size());
+		reserve(frame, objectCount);
+		frame.objectCount = objectCount;
+
+		//Host writes before the submit are visible to it, no barrier needed for the upload
+		std::memcpy(frame.mappedBounds, bounds.data(), sizeof(ObjectBounds) * objectCount);
+		auto* mappedCommands = static_cast<VkDrawIndirectCommand*>(frame.mappedCommands);
+		std::memcpy(mappedCommands, commands.data(), sizeof(VkDrawIndirectCommand) * objectCount);
+		std::memcpy(mappedCommands + objectCount, commands.data(), sizeof(VkDrawIndirectCommand) * objectCount);
+
+		//The buffers may have been re-created, so the set is written anew every frame
+		frame.descriptorSet = frameDescriptors.allocate(setLayout);
+		VkDescriptorImageInfo pyramidInfo{};
+		pyramidInfo.sampler = pyramid->getSampler();
+		pyramidInfo.imageView = pyramid->getView();
+		pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		VkDescriptorBufferInfo boundsInfo{ frame.boundsBuffer, 0, VK_WHOLE_SIZE };
+		VkDescriptorBufferInfo commandsInfo{ frame.commandBuffer, 0, VK_WHOLE_SIZE };
+
+		std::array<VkWriteDescriptorSet, 3> writes{};
+		for (uint32_t binding = 0; binding < writes.size(); binding++)
+		{
+			writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[binding].dstSet = frame.descriptorSet;
+			writes[binding].dstBinding = binding;
+			writes[binding].descriptorCount = 1;
+			writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		}//end for
+		writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo = &pyramidInfo;
+		writes[1].pBufferInfo = &boundsInfo;
+		writes[2].pBufferInfo = &commandsInfo;
+		vkUpdateDescriptorSets(lveDevice.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+		dispatch(commandBuffer, 0);
+	}//end cullFirstPhase
+
+	void LveOcclusionCuller::cullSecondPhase(VkCommandBuffer commandBuffer)
+	{
+		pyramid->build(commandBuffer, sceneTarget.getRenderExtent());
+		dispatch(commandBuffer, 1);
+	}//end cullSecondPhase
+
+	void LveOcclusionCuller::dispatch(VkCommandBuffer commandBuffer, uint32_t phase)
+	{
+		FrameResources& frame = frames[currentFrame];
+		if (frame.objectCount == 0)
+		{
+			return;
+		}//end if
+
+		cullPipeline->bind(commandBuffer);
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			pipelineLayout,
+			0,
+			1,
+			&frame.descriptorSet,
+			0,
+			nullptr);
+
+		CullPushConstantData push{};
+		push.objectCount = frame.objectCount;
+		push.phase = phase;
+		//The second phase always has the pyramid it just built
+		push.pyramidValid = pyramid->isBuilt() ? 1 : 0;
+		push.levelCount = pyramid->getLevelCount();
+		push.pyramidSize = { static_cast<float>(pyramid->getExtent().width), static_cast<float>(pyramid->getExtent().height) };
+		vkCmdPushConstants(
+			commandBuffer,
+			pipelineLayout,
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			sizeof(CullPushConstantData),
+			&push);
+		cullPipeline->dispatch(commandBuffer, frame.objectCount, WORKGROUP_SIZE);
+
+		//The draws read the instance counts, and the second phase reads what the first one culled
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}//end dispatch
+}//end namespace
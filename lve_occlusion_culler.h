@@ -0,0 +1,116 @@
+#pragma once
+
+#include "lve_compute_pipeline.h"
+#include "lve_descriptors.h"
+#include "lve_device.h"
+#include "lve_dynamic_resolution.h"
+#include "lve_hiz_pyramid.h"
+#include "lve_model.h"
+
+//std
+#include <memory>
+#include <vector>
+
+namespace lve
+{
+	//What the last frame of a slot drew and culled
+	struct LveOcclusionStats
+	{
+		uint32_t objects = 0;
+		uint32_t drawnFirstPhase = 0;
+		uint32_t drawnSecondPhase = 0;
+		uint32_t culled = 0;
+	};
+
+	//GPU occlusion culling in two phases against a Hi-Z pyramid of the scene depth:
+	//1. every object is tested against the pyramid of the last frame, the ones passing are drawn
+	//2. the pyramid is rebuilt from that depth and only the objects culled in phase 1 are tested
+	//   again, the ones passing now (disoccluded since last frame) are drawn too.
+	//Each object gets one indirect draw per phase whose instance count the culling shader sets to
+	//0 or 1, so the draws are still recorded (and sorted) on the CPU.
+	class LveOcclusionCuller
+	{
+	public:
+		//Must match local_size_x of hiz_cull.comp
+		static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+		//The render graph of sceneTarget has to be compiled, the pyramid is built from its depth
+		LveOcclusionCuller(
+			LveDevice& device,
+			LveDescriptorLayoutCache& layoutCache,
+			LveDescriptorSetCache& setCache,
+			LveFrameDescriptorAllocator& frameDescriptors,
+			LveDynamicResolution& sceneTarget,
+			uint32_t framesInFlight);
+		~LveOcclusionCuller();
+
+		LveOcclusionCuller(const LveOcclusionCuller&) = delete;
+		LveOcclusionCuller& operator=(const LveOcclusionCuller&) = delete;
+
+		static bool isSupported(LveDevice& device, VkFormat depthFormat) { return LveHiZPyramid::isSupported(device, depthFormat); }
+
+		//Call after the fence of frameIndex was waited on: reads back what the slot culled last time
+		//and starts an empty object list
+		void beginFrame(uint32_t frameIndex);
+		//Bounding circle in NDC and the nearest depth of the object. The returned index is the cull
+		//index of its draws in LveRenderQueue::submit.
+		uint32_t addObject(glm::vec2 center, float radius, float nearestDepth, const LveModel::Lod& lod);
+
+		//Outside a render pass, before the draws of the first phase
+		void cullFirstPhase(VkCommandBuffer commandBuffer);
+		//In a render graph pass between the scene passes that reads the scene depth as a compute texture:
+		//builds the pyramid from the depth of the first phase and re-tests what it culled
+		void cullSecondPhase(VkCommandBuffer commandBuffer);
+
+		//One VkDrawIndirectCommand per object for each phase, in the order the objects were added
+		VkBuffer getIndirectBuffer() const { return frames[currentFrame].commandBuffer; }
+		VkDeviceSize getPhaseOffset(uint32_t phase) const;
+		const LveOcclusionStats& getStats() const { return stats; }
+
+	private:
+		//Same layout as ObjectBounds in hiz_cull.comp (std430, 32 byte stride)
+		struct ObjectBounds
+		{
+			glm::vec4 rect;
+			float nearestDepth;
+			float padding[3];
+		};
+
+		//Host visible and persistently mapped, only touched while the slot's fence is signaled
+		struct FrameResources
+		{
+			VkBuffer boundsBuffer = VK_NULL_HANDLE;
+			VkDeviceMemory boundsMemory = VK_NULL_HANDLE;
+			void* mappedBounds = nullptr;
+			VkBuffer commandBuffer = VK_NULL_HANDLE;
+			VkDeviceMemory commandMemory = VK_NULL_HANDLE;
+			void* mappedCommands = nullptr;
+			uint32_t capacity = 0;
+			//Objects culled by the last submission of this slot
+			uint32_t objectCount = 0;
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		};
+
+		void createPipeline(LveDescriptorLayoutCache& layoutCache);
+		void reserve(FrameResources& frame, uint32_t capacity);
+		void destroyFrameResources(FrameResources& frame);
+		void dispatch(VkCommandBuffer commandBuffer, uint32_t phase);
+
+		LveDevice& lveDevice;
+		LveFrameDescriptorAllocator& frameDescriptors;
+		LveDynamicResolution& sceneTarget;
+		std::unique_ptr<LveHiZPyramid> pyramid;
+
+		VkDescriptorSetLayout setLayout;
+		VkPipelineLayout pipelineLayout;
+		std::unique_ptr<LveComputePipeline> cullPipeline;
+
+		std::vector<FrameResources> frames;
+		uint32_t currentFrame = 0;
+		//Objects of the frame being recorded, uploaded by cullFirstPhase
+		std::vector<ObjectBounds> bounds;
+		std::vector<VkDrawIndirectCommand> commands;
+
+		LveOcclusionStats stats;
+	};//end class LveOcclusionCuller
+}//end namespace
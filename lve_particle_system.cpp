@@ -0,0 +1,357 @@
+#include "lve_particle_system.h"
+
+//std
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve
+{
+	//Push constants of particle.comp
+	struct ParticlePushConstantData
+	{
+		float deltaTime;
+		uint32_t particleCount;
+	};
+
+	LveParticleSystem::LveParticleSystem(
+		LveDevice& device,
+		LveDescriptorLayoutCache& layoutCache,
+		LveDescriptorSetCache& setCache,
+		uint32_t particleCount,
+		uint32_t framesInFlight)
+		: lveDevice{ device }, particleCount{ particleCount }, framesInFlight{ framesInFlight }
+	{
+		createBuffers();
+		createDescriptorSets(layoutCache, setCache);
+		createPipeline();
+		createCommandBuffers();
+		createSyncObjects();
+		createQueryPool();
+	}//constructor
+
+	LveParticleSystem::~LveParticleSystem()
+	{
+		if (queryPool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(lveDevice.device(), queryPool, nullptr);
+		}//end if
+		for (auto semaphore : computeFinishedSemaphores)
+		{
+			vkDestroySemaphore(lveDevice.device(), semaphore, nullptr);
+		}//end for
+		vkFreeCommandBuffers(
+			lveDevice.device(),
+			lveDevice.getComputeCommandPool(),
+			static_cast<uint32_t>(commandBuffers.size()),
+			commandBuffers.data());
+		computePipeline.reset();
+		vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+		for (size_t i = 0; i < particleBuffers.size(); i++)
+		{
+			vkDestroyBuffer(lveDevice.device(), particleBuffers[i], nullptr);
+			vkFreeMemory(lveDevice.device(), particleBufferMemory[i], nullptr);
+		}//end for
+	}//destructor
+
+	void LveParticleSystem::createBuffers()
+	{
+		VkDeviceSize bufferSize = sizeof(Particle) * particleCount;
+
+		//A ring of particles drifting around the center, from a small LCG so every run looks the same
+		std::vector<Particle> particles(particleCount);
+		uint32_t state = 0x12345678u;
+		auto random = [&state]()
+		{
+			state = state * 1664525u + 1013904223u;
+			return static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+		};
+		for (auto& particle : particles)
+		{
+			float angle = random() * 6.2831853f;
+			float radius = 0.25f + 0.5f * std::sqrt(random());
+			particle.position = { radius * std::cos(angle), radius * std::sin(angle) };
+			float speed = 0.05f + 0.2f * random();
+			particle.velocity = { -std::sin(angle) * speed, std::cos(angle) * speed };
+		}//end for
+
+		//Written by the compute queue and read by the graphics queue, shared between both families
+		//when they differ
+		auto queueFamilies = lveDevice.findPhysicalQueueFamilies();
+		std::vector<uint32_t> sharedQueueFamilies = { queueFamilies.graphicsFamily, queueFamilies.computeFamily };
+		for (size_t i = 0; i < particleBuffers.size(); i++)
+		{
+			lveDevice.createBuffer(
+				bufferSize,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				particleBuffers[i],
+				particleBufferMemory[i],
+				sharedQueueFamilies);
+		}//end for
+
+		VkBuffer stagingBuffer;
+		VkDeviceMemory stagingBufferMemory;
+		lveDevice.createBuffer(
+			bufferSize,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			stagingBuffer,
+			stagingBufferMemory);
+
+		void* data;
+		vkMapMemory(lveDevice.device(), stagingBufferMemory, 0, bufferSize, 0, &data);
+		std::memcpy(data, particles.data(), static_cast<size_t>(bufferSize));
+		vkUnmapMemory(lveDevice.device(), stagingBufferMemory);
+
+		//Only the first buffer needs the start state, the first step writes the second one
+		lveDevice.copyBuffer(stagingBuffer, particleBuffers[0], bufferSize);
+
+		vkDestroyBuffer(lveDevice.device(), stagingBuffer, nullptr);
+		vkFreeMemory(lveDevice.device(), stagingBufferMemory, nullptr);
+	}//end createBuffers
+
+	void LveParticleSystem::createDescriptorSets(LveDescriptorLayoutCache& layoutCache, LveDescriptorSetCache& setCache)
+	{
+		LveDescriptorLayoutInfo layoutInfo{};
+		for (uint32_t binding = 0; binding < 2; binding++)
+		{
+			VkDescriptorSetLayoutBinding layoutBinding{};
+			layoutBinding.binding = binding;
+			layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			layoutBinding.descriptorCount = 1;
+			layoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			layoutInfo.bindings.push_back(layoutBinding);
+		}//end for
+		VkDescriptorSetLayout setLayout = layoutCache.getLayout(layoutInfo);
+
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			//Binding 0 is the particles in, binding 1 the particles out
+			std::vector<LveDescriptorWrite> writes(2);
+			for (uint32_t binding = 0; binding < 2; binding++)
+			{
+				writes[binding].binding = binding;
+				writes[binding].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				writes[binding].bufferInfo.buffer = particleBuffers[binding == 0 ? i : 1 - i];
+				writes[binding].bufferInfo.offset = 0;
+				writes[binding].bufferInfo.range = VK_WHOLE_SIZE;
+			}//end for
+			descriptorSets[i] = setCache.getSet(setLayout, writes);
+		}//end for
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(ParticlePushConstantData);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &setLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create particle pipeline layout!");
+		}//end if
+	}//end createDescriptorSets
+
+	void LveParticleSystem::createPipeline()
+	{
+		computePipeline = std::make_unique<LveComputePipeline>(
+			lveDevice,
+			"shaders/particle.comp.spv",
+			pipelineLayout);
+	}//end createPipeline
+
+	void LveParticleSystem::createCommandBuffers()
+	{
+		commandBuffers.resize(framesInFlight);
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = lveDevice.getComputeCommandPool();
+		allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+		if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate particle command buffers!");
+		}//end if
+	}//end createCommandBuffers
+
+	void LveParticleSystem::createSyncObjects()
+	{
+		computeFinishedSemaphores.resize(framesInFlight);
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		for (auto& semaphore : computeFinishedSemaphores)
+		{
+			if (vkCreateSemaphore(lveDevice.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create particle semaphores!");
+			}//end if
+		}//end for
+	}//end createSyncObjects
+
+	void LveParticleSystem::createQueryPool()
+	{
+		queriesWritten.assign(framesInFlight, false);
+		//Timestamps on every graphics and compute queue, otherwise the step simply goes untimed
+		if (!lveDevice.properties.limits.timestampComputeAndGraphics)
+		{
+			return;
+		}//end if
+
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = 2 * framesInFlight;
+		if (vkCreateQueryPool(lveDevice.device(), &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create particle query pool!");
+		}//end if
+	}//end createQueryPool
+
+	void LveParticleSystem::readStepTime(uint32_t frameIndex)
+	{
+		if (queryPool == VK_NULL_HANDLE || !queriesWritten[frameIndex])
+		{
+			return;
+		}//end if
+		//The slot fence has been waited on, so the step recorded here last time is complete
+		uint64_t timestamps[2];
+		if (vkGetQueryPoolResults(
+			lveDevice.device(),
+			queryPool,
+			2 * frameIndex,
+			2,
+			sizeof(timestamps),
+			timestamps,
+			sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+		{
+			lastStepTime = static_cast<double>(timestamps[1] - timestamps[0]) *
+				lveDevice.properties.limits.timestampPeriod / 1e6;
+		}//end if
+	}//end readStepTime
+
+	VkSemaphore LveParticleSystem::simulate(uint32_t frameIndex, float deltaTime)
+	{
+		readStepTime(frameIndex);
+
+		VkCommandBuffer commandBuffer = commandBuffers[frameIndex];
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to begin recording particle command buffer!");
+		}//end if
+
+		if (queryPool != VK_NULL_HANDLE)
+		{
+			vkCmdResetQueryPool(commandBuffer, queryPool, 2 * frameIndex, 2);
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 2 * frameIndex);
+		}//end if
+
+		//The previous step, submitted earlier on this same queue, wrote the buffer this one reads
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1,
+			&barrier,
+			0,
+			nullptr,
+			0,
+			nullptr);
+
+		computePipeline->bind(commandBuffer);
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			pipelineLayout,
+			0,
+			1,
+			&descriptorSets[currentBuffer],
+			0,
+			nullptr);
+
+		ParticlePushConstantData push{};
+		push.deltaTime = deltaTime;
+		push.particleCount = particleCount;
+		vkCmdPushConstants(
+			commandBuffer,
+			pipelineLayout,
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			sizeof(ParticlePushConstantData),
+			&push);
+		computePipeline->dispatch(commandBuffer, particleCount, WORKGROUP_SIZE);
+
+		if (queryPool != VK_NULL_HANDLE)
+		{
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 2 * frameIndex + 1);
+			queriesWritten[frameIndex] = true;
+		}//end if
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to record particle command buffer!");
+		}//end if
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &computeFinishedSemaphores[frameIndex];
+		if (vkQueueSubmit(lveDevice.computeQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to submit particle command buffer!");
+		}//end if
+
+		currentBuffer = 1 - currentBuffer;
+		return computeFinishedSemaphores[frameIndex];
+	}//end simulate
+
+	void LveParticleSystem::draw(VkCommandBuffer commandBuffer)
+	{
+		VkBuffer buffers[] = { particleBuffers[currentBuffer] };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		vkCmdDraw(commandBuffer, particleCount, 1, 0, 0);
+	}//end draw
+
+	std::vector<VkVertexInputBindingDescription> LveParticleSystem::getBindingDescriptions()
+	{
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+		bindingDescriptions[0].binding = 0;
+		bindingDescriptions[0].stride = sizeof(Particle);
+		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		return bindingDescriptions;
+	}//end getBindingDescriptions
+
+	std::vector<VkVertexInputAttributeDescription> LveParticleSystem::getAttributeDescriptions()
+	{
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
+		attributeDescriptions[0].binding = 0;
+		attributeDescriptions[0].location = 0;
+		attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+		attributeDescriptions[0].offset = offsetof(Particle, position);
+		attributeDescriptions[1].binding = 0;
+		attributeDescriptions[1].location = 1;
+		attributeDescriptions[1].format = VK_FORMAT_R32G32_SFLOAT;
+		attributeDescriptions[1].offset = offsetof(Particle, velocity);
+		return attributeDescriptions;
+	}//end getAttributeDescriptions
+}//end namespace
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "lve_compute_pipeline.h"
+#include "lve_descriptors.h"
+#include "lve_device.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+//std
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace lve
+{
+	//Particles simulated entirely on the GPU. Every frame a compute pass on the compute queue reads
+	//the particles from one storage buffer and writes the next step into the other, which the
+	//graphics queue then draws as points straight from that buffer.
+	//The step of frame N only touches the buffer drawn two frames ago (its frame slot fence has
+	//already been waited on), so it runs while the graphics queue is still drawing frame N - 1.
+	class LveParticleSystem
+	{
+	public:
+		struct Particle
+		{
+			glm::vec2 position;
+			glm::vec2 velocity;
+		};
+
+		//Must match local_size_x of particle.comp
+		static constexpr uint32_t WORKGROUP_SIZE = 256;
+
+		LveParticleSystem(
+			LveDevice& device,
+			LveDescriptorLayoutCache& layoutCache,
+			LveDescriptorSetCache& setCache,
+			uint32_t particleCount,
+			uint32_t framesInFlight);
+		~LveParticleSystem();
+
+		LveParticleSystem(const LveParticleSystem&) = delete;
+		LveParticleSystem& operator=(const LveParticleSystem&) = delete;
+
+		//Records and submits the step of this frame on the compute queue. The frame slot must be
+		//free (its fence waited on). The returned semaphore is signaled once the step is done, the
+		//graphics submit that draws the particles waits on it at the vertex input stage.
+		VkSemaphore simulate(uint32_t frameIndex, float deltaTime);
+		//Draws the particles written by the last simulate call as a point list
+		void draw(VkCommandBuffer commandBuffer);
+
+		static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+
+		uint32_t getParticleCount() const { return particleCount; }
+		//GPU time of the step finished last in milliseconds, 0 when the compute queue has no timestamps
+		double getLastStepTime() const { return lastStepTime; }
+
+	private:
+		void createBuffers();
+		void createDescriptorSets(LveDescriptorLayoutCache& layoutCache, LveDescriptorSetCache& setCache);
+		void createPipeline();
+		void createCommandBuffers();
+		void createSyncObjects();
+		void createQueryPool();
+		void readStepTime(uint32_t frameIndex);
+
+		LveDevice& lveDevice;
+		uint32_t particleCount;
+		uint32_t framesInFlight;
+
+		//Ping-pong pair, the step reads one and writes the other
+		std::array<VkBuffer, 2> particleBuffers{};
+		std::array<VkDeviceMemory, 2> particleBufferMemory{};
+		//Set i reads buffer i and writes the other one
+		std::array<VkDescriptorSet, 2> descriptorSets{};
+		//Buffer holding the latest step
+		uint32_t currentBuffer = 0;
+
+		VkPipelineLayout pipelineLayout;
+		std::unique_ptr<LveComputePipeline> computePipeline;
+
+		std::vector<VkCommandBuffer> commandBuffers;
+		std::vector<VkSemaphore> computeFinishedSemaphores;
+
+		//Two timestamps per frame slot, VK_NULL_HANDLE when unsupported
+		VkQueryPool queryPool = VK_NULL_HANDLE;
+		std::vector<bool> queriesWritten;
+		double lastStepTime = 0.0;
+	};//end class LveParticleSystem
+}//end namespace
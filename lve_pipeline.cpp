@@ -2,27 +2,172 @@
 
 #include "lve_model.h"
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <stdexcept>
 #include <iostream>
 #include <cassert>
 
 namespace lve
 {
+	namespace
+	{
+		//FNV-1a over raw bytes, the state structs are hashed field by field into it
+		void hashBytes(uint64_t& hash, const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}//end for
+		}//end hashBytes
+
+		template<typename T>
+		void hashValue(uint64_t& hash, const T& value)
+		{
+			hashBytes(hash, &value, sizeof(T));
+		}//end hashValue
+
+		//Constants sorted by id with their values, so the order of the set calls does not matter
+		std::vector<std::pair<uint32_t, std::vector<uint8_t>>> sortedConstants(const LveSpecialization& specialization)
+		{
+			std::vector<std::pair<uint32_t, std::vector<uint8_t>>> constants;
+			for (auto& entry : specialization.mapEntries)
+			{
+				auto first = specialization.data.begin() + entry.offset;
+				constants.push_back({ entry.constantID, std::vector<uint8_t>(first, first + entry.size) });
+			}//end for
+			std::sort(constants.begin(), constants.end());
+			return constants;
+		}//end sortedConstants
+	}//end namespace
+
+	bool LveSpecialization::operator<(const LveSpecialization& other) const
+	{
+		return sortedConstants(*this) < sortedConstants(other);
+	}//end operator<
+
+	uint64_t PipelineConfigInfo::stateHash() const
+	{
+		uint64_t hash = 14695981039346656037ull;
+		auto isDynamic = [this](VkDynamicState state)
+		{
+			return std::find(dynamicStateEnables.begin(), dynamicStateEnables.end(), state) != dynamicStateEnables.end();
+		};
+		if (!isDynamic(VK_DYNAMIC_STATE_VIEWPORT))
+		{
+			hashValue(hash, viewport);
+		}//end if
+		if (!isDynamic(VK_DYNAMIC_STATE_SCISSOR))
+		{
+			hashValue(hash, scissor);
+		}//end if
+
+		hashValue(hash, inputAssemblyInfo.topology);
+		hashValue(hash, inputAssemblyInfo.primitiveRestartEnable);
+
+		hashValue(hash, rasterizationInfo.depthClampEnable);
+		hashValue(hash, rasterizationInfo.rasterizerDiscardEnable);
+		hashValue(hash, rasterizationInfo.polygonMode);
+		hashValue(hash, rasterizationInfo.cullMode);
+		hashValue(hash, rasterizationInfo.frontFace);
+		hashValue(hash, rasterizationInfo.depthBiasEnable);
+		hashValue(hash, rasterizationInfo.depthBiasConstantFactor);
+		hashValue(hash, rasterizationInfo.depthBiasClamp);
+		hashValue(hash, rasterizationInfo.depthBiasSlopeFactor);
+		hashValue(hash, rasterizationInfo.lineWidth);
+
+		hashValue(hash, multisampleInfo.rasterizationSamples);
+		hashValue(hash, multisampleInfo.sampleShadingEnable);
+		hashValue(hash, multisampleInfo.minSampleShading);
+		hashValue(hash, multisampleInfo.alphaToCoverageEnable);
+		hashValue(hash, multisampleInfo.alphaToOneEnable);
+
+		hashValue(hash, colorBlendAttachment);
+		hashValue(hash, colorBlendInfo.logicOpEnable);
+		hashValue(hash, colorBlendInfo.logicOp);
+		hashValue(hash, colorBlendInfo.attachmentCount);
+		hashValue(hash, colorBlendInfo.blendConstants);
+
+		hashValue(hash, depthStencilInfo.depthTestEnable);
+		hashValue(hash, depthStencilInfo.depthWriteEnable);
+		hashValue(hash, depthStencilInfo.depthCompareOp);
+		hashValue(hash, depthStencilInfo.depthBoundsTestEnable);
+		hashValue(hash, depthStencilInfo.stencilTestEnable);
+		hashValue(hash, depthStencilInfo.front);
+		hashValue(hash, depthStencilInfo.back);
+		hashValue(hash, depthStencilInfo.minDepthBounds);
+		hashValue(hash, depthStencilInfo.maxDepthBounds);
+
+		for (auto& binding : bindingDescriptions)
+		{
+			hashValue(hash, binding);
+		}//end for
+		for (auto& attribute : attributeDescriptions)
+		{
+			hashValue(hash, attribute);
+		}//end for
+		for (auto state : dynamicStateEnables)
+		{
+			hashValue(hash, state);
+		}//end for
+
+		hashValue(hash, pipelineLayout);
+		hashValue(hash, renderPass);
+		hashValue(hash, subpass);
+		for (auto format : colorAttachmentFormats)
+		{
+			hashValue(hash, format);
+		}//end for
+		hashValue(hash, depthAttachmentFormat);
+		return hash;
+	}//end stateHash
+
 	LvePipeline::LvePipeline(
 		LveDevice& device,
 		const std::string& vertFilepath,
 		const std::string& fragFilepath,
 		const PipelineConfigInfo& configInfo) : lveDevice{device}
 	{
-		createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
+		auto vertCode = readFile(vertFilepath);
+		createShaderModule(lveDevice, vertCode, &vertShaderModule);
+
+		//A pipeline without fragment shader only writes depth (depth pre-pass)
+		if (!fragFilepath.empty())
+		{
+			auto fragCode = readFile(fragFilepath);
+			createShaderModule(lveDevice, fragCode, &fragShaderModule);
+		}//end if
+
+		createGraphicsPipeline(configInfo);
+	}//end LvePipeline
+
+	LvePipeline::LvePipeline(
+		LveDevice& device,
+		VkShaderModule vertShaderModule,
+		VkShaderModule fragShaderModule,
+		const PipelineConfigInfo& configInfo)
+		: lveDevice{ device },
+		vertShaderModule{ vertShaderModule },
+		fragShaderModule{ fragShaderModule },
+		ownsShaderModules{ false }
+	{
+		createGraphicsPipeline(configInfo);
 	}//end LvePipeline
 
 	LvePipeline::~LvePipeline()
 	{
-		vkDestroyShaderModule(lveDevice.device(), vertShaderModule, nullptr);
-		vkDestroyShaderModule(lveDevice.device(), fragShaderModule, nullptr);
-		vkDestroyPipeline(lveDevice.device(), graphicsPipeline, nullptr);
+		if (ownsShaderModules)
+		{
+			vkDestroyShaderModule(lveDevice.device(), vertShaderModule, nullptr);
+			vkDestroyShaderModule(lveDevice.device(), fragShaderModule, nullptr);
+		}//end if
+		//Modules are only needed to create the pipeline, the pipeline itself waits for the frames using it
+		LveReleasedResources resources{};
+		resources.pipeline = graphicsPipeline;
+		lveDevice.deletionQueue().release(resources);
 	}
 
 	std::vector<char> LvePipeline::readFile(const std::string& filepath)
@@ -49,20 +194,31 @@ namespace lve
 		return buffer;
 	}//end readFile
 
-	void LvePipeline::createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo)
+	void LvePipeline::createGraphicsPipeline(const PipelineConfigInfo& configInfo)
 	{
 		assert(
 			configInfo.pipelineLayout != VK_NULL_HANDLE &&
 			"Cannot create graphics pipeline:: no pipelineLayout provided in configInfo");
 		assert(
-			configInfo.renderPass != VK_NULL_HANDLE &&
-			"Cannot create graphics pipeline:: no renderPass provided in configInfo");
-
-		auto vertCode = readFile(vertFilepath);
-		auto fragCode = readFile(fragFilepath);
-
-		createShaderModule(vertCode, &vertShaderModule);
-		createShaderModule(fragCode, &fragShaderModule);
+			(configInfo.renderPass != VK_NULL_HANDLE ||
+				!configInfo.colorAttachmentFormats.empty() ||
+				configInfo.depthAttachmentFormat != VK_FORMAT_UNDEFINED) &&
+			"Cannot create graphics pipeline:: no renderPass or attachment formats provided in configInfo");
+
+		//A pipeline without fragment shader only writes depth (depth pre-pass)
+		uint32_t stageCount = fragShaderModule != VK_NULL_HANDLE ? 2 : 1;
+
+		//Constant values are copied into the driver's compiled shader, the infos only need to live
+		//until the pipeline is created
+		VkSpecializationInfo specializationInfos[2]{};
+		const LveSpecialization* specializations[2] = { &configInfo.vertexSpecialization, &configInfo.fragmentSpecialization };
+		for (int i = 0; i < 2; i++)
+		{
+			specializationInfos[i].mapEntryCount = static_cast<uint32_t>(specializations[i]->mapEntries.size());
+			specializationInfos[i].pMapEntries = specializations[i]->mapEntries.data();
+			specializationInfos[i].dataSize = specializations[i]->data.size();
+			specializationInfos[i].pData = specializations[i]->data.data();
+		}//end for
 
 		VkPipelineShaderStageCreateInfo shaderStages[2];
 		//Vertex shader configuration
@@ -72,7 +228,7 @@ namespace lve
 		shaderStages[0].pName = "main"; //Entry function of our vertex shader
 		shaderStages[0].flags = 0;
 		shaderStages[0].pNext = nullptr;
-		shaderStages[0].pSpecializationInfo = nullptr;
+		shaderStages[0].pSpecializationInfo = specializations[0]->empty() ? nullptr : &specializationInfos[0];
 
 		//Fragment shader configuration 
 		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -81,11 +237,11 @@ namespace lve
 		shaderStages[1].pName = "main"; //Entry function of our vertex shader
 		shaderStages[1].flags = 0;
 		shaderStages[1].pNext = nullptr;
-		shaderStages[1].pSpecializationInfo = nullptr;
+		shaderStages[1].pSpecializationInfo = specializations[1]->empty() ? nullptr : &specializationInfos[1];
 
 		//Struct is used to describe how we interpret our vertex buffer data that is the initial input into our graphics pipeline
-		auto bindingDescriptions = LveModel::Vertex::getBindingDescriptions();
-		auto attributeDescriptions = LveModel::Vertex::getAttributeDescriptions();
+		auto& bindingDescriptions = configInfo.bindingDescriptions;
+		auto& attributeDescriptions = configInfo.attributeDescriptions;
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
@@ -96,7 +252,7 @@ namespace lve
 		// Will specify all the configuration we just gave above to make the graphic pipeline
 		VkGraphicsPipelineCreateInfo pipelineInfo{};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = 2; //how many programmable stages (just vertex and frag shader)
+		pipelineInfo.stageCount = stageCount; //how many programmable stages (just vertex and frag shader)
 		pipelineInfo.pStages = shaderStages;
 		//wire our pipeline create info to our config info
 		pipelineInfo.pVertexInputState = &vertexInputInfo;
@@ -107,12 +263,23 @@ namespace lve
 
 		pipelineInfo.pColorBlendState = &configInfo.colorBlendInfo;
 		pipelineInfo.pDepthStencilState = &configInfo.depthStencilInfo;
-		pipelineInfo.pDynamicState = nullptr;
+		pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
 
 		pipelineInfo.layout = configInfo.pipelineLayout;
 		pipelineInfo.renderPass = configInfo.renderPass;
 		pipelineInfo.subpass = configInfo.subpass;
 
+		//Dynamic rendering: no render pass, the formats it will draw into instead
+		VkPipelineRenderingCreateInfoKHR renderingInfo{};
+		if (configInfo.renderPass == VK_NULL_HANDLE)
+		{
+			renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+			renderingInfo.colorAttachmentCount = static_cast<uint32_t>(configInfo.colorAttachmentFormats.size());
+			renderingInfo.pColorAttachmentFormats = configInfo.colorAttachmentFormats.data();
+			renderingInfo.depthAttachmentFormat = configInfo.depthAttachmentFormat;
+			pipelineInfo.pNext = &renderingInfo;
+		}//end if
+
 		pipelineInfo.basePipelineIndex = -1;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
@@ -128,14 +295,14 @@ namespace lve
 
 	}//end createGraphicsPipeline
 
-	void LvePipeline::createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule)
+	void LvePipeline::createShaderModule(LveDevice& device, const std::vector<char>& code, VkShaderModule* shaderModule)
 	{
 		VkShaderModuleCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 		createInfo.codeSize = code.size();
 		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
 
-		if (vkCreateShaderModule(lveDevice.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
+		if (vkCreateShaderModule(device.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to create shader module");
 		}//end if 
@@ -238,6 +405,117 @@ namespace lve
 		configInfo.depthStencilInfo.front = {};  // Optional
 		configInfo.depthStencilInfo.back = {};   // Optional
 
+		//Viewport and scissor are set while recording, so the same pipeline works for any render area
+		//(dynamic resolution renders to a varying part of the scene target)
+		configInfo.dynamicStateEnables = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+		configInfo.dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
+		configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
+		configInfo.dynamicStateInfo.flags = 0;
+		configInfo.dynamicStateInfo.pNext = nullptr;
+
+		//Vertex input, by default the full vertex layout of our models
+		configInfo.bindingDescriptions = LveModel::Vertex::getBindingDescriptions();
+		configInfo.attributeDescriptions = LveModel::Vertex::getAttributeDescriptions();
+
 	}//end defaultPipelineConfigInfo
 
+	void LvePipeline::depthPrePassPipelineConfigInfo(PipelineConfigInfo& configInfo, uint32_t width, uint32_t height)
+	{
+		defaultPipelineConfigInfo(configInfo, width, height);
+
+		//The pre-pass only needs positions, fetching the rest of the vertex would be wasted bandwidth
+		configInfo.attributeDescriptions = LveModel::Vertex::getPositionAttributeDescriptions();
+
+		//Keep the color attachment in the blend state (it has to match the subpass) but never write to it
+		configInfo.colorBlendAttachment.colorWriteMask = 0;
+
+		configInfo.depthStencilInfo.depthTestEnable = VK_TRUE;
+		configInfo.depthStencilInfo.depthWriteEnable = VK_TRUE;
+		configInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+	}//end depthPrePassPipelineConfigInfo
+
+	void LvePipeline::depthTestAfterPrePass(PipelineConfigInfo& configInfo, VkCompareOp compareOp)
+	{
+		assert(
+			(compareOp == VK_COMPARE_OP_EQUAL || compareOp == VK_COMPARE_OP_LESS_OR_EQUAL) &&
+			"Main pass after a depth pre-pass must test EQUAL or LESS_OR_EQUAL");
+		//Depth is final after the pre-pass, writing it again would only cost bandwidth
+		configInfo.depthStencilInfo.depthTestEnable = VK_TRUE;
+		configInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
+		configInfo.depthStencilInfo.depthCompareOp = compareOp;
+	}//end depthTestAfterPrePass
+
+	LvePipelineVariantCache::LvePipelineVariantCache(LveDevice& device) : lveDevice{ device }
+	{
+	}//constructor
+
+	LvePipelineVariantCache::~LvePipelineVariantCache()
+	{
+		//Pipelines first, they borrow the modules
+		variants.clear();
+		for (auto& entry : shaderModules)
+		{
+			vkDestroyShaderModule(lveDevice.device(), entry.second, nullptr);
+		}//end for
+	}//destructor
+
+	LvePipeline* LvePipelineVariantCache::getPipeline(
+		const std::string& vertFilepath,
+		const std::string& fragFilepath,
+		const PipelineConfigInfo& configInfo)
+	{
+		VariantKey key{
+			vertFilepath,
+			fragFilepath,
+			configInfo.vertexSpecialization,
+			configInfo.fragmentSpecialization,
+			configInfo.stateHash() };
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		auto found = variants.find(key);
+		if (found != variants.end())
+		{
+			return found->second.get();
+		}//end if
+
+		VkShaderModule vertModule = getShaderModule(vertFilepath);
+		VkShaderModule fragModule = fragFilepath.empty() ? VK_NULL_HANDLE : getShaderModule(fragFilepath);
+		auto pipeline = std::make_unique<LvePipeline>(lveDevice, vertModule, fragModule, configInfo);
+		LvePipeline* result = pipeline.get();
+		variants.emplace(std::move(key), std::move(pipeline));
+		return result;
+	}//end getPipeline
+
+	size_t LvePipelineVariantCache::getVariantCount()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return variants.size();
+	}//end getVariantCount
+
+	void LvePipelineVariantCache::addShaderCode(const std::string& filepath, const std::vector<char>& code)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		if (shaderModules.find(filepath) != shaderModules.end())
+		{
+			return;
+		}//end if
+		VkShaderModule shaderModule;
+		LvePipeline::createShaderModule(lveDevice, code, &shaderModule);
+		shaderModules.emplace(filepath, shaderModule);
+	}//end addShaderCode
+
+	VkShaderModule LvePipelineVariantCache::getShaderModule(const std::string& filepath)
+	{
+		auto found = shaderModules.find(filepath);
+		if (found != shaderModules.end())
+		{
+			return found->second;
+		}//end if
+		VkShaderModule shaderModule;
+		LvePipeline::createShaderModule(lveDevice, LvePipeline::readFile(filepath), &shaderModule);
+		shaderModules.emplace(filepath, shaderModule);
+		return shaderModule;
+	}//end getShaderModule
+
 }//end namespace
@@ -1,11 +1,47 @@
 #pragma once
 
 #include "lve_device.h"
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <tuple>
 #include <vector>
 
 namespace lve 
 {
+	//Values for the constant_id constants of one shader stage. The driver compiles the stage with
+	//them baked in, so a branch on a specialization constant costs nothing at run time.
+	struct LveSpecialization
+	{
+		std::vector<VkSpecializationMapEntry> mapEntries;
+		std::vector<uint8_t> data;
+
+		//bool constants take a VkBool32, int/uint/float their 32 bit type
+		template<typename T>
+		void set(uint32_t constantId, const T& value)
+		{
+			static_assert(sizeof(T) == 4, "specialization constants are 32 bit values");
+			for (auto& entry : mapEntries)
+			{
+				if (entry.constantID == constantId)
+				{
+					std::memcpy(data.data() + entry.offset, &value, sizeof(T));
+					return;
+				}//end if
+			}//end for
+			mapEntries.push_back({ constantId, static_cast<uint32_t>(data.size()), sizeof(T) });
+			data.resize(data.size() + sizeof(T));
+			std::memcpy(data.data() + mapEntries.back().offset, &value, sizeof(T));
+		}//end set
+
+		bool empty() const { return mapEntries.empty(); }
+		//Same constants with the same values, no matter the order they were set in
+		bool operator<(const LveSpecialization& other) const;
+	};
+
 	struct PipelineConfigInfo 
 	{
 		PipelineConfigInfo(const PipelineConfigInfo&) = delete;
@@ -20,9 +56,22 @@ namespace lve
 		VkPipelineColorBlendAttachmentState colorBlendAttachment;
 		VkPipelineColorBlendStateCreateInfo colorBlendInfo;
 		VkPipelineDepthStencilStateCreateInfo depthStencilInfo;
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+		std::vector<VkDynamicState> dynamicStateEnables;
+		VkPipelineDynamicStateCreateInfo dynamicStateInfo;
 		VkPipelineLayout pipelineLayout = nullptr;
 		VkRenderPass renderPass = nullptr;
 		uint32_t subpass = 0;
+		//Without a render pass (dynamic rendering) the pipeline only declares the formats it draws into,
+		//and works with every pass that has those
+		std::vector<VkFormat> colorAttachmentFormats;
+		VkFormat depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+		LveSpecialization vertexSpecialization;
+		LveSpecialization fragmentSpecialization;
+
+		//Hash of the fixed function state, render pass (or attachment formats) and layout (not the shaders or their constants)
+		uint64_t stateHash() const;
 	};
 	class LvePipeline 
 	{
@@ -32,6 +81,13 @@ namespace lve
 			const std::string& vertFilepath,
 			const std::string& fragFilepath, 
 			const PipelineConfigInfo& configInfo);
+		//Borrows already created shader modules (fragShaderModule may be VK_NULL_HANDLE), they must
+		//outlive the pipeline
+		LvePipeline(
+			LveDevice& device,
+			VkShaderModule vertShaderModule,
+			VkShaderModule fragShaderModule,
+			const PipelineConfigInfo& configInfo);
 		~LvePipeline();
 
 		LvePipeline(const LvePipeline&) = delete;
@@ -40,21 +96,64 @@ namespace lve
 		void bind(VkCommandBuffer commandBuffer);
 
 		static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo, uint32_t width, uint32_t height);
+		//Depth only variant: position only vertex input and no color writes, used to lay down depth first
+		static void depthPrePassPipelineConfigInfo(PipelineConfigInfo& configInfo, uint32_t width, uint32_t height);
+		//Turns a config into the main pass that follows a depth pre-pass: depth is already written, so only
+		//the front most fragment passes the test and gets shaded
+		static void depthTestAfterPrePass(PipelineConfigInfo& configInfo, VkCompareOp compareOp = VK_COMPARE_OP_EQUAL);
 
-	private:
+		//Whole file as bytes, also used to read SPIR-V ahead of time for LvePipelineVariantCache::addShaderCode
 		static std::vector<char> readFile(const std::string& filepath);
 
-		void createGraphicsPipeline(
-			const std::string& vertFilepath, 
-			const std::string& fragFilepath,
-			const PipelineConfigInfo& configInfo);
+	private:
+		friend class LvePipelineVariantCache;
+		friend class LveComputePipeline;
+
+		static void createShaderModule(LveDevice& device, const std::vector<char>& code, VkShaderModule* shaderModule);
 
-		void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
+		void createGraphicsPipeline(const PipelineConfigInfo& configInfo);
 
 		LveDevice& lveDevice;
 		VkPipeline graphicsPipeline;
 		VkShaderModule vertShaderModule;
-		VkShaderModule fragShaderModule;
+		VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+		bool ownsShaderModules = true;
 
 	};//end class
+
+	//Builds every permutation of a pipeline once: the key is the pair of shader files, the
+	//specialization constants of each stage and the state hash of the config. Each SPIR-V file is
+	//read and turned into a shader module once and shared by all of its variants.
+	class LvePipelineVariantCache
+	{
+	public:
+		LvePipelineVariantCache(LveDevice& device);
+		~LvePipelineVariantCache();
+
+		LvePipelineVariantCache(const LvePipelineVariantCache&) = delete;
+		LvePipelineVariantCache& operator=(const LvePipelineVariantCache&) = delete;
+
+		//Safe from any thread, the pipeline lives as long as the cache. fragFilepath may be empty.
+		LvePipeline* getPipeline(
+			const std::string& vertFilepath,
+			const std::string& fragFilepath,
+			const PipelineConfigInfo& configInfo);
+
+		size_t getVariantCount();
+
+		//Creates the shader module of filepath from code read ahead of time (e.g. while the device was
+		//being created), getPipeline then never reads that file. Safe from any thread.
+		void addShaderCode(const std::string& filepath, const std::vector<char>& code);
+
+	private:
+		using VariantKey = std::tuple<std::string, std::string, LveSpecialization, LveSpecialization, uint64_t>;
+
+		VkShaderModule getShaderModule(const std::string& filepath);
+
+		LveDevice& lveDevice;
+
+		std::mutex mutex;
+		std::map<std::string, VkShaderModule> shaderModules;
+		std::map<VariantKey, std::unique_ptr<LvePipeline>> variants;
+	};//end class LvePipelineVariantCache
 }//end namespace
@@ -0,0 +1,253 @@
+#include "lve_post_process.h"
+
+//std
+#include <stdexcept>
+#include <vector>
+
+namespace lve
+{
+	//Push constants of tonemap.frag and grade.frag, each reads the members it needs
+	struct SubpassPushConstantData
+	{
+		float exposure;
+		float contrast;
+		float saturation;
+	};
+
+	//Push constants of bloom.comp
+	struct BloomPushConstantData
+	{
+		int32_t renderWidth;
+		int32_t renderHeight;
+		float threshold;
+		float intensity;
+	};
+
+	LvePostProcess::LvePostProcess(
+		LveDevice& device,
+		LveRenderGraph& graph,
+		LveDynamicResolution& sceneTarget,
+		VkFormat colorFormat)
+		: lveDevice{ device }, graph{ graph }, sceneTarget{ sceneTarget }
+	{
+		if (sceneTarget.getColorFormat() != SCENE_FORMAT)
+		{
+			throw std::runtime_error("scene target is not drawn in the post processing scene format!");
+		}//end if
+
+		RenderGraphImageInfo imageInfo{};
+		imageInfo.extent = sceneTarget.getFullExtent();
+		imageInfo.format = colorFormat;
+		RenderGraphResource tonemapped = graph.createImage("tonemapped color", imageInfo);
+		graded = graph.createImage("graded color", imageInfo);
+		imageInfo.format = OUTPUT_FORMAT;
+		output = graph.createImage("post output", imageInfo);
+
+		//Each subpass only reads the pixel it writes, nothing in between ever has to leave the tile
+		subpassInputs = { sceneTarget.getColor(), tonemapped };
+		subpasses[0] = &graph.addPass("tonemap")
+			.readAttachment(sceneTarget.getColor())
+			.writeColor(tonemapped)
+			.setRecord([this](VkCommandBuffer commandBuffer) { drawSubpass(commandBuffer, 0); });
+		subpasses[1] = &graph.addPass("grade")
+			.readAttachment(tonemapped)
+			.writeColor(graded)
+			.setRecord([this](VkCommandBuffer commandBuffer) { drawSubpass(commandBuffer, 1); });
+		graph.addPass("bloom")
+			.readTexture(graded, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT)
+			.writeStorage(output, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT)
+			.setRecord([this](VkCommandBuffer commandBuffer) { applyBloom(commandBuffer); });
+	}//constructor
+
+	LvePostProcess::~LvePostProcess()
+	{
+		bloomPipeline.reset();
+		vkDestroyPipelineLayout(lveDevice.device(), bloomPipelineLayout, nullptr);
+		vkDestroySampler(lveDevice.device(), sampler, nullptr);
+		//The pipelines belong to the variant cache, the images to the graph
+		vkDestroyPipelineLayout(lveDevice.device(), subpassPipelineLayout, nullptr);
+	}//destructor
+
+	void LvePostProcess::createPipelines(
+		LveDescriptorLayoutCache& layoutCache,
+		LveDescriptorSetCache& setCache,
+		LvePipelineVariantCache& pipelineVariants)
+	{
+		createSubpassPipelines(layoutCache, setCache, pipelineVariants);
+		createBloom(layoutCache, setCache);
+	}//end createPipelines
+
+	void LvePostProcess::createSubpassPipelines(
+		LveDescriptorLayoutCache& layoutCache,
+		LveDescriptorSetCache& setCache,
+		LvePipelineVariantCache& pipelineVariants)
+	{
+		LveDescriptorLayoutInfo layoutInfo{};
+		VkDescriptorSetLayoutBinding inputBinding{};
+		inputBinding.binding = 0;
+		inputBinding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+		inputBinding.descriptorCount = 1;
+		inputBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		layoutInfo.bindings.push_back(inputBinding);
+		VkDescriptorSetLayout setLayout = layoutCache.getLayout(layoutInfo);
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(SubpassPushConstantData);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &setLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &subpassPipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create post processing pipeline layout!");
+		}//end if
+
+		//One triangle over the whole viewport, no vertex buffer, nothing tested or blended
+		const std::array<const char*, SUBPASS_COUNT> fragFilepaths = { "shaders/tonemap.frag.spv", "shaders/grade.frag.spv" };
+		for (uint32_t i = 0; i < SUBPASS_COUNT; i++)
+		{
+			PipelineConfigInfo configInfo{};
+			LvePipeline::defaultPipelineConfigInfo(configInfo, sceneTarget.getFullExtent().width, sceneTarget.getFullExtent().height);
+			configInfo.bindingDescriptions.clear();
+			configInfo.attributeDescriptions.clear();
+			configInfo.depthStencilInfo.depthTestEnable = VK_FALSE;
+			configInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
+			subpasses[i]->configurePipeline(configInfo);
+			configInfo.pipelineLayout = subpassPipelineLayout;
+			subpassPipelines[i] = pipelineVariants.getPipeline("shaders/fullscreen.vert.spv", fragFilepaths[i], configInfo);
+
+			LveDescriptorWrite write{};
+			write.binding = 0;
+			write.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			write.imageInfo.imageView = graph.getImageView(subpassInputs[i]);
+			write.imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			subpassSets[i] = setCache.getSet(setLayout, { write });
+		}//end for
+	}//end createSubpassPipelines
+
+	void LvePostProcess::createBloom(LveDescriptorLayoutCache& layoutCache, LveDescriptorSetCache& setCache)
+	{
+		//Only ever fetched from, the filter does not matter
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.maxLod = 0.0f;
+		if (vkCreateSampler(lveDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create post processing sampler!");
+		}//end if
+
+		//Graded scene color in, color plus bloom out
+		LveDescriptorLayoutInfo layoutInfo{};
+		VkDescriptorSetLayoutBinding layoutBinding{};
+		layoutBinding.binding = 0;
+		layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		layoutBinding.descriptorCount = 1;
+		layoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		layoutInfo.bindings.push_back(layoutBinding);
+		layoutBinding.binding = 1;
+		layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		layoutInfo.bindings.push_back(layoutBinding);
+		VkDescriptorSetLayout setLayout = layoutCache.getLayout(layoutInfo);
+
+		std::vector<LveDescriptorWrite> writes(2);
+		writes[0].binding = 0;
+		writes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].imageInfo.sampler = sampler;
+		writes[0].imageInfo.imageView = graph.getImageView(graded);
+		writes[0].imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		writes[1].binding = 1;
+		writes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].imageInfo.imageView = graph.getImageView(output);
+		writes[1].imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		bloomSet = setCache.getSet(setLayout, writes);
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(BloomPushConstantData);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &setLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &bloomPipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create bloom pipeline layout!");
+		}//end if
+
+		bloomPipeline = std::make_unique<LveComputePipeline>(
+			lveDevice,
+			"shaders/bloom.comp.spv",
+			bloomPipelineLayout);
+	}//end createBloom
+
+	void LvePostProcess::drawSubpass(VkCommandBuffer commandBuffer, uint32_t subpass)
+	{
+		SubpassPushConstantData push{};
+		push.exposure = settings.exposure;
+		push.contrast = settings.contrast;
+		push.saturation = settings.saturation;
+		//The graph set the viewport and scissor to the render area of the scene, only that is processed
+		subpassPipelines[subpass]->bind(commandBuffer);
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			subpassPipelineLayout,
+			0,
+			1,
+			&subpassSets[subpass],
+			0,
+			nullptr);
+		vkCmdPushConstants(
+			commandBuffer,
+			subpassPipelineLayout,
+			VK_SHADER_STAGE_FRAGMENT_BIT,
+			0,
+			sizeof(SubpassPushConstantData),
+			&push);
+		vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+	}//end drawSubpass
+
+	void LvePostProcess::applyBloom(VkCommandBuffer commandBuffer)
+	{
+		//The graph has the graded color sampleable and the output writable, nothing in the output is
+		//kept, every texel of the render area is written
+		VkExtent2D renderExtent = sceneTarget.getRenderExtent();
+		bloomPipeline->bind(commandBuffer);
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			bloomPipelineLayout,
+			0,
+			1,
+			&bloomSet,
+			0,
+			nullptr);
+		BloomPushConstantData push{};
+		push.renderWidth = static_cast<int32_t>(renderExtent.width);
+		push.renderHeight = static_cast<int32_t>(renderExtent.height);
+		push.threshold = settings.bloomThreshold;
+		push.intensity = settings.bloomIntensity;
+		vkCmdPushConstants(
+			commandBuffer,
+			bloomPipelineLayout,
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			sizeof(BloomPushConstantData),
+			&push);
+		bloomPipeline->dispatch(commandBuffer, renderExtent, { TILE_SIZE, TILE_SIZE });
+	}//end applyBloom
+}//end namespace
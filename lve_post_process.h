@@ -0,0 +1,97 @@
+#pragma once
+
+#include "lve_compute_pipeline.h"
+#include "lve_descriptors.h"
+#include "lve_device.h"
+#include "lve_dynamic_resolution.h"
+#include "lve_pipeline.h"
+#include "lve_render_graph.h"
+
+//std
+#include <array>
+#include <memory>
+
+namespace lve
+{
+	struct PostProcessSettings
+	{
+		//Scene color is scaled by this before it is tonemapped
+		float exposure = 1.0f;
+		//Color grading of the tonemapped image, 1 leaves it as it is
+		float contrast = 1.05f;
+		float saturation = 1.1f;
+		//What is brighter than the threshold (per channel) bleeds into its neighborhood
+		float bloomThreshold = 0.7f;
+		float bloomIntensity = 0.8f;
+	};
+
+	//Post processing of the scene target, split by what an effect reads. Per-pixel effects (tonemapping,
+	//color grading) are graph passes reading the pass before through an input attachment, so the graph
+	//runs them as subpasses of the scene render pass and on a tiler the chain costs no memory traffic at
+	//all. Bloom needs the neighborhood of a pixel and runs as a compute pass after it: every workgroup
+	//loads its tile plus an apron into shared memory once and blurs it there, one read of the image and
+	//one write in total.
+	class LvePostProcess
+	{
+	public:
+		//Tonemapping, then color grading
+		static constexpr uint32_t SUBPASS_COUNT = 2;
+		//What the scene target has to be drawn in, the tonemapping brings it down to the color format
+		static constexpr VkFormat SCENE_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+		//Written by the bloom pass, the source of the upscale blit
+		static constexpr VkFormat OUTPUT_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+		//Must match bloom.comp: output pixels per workgroup side, and blur taps on each side of a pixel
+		static constexpr uint32_t TILE_SIZE = 16;
+		static constexpr uint32_t BLOOM_RADIUS = 4;
+
+		//Adds the post passes to graph, right after the last scene pass so they can share its render pass
+		LvePostProcess(
+			LveDevice& device,
+			LveRenderGraph& graph,
+			LveDynamicResolution& sceneTarget,
+			VkFormat colorFormat);
+		~LvePostProcess();
+
+		LvePostProcess(const LvePostProcess&) = delete;
+		LvePostProcess& operator=(const LvePostProcess&) = delete;
+
+		//Once the graph is compiled, the pipelines need its render passes and images
+		void createPipelines(
+			LveDescriptorLayoutCache& layoutCache,
+			LveDescriptorSetCache& setCache,
+			LvePipelineVariantCache& pipelineVariants);
+
+		PostProcessSettings& getSettings() { return settings; }
+
+		//Written by the bloom pass, with the render area in its top left corner like the scene target
+		RenderGraphResource getOutput() { return output; }
+
+	private:
+		void createSubpassPipelines(LveDescriptorLayoutCache& layoutCache, LveDescriptorSetCache& setCache, LvePipelineVariantCache& pipelineVariants);
+		void createBloom(LveDescriptorLayoutCache& layoutCache, LveDescriptorSetCache& setCache);
+		//One full screen triangle
+		void drawSubpass(VkCommandBuffer commandBuffer, uint32_t subpass);
+		void applyBloom(VkCommandBuffer commandBuffer);
+
+		LveDevice& lveDevice;
+		LveRenderGraph& graph;
+		LveDynamicResolution& sceneTarget;
+		PostProcessSettings settings;
+
+		//What each subpass reads, the scene color then the tonemapped color
+		std::array<RenderGraphResource, SUBPASS_COUNT> subpassInputs{};
+		std::array<RenderGraphPass*, SUBPASS_COUNT> subpasses{};
+		RenderGraphResource graded;
+		RenderGraphResource output;
+
+		//Both subpasses share the layout, each has a set with its own input attachment
+		VkPipelineLayout subpassPipelineLayout = VK_NULL_HANDLE;
+		std::array<LvePipeline*, SUBPASS_COUNT> subpassPipelines{};
+		std::array<VkDescriptorSet, SUBPASS_COUNT> subpassSets{};
+
+		VkSampler sampler = VK_NULL_HANDLE;
+		VkDescriptorSet bloomSet;
+		VkPipelineLayout bloomPipelineLayout = VK_NULL_HANDLE;
+		std::unique_ptr<LveComputePipeline> bloomPipeline;
+	};//end class LvePostProcess
+}//end namespace
@@ -0,0 +1,170 @@
+#include "lve_present_group.h"
+
+//std
+#include <limits>
+#include <stdexcept>
+
+namespace lve
+{
+	//VK_SUCCESS < VK_SUBOPTIMAL_KHR < any error
+	static VkResult worseResult(VkResult a, VkResult b)
+	{
+		if (a < 0)
+		{
+			return a;
+		}//end if
+		if (b < 0 || b == VK_SUBOPTIMAL_KHR)
+		{
+			return b;
+		}//end if
+		return a;
+	}//end worseResult
+
+	LvePresentGroup::LvePresentGroup(LveDevice& device, std::vector<LveSwapChain*> swapChains)
+		: lveDevice{ device }, swapChains{ std::move(swapChains) }
+	{
+		if (this->swapChains.empty())
+		{
+			throw std::runtime_error("present group without swap chains!");
+		}//end if
+		imagesInFlight.resize(this->swapChains.size());
+		for (size_t i = 0; i < this->swapChains.size(); i++)
+		{
+			imagesInFlight[i].resize(this->swapChains[i]->imageCount(), VK_NULL_HANDLE);
+		}//end for
+		createSyncObjects();
+	}//constructor
+
+	LvePresentGroup::~LvePresentGroup()
+	{
+		for (auto semaphore : imageAvailableSemaphores)
+		{
+			vkDestroySemaphore(lveDevice.device(), semaphore, nullptr);
+		}//end for
+		for (auto semaphore : renderFinishedSemaphores)
+		{
+			vkDestroySemaphore(lveDevice.device(), semaphore, nullptr);
+		}//end for
+		for (auto fence : inFlightFences)
+		{
+			vkDestroyFence(lveDevice.device(), fence, nullptr);
+		}//end for
+	}//destructor
+
+	void LvePresentGroup::createSyncObjects()
+	{
+		imageAvailableSemaphores.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT * swapChains.size());
+		renderFinishedSemaphores.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+		inFlightFences.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		for (auto& semaphore : imageAvailableSemaphores)
+		{
+			if (vkCreateSemaphore(lveDevice.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create present group semaphore!");
+			}//end if
+		}//end for
+		for (size_t i = 0; i < LveSwapChain::MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			if (vkCreateSemaphore(lveDevice.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
+				vkCreateFence(lveDevice.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create present group synchronization objects!");
+			}//end if
+		}//end for
+	}//end createSyncObjects
+
+	VkResult LvePresentGroup::acquireNextImages(std::vector<uint32_t>& imageIndices)
+	{
+		vkWaitForFences(lveDevice.device(), 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		//The fence above is the one of the frame MAX_FRAMES_IN_FLIGHT back, what it used can go now
+		lveDevice.deletionQueue().beginFrame(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+
+		imageIndices.resize(swapChains.size());
+		VkResult result = VK_SUCCESS;
+		for (size_t i = 0; i < swapChains.size(); i++)
+		{
+			VkResult acquired = vkAcquireNextImageKHR(
+				lveDevice.device(),
+				swapChains[i]->getHandle(),
+				std::numeric_limits<uint64_t>::max(),
+				imageAvailableSemaphores[currentFrame * swapChains.size() + i],
+				VK_NULL_HANDLE,
+				&imageIndices[i]);
+			result = worseResult(result, acquired);
+		}//end for
+		return result;
+	}//end acquireNextImages
+
+	VkResult LvePresentGroup::submitCommandBuffers(
+		const VkCommandBuffer* buffers,
+		uint32_t bufferCount,
+		const std::vector<uint32_t>& imageIndices,
+		const std::vector<VkSemaphore>& extraWaitSemaphores,
+		const std::vector<VkPipelineStageFlags>& extraWaitStages)
+	{
+		//An image acquired again before the frame that last used it finished
+		for (size_t i = 0; i < swapChains.size(); i++)
+		{
+			VkFence& imageFence = imagesInFlight[i][imageIndices[i]];
+			if (imageFence != VK_NULL_HANDLE && imageFence != inFlightFences[currentFrame])
+			{
+				vkWaitForFences(lveDevice.device(), 1, &imageFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+			}//end if
+			imageFence = inFlightFences[currentFrame];
+		}//end for
+
+		waitSemaphores.assign(
+			imageAvailableSemaphores.begin() + currentFrame * swapChains.size(),
+			imageAvailableSemaphores.begin() + (currentFrame + 1) * swapChains.size());
+		waitStages.assign(swapChains.size(), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		waitSemaphores.insert(waitSemaphores.end(), extraWaitSemaphores.begin(), extraWaitSemaphores.end());
+		waitStages.insert(waitStages.end(), extraWaitStages.begin(), extraWaitStages.end());
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+		submitInfo.pWaitSemaphores = waitSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
+		submitInfo.commandBufferCount = bufferCount;
+		submitInfo.pCommandBuffers = buffers;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &renderFinishedSemaphores[currentFrame];
+
+		vkResetFences(lveDevice.device(), 1, &inFlightFences[currentFrame]);
+		if (vkQueueSubmit(lveDevice.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to submit draw command buffer!");
+		}//end if
+
+		handles.clear();
+		for (auto swapChain : swapChains)
+		{
+			handles.push_back(swapChain->getHandle());
+		}//end for
+		presentResults.assign(swapChains.size(), VK_SUCCESS);
+
+		VkPresentInfoKHR presentInfo{};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		presentInfo.waitSemaphoreCount = 1;
+		presentInfo.pWaitSemaphores = &renderFinishedSemaphores[currentFrame];
+		presentInfo.swapchainCount = static_cast<uint32_t>(handles.size());
+		presentInfo.pSwapchains = handles.data();
+		presentInfo.pImageIndices = imageIndices.data();
+		presentInfo.pResults = presentResults.data();
+		VkResult result = vkQueuePresentKHR(lveDevice.presentQueue(), &presentInfo);
+		for (VkResult presented : presentResults)
+		{
+			result = worseResult(result, presented);
+		}//end for
+
+		currentFrame = (currentFrame + 1) % LveSwapChain::MAX_FRAMES_IN_FLIGHT;
+		return result;
+	}//end submitCommandBuffers
+}//end namespace
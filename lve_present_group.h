@@ -0,0 +1,63 @@
+#pragma once
+
+#include "lve_device.h"
+#include "lve_swap_chain.h"
+
+//std
+#include <vector>
+
+namespace lve
+{
+	//Drives several swap chains (windows, monitors, viewports) as one: a frame waits on one fence,
+	//acquires an image from every swap chain, goes to the GPU in one submit waiting on all of the
+	//acquires and is shown with one vkQueuePresentKHR listing every swap chain. N windows cost N
+	//acquires, not N fences, submits and presents. The sync objects of the swap chains themselves
+	//are left unused, a swap chain belongs to at most one group and is not presented on its own.
+	class LvePresentGroup
+	{
+	public:
+		LvePresentGroup(LveDevice& device, std::vector<LveSwapChain*> swapChains);
+		~LvePresentGroup();
+
+		LvePresentGroup(const LvePresentGroup&) = delete;
+		LvePresentGroup& operator=(const LvePresentGroup&) = delete;
+
+		size_t getSwapChainCount() const { return swapChains.size(); }
+		LveSwapChain& getSwapChain(size_t index) { return *swapChains[index]; }
+		//Same meaning as LveSwapChain::getCurrentFrame
+		size_t getCurrentFrame() const { return currentFrame; }
+
+		//Waits for the frame slot, then fills imageIndices with one image per swap chain, in the order
+		//they were given. Returns the worst result of the acquires.
+		VkResult acquireNextImages(std::vector<uint32_t>& imageIndices);
+		//Every command buffer of the frame in one submit, which waits on every acquired image at
+		//COLOR_ATTACHMENT_OUTPUT (and the extra semaphores at their stages), then one present of all
+		//the images. Returns the worst present result.
+		VkResult submitCommandBuffers(
+			const VkCommandBuffer* buffers,
+			uint32_t bufferCount,
+			const std::vector<uint32_t>& imageIndices,
+			const std::vector<VkSemaphore>& extraWaitSemaphores = {},
+			const std::vector<VkPipelineStageFlags>& extraWaitStages = {});
+
+	private:
+		void createSyncObjects();
+
+		LveDevice& lveDevice;
+		std::vector<LveSwapChain*> swapChains;
+		//MAX_FRAMES_IN_FLIGHT x swap chains, one per acquire
+		std::vector<VkSemaphore> imageAvailableSemaphores;
+		//One per frame slot, a single present waits on it for every swap chain
+		std::vector<VkSemaphore> renderFinishedSemaphores;
+		std::vector<VkFence> inFlightFences;
+		//Per swap chain, the fence of the frame each image was last submitted with
+		std::vector<std::vector<VkFence>> imagesInFlight;
+		size_t currentFrame = 0;
+
+		//Reused every frame
+		std::vector<VkSemaphore> waitSemaphores;
+		std::vector<VkPipelineStageFlags> waitStages;
+		std::vector<VkSwapchainKHR> handles;
+		std::vector<VkResult> presentResults;
+	};//end class LvePresentGroup
+}//end namespace
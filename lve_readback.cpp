@@ -0,0 +1,436 @@
+#include "lve_readback.h"
+
+//std
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace lve
+{
+	static uint32_t texelSize(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		//The depth aspect alone of the packed formats is copied as 32 bits per texel
+		case VK_FORMAT_D32_SFLOAT:
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		case VK_FORMAT_D24_UNORM_S8_UINT:
+		case VK_FORMAT_X8_D24_UNORM_PACK32:
+			return 4;
+		case VK_FORMAT_D16_UNORM:
+		case VK_FORMAT_D16_UNORM_S8_UINT:
+			return 2;
+		default:
+			return 0;
+		}//end switch
+	}//end texelSize
+
+	static bool isDepthFormat(VkFormat format)
+	{
+		return format == VK_FORMAT_D32_SFLOAT || format == VK_FORMAT_D32_SFLOAT_S8_UINT ||
+			format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_X8_D24_UNORM_PACK32 ||
+			format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_D16_UNORM_S8_UINT;
+	}//end isDepthFormat
+
+	//Tightly packed texels to 8 bit RGB, or 8 bit gray for depth (0 near, 255 far)
+	static void convertTexels(const uint8_t* texels, VkFormat format, uint32_t texelCount, std::vector<uint8_t>& pixels)
+	{
+		if (!isDepthFormat(format))
+		{
+			bool bgra = format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+			pixels.resize(static_cast<size_t>(texelCount) * 3);
+			for (uint32_t i = 0; i < texelCount; i++)
+			{
+				const uint8_t* texel = texels + i * 4;
+				pixels[i * 3 + 0] = bgra ? texel[2] : texel[0];
+				pixels[i * 3 + 1] = texel[1];
+				pixels[i * 3 + 2] = bgra ? texel[0] : texel[2];
+			}//end for
+			return;
+		}//end if
+
+		pixels.resize(texelCount);
+		for (uint32_t i = 0; i < texelCount; i++)
+		{
+			float depth;
+			if (format == VK_FORMAT_D32_SFLOAT || format == VK_FORMAT_D32_SFLOAT_S8_UINT)
+			{
+				std::memcpy(&depth, texels + i * 4, sizeof(float));
+			}
+			else if (format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_D16_UNORM_S8_UINT)
+			{
+				uint16_t value;
+				std::memcpy(&value, texels + i * 2, sizeof(uint16_t));
+				depth = value / 65535.0f;
+			}
+			else
+			{
+				//24 bit depth in the low bits, the top 8 are undefined
+				uint32_t value;
+				std::memcpy(&value, texels + i * 4, sizeof(uint32_t));
+				depth = (value & 0xffffff) / 16777215.0f;
+			}//end if
+			pixels[i] = static_cast<uint8_t>(std::min(std::max(depth, 0.0f), 1.0f) * 255.0f + 0.5f);
+		}//end for
+	}//end convertTexels
+
+	static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size)
+	{
+		static const std::array<uint32_t, 256> table = []()
+		{
+			std::array<uint32_t, 256> values{};
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t value = i;
+				for (int bit = 0; bit < 8; bit++)
+				{
+					value = (value & 1) ? 0xedb88320u ^ (value >> 1) : value >> 1;
+				}//end for
+				values[i] = value;
+			}//end for
+			return values;
+		}();
+
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++)
+		{
+			crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+		}//end for
+		return ~crc;
+	}//end crc32
+
+	static void putBigEndian(std::vector<uint8_t>& out, uint32_t value)
+	{
+		out.push_back(static_cast<uint8_t>(value >> 24));
+		out.push_back(static_cast<uint8_t>(value >> 16));
+		out.push_back(static_cast<uint8_t>(value >> 8));
+		out.push_back(static_cast<uint8_t>(value));
+	}//end putBigEndian
+
+	static void putPngChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data)
+	{
+		putBigEndian(out, static_cast<uint32_t>(data.size()));
+		size_t typeOffset = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+		putBigEndian(out, crc32(0, out.data() + typeOffset, out.size() - typeOffset));
+	}//end putPngChunk
+
+	//Uncompressed deflate (stored blocks) in a zlib stream: bigger files, but written at memcpy speed
+	//and without a compression library, which suits dumping every frame
+	static std::vector<uint8_t> encodePng(uint32_t width, uint32_t height, uint32_t channels, const uint8_t* pixels)
+	{
+		const size_t rowSize = static_cast<size_t>(width) * channels;
+		std::vector<uint8_t> raw;
+		raw.reserve((rowSize + 1) * height);
+		for (uint32_t y = 0; y < height; y++)
+		{
+			//Filter type none
+			raw.push_back(0);
+			raw.insert(raw.end(), pixels + y * rowSize, pixels + (y + 1) * rowSize);
+		}//end for
+
+		std::vector<uint8_t> zlib;
+		zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+		zlib.push_back(0x78);
+		zlib.push_back(0x01);
+		size_t offset = 0;
+		do
+		{
+			size_t blockSize = std::min<size_t>(raw.size() - offset, 65535);
+			bool last = offset + blockSize == raw.size();
+			zlib.push_back(last ? 1 : 0);
+			zlib.push_back(static_cast<uint8_t>(blockSize));
+			zlib.push_back(static_cast<uint8_t>(blockSize >> 8));
+			zlib.push_back(static_cast<uint8_t>(~blockSize));
+			zlib.push_back(static_cast<uint8_t>(~blockSize >> 8));
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+			offset += blockSize;
+		} while (offset < raw.size());
+		uint32_t a = 1;
+		uint32_t b = 0;
+		for (uint8_t byte : raw)
+		{
+			a = (a + byte) % 65521;
+			b = (b + a) % 65521;
+		}//end for
+		putBigEndian(zlib, (b << 16) | a);
+
+		std::vector<uint8_t> header;
+		putBigEndian(header, width);
+		putBigEndian(header, height);
+		header.push_back(8);
+		//Gray or RGB, no compression/filter/interlace options
+		header.push_back(channels == 1 ? 0 : 2);
+		header.push_back(0);
+		header.push_back(0);
+		header.push_back(0);
+
+		std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+		putPngChunk(png, "IHDR", header);
+		putPngChunk(png, "IDAT", zlib);
+		putPngChunk(png, "IEND", {});
+		return png;
+	}//end encodePng
+
+	LveReadback::LveReadback(LveDevice& device, LveJobSystem& jobSystem, VkDeviceSize bytesPerSlot, uint32_t slotCount)
+		: lveDevice{ device }, jobSystem{ jobSystem }, slotCount{ slotCount }
+	{
+		//Slots start on an offset the copy and an invalidate of a non-coherent range both accept
+		nonCoherentAtomSize = std::max<VkDeviceSize>(lveDevice.properties.limits.nonCoherentAtomSize, 16);
+		this->bytesPerSlot = (bytesPerSlot + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize;
+		slots = std::make_unique<Slot[]>(slotCount);
+		for (uint32_t i = 0; i < slotCount; i++)
+		{
+			slots[i].offset = this->bytesPerSlot * i;
+		}//end for
+		createBuffer();
+	}//constructor
+
+	LveReadback::~LveReadback()
+	{
+		waitForWrites();
+		vkUnmapMemory(lveDevice.device(), memory);
+		vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
+		vkFreeMemory(lveDevice.device(), memory, nullptr);
+	}//destructor
+
+	void LveReadback::createBuffer()
+	{
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = bytesPerSlot * slotCount;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (vkCreateBuffer(lveDevice.device(), &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create readback buffer!");
+		}//end if
+
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(lveDevice.device(), buffer, &memRequirements);
+
+		//The CPU reads every byte, so cached memory comes first: reading write-combined memory is
+		//many times slower. Coherent saves the invalidate, but matters less.
+		VkMemoryPropertyFlags candidates[] = {
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT };
+		uint32_t memoryType = UINT32_MAX;
+		for (VkMemoryPropertyFlags candidate : candidates)
+		{
+			if (lveDevice.hasMemoryType(memRequirements.memoryTypeBits, candidate))
+			{
+				memoryType = lveDevice.findMemoryType(memRequirements.memoryTypeBits, candidate);
+				break;
+			}//end if
+		}//end for
+		if (memoryType == UINT32_MAX)
+		{
+			throw std::runtime_error("failed to find mappable memory for the readback buffer!");
+		}//end if
+		coherent = (lveDevice.getMemoryTypeProperties(memoryType) & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = memRequirements.size;
+		allocInfo.memoryTypeIndex = memoryType;
+		if (vkAllocateMemory(lveDevice.device(), &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate readback buffer memory!");
+		}//end if
+		vkBindBufferMemory(lveDevice.device(), buffer, memory, 0);
+
+		//Mapped once for the life of the buffer
+		void* data;
+		if (vkMapMemory(lveDevice.device(), memory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to map readback buffer memory!");
+		}//end if
+		mapped = static_cast<uint8_t*>(data);
+	}//end createBuffer
+
+	bool LveReadback::isFormatSupported(VkFormat format)
+	{
+		return texelSize(format) != 0;
+	}//end isFormatSupported
+
+	bool LveReadback::writeImage(const std::string& filepath, uint32_t width, uint32_t height, uint32_t channels, const uint8_t* pixels)
+	{
+		std::ofstream file{ filepath, std::ios::binary | std::ios::trunc };
+		if (!file.is_open())
+		{
+			return false;
+		}//end if
+
+		bool png = filepath.size() >= 4 && filepath.compare(filepath.size() - 4, 4, ".png") == 0;
+		if (png)
+		{
+			std::vector<uint8_t> encoded = encodePng(width, height, channels, pixels);
+			file.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+		}
+		else
+		{
+			//P6 is binary RGB, P5 binary gray
+			file << (channels == 1 ? "P5" : "P6") << "\n" << width << " " << height << "\n255\n";
+			file.write(reinterpret_cast<const char*>(pixels), static_cast<std::streamsize>(static_cast<size_t>(width) * height * channels));
+		}//end if
+		return static_cast<bool>(file);
+	}//end writeImage
+
+	void LveReadback::beginFrame(uint32_t frameIndex)
+	{
+		for (uint32_t i = 0; i < slotCount; i++)
+		{
+			Slot& slot = slots[i];
+			if (!slot.recorded || slot.frameIndex != frameIndex)
+			{
+				continue;
+			}//end if
+
+			//The copy finished with the fence just waited on, the CPU may read the slot now
+			if (!coherent)
+			{
+				VkMappedMemoryRange range{};
+				range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+				range.memory = memory;
+				range.offset = slot.offset;
+				range.size = bytesPerSlot;
+				vkInvalidateMappedMemoryRanges(lveDevice.device(), 1, &range);
+			}//end if
+			slot.recorded = false;
+			slot.writing.store(true, std::memory_order_relaxed);
+			jobSystem.run([this, &slot]() { writeSlot(slot); }, &writes);
+		}//end for
+	}//end beginFrame
+
+	void LveReadback::writeSlot(Slot& slot)
+	{
+		std::vector<uint8_t> pixels;
+		convertTexels(mapped + slot.offset, slot.format, slot.extent.width * slot.extent.height, pixels);
+		uint32_t channels = isDepthFormat(slot.format) ? 1 : 3;
+		if (writeImage(slot.filepath, slot.extent.width, slot.extent.height, channels, pixels.data()))
+		{
+			written.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			failed.fetch_add(1, std::memory_order_relaxed);
+		}//end if
+		//Hands the slot back to the render thread, the pixels were read out of it above
+		slot.writing.store(false, std::memory_order_release);
+	}//end writeSlot
+
+	bool LveReadback::readImage(VkCommandBuffer commandBuffer, uint32_t frameIndex, const LveReadbackSource& source, const std::string& filepath)
+	{
+		requested.fetch_add(1, std::memory_order_relaxed);
+		VkDeviceSize size = static_cast<VkDeviceSize>(texelSize(source.format)) * source.extent.width * source.extent.height;
+		Slot* slot = nullptr;
+		for (uint32_t i = 0; i < slotCount && size != 0 && size <= bytesPerSlot; i++)
+		{
+			if (!slots[i].recorded && !slots[i].writing.load(std::memory_order_acquire))
+			{
+				slot = &slots[i];
+				break;
+			}//end if
+		}//end for
+		if (slot == nullptr)
+		{
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}//end if
+		slot->recorded = true;
+		slot->frameIndex = frameIndex;
+		slot->format = source.format;
+		slot->extent = source.extent;
+		slot->filepath = filepath;
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = source.layout;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcAccessMask = source.access;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = source.image;
+		//Layout transitions of a combined depth stencil image have to cover both aspects
+		barrier.subresourceRange.aspectMask = source.aspect;
+		if (source.format == VK_FORMAT_D32_SFLOAT_S8_UINT || source.format == VK_FORMAT_D24_UNORM_S8_UINT || source.format == VK_FORMAT_D16_UNORM_S8_UINT)
+		{
+			barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+		}//end if
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			source.stage,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0,
+			0, nullptr,
+			0, nullptr,
+			1, &barrier);
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = slot->offset;
+		//Tightly packed rows
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = source.aspect;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { source.extent.width, source.extent.height, 1 };
+		vkCmdCopyImageToBuffer(commandBuffer, source.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+
+		//Back to where it was for whatever comes next (present, the next frame...), and the copy made
+		//visible to the host once the fence signals
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout = source.layout;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.dstAccessMask = 0;
+		VkBufferMemoryBarrier bufferBarrier{};
+		bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferBarrier.buffer = buffer;
+		bufferBarrier.offset = slot->offset;
+		bufferBarrier.size = size;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+			0,
+			0, nullptr,
+			1, &bufferBarrier,
+			1, &barrier);
+		return true;
+	}//end readImage
+
+	void LveReadback::waitForWrites()
+	{
+		jobSystem.wait(writes);
+	}//end waitForWrites
+
+	LveReadbackStats LveReadback::getStats() const
+	{
+		LveReadbackStats stats;
+		stats.requested = requested.load(std::memory_order_relaxed);
+		stats.written = written.load(std::memory_order_relaxed);
+		stats.dropped = dropped.load(std::memory_order_relaxed);
+		stats.failed = failed.load(std::memory_order_relaxed);
+		return stats;
+	}//end getStats
+}//end namespace
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "lve_device.h"
+#include "lve_job_system.h"
+
+//std
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lve
+{
+	//Image to copy out and the state it is in at that point of the command buffer. It is put back in
+	//the same layout after the copy, and whatever ran at stage with access is waited on first.
+	struct LveReadbackSource
+	{
+		VkImage image = VK_NULL_HANDLE;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+		VkExtent2D extent{};
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		VkAccessFlags access = VK_ACCESS_TRANSFER_WRITE_BIT;
+	};
+
+	struct LveReadbackStats
+	{
+		uint64_t requested = 0;
+		uint64_t written = 0;
+		//No free slot, image too big for one or format not supported
+		uint64_t dropped = 0;
+		uint64_t failed = 0;
+	};
+
+	//Copies color or depth attachments into a ring of host visible slots and writes them as images
+	//without ever waiting on the GPU: a copy is only read once the fence of the frame that recorded it
+	//was waited on anyway, and the conversion and file writing run on the job system. A slot stays
+	//taken until its file is written, when the writes fall behind new reads are dropped instead.
+	//Files ending in ".png" are written as PNG, anything else as binary PPM (color) or PGM (depth).
+	class LveReadback
+	{
+	public:
+		LveReadback(LveDevice& device, LveJobSystem& jobSystem, VkDeviceSize bytesPerSlot, uint32_t slotCount);
+		//Waits for the writes still running
+		~LveReadback();
+
+		LveReadback(const LveReadback&) = delete;
+		LveReadback& operator=(const LveReadback&) = delete;
+
+		//8 bit RGBA/BGRA color and the depth formats
+		static bool isFormatSupported(VkFormat format);
+		//pixels holds width * height * channels bytes, 3 channels for RGB, 1 for gray
+		static bool writeImage(const std::string& filepath, uint32_t width, uint32_t height, uint32_t channels, const uint8_t* pixels);
+
+		//Once the fence of frameIndex was waited on: the copies recorded with it last time are done
+		//and go to the job system to be written
+		void beginFrame(uint32_t frameIndex);
+		//Records the copy of source into a free slot, false when it was dropped
+		bool readImage(VkCommandBuffer commandBuffer, uint32_t frameIndex, const LveReadbackSource& source, const std::string& filepath);
+		//Blocks until every file handed to the job system is written
+		void waitForWrites();
+
+		LveReadbackStats getStats() const;
+
+	private:
+		struct Slot
+		{
+			VkDeviceSize offset = 0;
+			//Set by the render thread when the copy completed, cleared by the job once the file is written
+			std::atomic<bool> writing{ false };
+			//Render thread only
+			bool recorded = false;
+			uint32_t frameIndex = 0;
+			VkFormat format = VK_FORMAT_UNDEFINED;
+			VkExtent2D extent{};
+			std::string filepath;
+		};
+
+		void createBuffer();
+		void writeSlot(Slot& slot);
+
+		LveDevice& lveDevice;
+		LveJobSystem& jobSystem;
+		VkDeviceSize bytesPerSlot;
+		uint32_t slotCount;
+		VkDeviceSize nonCoherentAtomSize = 1;
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		uint8_t* mapped = nullptr;
+		bool coherent = false;
+		std::unique_ptr<Slot[]> slots;
+		LveJobCounter writes;
+
+		std::atomic<uint64_t> requested{ 0 };
+		std::atomic<uint64_t> written{ 0 };
+		std::atomic<uint64_t> dropped{ 0 };
+		std::atomic<uint64_t> failed{ 0 };
+	};//end class LveReadback
+}//end namespace
@@ -0,0 +1,1248 @@
+#include "lve_render_graph.h"
+
+//std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+
+namespace lve
+{
+	namespace
+	{
+		//Layout, stages and access an image needs to be in for a given use
+		struct AccessInfo
+		{
+			VkImageLayout layout;
+			VkPipelineStageFlags stages;
+			VkAccessFlags access;
+			VkImageUsageFlags usage;
+			bool writes;
+		};
+
+		//The part of an access mask a later barrier has to make available
+		const VkAccessFlags WRITE_ACCESS =
+			VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+			VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		AccessInfo getAccessInfo(RenderGraphAccess access, VkPipelineStageFlags stages)
+		{
+			switch (access)
+			{
+			case RenderGraphAccess::ColorAttachment:
+				return {
+					VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+					VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+					VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+					VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+					true };
+			case RenderGraphAccess::DepthAttachment:
+				return {
+					VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+					VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+					VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+					VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+					true };
+			case RenderGraphAccess::DepthAttachmentReadOnly:
+				return {
+					VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+					VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+					VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+					VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+					false };
+			case RenderGraphAccess::InputAttachment:
+				return {
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+					VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+					VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
+					false };
+			case RenderGraphAccess::SampledRead:
+				return {
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					stages,
+					VK_ACCESS_SHADER_READ_BIT,
+					VK_IMAGE_USAGE_SAMPLED_BIT,
+					false };
+			case RenderGraphAccess::StorageWrite:
+				return {
+					VK_IMAGE_LAYOUT_GENERAL,
+					stages,
+					VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+					VK_IMAGE_USAGE_STORAGE_BIT,
+					true };
+			case RenderGraphAccess::TransferSrc:
+				return {
+					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_ACCESS_TRANSFER_READ_BIT,
+					VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+					false };
+			case RenderGraphAccess::TransferDst:
+				return {
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_ACCESS_TRANSFER_WRITE_BIT,
+					VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+					true };
+			}//end switch
+			throw std::runtime_error("unknown render graph access");
+		}//end getAccessInfo
+
+		bool isAttachment(RenderGraphAccess access)
+		{
+			return access == RenderGraphAccess::ColorAttachment ||
+				access == RenderGraphAccess::DepthAttachment ||
+				access == RenderGraphAccess::DepthAttachmentReadOnly ||
+				access == RenderGraphAccess::InputAttachment;
+		}//end isAttachment
+
+		bool isDepthFormat(VkFormat format)
+		{
+			return format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_D32_SFLOAT ||
+				format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT ||
+				format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_X8_D24_UNORM_PACK32;
+		}//end isDepthFormat
+
+		VkImageAspectFlags getAspectMask(VkFormat format)
+		{
+			if (!isDepthFormat(format))
+			{
+				return VK_IMAGE_ASPECT_COLOR_BIT;
+			}//end if
+			if (format == VK_FORMAT_D32_SFLOAT || format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_X8_D24_UNORM_PACK32)
+			{
+				return VK_IMAGE_ASPECT_DEPTH_BIT;
+			}//end if
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		}//end getAspectMask
+	}//end anonymous namespace
+
+	RenderGraphPass& RenderGraphPass::addUse(
+		RenderGraphResource resource,
+		RenderGraphAccess access,
+		VkPipelineStageFlags stages,
+		bool clear,
+		VkClearValue clearValue)
+	{
+		uses.push_back({ resource, access, stages, clear, clearValue });
+		return *this;
+	}//end addUse
+
+	RenderGraphPass& RenderGraphPass::writeColor(RenderGraphResource resource)
+	{
+		return addUse(resource, RenderGraphAccess::ColorAttachment, 0, false, {});
+	}//end writeColor
+
+	RenderGraphPass& RenderGraphPass::writeColor(RenderGraphResource resource, VkClearColorValue clearColor)
+	{
+		VkClearValue clearValue{};
+		clearValue.color = clearColor;
+		return addUse(resource, RenderGraphAccess::ColorAttachment, 0, true, clearValue);
+	}//end writeColor
+
+	RenderGraphPass& RenderGraphPass::writeDepth(RenderGraphResource resource)
+	{
+		return addUse(resource, RenderGraphAccess::DepthAttachment, 0, false, {});
+	}//end writeDepth
+
+	RenderGraphPass& RenderGraphPass::writeDepth(RenderGraphResource resource, VkClearDepthStencilValue clearDepth)
+	{
+		VkClearValue clearValue{};
+		clearValue.depthStencil = clearDepth;
+		return addUse(resource, RenderGraphAccess::DepthAttachment, 0, true, clearValue);
+	}//end writeDepth
+
+	RenderGraphPass& RenderGraphPass::readDepth(RenderGraphResource resource)
+	{
+		return addUse(resource, RenderGraphAccess::DepthAttachmentReadOnly, 0, false, {});
+	}//end readDepth
+
+	RenderGraphPass& RenderGraphPass::readAttachment(RenderGraphResource resource)
+	{
+		return addUse(resource, RenderGraphAccess::InputAttachment, 0, false, {});
+	}//end readAttachment
+
+	RenderGraphPass& RenderGraphPass::readTexture(RenderGraphResource resource, VkPipelineStageFlags stages)
+	{
+		return addUse(resource, RenderGraphAccess::SampledRead, stages, false, {});
+	}//end readTexture
+
+	RenderGraphPass& RenderGraphPass::writeStorage(RenderGraphResource resource, VkPipelineStageFlags stages)
+	{
+		return addUse(resource, RenderGraphAccess::StorageWrite, stages, false, {});
+	}//end writeStorage
+
+	RenderGraphPass& RenderGraphPass::readTransfer(RenderGraphResource resource)
+	{
+		return addUse(resource, RenderGraphAccess::TransferSrc, 0, false, {});
+	}//end readTransfer
+
+	RenderGraphPass& RenderGraphPass::writeTransfer(RenderGraphResource resource)
+	{
+		return addUse(resource, RenderGraphAccess::TransferDst, 0, false, {});
+	}//end writeTransfer
+
+	RenderGraphPass& RenderGraphPass::setRecord(RecordFunction function)
+	{
+		record = std::move(function);
+		return *this;
+	}//end setRecord
+
+	RenderGraphPass& RenderGraphPass::setRenderArea(VkExtent2D area)
+	{
+		renderArea = area;
+		return *this;
+	}//end setRenderArea
+
+	bool RenderGraphPass::isGraphics() const
+	{
+		for (auto& use : uses)
+		{
+			if (isAttachment(use.access))
+			{
+				return true;
+			}//end if
+		}//end for
+		return false;
+	}//end isGraphics
+
+	void RenderGraphPass::configurePipeline(PipelineConfigInfo& configInfo) const
+	{
+		assert((renderPass != VK_NULL_HANDLE || !colorFormats.empty() || depthFormat != VK_FORMAT_UNDEFINED) &&
+			"Render graph must be compiled before its passes configure pipelines");
+		configInfo.renderPass = renderPass;
+		configInfo.subpass = subpass;
+		configInfo.colorAttachmentFormats.clear();
+		configInfo.depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+		if (renderPass == VK_NULL_HANDLE)
+		{
+			configInfo.colorAttachmentFormats = colorFormats;
+			configInfo.depthAttachmentFormat = depthFormat;
+		}//end if
+	}//end configurePipeline
+
+	LveRenderGraph::LveRenderGraph(LveDevice& device, bool dynamicRendering) : lveDevice{ device }, dynamicRendering{ dynamicRendering } {}
+
+	LveRenderGraph::~LveRenderGraph()
+	{
+		reset();
+	}//end destructor
+
+	RenderGraphResource LveRenderGraph::createImage(const std::string& name, const RenderGraphImageInfo& info)
+	{
+		assert(!compiled && "Cannot add images to a compiled render graph");
+		Resource resource{};
+		resource.name = name;
+		resource.info = info;
+		resources.push_back(resource);
+		return static_cast<RenderGraphResource>(resources.size() - 1);
+	}//end createImage
+
+	RenderGraphResource LveRenderGraph::importImage(
+		const std::string& name,
+		VkFormat format,
+		VkExtent2D extent,
+		VkImageLayout initialLayout,
+		VkImageLayout finalLayout)
+	{
+		assert(!compiled && "Cannot add images to a compiled render graph");
+		Resource resource{};
+		resource.name = name;
+		resource.info.format = format;
+		resource.info.extent = extent;
+		resource.imported = true;
+		resource.initialLayout = initialLayout;
+		resource.finalLayout = finalLayout;
+		resources.push_back(resource);
+		return static_cast<RenderGraphResource>(resources.size() - 1);
+	}//end importImage
+
+	void LveRenderGraph::setImportedImage(RenderGraphResource resource, VkImage image, VkImageView view)
+	{
+		assert(resources[resource].imported && "Only imported images can be replaced");
+		resources[resource].image = image;
+		resources[resource].view = view;
+	}//end setImportedImage
+
+	RenderGraphPass& LveRenderGraph::addPass(const std::string& name)
+	{
+		assert(!compiled && "Cannot add passes to a compiled render graph");
+		passes.push_back(std::unique_ptr<RenderGraphPass>(new RenderGraphPass(name)));
+		return *passes.back();
+	}//end addPass
+
+	void LveRenderGraph::compile()
+	{
+		assert(!compiled && "Render graph already compiled, call reset first");
+		buildGroups();
+		padGroups();
+		computeLifetimes();
+		planAttachments();
+		createImages();
+		allocateMemory();
+		createRenderPasses();
+		compiled = true;
+	}//end compile
+
+	void LveRenderGraph::reset()
+	{
+		VkDevice device = lveDevice.device();
+		for (auto& group : groups)
+		{
+			for (auto& kv : group.framebuffers)
+			{
+				vkDestroyFramebuffer(device, kv.second, nullptr);
+			}//end for
+			if (group.renderPass != VK_NULL_HANDLE)
+			{
+				vkDestroyRenderPass(device, group.renderPass, nullptr);
+			}//end if
+		}//end for
+		groups.clear();
+		for (auto& pass : passes)
+		{
+			pass->group = -1;
+			pass->renderPass = VK_NULL_HANDLE;
+			pass->subpass = 0;
+			pass->colorFormats.clear();
+			pass->depthFormat = VK_FORMAT_UNDEFINED;
+		}//end for
+
+		for (auto& resource : resources)
+		{
+			if (resource.imported)
+			{
+				continue;
+			}//end if
+			if (resource.view != VK_NULL_HANDLE)
+			{
+				vkDestroyImageView(device, resource.view, nullptr);
+				resource.view = VK_NULL_HANDLE;
+			}//end if
+			if (resource.image != VK_NULL_HANDLE)
+			{
+				vkDestroyImage(device, resource.image, nullptr);
+				resource.image = VK_NULL_HANDLE;
+			}//end if
+			resource.memoryBlock = -1;
+		}//end for
+
+		for (auto& block : memoryBlocks)
+		{
+			vkFreeMemory(device, block.memory, nullptr);
+		}//end for
+		memoryBlocks.clear();
+		blockStates.clear();
+		allocatedMemorySize = 0;
+		requestedMemorySize = 0;
+		compiled = false;
+	}//end reset
+
+	void LveRenderGraph::buildGroups()
+	{
+		//A pass reading an input attachment joins the render pass of the pass before it, every other
+		//pass starts a group of its own
+		groups.clear();
+		for (int passIndex = 0; passIndex < passes.size(); passIndex++)
+		{
+			auto& pass = *passes[passIndex];
+			bool readsAttachment = false;
+			for (auto& use : pass.uses)
+			{
+				readsAttachment = readsAttachment || use.access == RenderGraphAccess::InputAttachment;
+			}//end for
+
+			if (readsAttachment)
+			{
+				if (groups.empty() || !canMerge(groups.back(), pass))
+				{
+					throw std::runtime_error("render graph pass " + pass.name + " reads an input attachment the pass before it cannot share!");
+				}//end if
+				groups.back().passCount++;
+			}
+			else
+			{
+				Group group{};
+				group.firstPass = passIndex;
+				group.graphics = pass.isGraphics();
+				group.layoutGroup = static_cast<int>(groups.size());
+				for (auto& use : pass.uses)
+				{
+					if (isAttachment(use.access))
+					{
+						group.extent = resources[use.resource].info.extent;
+						break;
+					}//end if
+				}//end for
+				groups.push_back(group);
+			}//end else
+			pass.group = static_cast<int>(groups.size() - 1);
+		}//end for
+	}//end buildGroups
+
+	bool LveRenderGraph::canMerge(const Group& group, const RenderGraphPass& pass) const
+	{
+		if (!group.graphics)
+		{
+			return false;
+		}//end if
+
+		//What the group already draws into, and what it touches outside of its attachments
+		std::vector<bool> written(resources.size(), false);
+		std::vector<bool> attachment(resources.size(), false);
+		std::vector<bool> other(resources.size(), false);
+		for (int i = group.firstPass; i < group.firstPass + group.passCount; i++)
+		{
+			for (auto& use : passes[i]->uses)
+			{
+				if (isAttachment(use.access))
+				{
+					attachment[use.resource] = true;
+					written[use.resource] = written[use.resource] || getAccessInfo(use.access, use.stages).writes;
+				}
+				else
+				{
+					other[use.resource] = true;
+				}//end else
+			}//end for
+		}//end for
+
+		for (auto& use : pass.uses)
+		{
+			if (use.access == RenderGraphAccess::InputAttachment && !written[use.resource])
+			{
+				return false;
+			}//end if
+			if (isAttachment(use.access))
+			{
+				//Subpasses share the framebuffer, and nothing outside the render pass can see the image in between
+				const VkExtent2D& extent = resources[use.resource].info.extent;
+				if (extent.width != group.extent.width || extent.height != group.extent.height || other[use.resource])
+				{
+					return false;
+				}//end if
+			}
+			else if (attachment[use.resource])
+			{
+				return false;
+			}//end else if
+		}//end for
+		return true;
+	}//end canMerge
+
+	void LveRenderGraph::padGroups()
+	{
+		//Pipelines are made for one render pass but work in every compatible one. With more than one
+		//subpass that means the same subpasses and dependencies, so a lone pass drawing what the first
+		//subpass of a later render pass draws (a scene split in two around some compute) gets the
+		//subpasses of that render pass too.
+		auto signature = [this](int passIndex)
+		{
+			std::vector<std::pair<RenderGraphResource, RenderGraphAccess>> result;
+			for (auto& use : passes[passIndex]->uses)
+			{
+				if (isAttachment(use.access))
+				{
+					result.push_back({ use.resource, use.access });
+				}//end if
+			}//end for
+			return result;
+		};
+
+		for (int g = 0; g < groups.size(); g++)
+		{
+			if (!groups[g].graphics || groups[g].passCount != 1)
+			{
+				continue;
+			}//end if
+			auto passSignature = signature(groups[g].firstPass);
+			for (int h = g + 1; h < groups.size(); h++)
+			{
+				if (groups[h].passCount > 1 && signature(groups[h].firstPass) == passSignature)
+				{
+					groups[g].layoutGroup = h;
+					break;
+				}//end if
+			}//end for
+		}//end for
+	}//end padGroups
+
+	void LveRenderGraph::forEachAttachmentUse(const Group& group, const std::function<void(uint32_t, const RenderGraphPass::Use&)>& function) const
+	{
+		const Group& layout = groups[group.layoutGroup];
+		for (int subpass = 0; subpass < layout.passCount; subpass++)
+		{
+			const auto& pass = subpass < group.passCount ? *passes[group.firstPass + subpass] : *passes[layout.firstPass + subpass];
+			for (auto& use : pass.uses)
+			{
+				if (isAttachment(use.access))
+				{
+					function(static_cast<uint32_t>(subpass), use);
+				}//end if
+			}//end for
+		}//end for
+	}//end forEachAttachmentUse
+
+	void LveRenderGraph::computeLifetimes()
+	{
+		for (auto& resource : resources)
+		{
+			resource.firstPass = -1;
+			resource.lastPass = -1;
+			resource.usage = resource.info.extraUsage;
+		}//end for
+
+		auto markUse = [this](RenderGraphResource index, int firstPass, int lastPass)
+		{
+			auto& resource = resources[index];
+			resource.firstPass = resource.firstPass < 0 ? firstPass : std::min(resource.firstPass, firstPass);
+			resource.lastPass = std::max(resource.lastPass, lastPass);
+		};
+
+		for (auto& group : groups)
+		{
+			int lastPass = group.firstPass + group.passCount - 1;
+			for (int passIndex = group.firstPass; passIndex <= lastPass; passIndex++)
+			{
+				for (auto& use : passes[passIndex]->uses)
+				{
+					markUse(use.resource, passIndex, passIndex);
+					resources[use.resource].usage |= getAccessInfo(use.access, use.stages).usage;
+				}//end for
+			}//end for
+			if (!group.graphics)
+			{
+				continue;
+			}//end if
+			//Attachments are alive for the whole render pass, padding subpasses included
+			forEachAttachmentUse(group, [&](uint32_t, const RenderGraphPass::Use& use)
+			{
+				markUse(use.resource, group.firstPass, lastPass);
+				resources[use.resource].usage |= getAccessInfo(use.access, use.stages).usage;
+			});
+		}//end for
+	}//end computeLifetimes
+
+	void LveRenderGraph::planAttachments()
+	{
+		//Whether an image holds something a later pass can load, to choose between LOAD and DONT_CARE
+		std::vector<bool> hasContents(resources.size(), false);
+		//Images that are loaded or stored somewhere, those can never stay in tile memory only
+		std::vector<bool> kept(resources.size(), false);
+		for (int i = 0; i < resources.size(); i++)
+		{
+			hasContents[i] = resources[i].imported && resources[i].initialLayout != VK_IMAGE_LAYOUT_UNDEFINED;
+		}//end for
+
+		for (auto& group : groups)
+		{
+			int lastPass = group.firstPass + group.passCount - 1;
+			if (!group.graphics)
+			{
+				for (auto& use : passes[group.firstPass]->uses)
+				{
+					hasContents[use.resource] = hasContents[use.resource] || getAccessInfo(use.access, use.stages).writes;
+				}//end for
+				continue;
+			}//end if
+
+			group.attachments.clear();
+			std::vector<int> indices(resources.size(), -1);
+			std::vector<bool> real;
+			forEachAttachmentUse(group, [&](uint32_t subpass, const RenderGraphPass::Use& use)
+			{
+				AccessInfo info = getAccessInfo(use.access, use.stages);
+				int& index = indices[use.resource];
+				if (index < 0)
+				{
+					index = static_cast<int>(group.attachments.size());
+					Attachment attachment{};
+					attachment.resource = use.resource;
+					//The barrier in front of the render pass does the transition, the render pass only the
+					//ones between its subpasses
+					attachment.initialLayout = info.layout;
+					group.attachments.push_back(attachment);
+					real.push_back(false);
+				}//end if
+
+				Attachment& attachment = group.attachments[index];
+				attachment.finalLayout = info.layout;
+				attachment.stages |= info.stages;
+				attachment.access |= info.access;
+				attachment.writes = attachment.writes || info.writes;
+				if (subpass < group.passCount && !real[index])
+				{
+					//Padding subpasses draw nothing, so only the passes of the group decide what is loaded
+					real[index] = true;
+					attachment.loadOp = use.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR
+						: (hasContents[use.resource] ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+					attachment.clearValue = use.clearValue;
+				}//end if
+			});
+
+			for (int i = 0; i < group.attachments.size(); i++)
+			{
+				Attachment& attachment = group.attachments[i];
+				auto& resource = resources[attachment.resource];
+				//Contents only have to reach memory if somebody after the render pass looks at them,
+				//whether the render pass wrote them or only read them
+				bool storeNeeded = real[i] && (resource.imported || resource.lastPass > lastPass);
+				attachment.storeOp = storeNeeded ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				hasContents[attachment.resource] = storeNeeded;
+				kept[attachment.resource] = kept[attachment.resource] || storeNeeded || attachment.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD;
+			}//end for
+		}//end for
+
+		//An image that never leaves the render passes it is drawn in (nothing loads, stores, samples or
+		//copies it) only ever lives in tile memory, so it is created as a transient attachment and may
+		//use lazily allocated memory
+		const VkImageUsageFlags attachmentUsage =
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+		for (int i = 0; i < resources.size(); i++)
+		{
+			auto& resource = resources[i];
+			resource.transient = !resource.imported && resource.firstPass >= 0 && !kept[i] && (resource.usage & ~attachmentUsage) == 0;
+			if (resource.transient)
+			{
+				resource.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+			}//end if
+		}//end for
+	}//end planAttachments
+
+	void LveRenderGraph::createImages()
+	{
+		for (auto& resource : resources)
+		{
+			if (resource.imported || resource.firstPass < 0)
+			{
+				continue;
+			}//end if
+
+			VkImageCreateInfo imageInfo{};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.extent.width = resource.info.extent.width;
+			imageInfo.extent.height = resource.info.extent.height;
+			imageInfo.extent.depth = 1;
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.format = resource.info.format;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			imageInfo.usage = resource.usage;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			//Contents are never carried from one image to another through shared memory, so no alias flag is needed
+			imageInfo.flags = 0;
+
+			if (vkCreateImage(lveDevice.device(), &imageInfo, nullptr, &resource.image) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create render graph image: " + resource.name);
+			}//end if
+		}//end for
+	}//end createImages
+
+	void LveRenderGraph::allocateMemory()
+	{
+		//Visit the images in the order they come alive and give each one the first block
+		//whose previous occupant is already dead, this is a greedy interval colouring of the lifetimes.
+		std::vector<int> order;
+		for (int i = 0; i < resources.size(); i++)
+		{
+			if (!resources[i].imported && resources[i].image != VK_NULL_HANDLE)
+			{
+				order.push_back(i);
+			}//end if
+		}//end for
+		std::sort(order.begin(), order.end(), [&](int a, int b) { return resources[a].firstPass < resources[b].firstPass; });
+
+		const VkMemoryPropertyFlags lazyProperties =
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+
+		for (int index : order)
+		{
+			auto& resource = resources[index];
+			VkMemoryRequirements memRequirements;
+			vkGetImageMemoryRequirements(lveDevice.device(), resource.image, &memRequirements);
+			requestedMemorySize += memRequirements.size;
+
+			bool lazy = resource.transient && lveDevice.hasMemoryType(memRequirements.memoryTypeBits, lazyProperties);
+
+			int chosen = -1;
+			for (int b = 0; b < memoryBlocks.size(); b++)
+			{
+				auto& block = memoryBlocks[b];
+				if (block.lazy != lazy || block.lastPass >= resource.firstPass)
+				{
+					continue;
+				}//end if
+				uint32_t typeBits = block.memoryTypeBits & memRequirements.memoryTypeBits;
+				VkMemoryPropertyFlags properties = lazy ? lazyProperties : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+				if (typeBits == 0 || !lveDevice.hasMemoryType(typeBits, properties))
+				{
+					continue;
+				}//end if
+				chosen = b;
+				break;
+			}//end for
+
+			if (chosen < 0)
+			{
+				memoryBlocks.push_back({});
+				memoryBlocks.back().lazy = lazy;
+				chosen = static_cast<int>(memoryBlocks.size() - 1);
+			}//end if
+
+			auto& block = memoryBlocks[chosen];
+			//Offsets are always 0, so the alignment only matters for the size of the block
+			VkDeviceSize alignedSize = (memRequirements.size + memRequirements.alignment - 1) / memRequirements.alignment * memRequirements.alignment;
+			block.size = std::max(block.size, alignedSize);
+			block.memoryTypeBits &= memRequirements.memoryTypeBits;
+			block.lastPass = resource.lastPass;
+			resource.memoryBlock = chosen;
+		}//end for
+
+		for (auto& block : memoryBlocks)
+		{
+			VkMemoryAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = block.size;
+			allocInfo.memoryTypeIndex = lveDevice.findMemoryType(
+				block.memoryTypeBits,
+				block.lazy ? lazyProperties : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			if (vkAllocateMemory(lveDevice.device(), &allocInfo, nullptr, &block.memory) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to allocate render graph memory!");
+			}//end if
+			allocatedMemorySize += block.size;
+		}//end for
+		blockStates.assign(memoryBlocks.size(), ResourceState{});
+
+		for (int index : order)
+		{
+			auto& resource = resources[index];
+			if (vkBindImageMemory(lveDevice.device(), resource.image, memoryBlocks[resource.memoryBlock].memory, 0) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to bind render graph image memory!");
+			}//end if
+			createImageView(resource);
+		}//end for
+	}//end allocateMemory
+
+	void LveRenderGraph::createImageView(Resource& resource)
+	{
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = resource.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = resource.info.format;
+		//Views of depth/stencil images only see the depth aspect so they can be sampled
+		viewInfo.subresourceRange.aspectMask = isDepthFormat(resource.info.format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &resource.view) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create render graph image view: " + resource.name);
+		}//end if
+	}//end createImageView
+
+	void LveRenderGraph::createRenderPasses()
+	{
+		for (auto& group : groups)
+		{
+			if (!group.graphics)
+			{
+				continue;
+			}//end if
+			//Dynamic rendering has no subpasses, a render pass with several stays a render pass
+			group.dynamicRendering = dynamicRendering && lveDevice.isDynamicRenderingEnabled() && groups[group.layoutGroup].passCount == 1;
+			if (!group.dynamicRendering)
+			{
+				createRenderPass(group);
+			}//end if
+
+			for (int i = 0; i < group.passCount; i++)
+			{
+				auto& pass = *passes[group.firstPass + i];
+				pass.renderPass = group.renderPass;
+				pass.subpass = static_cast<uint32_t>(i);
+				pass.colorFormats.clear();
+				pass.depthFormat = VK_FORMAT_UNDEFINED;
+				if (!group.dynamicRendering)
+				{
+					continue;
+				}//end if
+				for (auto& use : pass.uses)
+				{
+					if (use.access == RenderGraphAccess::ColorAttachment)
+					{
+						pass.colorFormats.push_back(resources[use.resource].info.format);
+					}
+					else if (use.access == RenderGraphAccess::DepthAttachment || use.access == RenderGraphAccess::DepthAttachmentReadOnly)
+					{
+						pass.depthFormat = resources[use.resource].info.format;
+					}//end else if
+				}//end for
+			}//end for
+		}//end for
+	}//end createRenderPasses
+
+	void LveRenderGraph::createRenderPass(Group& group)
+	{
+		std::vector<VkAttachmentDescription> descriptions;
+		std::vector<int> indices(resources.size(), -1);
+		for (auto& attachment : group.attachments)
+		{
+			VkAttachmentDescription description{};
+			description.format = resources[attachment.resource].info.format;
+			description.samples = VK_SAMPLE_COUNT_1_BIT;
+			description.loadOp = attachment.loadOp;
+			description.storeOp = attachment.storeOp;
+			description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			description.initialLayout = attachment.initialLayout;
+			description.finalLayout = attachment.finalLayout;
+			indices[attachment.resource] = static_cast<int>(descriptions.size());
+			descriptions.push_back(description);
+		}//end for
+
+		const uint32_t subpassCount = static_cast<uint32_t>(groups[group.layoutGroup].passCount);
+		std::vector<std::vector<VkAttachmentReference>> colorRefs(subpassCount);
+		std::vector<std::vector<VkAttachmentReference>> inputRefs(subpassCount);
+		std::vector<std::vector<uint32_t>> preserveRefs(subpassCount);
+		std::vector<VkAttachmentReference> depthRefs(subpassCount);
+		std::vector<bool> hasDepth(subpassCount, false);
+
+		//Every attachment waits for its previous use in the render pass. By region: a pixel only waits
+		//for the same pixel of the subpass before, which is what lets a tiler keep the chain on chip.
+		std::map<std::pair<uint32_t, uint32_t>, VkSubpassDependency> dependencies;
+		std::vector<int> lastSubpass(descriptions.size(), -1);
+		std::vector<AccessInfo> lastInfo(descriptions.size());
+		forEachAttachmentUse(group, [&](uint32_t subpass, const RenderGraphPass::Use& use)
+		{
+			int index = indices[use.resource];
+			AccessInfo info = getAccessInfo(use.access, use.stages);
+			VkAttachmentReference reference{ static_cast<uint32_t>(index), info.layout };
+			switch (use.access)
+			{
+			case RenderGraphAccess::ColorAttachment:
+				colorRefs[subpass].push_back(reference);
+				break;
+			case RenderGraphAccess::InputAttachment:
+				inputRefs[subpass].push_back(reference);
+				break;
+			default:
+				assert(!hasDepth[subpass] && "A pass can only have one depth attachment");
+				depthRefs[subpass] = reference;
+				hasDepth[subpass] = true;
+				break;
+			}//end switch
+
+			int previous = lastSubpass[index];
+			if (previous >= 0 && previous != subpass)
+			{
+				VkSubpassDependency& dependency = dependencies[{ static_cast<uint32_t>(previous), subpass }];
+				dependency.srcSubpass = static_cast<uint32_t>(previous);
+				dependency.dstSubpass = subpass;
+				dependency.srcStageMask |= lastInfo[index].stages;
+				dependency.dstStageMask |= info.stages;
+				dependency.srcAccessMask |= lastInfo[index].access & WRITE_ACCESS;
+				dependency.dstAccessMask |= info.access;
+				dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+				//Subpasses in between have to keep the contents
+				for (int between = previous + 1; between < subpass; between++)
+				{
+					preserveRefs[between].push_back(static_cast<uint32_t>(index));
+				}//end for
+			}//end if
+			lastSubpass[index] = static_cast<int>(subpass);
+			lastInfo[index] = info;
+		});
+
+		std::vector<VkSubpassDescription> subpasses(subpassCount);
+		for (uint32_t i = 0; i < subpassCount; i++)
+		{
+			subpasses[i].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpasses[i].colorAttachmentCount = static_cast<uint32_t>(colorRefs[i].size());
+			subpasses[i].pColorAttachments = colorRefs[i].data();
+			subpasses[i].inputAttachmentCount = static_cast<uint32_t>(inputRefs[i].size());
+			subpasses[i].pInputAttachments = inputRefs[i].data();
+			subpasses[i].preserveAttachmentCount = static_cast<uint32_t>(preserveRefs[i].size());
+			subpasses[i].pPreserveAttachments = preserveRefs[i].data();
+			subpasses[i].pDepthStencilAttachment = hasDepth[i] ? &depthRefs[i] : nullptr;
+		}//end for
+
+		//No external dependencies: the layouts at the start and end are the ones the subpasses use, and
+		//execute() records explicit barriers around the render pass
+		std::vector<VkSubpassDependency> dependencyList;
+		for (auto& kv : dependencies)
+		{
+			dependencyList.push_back(kv.second);
+		}//end for
+
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(descriptions.size());
+		renderPassInfo.pAttachments = descriptions.data();
+		renderPassInfo.subpassCount = subpassCount;
+		renderPassInfo.pSubpasses = subpasses.data();
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencyList.size());
+		renderPassInfo.pDependencies = dependencyList.data();
+
+		if (vkCreateRenderPass(lveDevice.device(), &renderPassInfo, nullptr, &group.renderPass) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create render pass for: " + passes[group.firstPass]->name);
+		}//end if
+	}//end createRenderPass
+
+	VkFramebuffer LveRenderGraph::getFramebuffer(Group& group)
+	{
+		std::vector<VkImageView> views;
+		for (auto& attachment : group.attachments)
+		{
+			assert(resources[attachment.resource].view != VK_NULL_HANDLE && "Imported image was not set before execute");
+			views.push_back(resources[attachment.resource].view);
+		}//end for
+
+		auto it = group.framebuffers.find(views);
+		if (it != group.framebuffers.end())
+		{
+			return it->second;
+		}//end if
+
+		VkFramebufferCreateInfo framebufferInfo{};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = group.renderPass;
+		framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+		framebufferInfo.pAttachments = views.data();
+		framebufferInfo.width = group.extent.width;
+		framebufferInfo.height = group.extent.height;
+		framebufferInfo.layers = 1;
+
+		VkFramebuffer framebuffer;
+		if (vkCreateFramebuffer(lveDevice.device(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create framebuffer for: " + passes[group.firstPass]->name);
+		}//end if
+		group.framebuffers[views] = framebuffer;
+		return framebuffer;
+	}//end getFramebuffer
+
+	void LveRenderGraph::startFrame(RenderGraphResource resource)
+	{
+		if (touched[resource])
+		{
+			return;
+		}//end if
+		touched[resource] = true;
+		if (resources[resource].imported)
+		{
+			//Whoever owns the image did something with it before the frame, which the graph cannot see
+			states[resource] = ResourceState{};
+			states[resource].layout = resources[resource].initialLayout;
+			states[resource].writeStages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			return;
+		}//end if
+
+		//Images owned by the graph start every frame undefined (their contents are never kept across
+		//frames) but still have to wait for whatever last used their memory, in this frame or the last one
+		const ResourceState& blockState = blockStates[resources[resource].memoryBlock];
+		states[resource] = ResourceState{};
+		states[resource].writeStages = blockState.writeStages | blockState.readStages;
+		states[resource].writeAccess = blockState.writeAccess;
+	}//end startFrame
+
+	void LveRenderGraph::addBarrier(
+		BarrierBatch& batch,
+		RenderGraphResource resource,
+		VkImageLayout layout,
+		VkPipelineStageFlags stages,
+		VkAccessFlags accessMask,
+		bool writes,
+		bool discard)
+	{
+		startFrame(resource);
+		ResourceState& state = states[resource];
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.dstAccessMask = accessMask;
+		barrier.newLayout = layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = resources[resource].image;
+		barrier.subresourceRange.aspectMask = getAspectMask(resources[resource].info.format);
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		if (!writes && state.layout == layout)
+		{
+			//A read in the layout the image is already in only has to see the last write. Earlier reads
+			//may already have made it visible to these stages, otherwise it waits on the writer again
+			//(not on those reads: two reads never have to be ordered).
+			bool covered = (stages & ~state.visibleStages) == 0 && (accessMask & ~state.visibleAccess) == 0;
+			if (state.writeStages == 0 || covered)
+			{
+				state.readStages |= stages;
+				return;
+			}//end if
+			barrier.srcAccessMask = state.writeAccess;
+			barrier.oldLayout = layout;
+			batch.barriers.push_back(barrier);
+			batch.srcStages |= state.writeStages;
+			batch.dstStages |= stages;
+			state.readStages |= stages;
+			state.visibleStages |= stages;
+			state.visibleAccess |= accessMask;
+			return;
+		}//end if
+
+		//A write or a layout transition waits for the last write and every read since
+		barrier.srcAccessMask = state.writeAccess;
+		barrier.oldLayout = discard ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout;
+		batch.barriers.push_back(barrier);
+		batch.srcStages |= state.writeStages | state.readStages;
+		batch.dstStages |= stages;
+
+		state.layout = layout;
+		state.readStages = 0;
+		state.visibleStages = 0;
+		state.visibleAccess = 0;
+		state.writeStages = stages;
+		state.writeAccess = accessMask & WRITE_ACCESS;
+		if (!writes)
+		{
+			//The transition is the last write now, it is already visible to the stages that read after it
+			state.readStages = stages;
+			state.visibleStages = stages;
+			state.visibleAccess = accessMask;
+		}//end if
+	}//end addBarrier
+
+	void LveRenderGraph::flushBarriers(VkCommandBuffer commandBuffer, BarrierBatch& batch)
+	{
+		if (batch.barriers.empty())
+		{
+			return;
+		}//end if
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			batch.srcStages != 0 ? batch.srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			batch.dstStages,
+			0,
+			0, nullptr,
+			0, nullptr,
+			static_cast<uint32_t>(batch.barriers.size()), batch.barriers.data());
+		batch.barriers.clear();
+		batch.srcStages = 0;
+		batch.dstStages = 0;
+	}//end flushBarriers
+
+	void LveRenderGraph::execute(VkCommandBuffer commandBuffer)
+	{
+		assert(compiled && "Render graph must be compiled before execute");
+		states.assign(resources.size(), ResourceState{});
+		touched.assign(resources.size(), false);
+
+		BarrierBatch batch;
+		for (auto& group : groups)
+		{
+			//All the transitions of a group go out in one call, the attachments of a render pass with the
+			//union of what its subpasses do to them
+			if (group.graphics)
+			{
+				for (auto& attachment : group.attachments)
+				{
+					addBarrier(
+						batch,
+						attachment.resource,
+						attachment.initialLayout,
+						attachment.stages,
+						attachment.access,
+						attachment.writes || attachment.initialLayout != attachment.finalLayout,
+						attachment.loadOp != VK_ATTACHMENT_LOAD_OP_LOAD);
+				}//end for
+			}//end if
+			for (int i = group.firstPass; i < group.firstPass + group.passCount; i++)
+			{
+				for (auto& use : passes[i]->uses)
+				{
+					if (group.graphics && isAttachment(use.access))
+					{
+						continue;
+					}//end if
+					AccessInfo info = getAccessInfo(use.access, use.stages);
+					addBarrier(batch, use.resource, info.layout, info.stages, info.access, info.writes, false);
+				}//end for
+			}//end for
+			flushBarriers(commandBuffer, batch);
+
+			if (group.graphics)
+			{
+				executeGroup(commandBuffer, group);
+				for (auto& attachment : group.attachments)
+				{
+					ResourceState& state = states[attachment.resource];
+					if (attachment.writes || attachment.initialLayout != attachment.finalLayout)
+					{
+						state = ResourceState{};
+						state.layout = attachment.finalLayout;
+						state.writeStages = attachment.stages;
+						state.writeAccess = attachment.access & WRITE_ACCESS;
+					}//end if
+				}//end for
+			}
+			else if (passes[group.firstPass]->record)
+			{
+				passes[group.firstPass]->record(commandBuffer);
+			}//end else if
+
+			//The next image placed in the same memory waits for what this group did
+			auto updateBlock = [this](RenderGraphResource resource)
+			{
+				if (!resources[resource].imported)
+				{
+					blockStates[resources[resource].memoryBlock] = states[resource];
+				}//end if
+			};
+			for (auto& attachment : group.attachments)
+			{
+				updateBlock(attachment.resource);
+			}//end for
+			for (int i = group.firstPass; i < group.firstPass + group.passCount; i++)
+			{
+				for (auto& use : passes[i]->uses)
+				{
+					updateBlock(use.resource);
+				}//end for
+			}//end for
+		}//end for
+
+		//Hand the imported images back in the layout their owner expects, again in a single barrier
+		for (int i = 0; i < resources.size(); i++)
+		{
+			auto& resource = resources[i];
+			if (!resource.imported || !touched[i] || states[i].layout == resource.finalLayout)
+			{
+				continue;
+			}//end if
+			addBarrier(batch, static_cast<RenderGraphResource>(i), resource.finalLayout, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, true, false);
+		}//end for
+		flushBarriers(commandBuffer, batch);
+	}//end execute
+
+	void LveRenderGraph::executeGroup(VkCommandBuffer commandBuffer, Group& group)
+	{
+		//The render area of the first pass, from the top left corner of the attachments
+		VkExtent2D renderArea = passes[group.firstPass]->renderArea;
+		if (renderArea.width == 0 || renderArea.height == 0)
+		{
+			renderArea = group.extent;
+		}//end if
+		renderArea.width = std::min(renderArea.width, group.extent.width);
+		renderArea.height = std::min(renderArea.height, group.extent.height);
+
+		if (group.dynamicRendering)
+		{
+			beginRendering(commandBuffer, group, renderArea);
+		}
+		else
+		{
+			std::vector<VkClearValue> clearValues;
+			for (auto& attachment : group.attachments)
+			{
+				clearValues.push_back(attachment.clearValue);
+			}//end for
+
+			VkRenderPassBeginInfo renderPassInfo{};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = group.renderPass;
+			renderPassInfo.framebuffer = getFramebuffer(group);
+			renderPassInfo.renderArea.offset = { 0, 0 };
+			renderPassInfo.renderArea.extent = renderArea;
+			renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+			renderPassInfo.pClearValues = clearValues.data();
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		}//end else
+
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(renderArea.width);
+		viewport.height = static_cast<float>(renderArea.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{ {0, 0}, renderArea };
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		//Padding subpasses record nothing, the render pass just moves through them
+		const int subpassCount = groups[group.layoutGroup].passCount;
+		for (int subpass = 0; subpass < subpassCount; subpass++)
+		{
+			if (subpass > 0)
+			{
+				vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+			}//end if
+			if (subpass < group.passCount && passes[group.firstPass + subpass]->record)
+			{
+				passes[group.firstPass + subpass]->record(commandBuffer);
+			}//end if
+		}//end for
+
+		if (group.dynamicRendering)
+		{
+			lveDevice.cmdEndRendering(commandBuffer);
+		}
+		else
+		{
+			vkCmdEndRenderPass(commandBuffer);
+		}//end else
+	}//end executeGroup
+
+	void LveRenderGraph::beginRendering(VkCommandBuffer commandBuffer, Group& group, VkExtent2D renderArea)
+	{
+		//Same load/store ops as a render pass would have, with the image views given directly
+		std::vector<VkRenderingAttachmentInfoKHR> colorAttachments;
+		VkRenderingAttachmentInfoKHR depthAttachment{};
+		bool hasDepth = false;
+		for (auto& attachment : group.attachments)
+		{
+			assert(resources[attachment.resource].view != VK_NULL_HANDLE && "Imported image was not set before execute");
+			VkRenderingAttachmentInfoKHR info{};
+			info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+			info.imageView = resources[attachment.resource].view;
+			info.imageLayout = attachment.initialLayout;
+			info.loadOp = attachment.loadOp;
+			info.storeOp = attachment.storeOp;
+			info.clearValue = attachment.clearValue;
+			if (isDepthFormat(resources[attachment.resource].info.format))
+			{
+				depthAttachment = info;
+				hasDepth = true;
+			}
+			else
+			{
+				colorAttachments.push_back(info);
+			}//end else
+		}//end for
+
+		VkRenderingInfoKHR renderingInfo{};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		renderingInfo.renderArea.offset = { 0, 0 };
+		renderingInfo.renderArea.extent = renderArea;
+		renderingInfo.layerCount = 1;
+		renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size());
+		renderingInfo.pColorAttachments = colorAttachments.data();
+		renderingInfo.pDepthAttachment = hasDepth ? &depthAttachment : nullptr;
+
+		lveDevice.cmdBeginRendering(commandBuffer, renderingInfo);
+	}//end beginRendering
+}//end namespace
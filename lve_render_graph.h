@@ -0,0 +1,283 @@
+#pragma once
+
+#include "lve_device.h"
+#include "lve_pipeline.h"
+
+//std
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lve
+{
+	//Handle used by the passes to refer to an image registered in the graph
+	using RenderGraphResource = uint32_t;
+
+	//Describes an image owned by the graph. Usage flags are derived from how the passes access it,
+	//so only the format and the size have to be given.
+	struct RenderGraphImageInfo
+	{
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		VkExtent2D extent{};
+		VkImageUsageFlags extraUsage = 0;
+	};
+
+	//The ways a pass can touch an image. From these the graph derives the layout, the pipeline
+	//stages and the access masks used for the barriers, so passes never write barriers by hand.
+	enum class RenderGraphAccess
+	{
+		ColorAttachment,
+		DepthAttachment,
+		DepthAttachmentReadOnly,
+		InputAttachment,
+		SampledRead,
+		StorageWrite,
+		TransferSrc,
+		TransferDst
+	};
+
+	class LveRenderGraph;
+
+	//A node of the graph. Passes with attachments are graphics passes: the graph begins and ends the
+	//render pass (or the dynamic rendering) around their record callback. Every other pass just gets
+	//its barriers and the record callback.
+	class RenderGraphPass
+	{
+	public:
+		using RecordFunction = std::function<void(VkCommandBuffer)>;
+
+		RenderGraphPass& writeColor(RenderGraphResource resource);
+		RenderGraphPass& writeColor(RenderGraphResource resource, VkClearColorValue clearColor);
+		RenderGraphPass& writeDepth(RenderGraphResource resource);
+		RenderGraphPass& writeDepth(RenderGraphResource resource, VkClearDepthStencilValue clearDepth);
+		RenderGraphPass& readDepth(RenderGraphResource resource);
+		//Reads what the graphics pass right before wrote at the same pixel. The two become subpasses of
+		//one render pass, so on a tiler the image never has to leave the tile.
+		RenderGraphPass& readAttachment(RenderGraphResource resource);
+		RenderGraphPass& readTexture(
+			RenderGraphResource resource,
+			VkPipelineStageFlags stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+		RenderGraphPass& writeStorage(
+			RenderGraphResource resource,
+			VkPipelineStageFlags stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+		RenderGraphPass& readTransfer(RenderGraphResource resource);
+		RenderGraphPass& writeTransfer(RenderGraphResource resource);
+		RenderGraphPass& setRecord(RecordFunction function);
+		//Part of the attachments that is drawn, from their top left corner. Can change between frames
+		//(dynamic resolution), the viewport and scissor are set to it. Subpasses use the area of the
+		//first pass of their render pass. Zero, the default, is the whole attachment.
+		RenderGraphPass& setRenderArea(VkExtent2D area);
+
+		const std::string& getName() const { return name; }
+		bool isGraphics() const;
+		//Only valid after LveRenderGraph::compile, for graphics passes: VK_NULL_HANDLE when the pass
+		//uses dynamic rendering
+		VkRenderPass getRenderPass() const { return renderPass; }
+		uint32_t getSubpass() const { return subpass; }
+		//Makes a pipeline draw in this pass: its render pass and subpass, or its attachment formats
+		void configurePipeline(PipelineConfigInfo& configInfo) const;
+
+	private:
+		friend class LveRenderGraph;
+
+		struct Use
+		{
+			RenderGraphResource resource;
+			RenderGraphAccess access;
+			VkPipelineStageFlags stages;
+			bool clear;
+			VkClearValue clearValue;
+		};
+
+		RenderGraphPass(std::string name) : name{ std::move(name) } {}
+		RenderGraphPass& addUse(RenderGraphResource resource, RenderGraphAccess access, VkPipelineStageFlags stages, bool clear, VkClearValue clearValue);
+
+		std::string name;
+		std::vector<Use> uses;
+		RecordFunction record;
+		VkExtent2D renderArea{};
+
+		//Filled in by compile
+		int group = -1;
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		uint32_t subpass = 0;
+		std::vector<VkFormat> colorFormats;
+		VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+	};//end class RenderGraphPass
+
+	//Frame graph: passes declare the images they read and write, compile() groups the graphics passes
+	//into render passes, derives the pipeline barriers and places images that are never alive at the
+	//same time in the same device memory. execute() records the whole frame into one command buffer,
+	//batching every transition a render pass (or any other pass) needs into a single vkCmdPipelineBarrier.
+	//
+	//Graphics passes that read the pass before them through readAttachment are merged into one render
+	//pass as subpasses. A lone graphics pass writing the same attachments as the first subpass of such
+	//a render pass gets a render pass with the same subpasses (it just runs through the later ones), so
+	//pipelines made for one work in both. With dynamicRendering (and a device that has it) every other
+	//graphics pass begins rendering straight into the image views, without render pass or framebuffer.
+	class LveRenderGraph
+	{
+	public:
+		LveRenderGraph(LveDevice& device, bool dynamicRendering = false);
+		~LveRenderGraph();
+
+		LveRenderGraph(const LveRenderGraph&) = delete;
+		LveRenderGraph& operator=(const LveRenderGraph&) = delete;
+
+		RenderGraphResource createImage(const std::string& name, const RenderGraphImageInfo& info);
+		//Images owned by someone else (e.g. the swap chain). The graph transitions them from
+		//initialLayout and leaves them in finalLayout at the end of the frame.
+		RenderGraphResource importImage(
+			const std::string& name,
+			VkFormat format,
+			VkExtent2D extent,
+			VkImageLayout initialLayout,
+			VkImageLayout finalLayout);
+		//The view is only needed when the image is an attachment
+		void setImportedImage(RenderGraphResource resource, VkImage image, VkImageView view);
+
+		//Passes are executed in the order they are added
+		RenderGraphPass& addPass(const std::string& name);
+
+		void compile();
+		void execute(VkCommandBuffer commandBuffer);
+		//Releases everything created by compile so the graph can be rebuilt (e.g. on resize)
+		void reset();
+
+		//Images owned by the graph only exist after compile
+		VkImage getImage(RenderGraphResource resource) const { return resources[resource].image; }
+		VkImageView getImageView(RenderGraphResource resource) const { return resources[resource].view; }
+		VkFormat getFormat(RenderGraphResource resource) const { return resources[resource].info.format; }
+		//Bytes of device memory backing the graph owned images, after aliasing
+		VkDeviceSize getAllocatedMemorySize() const { return allocatedMemorySize; }
+		//Bytes the same images would take without aliasing
+		VkDeviceSize getRequestedMemorySize() const { return requestedMemorySize; }
+
+	private:
+		struct Resource
+		{
+			std::string name;
+			RenderGraphImageInfo info;
+			bool imported = false;
+			VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView view = VK_NULL_HANDLE;
+			VkImageUsageFlags usage = 0;
+			bool transient = false;
+			int firstPass = -1;
+			int lastPass = -1;
+			int memoryBlock = -1;
+		};
+
+		//An attachment of a render pass and what happens to it there
+		struct Attachment
+		{
+			RenderGraphResource resource;
+			VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			VkAttachmentStoreOp storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkClearValue clearValue{};
+			//Union of every use in the render pass, what the barrier in front of it waits for
+			VkPipelineStageFlags stages = 0;
+			VkAccessFlags access = 0;
+			bool writes = false;
+		};
+
+		//Consecutive passes executed as one unit: a render pass (one subpass per pass) or a single
+		//pass without attachments
+		struct Group
+		{
+			int firstPass = 0;
+			int passCount = 1;
+			bool graphics = false;
+			//Group whose subpasses the render pass has, itself unless it was padded to stay compatible
+			int layoutGroup = -1;
+			bool dynamicRendering = false;
+			VkExtent2D extent{};
+			std::vector<Attachment> attachments;
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+			//Imported images change every frame (swap chain), so framebuffers are cached per set of views
+			std::map<std::vector<VkImageView>, VkFramebuffer> framebuffers;
+		};
+
+		//A piece of device memory shared by every image whose lifetime fits in it
+		struct MemoryBlock
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkDeviceSize size = 0;
+			uint32_t memoryTypeBits = ~0u;
+			bool lazy = false;
+			int lastPass = -1;
+		};
+
+		//State tracked while recording so each barrier knows what it has to wait on
+		struct ResourceState
+		{
+			VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			//Last write (or layout transition) and the stages it is ordered before
+			VkPipelineStageFlags writeStages = 0;
+			VkAccessFlags writeAccess = 0;
+			//Reads since then, a later write has to wait for them
+			VkPipelineStageFlags readStages = 0;
+			//What the last write has been made visible to so far
+			VkPipelineStageFlags visibleStages = 0;
+			VkAccessFlags visibleAccess = 0;
+		};
+
+		//Barriers collected for one group, recorded as one call
+		struct BarrierBatch
+		{
+			std::vector<VkImageMemoryBarrier> barriers;
+			VkPipelineStageFlags srcStages = 0;
+			VkPipelineStageFlags dstStages = 0;
+		};
+
+		void buildGroups();
+		bool canMerge(const Group& group, const RenderGraphPass& pass) const;
+		void padGroups();
+		void computeLifetimes();
+		void planAttachments();
+		void createImages();
+		void allocateMemory();
+		void createImageView(Resource& resource);
+		void createRenderPasses();
+		void createRenderPass(Group& group);
+		VkFramebuffer getFramebuffer(Group& group);
+		//Walks the attachment uses of each subpass of the render pass of group, calling function(subpass, use).
+		//The first subpasses are the passes of group, a padded group takes the rest from its layoutGroup.
+		void forEachAttachmentUse(const Group& group, const std::function<void(uint32_t, const RenderGraphPass::Use&)>& function) const;
+
+		void startFrame(RenderGraphResource resource);
+		void addBarrier(
+			BarrierBatch& batch,
+			RenderGraphResource resource,
+			VkImageLayout layout,
+			VkPipelineStageFlags stages,
+			VkAccessFlags accessMask,
+			bool writes,
+			bool discard);
+		void flushBarriers(VkCommandBuffer commandBuffer, BarrierBatch& batch);
+		void executeGroup(VkCommandBuffer commandBuffer, Group& group);
+		void beginRendering(VkCommandBuffer commandBuffer, Group& group, VkExtent2D renderArea);
+
+		LveDevice& lveDevice;
+		bool dynamicRendering;
+		std::vector<Resource> resources;
+		std::vector<std::unique_ptr<RenderGraphPass>> passes;
+		std::vector<Group> groups;
+		std::vector<MemoryBlock> memoryBlocks;
+		//Last use of every memory block, carried over between frames
+		std::vector<ResourceState> blockStates;
+		//Recording state of the frame being executed
+		std::vector<ResourceState> states;
+		std::vector<bool> touched;
+		VkDeviceSize allocatedMemorySize = 0;
+		VkDeviceSize requestedMemorySize = 0;
+		bool compiled = false;
+	};//end class LveRenderGraph
+}//end namespace
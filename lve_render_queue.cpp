@@ -0,0 +1,223 @@
+#include "lve_render_queue.h"
+
+//std
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve
+{
+	uint64_t LveRenderQueue::makeSortKey(uint32_t pass, uint32_t pipelineId, uint32_t descriptorSetId, uint32_t meshId, float depth)
+	{
+		//Ids past the width of their field wrap around, draws still come out right, only less grouped
+		const uint64_t depthMax = (1ull << DEPTH_BITS) - 1;
+		uint64_t quantizedDepth = static_cast<uint64_t>(std::min(std::max(depth, 0.0f), 1.0f) * depthMax);
+
+		uint64_t key = pass & ((1u << PASS_BITS) - 1);
+		key = (key << PIPELINE_BITS) | (pipelineId & ((1u << PIPELINE_BITS) - 1));
+		key = (key << DESCRIPTOR_SET_BITS) | (descriptorSetId & ((1u << DESCRIPTOR_SET_BITS) - 1));
+		key = (key << MESH_BITS) | (meshId & ((1u << MESH_BITS) - 1));
+		key = (key << DEPTH_BITS) | quantizedDepth;
+		return key;
+	}//end makeSortKey
+
+	void LveRenderQueue::clear()
+	{
+		packets.clear();
+		keys.clear();
+		order.clear();
+		pushConstantData.clear();
+		pipelineIds.clear();
+		descriptorSetIds.clear();
+		meshIds.clear();
+		stats = LveRenderQueueStats{};
+	}//end clear
+
+	void LveRenderQueue::submit(
+		uint32_t pass,
+		LvePipeline* pipeline,
+		VkDescriptorSet descriptorSet,
+		LveModel* model,
+		uint32_t lod,
+		float depth,
+		const void* pushConstants,
+		uint32_t pushConstantSize,
+		uint32_t cullIndex)
+	{
+		if (pushConstantSize > MAX_PUSH_CONSTANT_SIZE)
+		{
+			throw std::runtime_error("push constants of a draw packet are too big!");
+		}//end if
+
+		DrawPacket packet{};
+		packet.pass = pass;
+		packet.pipeline = pipeline;
+		packet.descriptorSet = descriptorSet;
+		packet.model = model;
+		packet.lod = lod;
+		packet.depth = depth;
+		packet.cullIndex = cullIndex;
+		packet.pushConstantOffset = static_cast<uint32_t>(pushConstantData.size());
+		packet.pushConstantSize = pushConstantSize;
+		pushConstantData.resize(pushConstantData.size() + pushConstantSize);
+		std::memcpy(pushConstantData.data() + packet.pushConstantOffset, pushConstants, pushConstantSize);
+
+		//A null set sorts first within its pipeline
+		uint32_t descriptorSetId = descriptorSet == VK_NULL_HANDLE ? 0 : idOf(descriptorSetIds, reinterpret_cast<const void*>(descriptorSet));
+		keys.push_back(makeSortKey(pass, idOf(pipelineIds, pipeline), descriptorSetId, idOf(meshIds, model), depth));
+		order.push_back(static_cast<uint32_t>(packets.size()));
+		packets.push_back(packet);
+	}//end submit
+
+	void LveRenderQueue::sort()
+	{
+		radixSort(keys, order, scratchKeys, scratchOrder);
+	}//end sort
+
+	void LveRenderQueue::record(
+		VkCommandBuffer commandBuffer,
+		VkPipelineLayout pipelineLayout,
+		VkShaderStageFlags pushConstantStages,
+		uint32_t descriptorSetIndex,
+		VkBuffer indirectBuffer,
+		VkDeviceSize indirectOffset)
+	{
+		LvePipeline* boundPipeline = nullptr;
+		VkDescriptorSet boundDescriptorSet = VK_NULL_HANDLE;
+		LveModel* boundModel = nullptr;
+
+		for (uint32_t index : order)
+		{
+			const DrawPacket& packet = packets[index];
+
+			if (packet.pipeline != boundPipeline)
+			{
+				packet.pipeline->bind(commandBuffer);
+				boundPipeline = packet.pipeline;
+				stats.pipelineBinds++;
+			}
+			else
+			{
+				stats.pipelineBindsSkipped++;
+			}//end if
+
+			//Sets stay bound across pipelines with the same layout, only a different set needs a bind
+			if (packet.descriptorSet != VK_NULL_HANDLE)
+			{
+				if (packet.descriptorSet != boundDescriptorSet)
+				{
+					vkCmdBindDescriptorSets(
+						commandBuffer,
+						VK_PIPELINE_BIND_POINT_GRAPHICS,
+						pipelineLayout,
+						descriptorSetIndex,
+						1,
+						&packet.descriptorSet,
+						0,
+						nullptr);
+					boundDescriptorSet = packet.descriptorSet;
+					stats.descriptorSetBinds++;
+				}
+				else
+				{
+					stats.descriptorSetBindsSkipped++;
+				}//end if
+			}//end if
+
+			//One vertex buffer per model holding all of its levels, the same model means the same buffer
+			if (packet.model != boundModel)
+			{
+				packet.model->bind(commandBuffer);
+				boundModel = packet.model;
+				stats.vertexBufferBinds++;
+			}
+			else
+			{
+				stats.vertexBufferBindsSkipped++;
+			}//end if
+
+			if (packet.pushConstantSize > 0)
+			{
+				vkCmdPushConstants(
+					commandBuffer,
+					pipelineLayout,
+					pushConstantStages,
+					0,
+					packet.pushConstantSize,
+					pushConstantData.data() + packet.pushConstantOffset);
+			}//end if
+			if (indirectBuffer != VK_NULL_HANDLE && packet.cullIndex != NO_CULL_INDEX)
+			{
+				vkCmdDrawIndirect(
+					commandBuffer,
+					indirectBuffer,
+					indirectOffset + sizeof(VkDrawIndirectCommand) * packet.cullIndex,
+					1,
+					sizeof(VkDrawIndirectCommand));
+				stats.indirectDrawCommands++;
+			}
+			else
+			{
+				packet.model->draw(commandBuffer, packet.lod);
+				//Clamped to the last level the way LveModel::draw does
+				stats.directVertices += packet.model->getLod(std::min(packet.lod, packet.model->getLodCount() - 1)).vertexCount;
+			}//end if
+			stats.drawCommands++;
+		}//end for
+	}//end record
+
+	void LveRenderQueue::radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values, std::vector<uint64_t>& scratchKeys, std::vector<uint32_t>& scratchValues)
+	{
+		//LSD radix sort, 8 bits per pass. All eight histograms are built in one read of the keys,
+		//and a pass whose byte is the same in every key is skipped (the unused high bits of the pass
+		//field, a queue with one pipeline...).
+		const size_t count = keys.size();
+		scratchKeys.resize(count);
+		scratchValues.resize(count);
+
+		std::array<std::array<uint32_t, 256>, 8> histograms{};
+		for (uint64_t key : keys)
+		{
+			for (int pass = 0; pass < 8; pass++)
+			{
+				histograms[pass][(key >> (pass * 8)) & 0xff]++;
+			}//end for
+		}//end for
+
+		for (int pass = 0; pass < 8; pass++)
+		{
+			auto& histogram = histograms[pass];
+			uint8_t firstByte = count > 0 ? static_cast<uint8_t>(keys[0] >> (pass * 8)) : 0;
+			if (histogram[firstByte] == count)
+			{
+				continue;
+			}//end if
+
+			//Counts to starting offsets
+			uint32_t offset = 0;
+			for (auto& bucket : histogram)
+			{
+				uint32_t bucketCount = bucket;
+				bucket = offset;
+				offset += bucketCount;
+			}//end for
+
+			for (size_t i = 0; i < count; i++)
+			{
+				uint32_t destination = histogram[(keys[i] >> (pass * 8)) & 0xff]++;
+				scratchKeys[destination] = keys[i];
+				scratchValues[destination] = values[i];
+			}//end for
+			keys.swap(scratchKeys);
+			values.swap(scratchValues);
+		}//end for
+	}//end radixSort
+
+	uint32_t LveRenderQueue::idOf(std::unordered_map<const void*, uint32_t>& ids, const void* object)
+	{
+		//Ids start at 1, 0 is left for "no object"
+		auto inserted = ids.emplace(object, static_cast<uint32_t>(ids.size() + 1));
+		return inserted.first->second;
+	}//end idOf
+}//end namespace
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "lve_model.h"
+#include "lve_pipeline.h"
+
+//std
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace lve
+{
+	//Commands and binds issued by the queue since the last clear(), every record of the frame adds to them
+	struct LveRenderQueueStats
+	{
+		//A draw recorded once per culling phase counts once per phase
+		uint32_t drawCommands = 0;
+		//Of those, the ones whose instance count comes from an indirect buffer (e.g. written by GPU
+		//culling), they may draw nothing
+		uint32_t indirectDrawCommands = 0;
+		//Vertices of the direct draw commands, only the GPU knows how many the indirect ones draw
+		uint64_t directVertices = 0;
+		uint32_t pipelineBinds = 0;
+		uint32_t pipelineBindsSkipped = 0;
+		uint32_t descriptorSetBinds = 0;
+		uint32_t descriptorSetBindsSkipped = 0;
+		uint32_t vertexBufferBinds = 0;
+		uint32_t vertexBufferBindsSkipped = 0;
+	};
+
+	//Collects the draws of a frame, sorts them by a 64 bit key and records them with as few binds
+	//as possible. The key orders by pass first, then pipeline, descriptor set, mesh and depth, so
+	//draws sharing state end up next to each other and the recorder only binds what changed.
+	//Every pipeline in one queue must use the same pipeline layout.
+	class LveRenderQueue
+	{
+	public:
+		//Bits of each field in the sort key, from the most significant down
+		static constexpr uint32_t PASS_BITS = 4;
+		static constexpr uint32_t PIPELINE_BITS = 12;
+		static constexpr uint32_t DESCRIPTOR_SET_BITS = 12;
+		static constexpr uint32_t MESH_BITS = 16;
+		static constexpr uint32_t DEPTH_BITS = 20;
+		static constexpr uint32_t MAX_PUSH_CONSTANT_SIZE = 128;
+		//Draw that is always recorded as a plain draw
+		static constexpr uint32_t NO_CULL_INDEX = ~0u;
+
+		//depth in [0, 1], front to back within the same state
+		static uint64_t makeSortKey(uint32_t pass, uint32_t pipelineId, uint32_t descriptorSetId, uint32_t meshId, float depth);
+
+		//Forgets the draws of the last frame, their stats and the ids handed to their pipelines, sets and meshes.
+		//Ids only group equal state within one frame, and the same submission order gives the same ids again.
+		void clear();
+
+		//descriptorSet may be VK_NULL_HANDLE when the draw needs no set of its own. cullIndex picks the
+		//draw's command in the indirect buffer given to record.
+		void submit(
+			uint32_t pass,
+			LvePipeline* pipeline,
+			VkDescriptorSet descriptorSet,
+			LveModel* model,
+			uint32_t lod,
+			float depth,
+			const void* pushConstants,
+			uint32_t pushConstantSize,
+			uint32_t cullIndex = NO_CULL_INDEX);
+
+		void sort();
+		//Per draw descriptor sets are bound at descriptorSetIndex, push constants go to pushConstantStages.
+		//With an indirectBuffer, draws with a cull index are drawn with the VkDrawIndirectCommand at
+		//indirectOffset + cullIndex * sizeof(VkDrawIndirectCommand). A queue can be recorded more than
+		//once, e.g. once per culling phase with a different offset.
+		void record(
+			VkCommandBuffer commandBuffer,
+			VkPipelineLayout pipelineLayout,
+			VkShaderStageFlags pushConstantStages,
+			uint32_t descriptorSetIndex,
+			VkBuffer indirectBuffer = VK_NULL_HANDLE,
+			VkDeviceSize indirectOffset = 0);
+
+		struct DrawPacket
+		{
+			uint32_t pass;
+			LvePipeline* pipeline;
+			VkDescriptorSet descriptorSet;
+			LveModel* model;
+			uint32_t lod;
+			float depth;
+			uint32_t pushConstantOffset;
+			uint32_t pushConstantSize;
+			uint32_t cullIndex;
+		};
+
+		size_t size() const { return packets.size(); }
+		const LveRenderQueueStats& getStats() const { return stats; }
+		//Draws in the order they were submitted, e.g. to capture the frame
+		const std::vector<DrawPacket>& getPackets() const { return packets; }
+		const uint8_t* getPushConstants(const DrawPacket& packet) const { return pushConstantData.data() + packet.pushConstantOffset; }
+
+	private:
+
+		static void radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values, std::vector<uint64_t>& scratchKeys, std::vector<uint32_t>& scratchValues);
+		static uint32_t idOf(std::unordered_map<const void*, uint32_t>& ids, const void* object);
+
+		std::vector<DrawPacket> packets;
+		std::vector<uint64_t> keys;
+		//Packet index for each key, in sorted order after sort()
+		std::vector<uint32_t> order;
+		std::vector<uint64_t> scratchKeys;
+		std::vector<uint32_t> scratchOrder;
+		//Push constants of every packet, back to back
+		std::vector<uint8_t> pushConstantData;
+
+		//Keyed by address, so they never outlive the frame: a destroyed object's address may be reused
+		std::unordered_map<const void*, uint32_t> pipelineIds;
+		std::unordered_map<const void*, uint32_t> descriptorSetIds;
+		std::unordered_map<const void*, uint32_t> meshIds;
+
+		LveRenderQueueStats stats;
+	};//end class LveRenderQueue
+}//end namespace
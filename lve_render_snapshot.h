@@ -0,0 +1,38 @@
+#pragma once
+
+#include "lve_clustered_lighting.h"
+#include "lve_model.h"
+
+//std
+#include <cstdint>
+#include <vector>
+
+namespace lve
+{
+	//Everything the render thread needs to draw one object. Plain values copied out of the
+	//simulation. The model is already loaded, and stays alive until the render thread has moved on to
+	//a snapshot that no longer references it (see LveAssetManager::releaseUnloaded).
+	struct RenderObject
+	{
+		LveModel* model = nullptr;
+		glm::vec2 offset{};
+		glm::vec3 color{};
+		//Index into the bindless table, the same for every object sharing a material
+		uint32_t materialIndex = 0;
+		//Level of detail of the model to draw, picked by the simulation thread
+		uint32_t lod = 0;
+		//Depth of the object's layer, 0 is the nearest
+		float depth = 0.0f;
+	};
+
+	//State of the world after one simulation step, published by the simulation thread and never
+	//modified once the render thread has picked it up
+	struct RenderSnapshot
+	{
+		uint64_t simulationStep = 0;
+		double simulationTime = 0.0;
+		std::vector<RenderObject> objects;
+		//Every light, culled per cluster on the GPU
+		std::vector<LveLight> lights;
+	};
+}//end namespace
@@ -0,0 +1,713 @@
+#include "lve_spatial_index.h"
+
+//std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+
+namespace lve
+{
+	//Enough subtrees to keep every worker busy during refits and parallel queries
+	static constexpr uint32_t SUBTREE_TARGET = 64;
+	//Deeper than a median split tree over 2^32 objects gets
+	static constexpr uint32_t MAX_RAY_STACK = 64;
+
+	static LveBounds emptyBounds()
+	{
+		const float infinity = std::numeric_limits<float>::infinity();
+		return { glm::vec2{ infinity }, glm::vec2{ -infinity } };
+	}//end emptyBounds
+
+	//Half the perimeter of the box, the 2D stand-in for the surface area of the SAH: how likely a query
+	//is to touch the node. 0 for an empty box.
+	static float halfPerimeter(glm::vec2 min, glm::vec2 max)
+	{
+		glm::vec2 extent = max - min;
+		return extent.x >= 0.0f && extent.y >= 0.0f ? extent.x + extent.y : 0.0f;
+	}//end halfPerimeter
+
+	LveSpatialIndex::LveSpatialIndex(LveJobSystem& jobSystem, float rebuildThreshold)
+		: jobSystem{ jobSystem }, rebuildThreshold{ rebuildThreshold }
+	{
+	}//constructor
+
+	LveSpatialIndex::~LveSpatialIndex()
+	{
+		jobSystem.wait(buildDone);
+	}//destructor
+
+	uint32_t LveSpatialIndex::insert(const LveBounds& objectBounds)
+	{
+		uint32_t proxy;
+		if (!freeProxies.empty())
+		{
+			proxy = freeProxies.back();
+			freeProxies.pop_back();
+		}
+		else
+		{
+			proxy = static_cast<uint32_t>(bounds.size());
+			bounds.emplace_back();
+			alive.push_back(0);
+			inPending.push_back(0);
+			treeSlot.push_back(INVALID_PROXY);
+		}//end if
+		bounds[proxy] = objectBounds;
+		alive[proxy] = 1;
+		proxyCount++;
+
+		//A reused proxy may still have its slot in the tree, the refit picks the new bounds up there
+		if (treeSlot[proxy] == INVALID_PROXY && !inPending[proxy])
+		{
+			inPending[proxy] = 1;
+			pending.push_back(proxy);
+		}//end if
+		return proxy;
+	}//end insert
+
+	void LveSpatialIndex::update(uint32_t proxy, const LveBounds& objectBounds)
+	{
+		bounds[proxy] = objectBounds;
+	}//end update
+
+	void LveSpatialIndex::remove(uint32_t proxy)
+	{
+		//The tree slot stays until the next build, refit leaves it empty
+		alive[proxy] = 0;
+		freeProxies.push_back(proxy);
+		proxyCount--;
+	}//end remove
+
+	void LveSpatialIndex::commit()
+	{
+		if (building && buildDone.isDone())
+		{
+			adoptBuild();
+		}//end if
+		refit();
+
+		//Objects not in the tree are tested one by one
+		pendingProxies.clear();
+		pendingBounds.clear();
+		size_t kept = 0;
+		for (uint32_t proxy : pending)
+		{
+			if (alive[proxy] && treeSlot[proxy] == INVALID_PROXY)
+			{
+				pending[kept++] = proxy;
+				pendingProxies.push_back(proxy);
+				pendingBounds.push_back(bounds[proxy]);
+			}
+			else
+			{
+				inPending[proxy] = 0;
+			}//end if
+		}//end for
+		pending.resize(kept);
+
+		if (measureBuiltCost)
+		{
+			builtCost = cost;
+			measureBuiltCost = false;
+		}//end if
+		if (!building)
+		{
+			bool loose = builtCost > 0.0f && cost > builtCost * rebuildThreshold;
+			bool manyPending = pending.size() >= std::max(MIN_PENDING_FOR_REBUILD, proxyCount / 8);
+			if (loose || manyPending)
+			{
+				startBuild();
+			}//end if
+		}//end if
+	}//end commit
+
+	void LveSpatialIndex::rebuild()
+	{
+		if (building)
+		{
+			jobSystem.wait(buildDone);
+			adoptBuild();
+		}//end if
+		startBuild();
+		jobSystem.wait(buildDone);
+		adoptBuild();
+		commit();
+	}//end rebuild
+
+	void LveSpatialIndex::startBuild()
+	{
+		//A copy, the bounds keep changing while the build runs
+		buildInput.clear();
+		buildInput.reserve(proxyCount);
+		for (uint32_t proxy = 0; proxy < bounds.size(); proxy++)
+		{
+			if (alive[proxy])
+			{
+				const LveBounds& objectBounds = bounds[proxy];
+				buildInput.push_back({ objectBounds, (objectBounds.min + objectBounds.max) * 0.5f, proxy });
+			}//end if
+		}//end for
+		building = true;
+		jobSystem.run([this]() { buildTree(buildInput, buildOutput); }, &buildDone);
+	}//end startBuild
+
+	void LveSpatialIndex::adoptBuild()
+	{
+		for (uint32_t slot = 0; slot < tree.primitiveSource.size(); slot++)
+		{
+			treeSlot[tree.primitiveSource[slot]] = INVALID_PROXY;
+		}//end for
+		tree = std::move(buildOutput);
+		buildOutput = Tree{};
+		//Objects removed since the copy was taken are left out by the refit. One whose proxy was reused
+		//since is the new object, at the bounds the refit reads.
+		for (uint32_t slot = 0; slot < tree.primitiveSource.size(); slot++)
+		{
+			treeSlot[tree.primitiveSource[slot]] = slot;
+		}//end for
+		//A proxy removed before the copy and reused since had a slot in the old tree only, so insert did
+		//not make it pending. It is in neither tree now, it goes with the pending objects.
+		for (uint32_t proxy = 0; proxy < bounds.size(); proxy++)
+		{
+			if (alive[proxy] && treeSlot[proxy] == INVALID_PROXY && !inPending[proxy])
+			{
+				inPending[proxy] = 1;
+				pending.push_back(proxy);
+			}//end if
+		}//end for
+		building = false;
+		measureBuiltCost = true;
+		rebuilds++;
+	}//end adoptBuild
+
+	void LveSpatialIndex::buildTree(std::vector<BuildPrimitive>& primitives, Tree& tree)
+	{
+		tree = Tree{};
+		if (primitives.empty())
+		{
+			return;
+		}//end if
+		tree.nodes.reserve(2 * (primitives.size() / 2 + 1));
+		buildNode(primitives, 0, static_cast<uint32_t>(primitives.size()), tree);
+
+		tree.primitiveSource.resize(primitives.size());
+		for (size_t i = 0; i < primitives.size(); i++)
+		{
+			tree.primitiveSource[i] = primitives[i].proxy;
+		}//end for
+		tree.primitiveProxy.resize(primitives.size());
+		tree.primitiveBounds.resize(primitives.size());
+		findSubtrees(tree);
+	}//end buildTree
+
+	uint32_t LveSpatialIndex::buildNode(std::vector<BuildPrimitive>& primitives, uint32_t begin, uint32_t end, Tree& tree)
+	{
+		uint32_t index = static_cast<uint32_t>(tree.nodes.size());
+		tree.nodes.emplace_back();
+
+		LveBounds nodeBounds = emptyBounds();
+		LveBounds centerBounds = emptyBounds();
+		for (uint32_t i = begin; i < end; i++)
+		{
+			nodeBounds.min = glm::min(nodeBounds.min, primitives[i].bounds.min);
+			nodeBounds.max = glm::max(nodeBounds.max, primitives[i].bounds.max);
+			centerBounds.min = glm::min(centerBounds.min, primitives[i].center);
+			centerBounds.max = glm::max(centerBounds.max, primitives[i].center);
+		}//end for
+
+		if (end - begin > MAX_LEAF_SIZE)
+		{
+			//Median split along the longer side of the centers, a balanced tree with leaves of 2 to 4
+			glm::vec2 extent = centerBounds.max - centerBounds.min;
+			int axis = extent.x >= extent.y ? 0 : 1;
+			uint32_t middle = begin + (end - begin) / 2;
+			std::nth_element(
+				primitives.begin() + begin,
+				primitives.begin() + middle,
+				primitives.begin() + end,
+				[axis](const BuildPrimitive& a, const BuildPrimitive& b) { return a.center[axis] < b.center[axis]; });
+			buildNode(primitives, begin, middle, tree);
+			buildNode(primitives, middle, end, tree);
+		}//end if
+
+		//Written after the children, pushing them may have moved the nodes
+		Node& node = tree.nodes[index];
+		node.min = nodeBounds.min;
+		node.max = nodeBounds.max;
+		node.skip = static_cast<uint32_t>(tree.nodes.size());
+		node.firstPrimitive = begin;
+		node.primitiveCount = end - begin;
+		node.padding = 0;
+		return index;
+	}//end buildNode
+
+	void LveSpatialIndex::findSubtrees(Tree& tree)
+	{
+		//Opens the tree level by level from the root until there are enough subtrees
+		std::vector<uint32_t> frontier = { 0 };
+		std::vector<uint32_t> next;
+		while (frontier.size() < SUBTREE_TARGET)
+		{
+			next.clear();
+			bool opened = false;
+			for (uint32_t index : frontier)
+			{
+				if (tree.nodes[index].skip == index + 1)
+				{
+					next.push_back(index);
+					continue;
+				}//end if
+				tree.topNodes.push_back(index);
+				next.push_back(index + 1);
+				next.push_back(tree.nodes[index + 1].skip);
+				opened = true;
+			}//end for
+			frontier.swap(next);
+			if (!opened)
+			{
+				break;
+			}//end if
+		}//end while
+		tree.subtreeRoots = frontier;
+		//Children come after their parents, so a descending order refits children first
+		std::sort(tree.topNodes.begin(), tree.topNodes.end(), std::greater<uint32_t>());
+	}//end findSubtrees
+
+	float LveSpatialIndex::refitNode(Tree& tree, uint32_t index)
+	{
+		Node& node = tree.nodes[index];
+		LveBounds nodeBounds = emptyBounds();
+		if (node.skip == index + 1)
+		{
+			for (uint32_t i = node.firstPrimitive; i < node.firstPrimitive + node.primitiveCount; i++)
+			{
+				nodeBounds.min = glm::min(nodeBounds.min, tree.primitiveBounds[i].min);
+				nodeBounds.max = glm::max(nodeBounds.max, tree.primitiveBounds[i].max);
+			}//end for
+		}
+		else
+		{
+			const Node& left = tree.nodes[index + 1];
+			const Node& right = tree.nodes[left.skip];
+			nodeBounds.min = glm::min(left.min, right.min);
+			nodeBounds.max = glm::max(left.max, right.max);
+		}//end if
+		node.min = nodeBounds.min;
+		node.max = nodeBounds.max;
+		return halfPerimeter(node.min, node.max);
+	}//end refitNode
+
+	float LveSpatialIndex::refitRange(Tree& tree, uint32_t begin, uint32_t end)
+	{
+		float rangeCost = 0.0f;
+		for (uint32_t index = end; index > begin; index--)
+		{
+			rangeCost += refitNode(tree, index - 1);
+		}//end for
+		return rangeCost;
+	}//end refitRange
+
+	void LveSpatialIndex::refit()
+	{
+		cost = 0.0f;
+		if (tree.nodes.empty())
+		{
+			return;
+		}//end if
+
+		//Current bounds into leaf order, so the node pass and the queries read them sequentially
+		jobSystem.parallelFor(
+			static_cast<uint32_t>(tree.primitiveSource.size()),
+			4096,
+			[this](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t slot = begin; slot < end; slot++)
+			{
+				uint32_t proxy = tree.primitiveSource[slot];
+				bool present = alive[proxy] && treeSlot[proxy] == slot;
+				tree.primitiveProxy[slot] = present ? proxy : INVALID_PROXY;
+				tree.primitiveBounds[slot] = present ? bounds[proxy] : emptyBounds();
+			}//end for
+		});
+
+		//Subtrees are independent, the few nodes above them go last
+		std::vector<float> subtreeCosts(tree.subtreeRoots.size());
+		jobSystem.parallelFor(
+			static_cast<uint32_t>(tree.subtreeRoots.size()),
+			1,
+			[this, &subtreeCosts](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				uint32_t root = tree.subtreeRoots[i];
+				subtreeCosts[i] = refitRange(tree, root, tree.nodes[root].skip);
+			}//end for
+		});
+		for (float subtreeCost : subtreeCosts)
+		{
+			cost += subtreeCost;
+		}//end for
+		for (uint32_t index : tree.topNodes)
+		{
+			cost += refitNode(tree, index);
+		}//end for
+	}//end refit
+
+	template<typename NodeTest, typename PrimitiveTest>
+	void LveSpatialIndex::collect(uint32_t begin, uint32_t end, const NodeTest& nodeTest, const PrimitiveTest& primitiveTest, std::vector<uint32_t>& results) const
+	{
+		uint32_t index = begin;
+		while (index < end)
+		{
+			const Node& node = tree.nodes[index];
+			Overlap overlap = nodeTest(node.min, node.max);
+			if (overlap == Overlap::Outside)
+			{
+				index = node.skip;
+				continue;
+			}//end if
+
+			bool leaf = node.skip == index + 1;
+			if (overlap == Overlap::Inside || leaf)
+			{
+				//The primitives of a subtree are one range, taken whole when it is all inside
+				for (uint32_t i = node.firstPrimitive; i < node.firstPrimitive + node.primitiveCount; i++)
+				{
+					uint32_t proxy = tree.primitiveProxy[i];
+					if (proxy != INVALID_PROXY && (overlap == Overlap::Inside || primitiveTest(tree.primitiveBounds[i])))
+					{
+						results.push_back(proxy);
+					}//end if
+				}//end for
+				index = node.skip;
+				continue;
+			}//end if
+			index++;
+		}//end while
+	}//end collect
+
+	template<typename PrimitiveTest>
+	void LveSpatialIndex::collectPending(const PrimitiveTest& primitiveTest, std::vector<uint32_t>& results) const
+	{
+		for (size_t i = 0; i < pendingProxies.size(); i++)
+		{
+			if (primitiveTest(pendingBounds[i]))
+			{
+				results.push_back(pendingProxies[i]);
+			}//end if
+		}//end for
+	}//end collectPending
+
+	LveSpatialIndex::Overlap LveSpatialIndex::testPlanes(const glm::vec3* planes, uint32_t planeCount, glm::vec2 min, glm::vec2 max)
+	{
+		Overlap overlap = Overlap::Inside;
+		for (uint32_t i = 0; i < planeCount; i++)
+		{
+			const glm::vec3& plane = planes[i];
+			//Corners of the box farthest along and against the normal
+			glm::vec2 farthest{ plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y };
+			glm::vec2 nearest{ plane.x >= 0.0f ? min.x : max.x, plane.y >= 0.0f ? min.y : max.y };
+			if (plane.x * farthest.x + plane.y * farthest.y + plane.z < 0.0f)
+			{
+				return Overlap::Outside;
+			}//end if
+			if (plane.x * nearest.x + plane.y * nearest.y + plane.z < 0.0f)
+			{
+				overlap = Overlap::Partial;
+			}//end if
+		}//end for
+		return overlap;
+	}//end testPlanes
+
+	void LveSpatialIndex::queryPlanes(const glm::vec3* planes, uint32_t planeCount, std::vector<uint32_t>& results) const
+	{
+		auto nodeTest = [planes, planeCount](glm::vec2 min, glm::vec2 max) { return testPlanes(planes, planeCount, min, max); };
+		auto primitiveTest = [&nodeTest](const LveBounds& primitive) { return nodeTest(primitive.min, primitive.max) != Overlap::Outside; };
+
+		if (!tree.nodes.empty())
+		{
+			collect(0, static_cast<uint32_t>(tree.nodes.size()), nodeTest, primitiveTest, results);
+		}//end if
+		collectPending(primitiveTest, results);
+	}//end queryPlanes
+
+	void LveSpatialIndex::queryPlanesParallel(const glm::vec3* planes, uint32_t planeCount, std::vector<uint32_t>& results) const
+	{
+		if (tree.subtreeRoots.size() <= 1)
+		{
+			queryPlanes(planes, planeCount, results);
+			return;
+		}//end if
+
+		//Same tests as queryPlanes, one subtree per job. The nodes above the subtrees are not tested,
+		//there are too few of them to matter.
+		auto nodeTest = [planes, planeCount](glm::vec2 min, glm::vec2 max) { return testPlanes(planes, planeCount, min, max); };
+		auto primitiveTest = [&nodeTest](const LveBounds& primitive) { return nodeTest(primitive.min, primitive.max) != Overlap::Outside; };
+
+		std::vector<std::vector<uint32_t>> partialResults(tree.subtreeRoots.size());
+		jobSystem.parallelFor(
+			static_cast<uint32_t>(tree.subtreeRoots.size()),
+			1,
+			[this, &nodeTest, &primitiveTest, &partialResults](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				uint32_t root = tree.subtreeRoots[i];
+				collect(root, tree.nodes[root].skip, nodeTest, primitiveTest, partialResults[i]);
+			}//end for
+		});
+		for (auto& partial : partialResults)
+		{
+			results.insert(results.end(), partial.begin(), partial.end());
+		}//end for
+		collectPending(primitiveTest, results);
+	}//end queryPlanesParallel
+
+	void LveSpatialIndex::queryBounds(const LveBounds& query, std::vector<uint32_t>& results) const
+	{
+		auto nodeTest = [&query](glm::vec2 min, glm::vec2 max)
+		{
+			if (max.x < query.min.x || max.y < query.min.y || min.x > query.max.x || min.y > query.max.y)
+			{
+				return Overlap::Outside;
+			}//end if
+			bool inside = min.x >= query.min.x && min.y >= query.min.y && max.x <= query.max.x && max.y <= query.max.y;
+			return inside ? Overlap::Inside : Overlap::Partial;
+		};
+		auto primitiveTest = [&nodeTest](const LveBounds& primitive) { return nodeTest(primitive.min, primitive.max) != Overlap::Outside; };
+
+		if (!tree.nodes.empty())
+		{
+			collect(0, static_cast<uint32_t>(tree.nodes.size()), nodeTest, primitiveTest, results);
+		}//end if
+		collectPending(primitiveTest, results);
+	}//end queryBounds
+
+	void LveSpatialIndex::queryRadius(glm::vec2 center, float radius, std::vector<uint32_t>& results) const
+	{
+		const float radiusSquared = radius * radius;
+		auto nodeTest = [center, radiusSquared](glm::vec2 min, glm::vec2 max)
+		{
+			glm::vec2 closest = glm::min(glm::max(center, min), max) - center;
+			if (glm::dot(closest, closest) > radiusSquared)
+			{
+				return Overlap::Outside;
+			}//end if
+			glm::vec2 farthest = glm::max(glm::abs(center - min), glm::abs(max - center));
+			return glm::dot(farthest, farthest) <= radiusSquared ? Overlap::Inside : Overlap::Partial;
+		};
+		auto primitiveTest = [&nodeTest](const LveBounds& primitive) { return nodeTest(primitive.min, primitive.max) != Overlap::Outside; };
+
+		if (!tree.nodes.empty())
+		{
+			collect(0, static_cast<uint32_t>(tree.nodes.size()), nodeTest, primitiveTest, results);
+		}//end if
+		collectPending(primitiveTest, results);
+	}//end queryRadius
+
+	LveRayHit LveSpatialIndex::raycast(glm::vec2 origin, glm::vec2 direction, float maxDistance) const
+	{
+		const glm::vec2 inverse{ 1.0f / direction.x, 1.0f / direction.y };
+		//Distance the ray enters the box at, or infinity when it misses it within maxDistance
+		auto entry = [origin, inverse, maxDistance](glm::vec2 min, glm::vec2 max)
+		{
+			glm::vec2 t0 = (min - origin) * inverse;
+			glm::vec2 t1 = (max - origin) * inverse;
+			float near = std::max(std::max(std::min(t0.x, t1.x), std::min(t0.y, t1.y)), 0.0f);
+			float far = std::min(std::min(std::max(t0.x, t1.x), std::max(t0.y, t1.y)), maxDistance);
+			return near <= far ? near : std::numeric_limits<float>::infinity();
+		};
+
+		LveRayHit hit{};
+		float best = std::numeric_limits<float>::infinity();
+		for (size_t i = 0; i < pendingProxies.size(); i++)
+		{
+			float distance = entry(pendingBounds[i].min, pendingBounds[i].max);
+			if (distance < best)
+			{
+				best = distance;
+				hit = { pendingProxies[i], distance };
+			}//end if
+		}//end for
+		if (tree.nodes.empty())
+		{
+			return hit;
+		}//end if
+
+		//Nearer child first, anything entered past the best hit so far is skipped
+		struct StackEntry
+		{
+			uint32_t node;
+			float distance;
+		};
+		StackEntry stack[MAX_RAY_STACK];
+		uint32_t stackSize = 0;
+		float rootDistance = entry(tree.nodes[0].min, tree.nodes[0].max);
+		if (rootDistance < best)
+		{
+			stack[stackSize++] = { 0, rootDistance };
+		}//end if
+		while (stackSize > 0)
+		{
+			StackEntry current = stack[--stackSize];
+			if (current.distance >= best)
+			{
+				continue;
+			}//end if
+			const Node& node = tree.nodes[current.node];
+			if (node.skip == current.node + 1)
+			{
+				for (uint32_t i = node.firstPrimitive; i < node.firstPrimitive + node.primitiveCount; i++)
+				{
+					if (tree.primitiveProxy[i] == INVALID_PROXY)
+					{
+						continue;
+					}//end if
+					float distance = entry(tree.primitiveBounds[i].min, tree.primitiveBounds[i].max);
+					if (distance < best)
+					{
+						best = distance;
+						hit = { tree.primitiveProxy[i], distance };
+					}//end if
+				}//end for
+				continue;
+			}//end if
+
+			uint32_t left = current.node + 1;
+			uint32_t right = tree.nodes[left].skip;
+			float leftDistance = entry(tree.nodes[left].min, tree.nodes[left].max);
+			float rightDistance = entry(tree.nodes[right].min, tree.nodes[right].max);
+			if (leftDistance > rightDistance)
+			{
+				std::swap(left, right);
+				std::swap(leftDistance, rightDistance);
+			}//end if
+			if (rightDistance < best && stackSize < MAX_RAY_STACK)
+			{
+				stack[stackSize++] = { right, rightDistance };
+			}//end if
+			if (leftDistance < best && stackSize < MAX_RAY_STACK)
+			{
+				stack[stackSize++] = { left, leftDistance };
+			}//end if
+		}//end while
+		return hit;
+	}//end raycast
+
+	LveSpatialIndexStats LveSpatialIndex::getStats() const
+	{
+		LveSpatialIndexStats stats;
+		stats.proxies = proxyCount;
+		stats.nodes = static_cast<uint32_t>(tree.nodes.size());
+		stats.pending = static_cast<uint32_t>(pendingProxies.size());
+		stats.costRatio = builtCost > 0.0f ? cost / builtCost : 1.0f;
+		stats.rebuilds = rebuilds;
+		return stats;
+	}//end getStats
+
+	void runSpatialIndexBenchmark()
+	{
+		const uint32_t objectCount = 1 << 20;
+		const float worldSize = 1000.0f;
+		const int queryCount = 1000;
+		using Clock = std::chrono::steady_clock;
+		auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+		LveJobSystem jobSystem;
+		LveSpatialIndex index{ jobSystem };
+		std::mt19937 random{ 1234 };
+		std::uniform_real_distribution<float> position{ -worldSize, worldSize };
+		std::uniform_real_distribution<float> radius{ 0.5f, 2.0f };
+		std::uniform_real_distribution<float> unit{ -1.0f, 1.0f };
+
+		std::vector<glm::vec2> centers(objectCount);
+		std::vector<float> radii(objectCount);
+		std::vector<uint32_t> proxies(objectCount);
+		for (uint32_t i = 0; i < objectCount; i++)
+		{
+			centers[i] = { position(random), position(random) };
+			radii[i] = radius(random);
+			proxies[i] = index.insert(LveBounds::fromCircle(centers[i], radii[i]));
+		}//end for
+
+		auto start = Clock::now();
+		index.rebuild();
+		std::cout << "spatial index: " << objectCount << " objects, build " << elapsedMs(start) << " ms, "
+			<< index.getStats().nodes << " nodes\n";
+
+		//Everything moves a little every step, the tree is only refitted
+		const int steps = 10;
+		double commitMs = 0.0;
+		for (int step = 0; step < steps; step++)
+		{
+			for (uint32_t i = 0; i < objectCount; i++)
+			{
+				centers[i] += glm::vec2{ unit(random), unit(random) } * 0.5f;
+				index.update(proxies[i], LveBounds::fromCircle(centers[i], radii[i]));
+			}//end for
+			start = Clock::now();
+			index.commit();
+			commitMs += elapsedMs(start);
+		}//end for
+		LveSpatialIndexStats stats = index.getStats();
+		std::cout << "refit + commit " << commitMs / steps << " ms, cost ratio " << stats.costRatio
+			<< ", background rebuilds " << stats.rebuilds - 1 << "\n";
+
+		//View sized queries: a 50 x 50 window (about 700 objects) at random places
+		std::vector<uint32_t> results;
+		size_t found = 0;
+		start = Clock::now();
+		for (int i = 0; i < queryCount; i++)
+		{
+			glm::vec2 center{ position(random), position(random) };
+			glm::vec3 planes[4] = {
+				{ 1.0f, 0.0f, -(center.x - 25.0f) },
+				{ -1.0f, 0.0f, center.x + 25.0f },
+				{ 0.0f, 1.0f, -(center.y - 25.0f) },
+				{ 0.0f, -1.0f, center.y + 25.0f } };
+			results.clear();
+			index.queryPlanes(planes, 4, results);
+			found += results.size();
+		}//end for
+		std::cout << "frustum query " << elapsedMs(start) * 1000.0 / queryCount << " us, " << found / queryCount << " objects\n";
+
+		found = 0;
+		start = Clock::now();
+		for (int i = 0; i < queryCount; i++)
+		{
+			results.clear();
+			index.queryRadius({ position(random), position(random) }, 10.0f, results);
+			found += results.size();
+		}//end for
+		std::cout << "radius query " << elapsedMs(start) * 1000.0 / queryCount << " us, " << found / queryCount << " objects\n";
+
+		uint32_t hits = 0;
+		start = Clock::now();
+		for (int i = 0; i < queryCount; i++)
+		{
+			glm::vec2 direction{ unit(random), unit(random) };
+			hits += index.raycast({ position(random), position(random) }, direction, 2.0f * worldSize).isHit() ? 1 : 0;
+		}//end for
+		std::cout << "raycast " << elapsedMs(start) * 1000.0 / queryCount << " us, " << hits << " of " << queryCount << " hit\n";
+
+		//A quarter of the world: big results are where splitting the query over the workers pays off
+		glm::vec3 planes[4] = {
+			{ 1.0f, 0.0f, 0.0f },
+			{ -1.0f, 0.0f, worldSize },
+			{ 0.0f, 1.0f, 0.0f },
+			{ 0.0f, -1.0f, worldSize } };
+		results.clear();
+		start = Clock::now();
+		index.queryPlanes(planes, 4, results);
+		double serialMs = elapsedMs(start);
+		size_t serialCount = results.size();
+		results.clear();
+		start = Clock::now();
+		index.queryPlanesParallel(planes, 4, results);
+		std::cout << "large frustum query (" << serialCount << " objects) " << serialMs << " ms, parallel " << elapsedMs(start)
+			<< " ms (" << results.size() << " objects)\n";
+	}//end runSpatialIndexBenchmark
+}//end namespace
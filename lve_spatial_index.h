@@ -0,0 +1,189 @@
+#pragma once
+
+#include "lve_job_system.h"
+
+//libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+//std
+#include <cstdint>
+#include <vector>
+
+namespace lve
+{
+	//Axis aligned box in the plane of the scene
+	struct LveBounds
+	{
+		glm::vec2 min{ 0.0f };
+		glm::vec2 max{ 0.0f };
+
+		static LveBounds fromCircle(glm::vec2 center, float radius)
+		{
+			return { center - glm::vec2{ radius }, center + glm::vec2{ radius } };
+		}//end fromCircle
+	};
+
+	struct LveRayHit
+	{
+		//INVALID_PROXY when nothing was hit
+		uint32_t proxy = ~0u;
+		//Along the direction, in units of its length, to where the ray enters the object's bounds
+		float distance = 0.0f;
+
+		bool isHit() const { return proxy != ~0u; }
+	};
+
+	struct LveSpatialIndexStats
+	{
+		uint32_t proxies = 0;
+		uint32_t nodes = 0;
+		//Inserted since the last build, tested one by one until the next one
+		uint32_t pending = 0;
+		//Cost of the refitted tree relative to the tree right after its build, a rebuild starts past the threshold
+		float costRatio = 1.0f;
+		uint32_t rebuilds = 0;
+	};
+
+	//Bounding volume hierarchy over the bounds of the objects of a scene, for visibility, picking and
+	//proximity queries. Objects move by updating their bounds: commit refits the tree in place, and
+	//once refitting has made it too loose (or enough objects were inserted) a new tree is built on the
+	//job system from a copy of the bounds, and swapped in by a later commit without ever waiting on it.
+	//Nodes are 32 bytes stored depth first, a subtree is one contiguous range of nodes and of
+	//primitives, so queries walk memory forwards without a stack and take whole subtrees found inside
+	//the query without testing them. The bounds each leaf tests are copied next to it at refit.
+	//Insert, update and remove are for one thread and show in queries from the next commit on. Queries
+	//read only what commit wrote, so any number of them can run on any threads at the same time as
+	//the updates of the next step, but not at the same time as commit.
+	class LveSpatialIndex
+	{
+	public:
+		static constexpr uint32_t INVALID_PROXY = ~0u;
+		static constexpr uint32_t MAX_LEAF_SIZE = 4;
+		//Below this many pending objects a linear test is cheaper than rebuilding for them
+		static constexpr uint32_t MIN_PENDING_FOR_REBUILD = 256;
+
+		//rebuildThreshold: how much worse than right after its build the tree may get before a rebuild
+		LveSpatialIndex(LveJobSystem& jobSystem, float rebuildThreshold = 1.5f);
+		//Waits for a background build still running
+		~LveSpatialIndex();
+
+		LveSpatialIndex(const LveSpatialIndex&) = delete;
+		LveSpatialIndex& operator=(const LveSpatialIndex&) = delete;
+
+		uint32_t insert(const LveBounds& bounds);
+		void update(uint32_t proxy, const LveBounds& bounds);
+		void remove(uint32_t proxy);
+
+		//Once after the updates of a step: swaps in a finished background build, refits the tree to the
+		//current bounds and starts a new build when the tree has gotten too loose
+		void commit();
+		//Builds a new tree right away and commits, e.g. after loading a scene
+		void rebuild();
+
+		//Convex region bounded by planes (xy the normal pointing in, z the offset: inside where
+		//dot(xy, p) + z >= 0), e.g. the four sides of the view. Appends the proxies overlapping it.
+		void queryPlanes(const glm::vec3* planes, uint32_t planeCount, std::vector<uint32_t>& results) const;
+		void queryBounds(const LveBounds& bounds, std::vector<uint32_t>& results) const;
+		void queryRadius(glm::vec2 center, float radius, std::vector<uint32_t>& results) const;
+		//Nearest bounds along the ray, direction need not be normalized
+		LveRayHit raycast(glm::vec2 origin, glm::vec2 direction, float maxDistance) const;
+		//Same as queryPlanes, with the subtrees spread over the job system. Pays off for big results.
+		void queryPlanesParallel(const glm::vec3* planes, uint32_t planeCount, std::vector<uint32_t>& results) const;
+
+		LveSpatialIndexStats getStats() const;
+
+	private:
+		//Leaf when skip == its own index + 1, otherwise the left child follows it and the right child
+		//is at the left child's skip
+		struct Node
+		{
+			glm::vec2 min;
+			glm::vec2 max;
+			//Index of the node after this subtree
+			uint32_t skip;
+			//Primitives of the whole subtree
+			uint32_t firstPrimitive;
+			uint32_t primitiveCount;
+			uint32_t padding;
+		};
+
+		struct Tree
+		{
+			std::vector<Node> nodes;
+			//Proxy each primitive slot was built for
+			std::vector<uint32_t> primitiveSource;
+			//Written by refit: the proxy (INVALID_PROXY once removed) and its bounds, in leaf order
+			std::vector<uint32_t> primitiveProxy;
+			std::vector<LveBounds> primitiveBounds;
+			//Disjoint subtrees refitted in parallel, and the nodes above them, in descending order
+			std::vector<uint32_t> subtreeRoots;
+			std::vector<uint32_t> topNodes;
+		};
+
+		struct BuildPrimitive
+		{
+			LveBounds bounds;
+			glm::vec2 center;
+			uint32_t proxy;
+		};
+
+		enum class Overlap
+		{
+			Outside,
+			Partial,
+			Inside
+		};
+
+		static void buildTree(std::vector<BuildPrimitive>& primitives, Tree& tree);
+		static uint32_t buildNode(std::vector<BuildPrimitive>& primitives, uint32_t begin, uint32_t end, Tree& tree);
+		static void findSubtrees(Tree& tree);
+		static float refitRange(Tree& tree, uint32_t begin, uint32_t end);
+		static float refitNode(Tree& tree, uint32_t index);
+		//Shared by queryPlanes and queryPlanesParallel
+		static Overlap testPlanes(const glm::vec3* planes, uint32_t planeCount, glm::vec2 min, glm::vec2 max);
+
+		void startBuild();
+		void adoptBuild();
+		void refit();
+
+		//Walks the nodes [begin, end) of a subtree forwards
+		template<typename NodeTest, typename PrimitiveTest>
+		void collect(uint32_t begin, uint32_t end, const NodeTest& nodeTest, const PrimitiveTest& primitiveTest, std::vector<uint32_t>& results) const;
+		template<typename PrimitiveTest>
+		void collectPending(const PrimitiveTest& primitiveTest, std::vector<uint32_t>& results) const;
+
+		LveJobSystem& jobSystem;
+		float rebuildThreshold;
+
+		//Per proxy, owner thread only
+		std::vector<LveBounds> bounds;
+		std::vector<uint8_t> alive;
+		std::vector<uint8_t> inPending;
+		//Primitive slot of the proxy in the current tree, INVALID_PROXY if it was inserted after the build
+		std::vector<uint32_t> treeSlot;
+		std::vector<uint32_t> freeProxies;
+		std::vector<uint32_t> pending;
+		uint32_t proxyCount = 0;
+
+		//Read by queries, written by commit
+		Tree tree;
+		std::vector<uint32_t> pendingProxies;
+		std::vector<LveBounds> pendingBounds;
+		float cost = 0.0f;
+		float builtCost = 0.0f;
+		bool measureBuiltCost = false;
+
+		//Background build, its input and output are untouched by anything else until it is done
+		bool building = false;
+		LveJobCounter buildDone;
+		std::vector<BuildPrimitive> buildInput;
+		Tree buildOutput;
+		uint32_t rebuilds = 0;
+	};//end class LveSpatialIndex
+
+	//Builds an index over a million objects and prints the build, refit and query times. Started with
+	//"--spatial-benchmark".
+	void runSpatialIndexBenchmark();
+}//end namespace
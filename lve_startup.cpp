@@ -0,0 +1,207 @@
+#include "lve_startup.h"
+
+//std
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace lve
+{
+	//Initialized with the other statics before main, as close to the launch as the engine can see
+	static const std::chrono::steady_clock::time_point launchTime = std::chrono::steady_clock::now();
+
+	LveStartup::LveStartup(LveJobSystem& jobSystem) : jobSystem{ jobSystem }
+	{
+	}//constructor
+
+	double LveStartup::millisecondsSinceLaunch()
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - launchTime).count();
+	}//end millisecondsSinceLaunch
+
+	LveStartupStageId LveStartup::addStage(
+		const std::string& name,
+		const std::vector<LveStartupStageId>& dependencies,
+		std::function<void()> function,
+		bool mainThread)
+	{
+		LveStartupStageId id = static_cast<LveStartupStageId>(stages.size());
+		for (LveStartupStageId dependency : dependencies)
+		{
+			if (dependency >= id)
+			{
+				throw std::runtime_error("startup stage " + name + " depends on a stage added after it!");
+			}//end if
+			stages[dependency].dependents.push_back(id);
+		}//end for
+
+		Stage stage;
+		stage.name = name;
+		stage.function = std::move(function);
+		stage.mainThread = mainThread;
+		stage.remainingDependencies = static_cast<uint32_t>(dependencies.size());
+		stages.push_back(std::move(stage));
+		return id;
+	}//end addStage
+
+	void LveStartup::run()
+	{
+		double beginMs = millisecondsSinceLaunch();
+		std::vector<LveStartupStageId> ready;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			for (LveStartupStageId id = 0; id < stages.size(); id++)
+			{
+				if (stages[id].remainingDependencies > 0)
+				{
+					continue;
+				}//end if
+				if (stages[id].mainThread)
+				{
+					mainThreadReady.push_back(id);
+				}
+				else
+				{
+					ready.push_back(id);
+				}//end if
+			}//end for
+		}
+		start(ready);
+
+		//The calling thread is the main thread: it runs the stages that need it and otherwise sleeps
+		//until another stage finishes, the workers do the rest
+		std::unique_lock<std::mutex> lock{ mutex };
+		while (finishedStages < stages.size())
+		{
+			if (!mainThreadReady.empty())
+			{
+				LveStartupStageId id = mainThreadReady.back();
+				mainThreadReady.pop_back();
+				lock.unlock();
+				execute(id);
+				lock.lock();
+				continue;
+			}//end if
+			stageFinished.wait(lock);
+		}//end while
+		totalMs = millisecondsSinceLaunch() - beginMs;
+
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}//end if
+	}//end run
+
+	void LveStartup::execute(LveStartupStageId id)
+	{
+		Stage& stage = stages[id];
+		bool failed;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			failed = error != nullptr;
+		}
+		if (failed)
+		{
+			//Whatever it depends on may not exist
+			stage.skipped = true;
+		}
+		else
+		{
+			stage.startMs = millisecondsSinceLaunch();
+			try
+			{
+				stage.function();
+			}//end try
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				if (!error)
+				{
+					error = std::current_exception();
+				}//end if
+			}//end catch
+			stage.durationMs = millisecondsSinceLaunch() - stage.startMs;
+		}//end if
+
+		std::vector<LveStartupStageId> ready;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			release(id, ready);
+			finishedStages++;
+			//Notified under the lock, run may return and take the condition variable with it right after
+			stageFinished.notify_all();
+		}
+		start(ready);
+	}//end execute
+
+	void LveStartup::release(LveStartupStageId id, std::vector<LveStartupStageId>& ready)
+	{
+		for (LveStartupStageId dependent : stages[id].dependents)
+		{
+			if (--stages[dependent].remainingDependencies > 0)
+			{
+				continue;
+			}//end if
+			if (stages[dependent].mainThread)
+			{
+				mainThreadReady.push_back(dependent);
+			}
+			else
+			{
+				ready.push_back(dependent);
+			}//end if
+		}//end for
+	}//end release
+
+	void LveStartup::start(const std::vector<LveStartupStageId>& ready)
+	{
+		for (LveStartupStageId id : ready)
+		{
+			jobSystem.run([this, id]() { execute(id); });
+		}//end for
+	}//end start
+
+	void LveStartup::printReport() const
+	{
+		std::vector<LveStartupStageId> order(stages.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [this](LveStartupStageId a, LveStartupStageId b)
+		{
+			//Skipped stages never started, they go last
+			if (stages[a].skipped != stages[b].skipped)
+			{
+				return stages[b].skipped;
+			}//end if
+			return stages[a].startMs < stages[b].startMs;
+		});
+
+		double stagesMs = 0.0;
+		for (const Stage& stage : stages)
+		{
+			stagesMs += stage.durationMs;
+		}//end for
+		//Formatted on its own stream, std::cout keeps the flags it had
+		std::ostringstream report;
+		report << std::fixed << std::setprecision(1)
+			<< "startup: " << totalMs << " ms for " << stagesMs << " ms of stages, done "
+			<< millisecondsSinceLaunch() << " ms after launch\n";
+		report << "stage                start ms       ms  thread\n";
+		for (LveStartupStageId id : order)
+		{
+			const Stage& stage = stages[id];
+			report << std::left << std::setw(18) << stage.name << std::right;
+			if (stage.skipped)
+			{
+				report << "  skipped\n";
+				continue;
+			}//end if
+			report << std::setw(10) << stage.startMs << " " << std::setw(8) << stage.durationMs << "  "
+				<< (stage.mainThread ? "main" : "worker") << "\n";
+		}//end for
+		std::cout << report.str();
+	}//end printReport
+}//end namespace
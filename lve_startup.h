@@ -0,0 +1,77 @@
+#pragma once
+
+#include "lve_job_system.h"
+
+//std
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lve
+{
+	using LveStartupStageId = uint32_t;
+
+	//Engine startup as a graph of stages: a stage starts as soon as every stage it depends on has
+	//finished, so independent ones (reading shader files while the device is created, decoding models
+	//while the swap chain is set up) run at the same time on the job system. Stages that have to run
+	//on the main thread (GLFW windows) are run by the thread calling run. Every stage is timed, and
+	//printReport shows where the time from launch to the first frame went.
+	class LveStartup
+	{
+	public:
+		LveStartup(LveJobSystem& jobSystem);
+
+		LveStartup(const LveStartup&) = delete;
+		LveStartup& operator=(const LveStartup&) = delete;
+
+		//Dependencies are stages added before this one
+		LveStartupStageId addStage(
+			const std::string& name,
+			const std::vector<LveStartupStageId>& dependencies,
+			std::function<void()> function,
+			bool mainThread = false);
+
+		//Runs every stage and returns once they all finished. When a stage throws, the stages not
+		//started yet are skipped and the exception is rethrown once the running ones finished.
+		void run();
+
+		//Table of the stages in the order they started: when, for how long and on which thread
+		void printReport() const;
+		double getTotalMs() const { return totalMs; }
+
+		//Since the engine was loaded, before main
+		static double millisecondsSinceLaunch();
+
+	private:
+		struct Stage
+		{
+			std::string name;
+			std::function<void()> function;
+			bool mainThread = false;
+			std::vector<LveStartupStageId> dependents;
+			uint32_t remainingDependencies = 0;
+			bool skipped = false;
+			double startMs = 0.0;
+			double durationMs = 0.0;
+		};
+
+		void execute(LveStartupStageId id);
+		//With mutex held, the stages it returns are started by the caller once it is released
+		void release(LveStartupStageId id, std::vector<LveStartupStageId>& ready);
+		void start(const std::vector<LveStartupStageId>& ready);
+
+		LveJobSystem& jobSystem;
+		std::vector<Stage> stages;
+		double totalMs = 0.0;
+
+		std::mutex mutex;
+		std::condition_variable stageFinished;
+		std::vector<LveStartupStageId> mainThreadReady;
+		uint32_t finishedStages = 0;
+		std::exception_ptr error;
+	};//end class LveStartup
+}//end namespace
@@ -0,0 +1,145 @@
+#include "lve_streaming_buffer.h"
+
+//std
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve
+{
+	LveStreamingBuffer::LveStreamingBuffer(
+		LveDevice& device,
+		VkDeviceSize bytesPerFrame,
+		uint32_t framesInFlight,
+		VkBufferUsageFlags usage)
+		: lveDevice{ device }, framesInFlight{ framesInFlight }
+	{
+		nonCoherentAtomSize = std::max<VkDeviceSize>(lveDevice.properties.limits.nonCoherentAtomSize, 1);
+		this->bytesPerFrame = (bytesPerFrame + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize;
+		createBuffer(usage);
+	}//constructor
+
+	LveStreamingBuffer::~LveStreamingBuffer()
+	{
+		vkUnmapMemory(lveDevice.device(), memory);
+		vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
+		vkFreeMemory(lveDevice.device(), memory, nullptr);
+	}//destructor
+
+	void LveStreamingBuffer::createBuffer(VkBufferUsageFlags usage)
+	{
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = bytesPerFrame * framesInFlight;
+		bufferInfo.usage = usage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (vkCreateBuffer(lveDevice.device(), &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create streaming buffer!");
+		}//end if
+
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(lveDevice.device(), buffer, &memRequirements);
+
+		//Device local memory the CPU can write to (resizable BAR, integrated GPUs) saves the GPU
+		//reading over the bus, then coherent system memory, then anything mappable with explicit flushes
+		VkMemoryPropertyFlags candidates[] = {
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT };
+		uint32_t memoryType = UINT32_MAX;
+		for (VkMemoryPropertyFlags candidate : candidates)
+		{
+			if (lveDevice.hasMemoryType(memRequirements.memoryTypeBits, candidate))
+			{
+				memoryType = lveDevice.findMemoryType(memRequirements.memoryTypeBits, candidate);
+				break;
+			}//end if
+		}//end for
+		if (memoryType == UINT32_MAX)
+		{
+			throw std::runtime_error("failed to find mappable memory for the streaming buffer!");
+		}//end if
+		coherent = (lveDevice.getMemoryTypeProperties(memoryType) & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = memRequirements.size;
+		allocInfo.memoryTypeIndex = memoryType;
+		if (vkAllocateMemory(lveDevice.device(), &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate streaming buffer memory!");
+		}//end if
+		vkBindBufferMemory(lveDevice.device(), buffer, memory, 0);
+
+		//Mapped once for the life of the buffer
+		void* data;
+		if (vkMapMemory(lveDevice.device(), memory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to map streaming buffer memory!");
+		}//end if
+		mapped = static_cast<uint8_t*>(data);
+	}//end createBuffer
+
+	void LveStreamingBuffer::beginFrame(uint32_t frameIndex)
+	{
+		//The slot's fence has signaled, so the GPU is done with everything it was given last time
+		stats.bytesUsed = std::min(head.load(std::memory_order_relaxed), bytesPerFrame);
+		stats.allocations = allocationCount.exchange(0, std::memory_order_relaxed);
+		stats.failedAllocations = failedAllocationCount.exchange(0, std::memory_order_relaxed);
+		currentFrame = frameIndex % framesInFlight;
+		head.store(0, std::memory_order_relaxed);
+	}//end beginFrame
+
+	LveStreamingAllocation LveStreamingBuffer::allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		LveStreamingAllocation allocation{};
+		VkDeviceSize offset = head.load(std::memory_order_relaxed);
+		VkDeviceSize end;
+		do
+		{
+			offset = (offset + alignment - 1) & ~(alignment - 1);
+			end = offset + size;
+			if (end > bytesPerFrame)
+			{
+				failedAllocationCount.fetch_add(1, std::memory_order_relaxed);
+				return allocation;
+			}//end if
+			//On failure offset is reloaded with the head another thread moved it to
+		} while (!head.compare_exchange_weak(offset, end, std::memory_order_relaxed));
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+		VkDeviceSize frameBase = bytesPerFrame * currentFrame;
+		allocation.buffer = buffer;
+		allocation.offset = frameBase + offset;
+		allocation.size = size;
+		allocation.data = mapped + frameBase + offset;
+		return allocation;
+	}//end allocate
+
+	LveStreamingAllocation LveStreamingBuffer::upload(const void* data, VkDeviceSize size, VkDeviceSize alignment)
+	{
+		LveStreamingAllocation allocation = allocate(size, alignment);
+		if (allocation.isValid())
+		{
+			memcpy(allocation.data, data, static_cast<size_t>(size));
+		}//end if
+		return allocation;
+	}//end upload
+
+	void LveStreamingBuffer::flush()
+	{
+		VkDeviceSize used = std::min(head.load(std::memory_order_relaxed), bytesPerFrame);
+		if (coherent || used == 0)
+		{
+			return;
+		}//end if
+		//bytesPerFrame is a multiple of the atom size, so the rounded range stays inside the part
+		VkMappedMemoryRange range{};
+		range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory = memory;
+		range.offset = bytesPerFrame * currentFrame;
+		range.size = (used + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize;
+		vkFlushMappedMemoryRanges(lveDevice.device(), 1, &range);
+	}//end flush
+}//end namespace
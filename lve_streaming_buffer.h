@@ -0,0 +1,86 @@
+#pragma once
+
+#include "lve_device.h"
+
+//std
+#include <atomic>
+#include <cstdint>
+
+namespace lve
+{
+	//Slice of the streaming buffer, written through data and bound with buffer + offset. Only valid
+	//for the frame it was allocated in.
+	struct LveStreamingAllocation
+	{
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		void* data = nullptr;
+
+		//False when the frame's part of the ring was full
+		bool isValid() const { return data != nullptr; }
+	};
+
+	//Use of the ring by the last frame that retired
+	struct LveStreamingStats
+	{
+		VkDeviceSize bytesUsed = 0;
+		uint32_t allocations = 0;
+		uint32_t failedAllocations = 0;
+	};
+
+	//One buffer mapped for its whole life and split in a part per frame in flight, for data written
+	//by the CPU every frame (debug lines, UI, ...). Allocating bumps an atomic offset into the part of
+	//the frame being recorded, so any thread can allocate without locks and nothing is created or
+	//freed per frame. The part is reclaimed as a whole when the frame's fence has signaled.
+	class LveStreamingBuffer
+	{
+	public:
+		LveStreamingBuffer(
+			LveDevice& device,
+			VkDeviceSize bytesPerFrame,
+			uint32_t framesInFlight,
+			VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+		~LveStreamingBuffer();
+
+		LveStreamingBuffer(const LveStreamingBuffer&) = delete;
+		LveStreamingBuffer& operator=(const LveStreamingBuffer&) = delete;
+
+		//Call after the fence of frameIndex was waited on, with no allocation in progress: everything
+		//allocated the last time this slot was recorded is free again
+		void beginFrame(uint32_t frameIndex);
+		//Safe from any thread. alignment must be a power of two (e.g. minUniformBufferOffsetAlignment
+		//for uniform data). Returns an invalid allocation when the frame's part is full.
+		LveStreamingAllocation allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+		//allocate and copy size bytes of data in
+		LveStreamingAllocation upload(const void* data, VkDeviceSize size, VkDeviceSize alignment = 16);
+		//Before the frame is submitted: makes the CPU writes visible to the GPU when the memory is not
+		//host coherent, nothing to do otherwise
+		void flush();
+
+		VkBuffer getBuffer() const { return buffer; }
+		bool isCoherent() const { return coherent; }
+		const LveStreamingStats& getStats() const { return stats; }
+
+	private:
+		void createBuffer(VkBufferUsageFlags usage);
+
+		LveDevice& lveDevice;
+		//Rounded up to nonCoherentAtomSize so every part can be flushed on its own
+		VkDeviceSize bytesPerFrame;
+		uint32_t framesInFlight;
+		VkDeviceSize nonCoherentAtomSize;
+
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+		uint8_t* mapped = nullptr;
+		bool coherent = false;
+
+		uint32_t currentFrame = 0;
+		//Offset of the next free byte within the current frame's part
+		std::atomic<VkDeviceSize> head{ 0 };
+		std::atomic<uint32_t> allocationCount{ 0 };
+		std::atomic<uint32_t> failedAllocationCount{ 0 };
+		LveStreamingStats stats;
+	};//end class LveStreamingBuffer
+}//end namespace
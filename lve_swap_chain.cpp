@@ -11,13 +11,26 @@
 
 namespace lve {
 
-LveSwapChain::LveSwapChain(LveDevice &deviceRef, VkExtent2D extent)
-    : device{deviceRef}, windowExtent{extent} {
+LveSwapChain::LveSwapChain(LveDevice &deviceRef, LveWindow &window)
+    : device{deviceRef}, windowExtent{window.getExtent()}, surface{window.getSurface()} {
+  if (surface == VK_NULL_HANDLE) {
+    throw std::runtime_error("window was not given to the device, it has no surface!");
+  }
+  init();
+}
+
+void LveSwapChain::init() {
   createSwapChain();
   createImageViews();
-  createRenderPass();
+  // With dynamic rendering passes draw into the image views directly, nothing to create (or
+  // re-create on resize) per image besides them
+  if (!device.isDynamicRenderingEnabled()) {
+    createRenderPass();
+  }
   createDepthResources();
-  createFramebuffers();
+  if (!device.isDynamicRenderingEnabled()) {
+    createFramebuffers();
+  }
   createSyncObjects();
 }
 
@@ -42,7 +55,9 @@ LveSwapChain::~LveSwapChain() {
     vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
   }
 
-  vkDestroyRenderPass(device.device(), renderPass, nullptr);
+  if (renderPass != VK_NULL_HANDLE) {
+    vkDestroyRenderPass(device.device(), renderPass, nullptr);
+  }
 
   // cleanup synchronization objects
   for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
@@ -59,6 +74,8 @@ VkResult LveSwapChain::acquireNextImage(uint32_t *imageIndex) {
       &inFlightFences[currentFrame],
       VK_TRUE,
       std::numeric_limits<uint64_t>::max());
+  // The fence above is the one of the frame MAX_FRAMES_IN_FLIGHT back, what it used can go now
+  device.deletionQueue().beginFrame(MAX_FRAMES_IN_FLIGHT);
 
   VkResult result = vkAcquireNextImageKHR(
       device.device(),
@@ -72,7 +89,10 @@ VkResult LveSwapChain::acquireNextImage(uint32_t *imageIndex) {
 }
 
 VkResult LveSwapChain::submitCommandBuffers(
-    const VkCommandBuffer *buffers, uint32_t *imageIndex) {
+    const VkCommandBuffer *buffers,
+    uint32_t *imageIndex,
+    const std::vector<VkSemaphore> &extraWaitSemaphores,
+    const std::vector<VkPipelineStageFlags> &extraWaitStages) {
   if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
     vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
   }
@@ -81,11 +101,14 @@ VkResult LveSwapChain::submitCommandBuffers(
   VkSubmitInfo submitInfo = {};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-  VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-  VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  submitInfo.waitSemaphoreCount = 1;
-  submitInfo.pWaitSemaphores = waitSemaphores;
-  submitInfo.pWaitDstStageMask = waitStages;
+  std::vector<VkSemaphore> waitSemaphores = {imageAvailableSemaphores[currentFrame]};
+  std::vector<VkPipelineStageFlags> waitStages = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+  waitSemaphores.insert(
+      waitSemaphores.end(), extraWaitSemaphores.begin(), extraWaitSemaphores.end());
+  waitStages.insert(waitStages.end(), extraWaitStages.begin(), extraWaitStages.end());
+  submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+  submitInfo.pWaitSemaphores = waitSemaphores.data();
+  submitInfo.pWaitDstStageMask = waitStages.data();
 
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = buffers;
@@ -120,7 +143,7 @@ VkResult LveSwapChain::submitCommandBuffers(
 }
 
 void LveSwapChain::createSwapChain() {
-  SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
+  SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport(surface);
 
   VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
   VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
@@ -134,14 +157,20 @@ void LveSwapChain::createSwapChain() {
 
   VkSwapchainCreateInfoKHR createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-  createInfo.surface = device.surface();
+  createInfo.surface = surface;
 
   createInfo.minImageCount = imageCount;
   createInfo.imageFormat = surfaceFormat.format;
   createInfo.imageColorSpace = surfaceFormat.colorSpace;
   createInfo.imageExtent = extent;
   createInfo.imageArrayLayers = 1;
-  createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  // transfer dst so the dynamic resolution scene target can be blitted into it, transfer src when
+  // supported so the presented image can be read back
+  createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  readable = (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+  if (readable) {
+    createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  }
 
   QueueFamilyIndices indices = device.findPhysicalQueueFamilies();
   uint32_t queueFamilyIndices[] = {indices.graphicsFamily, indices.presentFamily};
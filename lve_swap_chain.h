@@ -15,18 +15,26 @@ class LveSwapChain {
  public:
   static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
 
-  LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent);
+  // Presents to the surface of window, which has to be one of the windows the device was created
+  // with. Several swap chains (a second monitor, an editor viewport) are presented together with
+  // LvePresentGroup.
+  LveSwapChain(LveDevice &deviceRef, LveWindow &window);
   ~LveSwapChain();
 
   LveSwapChain(const LveSwapChain &) = delete;
   void operator=(const LveSwapChain &) = delete;
 
+  // Not created when the device has dynamic rendering, draw into getImageView then
   VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
   VkRenderPass getRenderPass() { return renderPass; }
   VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+  VkImage getImage(int index) { return swapChainImages[index]; }
   size_t imageCount() { return swapChainImages.size(); }
+  VkSwapchainKHR getHandle() { return swapChain; }
   VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
   VkExtent2D getSwapChainExtent() { return swapChainExtent; }
+  // whether the images can be copied out after the frame, e.g. by LveReadback
+  bool isReadable() { return readable; }
   uint32_t width() { return swapChainExtent.width; }
   uint32_t height() { return swapChainExtent.height; }
 
@@ -35,10 +43,21 @@ class LveSwapChain {
   }
   VkFormat findDepthFormat();
 
+  //Frame in flight slot used by the image being acquired/submitted, resources indexed by it are
+  //safe to reuse once acquireNextImage has returned
+  size_t getCurrentFrame() { return currentFrame; }
+
   VkResult acquireNextImage(uint32_t *imageIndex);
-  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+  // extraWaitSemaphores are waited on at the matching extraWaitStages on top of the acquired image,
+  // e.g. compute work on another queue producing data the frame reads
+  VkResult submitCommandBuffers(
+      const VkCommandBuffer *buffers,
+      uint32_t *imageIndex,
+      const std::vector<VkSemaphore> &extraWaitSemaphores = {},
+      const std::vector<VkPipelineStageFlags> &extraWaitStages = {});
 
  private:
+  void init();
   void createSwapChain();
   void createImageViews();
   void createDepthResources();
@@ -55,9 +74,10 @@ class LveSwapChain {
 
   VkFormat swapChainImageFormat;
   VkExtent2D swapChainExtent;
+  bool readable = false;
 
   std::vector<VkFramebuffer> swapChainFramebuffers;
-  VkRenderPass renderPass;
+  VkRenderPass renderPass = VK_NULL_HANDLE;
 
   std::vector<VkImage> depthImages;
   std::vector<VkDeviceMemory> depthImageMemorys;
@@ -67,6 +87,8 @@ class LveSwapChain {
 
   LveDevice &device;
   VkExtent2D windowExtent;
+  // owned by the window
+  VkSurfaceKHR surface;
 
   VkSwapchainKHR swapChain;
 
@@ -0,0 +1,790 @@
+#include "lve_texture.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+
+namespace lve
+{
+	namespace
+	{
+		//Read-only mapping of a whole file, the texture data is copied straight out of it
+		class MappedFile
+		{
+		public:
+			MappedFile(const std::string& filepath)
+			{
+#if defined(_WIN32)
+				file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				LARGE_INTEGER fileSize{};
+				if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+				{
+					close();
+					throw std::runtime_error("failed to open file: " + filepath);
+				}//end if
+				mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				mappedData = mapping != nullptr ? static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+				mappedSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+				file = open(filepath.c_str(), O_RDONLY);
+				struct stat fileStat {};
+				if (file < 0 || fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+				{
+					close();
+					throw std::runtime_error("failed to open file: " + filepath);
+				}//end if
+				mappedSize = static_cast<size_t>(fileStat.st_size);
+				void* address = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, file, 0);
+				mappedData = address != MAP_FAILED ? static_cast<const uint8_t*>(address) : nullptr;
+#endif
+				if (mappedData == nullptr)
+				{
+					close();
+					throw std::runtime_error("failed to map file: " + filepath);
+				}//end if
+			}//constructor
+
+			~MappedFile() { close(); }
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			const uint8_t* data() const { return mappedData; }
+			size_t size() const { return mappedSize; }
+
+		private:
+			void close()
+			{
+#if defined(_WIN32)
+				if (mappedData != nullptr) UnmapViewOfFile(mappedData);
+				if (mapping != nullptr) CloseHandle(mapping);
+				if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+				mapping = nullptr;
+				file = INVALID_HANDLE_VALUE;
+#else
+				if (mappedData != nullptr) munmap(const_cast<uint8_t*>(mappedData), mappedSize);
+				if (file >= 0) ::close(file);
+				file = -1;
+#endif
+				mappedData = nullptr;
+			}//end close
+
+#if defined(_WIN32)
+			HANDLE file = INVALID_HANDLE_VALUE;
+			HANDLE mapping = nullptr;
+#else
+			int file = -1;
+#endif
+			const uint8_t* mappedData = nullptr;
+			size_t mappedSize = 0;
+		};//end class MappedFile
+
+		//Size of the smallest addressable piece of a format, 1x1 for plain formats
+		struct FormatBlock
+		{
+			uint32_t width;
+			uint32_t height;
+			uint32_t bytes;
+		};
+
+		FormatBlock getFormatBlock(VkFormat format)
+		{
+			switch (format)
+			{
+			case VK_FORMAT_R8_UNORM:
+				return { 1, 1, 1 };
+			case VK_FORMAT_R8G8_UNORM:
+				return { 1, 1, 2 };
+			case VK_FORMAT_R8G8B8A8_UNORM:
+			case VK_FORMAT_R8G8B8A8_SRGB:
+			case VK_FORMAT_B8G8R8A8_UNORM:
+			case VK_FORMAT_B8G8R8A8_SRGB:
+				return { 1, 1, 4 };
+			case VK_FORMAT_R16G16B16A16_SFLOAT:
+				return { 1, 1, 8 };
+			case VK_FORMAT_R32G32B32A32_SFLOAT:
+				return { 1, 1, 16 };
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			case VK_FORMAT_BC4_UNORM_BLOCK:
+			case VK_FORMAT_BC4_SNORM_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+			case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+			case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+				return { 4, 4, 8 };
+			case VK_FORMAT_BC2_UNORM_BLOCK:
+			case VK_FORMAT_BC2_SRGB_BLOCK:
+			case VK_FORMAT_BC3_UNORM_BLOCK:
+			case VK_FORMAT_BC3_SRGB_BLOCK:
+			case VK_FORMAT_BC5_UNORM_BLOCK:
+			case VK_FORMAT_BC5_SNORM_BLOCK:
+			case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+			case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+			case VK_FORMAT_BC7_UNORM_BLOCK:
+			case VK_FORMAT_BC7_SRGB_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+			case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+			case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+			case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+			case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+				return { 4, 4, 16 };
+			case VK_FORMAT_ASTC_5x4_UNORM_BLOCK:
+			case VK_FORMAT_ASTC_5x4_SRGB_BLOCK:
+				return { 5, 4, 16 };
+			case VK_FORMAT_ASTC_5x5_UNORM_BLOCK:
+			case VK_FORMAT_ASTC_5x5_SRGB_BLOCK:
+				return { 5, 5, 16 };
+			case VK_FORMAT_ASTC_6x5_UNORM_BLOCK:
+			case VK_FORMAT_ASTC_6x5_SRGB_BLOCK:
+				return { 6, 5, 16 };
+			case VK_FORMAT_ASTC_6x6_UNORM_BLOCK:
+			case VK_FORMAT_ASTC_6x6_SRGB_BLOCK:
+				return { 6, 6, 16 };
+			case VK_FORMAT_ASTC_8x5_UNORM_BLOCK:
+			case VK_FORMAT_ASTC_8x5_SRGB_BLOCK:
+				return { 8, 5, 16 };
+			case VK_FORMAT_ASTC_8x6_UNORM_BLOCK:
+			case VK_FORMAT_ASTC_8x6_SRGB_BLOCK:
+				return { 8, 6, 16 };
+			case VK_FORMAT_ASTC_8x8_UNORM_BLOCK:
+			case VK_FORMAT_ASTC_8x8_SRGB_BLOCK:
+				return { 8, 8, 16 };
+			case VK_FORMAT_ASTC_10x5_UNORM_BLOCK:
+			case VK_FORMAT_ASTC_10x5_SRGB_BLOCK:
+				return { 10, 5, 16 };
+			case VK_FORMAT_ASTC_10x6_UNORM_BLOCK:
+			case VK_FORMAT_ASTC_10x6_SRGB_BLOCK:
+				return { 10, 6, 16 };
+			case VK_FORMAT_ASTC_10x8_UNORM_BLOCK:
+			case VK_FORMAT_ASTC_10x8_SRGB_BLOCK:
+				return { 10, 8, 16 };
+			case VK_FORMAT_ASTC_10x10_UNORM_BLOCK:
+			case VK_FORMAT_ASTC_10x10_SRGB_BLOCK:
+				return { 10, 10, 16 };
+			case VK_FORMAT_ASTC_12x10_UNORM_BLOCK:
+			case VK_FORMAT_ASTC_12x10_SRGB_BLOCK:
+				return { 12, 10, 16 };
+			case VK_FORMAT_ASTC_12x12_UNORM_BLOCK:
+			case VK_FORMAT_ASTC_12x12_SRGB_BLOCK:
+				return { 12, 12, 16 };
+			default:
+				throw std::runtime_error("unsupported texture format!");
+			}//end switch
+		}//end getFormatBlock
+
+		VkDeviceSize getLevelSize(VkFormat format, VkExtent2D extent, uint32_t level)
+		{
+			FormatBlock block = getFormatBlock(format);
+			VkDeviceSize width = std::max(extent.width >> level, 1u);
+			VkDeviceSize height = std::max(extent.height >> level, 1u);
+			return ((width + block.width - 1) / block.width) * ((height + block.height - 1) / block.height) * block.bytes;
+		}//end getLevelSize
+
+		uint32_t getFullMipChain(VkExtent2D extent)
+		{
+			return static_cast<uint32_t>(std::floor(std::log2(std::max(extent.width, extent.height)))) + 1;
+		}//end getFullMipChain
+
+		template<typename T>
+		T readValue(const uint8_t* data, size_t offset)
+		{
+			T value;
+			std::memcpy(&value, data + offset, sizeof(T));
+			return value;
+		}//end readValue
+
+		constexpr uint32_t makeFourCC(char a, char b, char c, char d)
+		{
+			return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+		}//end makeFourCC
+
+		//DXGI_FORMAT values of the DX10 DDS header extension
+		VkFormat dxgiToVkFormat(uint32_t dxgiFormat)
+		{
+			switch (dxgiFormat)
+			{
+			case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+			case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+			case 87: return VK_FORMAT_B8G8R8A8_UNORM;
+			case 91: return VK_FORMAT_B8G8R8A8_SRGB;
+			case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+			case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+			case 74: return VK_FORMAT_BC2_UNORM_BLOCK;
+			case 75: return VK_FORMAT_BC2_SRGB_BLOCK;
+			case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+			case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+			case 80: return VK_FORMAT_BC4_UNORM_BLOCK;
+			case 81: return VK_FORMAT_BC4_SNORM_BLOCK;
+			case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+			case 84: return VK_FORMAT_BC5_SNORM_BLOCK;
+			case 95: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+			case 96: return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+			case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+			case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+			default: return VK_FORMAT_UNDEFINED;
+			}//end switch
+		}//end dxgiToVkFormat
+	}//end namespace
+
+	LveTexture::LveTexture(
+		LveDevice& device,
+		VkImage image,
+		VkDeviceMemory memory,
+		VkFormat format,
+		VkExtent2D extent,
+		uint32_t mipLevels,
+		VkDeviceSize memorySize)
+		: lveDevice{ device }, image{ image }, memory{ memory }, format{ format }, extent{ extent }, mipLevels{ mipLevels }, memorySize{ memorySize }
+	{
+	}//constructor
+
+	LveTexture::~LveTexture()
+	{
+		LveReleasedResources resources{};
+		resources.image = image;
+		resources.memory = memory;
+		lveDevice.deletionQueue().release(resources);
+	}//destructor
+
+	bool LveSamplerInfo::operator<(const LveSamplerInfo& other) const
+	{
+		return std::tie(magFilter, minFilter, mipmapMode, addressMode, anisotropy) <
+			std::tie(other.magFilter, other.minFilter, other.mipmapMode, other.addressMode, other.anisotropy);
+	}//end operator<
+
+	bool LveTextureCache::ViewKey::operator<(const ViewKey& other) const
+	{
+		return std::tie(image, format, baseMipLevel, levelCount, baseArrayLayer, layerCount) <
+			std::tie(other.image, other.format, other.baseMipLevel, other.levelCount, other.baseArrayLayer, other.layerCount);
+	}//end operator<
+
+	LveTextureCache::LveTextureCache(LveDevice& device) : lveDevice{ device }
+	{
+	}//constructor
+
+	LveTextureCache::~LveTextureCache()
+	{
+		for (auto& entry : imageViews)
+		{
+			vkDestroyImageView(lveDevice.device(), entry.second, nullptr);
+		}//end for
+		for (auto& entry : samplers)
+		{
+			vkDestroySampler(lveDevice.device(), entry.second, nullptr);
+		}//end for
+	}//destructor
+
+	std::shared_ptr<LveTexture> LveTextureCache::loadTexture(const std::string& filepath)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			auto found = textures.find(filepath);
+			if (found != textures.end())
+			{
+				return found->second;
+			}//end if
+		}
+
+		//The mapping stays open until the blocks are in the staging buffer, then goes away
+		MappedFile file{ filepath };
+		static const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+		TextureSource source;
+		if (file.size() >= sizeof(KTX2_IDENTIFIER) && std::memcmp(file.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0)
+		{
+			source = parseKtx2(file.data(), file.size(), filepath);
+		}
+		else if (file.size() >= 4 && readValue<uint32_t>(file.data(), 0) == makeFourCC('D', 'D', 'S', ' '))
+		{
+			source = parseDds(file.data(), file.size(), filepath);
+		}
+		else
+		{
+			throw std::runtime_error("unknown texture container: " + filepath);
+		}//end if
+		std::shared_ptr<LveTexture> texture = upload(source);
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		return textures.emplace(filepath, texture).first->second;
+	}//end loadTexture
+
+	std::shared_ptr<LveTexture> LveTextureCache::createTexture(
+		const std::string& name,
+		const void* pixels,
+		uint32_t width,
+		uint32_t height,
+		VkFormat format)
+	{
+		assert(getFormatBlock(format).width == 1 && "createTexture takes uncompressed pixels only");
+
+		TextureSource source;
+		source.format = format;
+		source.extent = { width, height };
+		source.levels.push_back({ static_cast<const uint8_t*>(pixels), getLevelSize(format, source.extent, 0) });
+		std::shared_ptr<LveTexture> texture = upload(source);
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		textures[name] = texture;
+		return texture;
+	}//end createTexture
+
+	VkImageView LveTextureCache::getImageView(const LveTexture& texture)
+	{
+		VkImageSubresourceRange range{};
+		range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		range.baseMipLevel = 0;
+		range.levelCount = texture.getMipLevels();
+		range.baseArrayLayer = 0;
+		range.layerCount = 1;
+		return getImageView(texture.getImage(), texture.getFormat(), range);
+	}//end getImageView
+
+	VkImageView LveTextureCache::getImageView(VkImage image, VkFormat format, const VkImageSubresourceRange& range)
+	{
+		ViewKey key{ image, format, range.baseMipLevel, range.levelCount, range.baseArrayLayer, range.layerCount };
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		auto found = imageViews.find(key);
+		if (found != imageViews.end())
+		{
+			return found->second;
+		}//end if
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange = range;
+
+		VkImageView imageView;
+		if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &imageView) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create texture image view!");
+		}//end if
+		imageViews.emplace(key, imageView);
+		return imageView;
+	}//end getImageView
+
+	VkSampler LveTextureCache::getSampler(const LveSamplerInfo& info)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		auto found = samplers.find(info);
+		if (found != samplers.end())
+		{
+			return found->second;
+		}//end if
+
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = info.magFilter;
+		samplerInfo.minFilter = info.minFilter;
+		samplerInfo.mipmapMode = info.mipmapMode;
+		samplerInfo.addressModeU = info.addressMode;
+		samplerInfo.addressModeV = info.addressMode;
+		samplerInfo.addressModeW = info.addressMode;
+		samplerInfo.mipLodBias = 0.0f;
+		samplerInfo.anisotropyEnable = info.anisotropy && lveDevice.enabledFeatures.samplerAnisotropy ? VK_TRUE : VK_FALSE;
+		samplerInfo.maxAnisotropy = lveDevice.properties.limits.maxSamplerAnisotropy;
+		samplerInfo.compareEnable = VK_FALSE;
+		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		samplerInfo.unnormalizedCoordinates = VK_FALSE;
+
+		VkSampler sampler;
+		if (vkCreateSampler(lveDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create texture sampler!");
+		}//end if
+		samplers.emplace(info, sampler);
+		return sampler;
+	}//end getSampler
+
+	bool LveTextureCache::isFormatSupported(VkFormat format)
+	{
+		//Each compression family is a device feature on top of the per format properties
+		if (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK && !lveDevice.enabledFeatures.textureCompressionBC)
+		{
+			return false;
+		}//end if
+		if (format >= VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK && format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK && !lveDevice.enabledFeatures.textureCompressionETC2)
+		{
+			return false;
+		}//end if
+		if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK && !lveDevice.enabledFeatures.textureCompressionASTC_LDR)
+		{
+			return false;
+		}//end if
+		VkFormatProperties props = lveDevice.getFormatProperties(format);
+		const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+		return (props.optimalTilingFeatures & required) == required;
+	}//end isFormatSupported
+
+	LveTextureCache::TextureSource LveTextureCache::parseKtx2(const uint8_t* data, size_t size, const std::string& filepath)
+	{
+		//12 byte identifier, 9 uint32 header fields, index of the data blocks (32 bytes), level index
+		const size_t HEADER_SIZE = 80;
+		const size_t LEVEL_ENTRY_SIZE = 24;
+		if (size < HEADER_SIZE)
+		{
+			throw std::runtime_error("truncated KTX2 file: " + filepath);
+		}//end if
+
+		TextureSource source;
+		source.format = static_cast<VkFormat>(readValue<uint32_t>(data, 12));
+		source.extent.width = readValue<uint32_t>(data, 20);
+		source.extent.height = readValue<uint32_t>(data, 24);
+		uint32_t pixelDepth = readValue<uint32_t>(data, 28);
+		uint32_t layerCount = readValue<uint32_t>(data, 32);
+		uint32_t faceCount = readValue<uint32_t>(data, 36);
+		uint32_t levelCount = readValue<uint32_t>(data, 40);
+		uint32_t supercompressionScheme = readValue<uint32_t>(data, 44);
+
+		//Basis Universal (format undefined) and zstd/zlib supercompression would need a CPU transcode
+		if (source.format == VK_FORMAT_UNDEFINED || supercompressionScheme != 0)
+		{
+			throw std::runtime_error("supercompressed KTX2 textures are not supported: " + filepath);
+		}//end if
+		if (pixelDepth > 1 || layerCount > 1 || faceCount != 1 || source.extent.width == 0 || source.extent.height == 0)
+		{
+			throw std::runtime_error("only single 2D KTX2 textures are supported: " + filepath);
+		}//end if
+
+		//Zero levels asks the loader to generate the mip chain
+		uint32_t storedLevels = std::max(levelCount, 1u);
+		if (size < HEADER_SIZE + storedLevels * LEVEL_ENTRY_SIZE)
+		{
+			throw std::runtime_error("truncated KTX2 file: " + filepath);
+		}//end if
+		for (uint32_t level = 0; level < storedLevels; level++)
+		{
+			size_t entry = HEADER_SIZE + level * LEVEL_ENTRY_SIZE;
+			uint64_t byteOffset = readValue<uint64_t>(data, entry);
+			uint64_t byteLength = readValue<uint64_t>(data, entry + 8);
+			if (byteOffset + byteLength > size || byteLength < getLevelSize(source.format, source.extent, level))
+			{
+				throw std::runtime_error("corrupt KTX2 level index: " + filepath);
+			}//end if
+			source.levels.push_back({ data + byteOffset, getLevelSize(source.format, source.extent, level) });
+		}//end for
+		return source;
+	}//end parseKtx2
+
+	LveTextureCache::TextureSource LveTextureCache::parseDds(const uint8_t* data, size_t size, const std::string& filepath)
+	{
+		//Magic, 124 byte DDS_HEADER with the pixel format at byte 76, optional 20 byte DX10 header
+		const size_t HEADER_SIZE = 128;
+		const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+		const uint32_t DDPF_FOURCC = 0x4;
+		const uint32_t DDPF_RGB = 0x40;
+		const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+		if (size < HEADER_SIZE)
+		{
+			throw std::runtime_error("truncated DDS file: " + filepath);
+		}//end if
+
+		TextureSource source;
+		uint32_t flags = readValue<uint32_t>(data, 8);
+		source.extent.height = readValue<uint32_t>(data, 12);
+		source.extent.width = readValue<uint32_t>(data, 16);
+		uint32_t mipMapCount = readValue<uint32_t>(data, 28);
+		uint32_t formatFlags = readValue<uint32_t>(data, 80);
+		uint32_t fourCC = readValue<uint32_t>(data, 84);
+		uint32_t rgbBitCount = readValue<uint32_t>(data, 88);
+		uint32_t redMask = readValue<uint32_t>(data, 92);
+		uint32_t caps2 = readValue<uint32_t>(data, 112);
+		size_t dataOffset = HEADER_SIZE;
+
+		if (caps2 & DDSCAPS2_CUBEMAP)
+		{
+			throw std::runtime_error("cube map DDS textures are not supported: " + filepath);
+		}//end if
+
+		if ((formatFlags & DDPF_FOURCC) && fourCC == makeFourCC('D', 'X', '1', '0'))
+		{
+			if (size < HEADER_SIZE + 20 || readValue<uint32_t>(data, HEADER_SIZE + 12) > 1)
+			{
+				throw std::runtime_error("only single 2D DDS textures are supported: " + filepath);
+			}//end if
+			source.format = dxgiToVkFormat(readValue<uint32_t>(data, HEADER_SIZE));
+			dataOffset += 20;
+		}
+		else if (formatFlags & DDPF_FOURCC)
+		{
+			switch (fourCC)
+			{
+			case makeFourCC('D', 'X', 'T', '1'): source.format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK; break;
+			case makeFourCC('D', 'X', 'T', '3'): source.format = VK_FORMAT_BC2_UNORM_BLOCK; break;
+			case makeFourCC('D', 'X', 'T', '5'): source.format = VK_FORMAT_BC3_UNORM_BLOCK; break;
+			case makeFourCC('A', 'T', 'I', '1'):
+			case makeFourCC('B', 'C', '4', 'U'): source.format = VK_FORMAT_BC4_UNORM_BLOCK; break;
+			case makeFourCC('A', 'T', 'I', '2'):
+			case makeFourCC('B', 'C', '5', 'U'): source.format = VK_FORMAT_BC5_UNORM_BLOCK; break;
+			default: source.format = VK_FORMAT_UNDEFINED; break;
+			}//end switch
+		}
+		else if ((formatFlags & DDPF_RGB) && rgbBitCount == 32)
+		{
+			source.format = redMask == 0x000000ff ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_B8G8R8A8_UNORM;
+		}//end if
+
+		if (source.format == VK_FORMAT_UNDEFINED)
+		{
+			throw std::runtime_error("unsupported DDS pixel format: " + filepath);
+		}//end if
+
+		//Levels are stored one after the other, largest first
+		uint32_t levelCount = (flags & DDSD_MIPMAPCOUNT) ? std::max(mipMapCount, 1u) : 1u;
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			VkDeviceSize levelSize = getLevelSize(source.format, source.extent, level);
+			if (dataOffset + levelSize > size)
+			{
+				throw std::runtime_error("truncated DDS file: " + filepath);
+			}//end if
+			source.levels.push_back({ data + dataOffset, levelSize });
+			dataOffset += static_cast<size_t>(levelSize);
+		}//end for
+		return source;
+	}//end parseDds
+
+	std::shared_ptr<LveTexture> LveTextureCache::upload(const TextureSource& source)
+	{
+		if (!isFormatSupported(source.format))
+		{
+			throw std::runtime_error("texture format not supported by the device!");
+		}//end if
+
+		uint32_t fullChain = getFullMipChain(source.extent);
+		uint32_t providedLevels = std::min(static_cast<uint32_t>(source.levels.size()), fullChain);
+
+		//Missing levels are blitted on the GPU, which compressed formats never allow
+		VkFormatProperties props = lveDevice.getFormatProperties(source.format);
+		const VkFormatFeatureFlags blitFeatures =
+			VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		bool generate = providedLevels < fullChain && (props.optimalTilingFeatures & blitFeatures) == blitFeatures;
+		uint32_t mipLevels = generate ? fullChain : providedLevels;
+
+		//Every provided level goes into one staging buffer, offsets kept multiples of the block size and of 4
+		std::vector<VkBufferImageCopy> regions;
+		VkDeviceSize stagingSize = 0;
+		for (uint32_t level = 0; level < providedLevels; level++)
+		{
+			stagingSize = (stagingSize + 15) & ~static_cast<VkDeviceSize>(15);
+
+			VkBufferImageCopy region{};
+			region.bufferOffset = stagingSize;
+			region.bufferRowLength = 0;
+			region.bufferImageHeight = 0;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = level;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = { 0, 0, 0 };
+			region.imageExtent = { std::max(source.extent.width >> level, 1u), std::max(source.extent.height >> level, 1u), 1 };
+			regions.push_back(region);
+
+			stagingSize += source.levels[level].size;
+		}//end for
+
+		VkBuffer stagingBuffer;
+		VkDeviceMemory stagingBufferMemory;
+		lveDevice.createBuffer(
+			stagingSize,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			stagingBuffer,
+			stagingBufferMemory);
+
+		void* data;
+		vkMapMemory(lveDevice.device(), stagingBufferMemory, 0, stagingSize, 0, &data);
+		for (uint32_t level = 0; level < providedLevels; level++)
+		{
+			memcpy(static_cast<uint8_t*>(data) + regions[level].bufferOffset, source.levels[level].data, static_cast<size_t>(source.levels[level].size));
+		}//end for
+		vkUnmapMemory(lveDevice.device(), stagingBufferMemory);
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = source.format;
+		imageInfo.extent = { source.extent.width, source.extent.height, 1 };
+		imageInfo.mipLevels = mipLevels;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (generate ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0);
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		VkImage image;
+		VkDeviceMemory imageMemory;
+		lveDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(lveDevice.device(), image, &memRequirements);
+
+		VkCommandBuffer commandBuffer = lveDevice.beginSingleTimeCommands();
+
+		//All levels at once into TRANSFER_DST
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = mipLevels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		vkCmdCopyBufferToImage(
+			commandBuffer,
+			stagingBuffer,
+			image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()),
+			regions.data());
+
+		if (generate)
+		{
+			generateMipmaps(commandBuffer, image, source.extent, providedLevels, mipLevels);
+		}
+		else
+		{
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}//end if
+
+		lveDevice.endSingleTimeCommands(commandBuffer);
+
+		vkDestroyBuffer(lveDevice.device(), stagingBuffer, nullptr);
+		vkFreeMemory(lveDevice.device(), stagingBufferMemory, nullptr);
+
+		return std::make_shared<LveTexture>(
+			lveDevice,
+			image,
+			imageMemory,
+			source.format,
+			source.extent,
+			mipLevels,
+			memRequirements.size);
+	}//end upload
+
+	void LveTextureCache::generateMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkExtent2D extent, uint32_t firstLevel, uint32_t mipLevels)
+	{
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		//Each level is downsampled from the one above it, which has to be finished and readable first
+		for (uint32_t level = firstLevel; level < mipLevels; level++)
+		{
+			barrier.subresourceRange.baseMipLevel = level - 1;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			VkImageBlit blit{};
+			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.srcSubresource.mipLevel = level - 1;
+			blit.srcSubresource.baseArrayLayer = 0;
+			blit.srcSubresource.layerCount = 1;
+			blit.srcOffsets[0] = { 0, 0, 0 };
+			blit.srcOffsets[1] = { static_cast<int32_t>(std::max(extent.width >> (level - 1), 1u)), static_cast<int32_t>(std::max(extent.height >> (level - 1), 1u)), 1 };
+			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.dstSubresource.mipLevel = level;
+			blit.dstSubresource.baseArrayLayer = 0;
+			blit.dstSubresource.layerCount = 1;
+			blit.dstOffsets[0] = { 0, 0, 0 };
+			blit.dstOffsets[1] = { static_cast<int32_t>(std::max(extent.width >> level, 1u)), static_cast<int32_t>(std::max(extent.height >> level, 1u)), 1 };
+			vkCmdBlitImage(
+				commandBuffer,
+				image,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				image,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1,
+				&blit,
+				VK_FILTER_LINEAR);
+		}//end for
+
+		//One batched transition of the whole chain to shader read: the untouched source levels and the
+		//last level are still TRANSFER_DST, every level a blit read from is TRANSFER_SRC
+		std::vector<VkImageMemoryBarrier> barriers;
+		auto addTransition = [&](uint32_t baseLevel, uint32_t levelCount, VkImageLayout oldLayout, VkAccessFlags srcAccess)
+		{
+			if (levelCount == 0)
+			{
+				return;
+			}//end if
+			VkImageMemoryBarrier transition = barrier;
+			transition.subresourceRange.baseMipLevel = baseLevel;
+			transition.subresourceRange.levelCount = levelCount;
+			transition.oldLayout = oldLayout;
+			transition.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			transition.srcAccessMask = srcAccess;
+			transition.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barriers.push_back(transition);
+		};
+		addTransition(0, firstLevel - 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT);
+		addTransition(firstLevel - 1, mipLevels - firstLevel, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT);
+		addTransition(mipLevels - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT);
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr,
+			static_cast<uint32_t>(barriers.size()),
+			barriers.data());
+	}//end generateMipmaps
+}//end namespace
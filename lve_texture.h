@@ -0,0 +1,134 @@
+#pragma once
+
+#include "lve_device.h"
+
+//std
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lve
+{
+	//A sampled 2D image with its full mip chain, always left in SHADER_READ_ONLY_OPTIMAL
+	class LveTexture
+	{
+	public:
+		LveTexture(
+			LveDevice& device,
+			VkImage image,
+			VkDeviceMemory memory,
+			VkFormat format,
+			VkExtent2D extent,
+			uint32_t mipLevels,
+			VkDeviceSize memorySize);
+		~LveTexture();
+
+		LveTexture(const LveTexture&) = delete;
+		LveTexture& operator=(const LveTexture&) = delete;
+
+		VkImage getImage() const { return image; }
+		VkFormat getFormat() const { return format; }
+		VkExtent2D getExtent() const { return extent; }
+		uint32_t getMipLevels() const { return mipLevels; }
+		//Device memory taken by the image, to compare compressed against uncompressed sources
+		VkDeviceSize getMemorySize() const { return memorySize; }
+
+	private:
+		LveDevice& lveDevice;
+		VkImage image;
+		VkDeviceMemory memory;
+		VkFormat format;
+		VkExtent2D extent;
+		uint32_t mipLevels;
+		VkDeviceSize memorySize;
+	};//end class LveTexture
+
+	//Sampler state, identical infos share one VkSampler
+	struct LveSamplerInfo
+	{
+		VkFilter magFilter = VK_FILTER_LINEAR;
+		VkFilter minFilter = VK_FILTER_LINEAR;
+		VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		bool anisotropy = true;
+
+		bool operator<(const LveSamplerInfo& other) const;
+	};
+
+	//Loads textures and owns every texture, image view and sampler made from them.
+	//KTX2 and DDS files are memory mapped and their blocks copied as they are into the staging
+	//buffer, so BCn/ASTC/ETC2 data goes to the GPU without ever being decoded (a BC1 texture is 8x
+	//smaller than RGBA8, BC3/BC7/ASTC 4x4 4x). Files without a full mip chain in a format the GPU can
+	//blit get the missing levels generated on the GPU.
+	//Uploads go through LveDevice::beginSingleTimeCommands on the graphics queue, so textures must
+	//be loaded before the render thread starts or from it.
+	class LveTextureCache
+	{
+	public:
+		LveTextureCache(LveDevice& device);
+		~LveTextureCache();
+
+		LveTextureCache(const LveTextureCache&) = delete;
+		LveTextureCache& operator=(const LveTextureCache&) = delete;
+
+		//.ktx2 or .dds, loading the same path again returns the same texture
+		std::shared_ptr<LveTexture> loadTexture(const std::string& filepath);
+		//Tightly packed RGBA8 pixels, the mip chain is generated on the GPU
+		std::shared_ptr<LveTexture> createTexture(
+			const std::string& name,
+			const void* pixels,
+			uint32_t width,
+			uint32_t height,
+			VkFormat format = VK_FORMAT_R8G8B8A8_SRGB);
+
+		//View over every mip level of the texture
+		VkImageView getImageView(const LveTexture& texture);
+		VkImageView getImageView(VkImage image, VkFormat format, const VkImageSubresourceRange& range);
+		VkSampler getSampler(const LveSamplerInfo& info = LveSamplerInfo{});
+
+		//True when the device can sample the format directly (checks the compression features too)
+		bool isFormatSupported(VkFormat format);
+
+	private:
+		//One mip level of the source, pointing into the mapped file or the caller's pixels
+		struct SourceLevel
+		{
+			const uint8_t* data;
+			VkDeviceSize size;
+		};
+
+		struct TextureSource
+		{
+			VkFormat format = VK_FORMAT_UNDEFINED;
+			VkExtent2D extent{};
+			std::vector<SourceLevel> levels;
+		};
+
+		struct ViewKey
+		{
+			VkImage image;
+			VkFormat format;
+			uint32_t baseMipLevel;
+			uint32_t levelCount;
+			uint32_t baseArrayLayer;
+			uint32_t layerCount;
+
+			bool operator<(const ViewKey& other) const;
+		};
+
+		static TextureSource parseKtx2(const uint8_t* data, size_t size, const std::string& filepath);
+		static TextureSource parseDds(const uint8_t* data, size_t size, const std::string& filepath);
+
+		std::shared_ptr<LveTexture> upload(const TextureSource& source);
+		void generateMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkExtent2D extent, uint32_t firstLevel, uint32_t mipLevels);
+
+		LveDevice& lveDevice;
+
+		std::mutex mutex;
+		std::map<std::string, std::shared_ptr<LveTexture>> textures;
+		std::map<ViewKey, VkImageView> imageViews;
+		std::map<LveSamplerInfo, VkSampler> samplers;
+	};//end class LveTextureCache
+}//end namespace
@@ -0,0 +1,61 @@
+#pragma once
+
+//std
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace lve
+{
+	//Lock-free single producer/single consumer triple buffer. The producer always has a slot of its
+	//own to write into and the consumer always has a slot of its own to read from, the third slot
+	//holds the latest published value in between. Neither side ever waits on the other: the producer
+	//overwrites values nobody picked up yet and the consumer keeps its current value until a newer one
+	//is published. Slots are reused, so a T holding containers stops allocating after the first frames.
+	template<typename T>
+	class LveTripleBuffer
+	{
+	public:
+		LveTripleBuffer() = default;
+
+		LveTripleBuffer(const LveTripleBuffer&) = delete;
+		LveTripleBuffer& operator=(const LveTripleBuffer&) = delete;
+
+		//Producer side: the slot to fill in, it still holds whatever was written there three publishes ago
+		T& getWriteBuffer() { return buffers[writeIndex]; }
+
+		//Producer side: hands the write slot over and takes back the one that was waiting in the middle
+		void publish()
+		{
+			uint8_t previous = middle.exchange(static_cast<uint8_t>(writeIndex | FRESH_BIT), std::memory_order_acq_rel);
+			writeIndex = previous & INDEX_MASK;
+		}//end publish
+
+		//Consumer side: swaps in the latest published value if there is one, returns false when the
+		//read slot is already the newest
+		bool consume()
+		{
+			//Only the consumer clears the bit, so once seen set it stays set until the exchange below
+			if ((middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+			{
+				return false;
+			}//end if
+			uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+			readIndex = previous & INDEX_MASK;
+			return true;
+		}//end consume
+
+		//Consumer side: the value picked up by the last consume, it is not touched by the producer
+		const T& getReadBuffer() const { return buffers[readIndex]; }
+
+	private:
+		static constexpr uint8_t INDEX_MASK = 0x3;
+		static constexpr uint8_t FRESH_BIT = 0x4;
+
+		std::array<T, 3> buffers{};
+		//Index of the middle slot plus the fresh bit, the only state shared by both threads
+		alignas(64) std::atomic<uint8_t> middle{ 1 };
+		alignas(64) uint8_t writeIndex = 0;
+		alignas(64) uint8_t readIndex = 2;
+	};//end class LveTripleBuffer
+}//end namespace
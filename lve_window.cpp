@@ -4,6 +4,8 @@
 
 namespace lve 
 {
+	int LveWindow::windowCount = 0;
+
 	LveWindow::LveWindow(int w, int h, std::string name) : width{ w }, height{ h }, windowName{ name }
 	{
 		initWindow();
@@ -12,12 +14,18 @@ namespace lve
 	LveWindow::~LveWindow()
 	{
 		glfwDestroyWindow(window);
-		glfwTerminate();
+		if (--windowCount == 0)
+		{
+			glfwTerminate();
+		}//end if
 	}//end Destructor
 
 	void LveWindow::initWindow()
 	{
-		glfwInit();
+		if (windowCount++ == 0)
+		{
+			glfwInit();
+		}//end if
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
 
@@ -25,11 +33,25 @@ namespace lve
 
 	}//end initWindow
 
-	void LveWindow::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface)
+	void LveWindow::createSurface(VkInstance instance)
 	{
-		if (glfwCreateWindowSurface(instance, window, nullptr, surface) != VK_SUCCESS)
+		if (surface != VK_NULL_HANDLE)
+		{
+			throw std::runtime_error("window already has a surface!");
+		}//end if
+		if (glfwCreateWindowSurface(instance, window, nullptr, &surface) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to create window surface");
 		}//end if 
-	}// end createWindowSurface
+		surfaceInstance = instance;
+	}// end createSurface
+
+	void LveWindow::destroySurface()
+	{
+		if (surface != VK_NULL_HANDLE)
+		{
+			vkDestroySurfaceKHR(surfaceInstance, surface, nullptr);
+			surface = VK_NULL_HANDLE;
+		}//end if
+	}//end destroySurface
 }//end namespace
\ No newline at end of file
@@ -19,14 +19,24 @@ namespace lve
 		bool shouldClose() { return glfwWindowShouldClose(window); }
 		VkExtent2D getExtent() { return { static_cast<uint32_t>(width), static_cast<uint32_t>(height) }; }
 
-		void createWindowSurface(VkInstance instance, VkSurfaceKHR* surface);
+		//The surface belongs to the window, but it is made from the instance of the device presenting to
+		//it: LveDevice creates it and destroys it again before the instance
+		void createSurface(VkInstance instance);
+		void destroySurface();
+		//VK_NULL_HANDLE unless the window was given to a device
+		VkSurfaceKHR getSurface() { return surface; }
 	private:
 		void initWindow();
 
+		//GLFW is initialized by the first window and terminated with the last one
+		static int windowCount;
+
 		const int width;
 		const int height;
 
 		std::string windowName;
 		GLFWwindow* window;
+		VkInstance surfaceInstance = VK_NULL_HANDLE;
+		VkSurfaceKHR surface = VK_NULL_HANDLE;
 	};//end class LveWindow
 }//end namespace
\ No newline at end of file
@@ -1,13 +1,64 @@
 #include "first_app.h"
+#include "lve_capture.h"
+#include "lve_job_benchmark.h"
+#include "lve_spatial_index.h"
 
 //std 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
-int main()
+int main(int argc, char** argv)
 {
-	lve::FirstApp app{};
+	std::string captureFilepath;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument{ argv[i] };
+		if (argument == "--job-benchmark")
+		{
+			lve::runJobSystemBenchmark();
+			return EXIT_SUCCESS;
+		}
+		else if (argument == "--spatial-benchmark")
+		{
+			lve::runSpatialIndexBenchmark();
+			return EXIT_SUCCESS;
+		}
+		else if (argument == "--capture" && i + 1 < argc)
+		{
+			captureFilepath = argv[++i];
+		}
+		else if (argument == "--replay" && i + 1 < argc)
+		{
+			//--replay <file> [repeats] [--dump <prefix>]
+			std::string replayFilepath{ argv[++i] };
+			uint32_t repeats = 1;
+			std::string dumpPrefix;
+			if (i + 1 < argc && std::string{ argv[i + 1] } != "--dump")
+			{
+				repeats = static_cast<uint32_t>(std::max(1l, std::strtol(argv[++i], nullptr, 10)));
+			}//end if
+			if (i + 2 < argc && std::string{ argv[i + 1] } == "--dump")
+			{
+				dumpPrefix = argv[i + 2];
+				i += 2;
+			}//end if
+			try
+			{
+				lve::runCaptureReplay(replayFilepath, repeats, dumpPrefix);
+			}//end try
+			catch (const std::exception& e)
+			{
+				std::cerr << e.what() << "\n";
+				return EXIT_FAILURE;
+			}//end catch
+			return EXIT_SUCCESS;
+		}//end if
+	}//end for
+
+	lve::FirstApp app{ captureFilepath };
 
 	try
 	{
@@ -0,0 +1,21 @@
+#version 450
+
+//Tonemapped color of this pixel, written by the tonemap subpass
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput tonemapped;
+
+layout(location = 0) out vec4 outColor;
+
+//Shared with tonemap.frag
+layout(push_constant) uniform Push {
+	float exposure;
+	float contrast;
+	float saturation;
+} push;
+
+void main() {
+	vec3 color = subpassLoad(tonemapped).rgb;
+	float luma = dot(color, vec3(0.2126, 0.7152, 0.0722));
+	color = mix(vec3(luma), color, push.saturation);
+	color = (color - 0.5) * push.contrast + 0.5;
+	outColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 450
+
+//The particle buffer is bound straight as the vertex buffer, one point per particle
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 velocity;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+	gl_PointSize = 1.0;
+	gl_Position = vec4(position, 0.0, 1.0);
+	//Faster particles are brighter
+	fragColor = mix(vec3(0.1, 0.2, 0.6), vec3(1.0, 0.9, 0.6), min(length(velocity) * 4.0, 1.0));
+}
\ No newline at end of file
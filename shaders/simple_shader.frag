@@ -1,7 +1,88 @@
 #version 450
 
+//compile.bat builds this twice: with BINDLESS_MATERIALS for devices with descriptor indexing, and
+//without it (flat push constant color) for the rest, which cannot even load a shader using the table
+#ifdef BINDLESS_MATERIALS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
+//NDC position of the fragment, picks its cluster along with the object's depth
+layout(location = 0) in vec2 fragPosition;
+#ifdef BINDLESS_MATERIALS
+layout(location = 1) in vec2 fragUv;
+#endif
+
 layout (location = 0) out vec4 outColor;
 
+layout(push_constant) uniform Push {
+	vec2 offset;
+	vec3 color;
+	//Slot of the material in the bindless table (set 0)
+	uint materialIndex;
+	//Layer of the object, nearer objects occlude the ones behind them
+	float depth;
+} push;
+
+//Debug view, a pipeline variant of its own so the normal variant has no branch at all
+layout(constant_id = 0) const bool SHOW_MATERIAL_INDEX = false;
+//Off for what is drawn over the scene (debug lines), flat color then
+layout(constant_id = 1) const bool LIGHTING = true;
+
+//Must match LveClusteredLighting
+const uvec3 CLUSTER_GRID = uvec3(16, 9, 16);
+const vec3 AMBIENT = vec3(0.2);
+
+#ifdef BINDLESS_MATERIALS
+//Set 0 is the bindless table, every material's texture at its material index
+layout(set = 0, binding = 0) uniform sampler2D materialTextures[];
+#endif
+
+struct Light {
+	//NDC x and y, depth, radius
+	vec4 positionRadius;
+	//rgb, intensity in w
+	vec4 color;
+};
+
+//Set 1 is the lighting, written by light_cull.comp
+layout(set = 1, binding = 0) readonly buffer Lights {
+	Light lights[];
+};
+layout(set = 1, binding = 1) readonly buffer Clusters {
+	uvec2 clusters[];
+};
+layout(set = 1, binding = 2) readonly buffer LightIndices {
+	uint lightIndexCount;
+	uint lightIndices[];
+};
+
+vec3 baseColor() {
+#ifdef BINDLESS_MATERIALS
+	//The index is the same for the whole draw today, nonuniformEXT keeps the lookup valid once it
+	//varies within one (instanced or merged draws)
+	return push.color * texture(materialTextures[nonuniformEXT(push.materialIndex)], fragUv).rgb;
+#else
+	return push.color;
+#endif
+}
+
 void main() {
-	outColor = vec4(1.0, 0.0, 1.0, 1.0);
+	if (SHOW_MATERIAL_INDEX) {
+		//A distinct flat color per material
+		outColor = vec4(fract(float(push.materialIndex) * vec3(0.31, 0.57, 0.73)), 1.0);
+	} else if (LIGHTING) {
+		//Only the lights of this fragment's cluster, however many the scene has
+		vec3 position = vec3(fragPosition, push.depth);
+		uvec3 cell = min(uvec3(clamp(vec3(position.xy * 0.5 + 0.5, position.z), 0.0, 1.0) * vec3(CLUSTER_GRID)), CLUSTER_GRID - 1);
+		uvec2 range = clusters[cell.x + CLUSTER_GRID.x * (cell.y + CLUSTER_GRID.y * cell.z)];
+		vec3 light = AMBIENT;
+		for (uint i = 0; i < range.y; i++) {
+			Light pointLight = lights[lightIndices[range.x + i]];
+			float falloff = max(1.0 - distance(position, pointLight.positionRadius.xyz) / pointLight.positionRadius.w, 0.0);
+			light += pointLight.color.rgb * pointLight.color.w * falloff * falloff;
+		}
+		outColor = vec4(baseColor() * light, 1.0);
+	} else {
+		outColor = vec4(baseColor(), 1.0);
+	}
 }
\ No newline at end of file
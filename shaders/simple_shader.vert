@@ -2,6 +2,26 @@
 
 layout(location = 0) in vec2 position;
 
+//NDC position, the fragment shader finds its light cluster with it
+layout(location = 0) out vec2 fragPosition;
+//Material texture coordinates, from the model position so every instance looks the same
+layout(location = 1) out vec2 fragUv;
+
+layout(push_constant) uniform Push {
+	vec2 offset;
+	vec3 color;
+	//Slot of the material in the bindless table (set 0)
+	uint materialIndex;
+	//Layer of the object, nearer objects occlude the ones behind them
+	float depth;
+} push;
+
+//Depth pre-pass and main pass must produce bit identical depth for the EQUAL test to pass
+invariant gl_Position;
+
 void main() {
-	gl_Position = vec4(position, 0.0, 1.0);
+	fragPosition = position + push.offset;
+	//One repeat of the texture per quarter unit
+	fragUv = position * 4.0;
+	gl_Position = vec4(fragPosition, push.depth, 1.0);
 }
\ No newline at end of file
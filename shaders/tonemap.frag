@@ -0,0 +1,19 @@
+#version 450
+
+//HDR scene color of this pixel, written by the scene subpass
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput sceneColor;
+
+layout(location = 0) out vec4 outColor;
+
+//Shared with grade.frag
+layout(push_constant) uniform Push {
+	float exposure;
+	float contrast;
+	float saturation;
+} push;
+
+void main() {
+	//Reinhard, maps [0, inf) into [0, 1)
+	vec3 color = subpassLoad(sceneColor).rgb * push.exposure;
+	outColor = vec4(color / (color + 1.0), 1.0);
+}
\ No newline at end of file